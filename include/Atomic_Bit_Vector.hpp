@@ -0,0 +1,445 @@
+
+#ifndef ATOMIC_BIT_VECTOR_HPP
+#define ATOMIC_BIT_VECTOR_HPP
+
+
+
+#include "Memory_Mapped_File.hpp"
+#include "Huge_Pages.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <string>
+#include <iostream>
+
+
+// A bit-packed vector of `BITS`-bit wide entries, supporting lock-free concurrent
+// reads and updates of its entries through word-level compare-and-swap (CAS).
+// Unlike `compact::ts_vector`, an entry never straddles two 64-bit words: each
+// word packs `entries_per_word` entries into its lower bits, and its most
+// significant bit is reserved as a claim-flag for the two-entry update protocol
+// (see `cas_pair`).
+template <uint8_t BITS>
+class Atomic_Bit_Vector
+{
+    static_assert(BITS > 0 && BITS <= 8, "Entries of the atomic bitvector must fit in a byte.");
+
+public:
+
+    typedef uint8_t value_t;    // Type of the entries, as seen from outside.
+
+
+private:
+
+    static constexpr uint8_t word_bits = 64;    // Number of bits in each word of the underlying storage.
+    static constexpr uint8_t entries_per_word = (word_bits - 1) / BITS; // Number of entries packed into each word.
+    static constexpr uint64_t entry_mask = (static_cast<uint64_t>(1) << BITS) - 1;  // Bitmask to extract an entry at offset 0.
+    static constexpr uint64_t claim_flag = static_cast<uint64_t>(1) << (word_bits - 1); // Flag marking a word claimed by an in-flight two-entry update.
+
+    std::size_t size_;  // Number of entries in the vector.
+    std::size_t word_count; // Number of words in the underlying storage.
+    Huge_Page_Allocator<uint64_t> allocator;    // Allocator for the underlying storage, backing it with huge pages.
+    std::unique_ptr<Memory_Mapped_File> mapping;    // Memory-mapping of a serialized vector, if the storage is backed by one.
+    uint64_t* word; // The underlying storage.
+
+
+    // Returns the index of the word containing the entry at index `idx`.
+    static std::size_t word_idx(std::size_t idx);
+
+    // Returns the bit-offset of the entry at index `idx` in its word.
+    static uint8_t bit_offset(std::size_t idx);
+
+    // Returns the entry at index `idx` from the word `w` that contains it.
+    static value_t extract(uint64_t w, std::size_t idx);
+
+    // Returns the word `w` with its entry for index `idx` replaced with `val`.
+    static uint64_t replace(uint64_t w, std::size_t idx, value_t val);
+
+    // Returns the number of words required to store `size` entries.
+    static std::size_t words_for(std::size_t size);
+
+    // Atomically loads the word at index `w_idx`, waiting for any in-flight
+    // two-entry update having claimed the word to complete.
+    uint64_t load_word(std::size_t w_idx) const;
+
+    // Attempts to replace the word at index `w_idx` from `expected` to `desired`
+    // atomically. Returns `true` iff the replacement succeeds.
+    bool cas_word(std::size_t w_idx, uint64_t expected, uint64_t desired);
+
+    // Allocates (uninitialized) storage for the entries.
+    void allocate();
+
+    // Frees the storage of the entries.
+    void deallocate();
+
+
+public:
+
+    // Constructs a vector of `size` entries, with uninitialized values.
+    Atomic_Bit_Vector(std::size_t size);
+
+    Atomic_Bit_Vector(const Atomic_Bit_Vector&) = delete;
+    Atomic_Bit_Vector& operator=(const Atomic_Bit_Vector&) = delete;
+
+    // Destructs the vector.
+    ~Atomic_Bit_Vector();
+
+    // Returns the average number of bits used by each entry.
+    static constexpr double bits_per_entry() { return static_cast<double>(word_bits) / entries_per_word; }
+
+    // Returns the number of entries in the vector.
+    std::size_t size() const;
+
+    // Returns the size of the underlying storage in bytes.
+    std::size_t bytes() const;
+
+    // Returns the size of the underlying storage in bytes for a vector of `size` entries.
+    static std::size_t bytes_for(std::size_t size);
+
+    // Returns the page backing obtained for the underlying storage.
+    Page_Backing backing() const;
+
+    // Sets all the entries to zero.
+    void clear_mem();
+
+    // Releases the underlying storage, leaving the vector empty.
+    void clear();
+
+    // Returns the entry at index `idx`.
+    value_t load(std::size_t idx) const;
+
+    // Prefetches the word containing the entry at index `idx` into the cache.
+    void prefetch(std::size_t idx) const;
+
+    // Attempts to update the entry at index `idx` from `expected` to `desired`
+    // atomically. Returns `true` iff the entry had the value `expected`.
+    bool cas(std::size_t idx, value_t expected, value_t desired);
+
+    // Stores `val` to the entry at index `idx`.
+    void store(std::size_t idx, value_t val);
+
+    // Atomically transforms the entry at index `idx` through the function `f`.
+    void transform(std::size_t idx, value_t (*f)(value_t));
+
+    // Attempts to update the entries at indices `idx_1` and `idx_2` from `exp_1`
+    // and `exp_2` to `des_1` and `des_2` respectively, in a tied manner — both
+    // successful or failing. Returns `true` iff the updates succeed. If both the
+    // indices are the same, then the entry is updated to `des_2`.
+    bool cas_pair(std::size_t idx_1, value_t exp_1, value_t des_1, std::size_t idx_2, value_t exp_2, value_t des_2);
+
+    // Serializes the vector to the stream `output`, tagged with the format
+    // version `version` of its content. The words are laid out at a
+    // page-aligned offset, so that the serialization can be mapped.
+    void serialize(std::ostream& output, uint32_t version) const;
+
+    // Deserializes the vector from the file at path `file_path`, by mapping it
+    // into memory in a copy-on-write manner, i.e. updates to the vector are not
+    // carried to the file. The file is rejected if it is not tagged with the
+    // format version `version`. If `populate` is `true`, then the file is read
+    // into memory at once; otherwise its pages are faulted-in on demand.
+    void deserialize(const std::string& file_path, uint32_t version, bool populate = false);
+};
+
+
+template <uint8_t BITS>
+inline Atomic_Bit_Vector<BITS>::Atomic_Bit_Vector(const std::size_t size):
+    size_(size),
+    word_count(words_for(size)),
+    word(nullptr)
+{
+    allocate();
+}
+
+
+template <uint8_t BITS>
+inline Atomic_Bit_Vector<BITS>::~Atomic_Bit_Vector()
+{
+    deallocate();
+}
+
+
+template <uint8_t BITS>
+inline std::size_t Atomic_Bit_Vector<BITS>::word_idx(const std::size_t idx)
+{
+    return idx / entries_per_word;
+}
+
+
+template <uint8_t BITS>
+inline uint8_t Atomic_Bit_Vector<BITS>::bit_offset(const std::size_t idx)
+{
+    return (idx % entries_per_word) * BITS;
+}
+
+
+template <uint8_t BITS>
+inline typename Atomic_Bit_Vector<BITS>::value_t Atomic_Bit_Vector<BITS>::extract(const uint64_t w, const std::size_t idx)
+{
+    return static_cast<value_t>((w >> bit_offset(idx)) & entry_mask);
+}
+
+
+template <uint8_t BITS>
+inline uint64_t Atomic_Bit_Vector<BITS>::replace(const uint64_t w, const std::size_t idx, const value_t val)
+{
+    const uint8_t offset = bit_offset(idx);
+    return (w & ~(entry_mask << offset)) | (static_cast<uint64_t>(val) << offset);
+}
+
+
+template <uint8_t BITS>
+inline std::size_t Atomic_Bit_Vector<BITS>::words_for(const std::size_t size)
+{
+    return (size + entries_per_word - 1) / entries_per_word;
+}
+
+
+template <uint8_t BITS>
+inline uint64_t Atomic_Bit_Vector<BITS>::load_word(const std::size_t w_idx) const
+{
+    uint64_t w;
+    while((w = __atomic_load_n(word + w_idx, __ATOMIC_ACQUIRE)) & claim_flag)
+        ;
+
+    return w;
+}
+
+
+template <uint8_t BITS>
+inline bool Atomic_Bit_Vector<BITS>::cas_word(const std::size_t w_idx, uint64_t expected, const uint64_t desired)
+{
+    return __atomic_compare_exchange_n(word + w_idx, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::allocate()
+{
+    if(word_count > 0)
+        word = allocator.allocate(word_count);
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::deallocate()
+{
+    if(mapping != nullptr)
+        mapping.reset();
+    else if(word != nullptr)
+        allocator.deallocate(word, word_count);
+
+    word = nullptr;
+}
+
+
+template <uint8_t BITS>
+inline std::size_t Atomic_Bit_Vector<BITS>::size() const
+{
+    return size_;
+}
+
+
+template <uint8_t BITS>
+inline std::size_t Atomic_Bit_Vector<BITS>::bytes() const
+{
+    return word_count * sizeof(uint64_t);
+}
+
+
+template <uint8_t BITS>
+inline std::size_t Atomic_Bit_Vector<BITS>::bytes_for(const std::size_t size)
+{
+    return words_for(size) * sizeof(uint64_t);
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::clear_mem()
+{
+    if(word != nullptr)
+        std::memset(word, 0, bytes());
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::clear()
+{
+    deallocate();
+    size_ = word_count = 0;
+}
+
+
+template <uint8_t BITS>
+inline typename Atomic_Bit_Vector<BITS>::value_t Atomic_Bit_Vector<BITS>::load(const std::size_t idx) const
+{
+    return extract(load_word(word_idx(idx)), idx);
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::prefetch(const std::size_t idx) const
+{
+    __builtin_prefetch(word + word_idx(idx), 1);
+}
+
+
+template <uint8_t BITS>
+inline bool Atomic_Bit_Vector<BITS>::cas(const std::size_t idx, const value_t expected, const value_t desired)
+{
+    const std::size_t w_idx = word_idx(idx);
+    while(true)
+    {
+        const uint64_t w = load_word(w_idx);
+        if(extract(w, idx) != expected)
+            return false;
+
+        // The CAS fails spuriously only if some other entry in the word changed meanwhile.
+        if(cas_word(w_idx, w, replace(w, idx, desired)))
+            return true;
+    }
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::store(const std::size_t idx, const value_t val)
+{
+    const std::size_t w_idx = word_idx(idx);
+    uint64_t w;
+    do
+        w = load_word(w_idx);
+    while(!cas_word(w_idx, w, replace(w, idx, val)));
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::transform(const std::size_t idx, value_t (* const f)(value_t))
+{
+    const std::size_t w_idx = word_idx(idx);
+    uint64_t w;
+    do
+        w = load_word(w_idx);
+    while(!cas_word(w_idx, w, replace(w, idx, f(extract(w, idx)))));
+}
+
+
+template <uint8_t BITS>
+inline bool Atomic_Bit_Vector<BITS>::cas_pair(std::size_t idx_1, value_t exp_1, value_t des_1, std::size_t idx_2, value_t exp_2, value_t des_2)
+{
+    const std::size_t w_1 = word_idx(idx_1);
+    const std::size_t w_2 = word_idx(idx_2);
+
+    // Both the entries are in the same word: a single CAS suffices.
+    if(w_1 == w_2)
+        while(true)
+        {
+            const uint64_t w = load_word(w_1);
+            if(extract(w, idx_1) != exp_1 || extract(w, idx_2) != exp_2)
+                return false;
+
+            if(cas_word(w_1, w, replace(replace(w, idx_1, des_1), idx_2, des_2)))
+                return true;
+        }
+
+
+    // Resolution for potential deadlocks: words are always claimed in increasing order.
+    if(w_1 > w_2)
+        std::swap(idx_1, idx_2),
+        std::swap(exp_1, exp_2),
+        std::swap(des_1, des_2);
+
+    const std::size_t w_l = word_idx(idx_1);
+    const std::size_t w_r = word_idx(idx_2);
+
+    // Claim the lower word, tentatively writing its new entry. While claimed, no other
+    // thread can modify or read the word, as their expected values lack the claim-flag.
+    uint64_t old_l, new_l;
+    do
+    {
+        old_l = load_word(w_l);
+        if(extract(old_l, idx_1) != exp_1)
+            return false;
+
+        new_l = replace(old_l, idx_1, des_1);
+    }
+    while(!cas_word(w_l, old_l, new_l | claim_flag));
+
+    // Update the higher word; and then release the lower word, rolling it back if required.
+    while(true)
+    {
+        const uint64_t old_r = load_word(w_r);
+        if(extract(old_r, idx_2) != exp_2)
+        {
+            __atomic_store_n(word + w_l, old_l, __ATOMIC_RELEASE);
+            return false;
+        }
+
+        if(cas_word(w_r, old_r, replace(old_r, idx_2, des_2)))
+            break;
+    }
+
+    __atomic_store_n(word + w_l, new_l, __ATOMIC_RELEASE);
+    return true;
+}
+
+
+template <uint8_t BITS>
+inline Page_Backing Atomic_Bit_Vector<BITS>::backing() const
+{
+    return word != nullptr ? Huge_Pages::backing(word) : Page_Backing::regular;
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::serialize(std::ostream& output, const uint32_t version) const
+{
+    const uint8_t bits = BITS;
+    output.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    output.write(reinterpret_cast<const char*>(&bits), sizeof(bits));
+    output.write(reinterpret_cast<const char*>(&size_), sizeof(size_));
+    Memory_Mapped_File::pad(output, sizeof(version) + sizeof(bits) + sizeof(size_));
+    output.write(reinterpret_cast<const char*>(word), bytes());
+}
+
+
+template <uint8_t BITS>
+inline void Atomic_Bit_Vector<BITS>::deserialize(const std::string& file_path, const uint32_t version, const bool populate)
+{
+    std::unique_ptr<Memory_Mapped_File> file(new Memory_Mapped_File(file_path, populate));
+
+    uint32_t file_version = 0;
+    uint8_t bits = 0;
+    std::size_t size = 0;
+    const std::size_t header_bytes = Memory_Mapped_File::page_align(sizeof(file_version) + sizeof(bits) + sizeof(size));
+    if(file->size() >= header_bytes)
+    {
+        std::memcpy(&file_version, file->data(), sizeof(file_version));
+        std::memcpy(&bits, file->data() + sizeof(file_version), sizeof(bits));
+        std::memcpy(&size, file->data() + sizeof(file_version) + sizeof(bits), sizeof(size));
+    }
+
+    if(file->size() >= header_bytes && file_version != version)
+    {
+        std::cerr << "The hash table buckets at file " << file_path << " are of format version " << file_version
+                    << ", whereas version " << version << " is expected. Remove the file to have it rebuilt. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(file->size() < header_bytes || bits != BITS || file->size() != header_bytes + words_for(size) * sizeof(uint64_t))
+    {
+        std::cerr << "Incompatible hash table buckets found at file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    deallocate();
+    size_ = size;
+    word_count = words_for(size);
+    mapping = std::move(file);
+    word = reinterpret_cast<uint64_t*>(mapping->data() + header_bytes);
+}
+
+
+#endif
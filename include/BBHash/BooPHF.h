@@ -10,6 +10,7 @@
 #include <math.h>
 #include <inttypes.h>
 #include <array>
+#include <algorithm>
 #include <unordered_map>
 #include <vector>
 #include <assert.h>
@@ -20,6 +21,8 @@
 #include <chrono>
 #include <thread>
 
+#include "Huge_Pages.hpp"
+
 
 
 namespace boomphf {
@@ -605,7 +608,9 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 
 	public:
 
-		bitVector() : _size(0)
+		// The bit arrays are randomly accessed at lookups; hence these are backed
+		// by huge pages where possible, through `Huge_Pages`.
+		bitVector() : _size(0), _nchar(0)
 		{
 			_bitArray = nullptr;
 		}
@@ -613,13 +618,13 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		bitVector(uint64_t n) : _size(n)
 		{
 			_nchar  = (1ULL+n/64ULL);
-			_bitArray =  (uint64_t *) calloc (_nchar,sizeof(uint64_t));
+			_bitArray =  (uint64_t *) Huge_Pages::allocate (_nchar*sizeof(uint64_t));
 		}
 
 		~bitVector()
 		{
 			if(_bitArray != nullptr)
-				free(_bitArray);
+				Huge_Pages::deallocate(_bitArray, _nchar*sizeof(uint64_t));
 		}
 
 		 //copy constructor
@@ -628,7 +633,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			 _size =  r._size;
 			 _nchar = r._nchar;
 			 _ranks = r._ranks;
-			 _bitArray = (uint64_t *) calloc (_nchar,sizeof(uint64_t));
+			 _bitArray = (uint64_t *) Huge_Pages::allocate (_nchar*sizeof(uint64_t));
 			 memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
 		 }
 		
@@ -637,12 +642,12 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		{
 			if (&r != this)
 			{
+				if(_bitArray != nullptr)
+					Huge_Pages::deallocate(_bitArray, _nchar*sizeof(uint64_t));
 				_size =  r._size;
 				_nchar = r._nchar;
 				_ranks = r._ranks;
-				if(_bitArray != nullptr)
-					free(_bitArray);
-				_bitArray = (uint64_t *) calloc (_nchar,sizeof(uint64_t));
+				_bitArray = (uint64_t *) Huge_Pages::allocate (_nchar*sizeof(uint64_t));
 				memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
 			}
 			return *this;
@@ -655,7 +660,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			if (&r != this)
 			{
 				if(_bitArray != nullptr)
-					free(_bitArray);
+					Huge_Pages::deallocate(_bitArray, _nchar*sizeof(uint64_t));
 				
 				_size =  std::move (r._size);
 				_nchar = std::move (r._nchar);
@@ -666,7 +671,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			return *this;
 		}
 		// Move constructor
-		bitVector(bitVector &&r) : _bitArray ( nullptr),_size(0)
+		bitVector(bitVector &&r) : _bitArray ( nullptr),_size(0),_nchar(0)
 		{
 			*this = std::move(r);
 		}
@@ -675,8 +680,15 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		void resize(uint64_t newsize)
 		{
 			//printf("bitvector resize from  %llu bits to %llu \n",_size,newsize);
-			_nchar  = (1ULL+newsize/64ULL);
-			_bitArray = (uint64_t *) realloc(_bitArray,_nchar*sizeof(uint64_t));
+			const uint64_t nchar  = (1ULL+newsize/64ULL);
+			uint64_t* const bitArray = (uint64_t *) Huge_Pages::allocate(nchar*sizeof(uint64_t));
+			if(_bitArray != nullptr)
+			{
+				memcpy(bitArray, _bitArray, std::min(_nchar, nchar)*sizeof(uint64_t));
+				Huge_Pages::deallocate(_bitArray, _nchar*sizeof(uint64_t));
+			}
+			_bitArray = bitArray;
+			_nchar = nchar;
 			_size = newsize;
 		}
 
@@ -766,6 +778,12 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			return _bitArray[cell64];
 		}
 
+		//the underlying bit array
+		const uint64_t* data() const
+		{
+			return _bitArray;
+		}
+
 		//set bit pos to 1
 		void set(uint64_t pos)
 		{
@@ -798,6 +816,19 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			return curent_rank;
 		}
 
+		//prefetch the word containing bit pos
+		void prefetch(uint64_t pos) const
+		{
+			__builtin_prefetch(_bitArray + (pos >> 6ULL));
+		}
+
+		//prefetch the rank sample and the word required to compute rank at pos
+		void prefetch_rank(uint64_t pos) const
+		{
+			__builtin_prefetch(_ranks.data() + (pos / _nb_bits_per_rank_sample));
+			__builtin_prefetch(_bitArray + (pos >> 6ULL));
+		}
+
 		uint64_t rank(uint64_t pos) const
 		{
 			uint64_t word_idx = pos / 64ULL;
@@ -848,7 +879,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		 // epsilon =  64 / _nb_bits_per_rank_sample   bits
 		// additional size for rank is epsilon * _size
 		static const uint64_t _nb_bits_per_rank_sample = 512; //512 seems ok
-		std::vector<uint64_t> _ranks;
+		std::vector<uint64_t, Huge_Page_Allocator<uint64_t>> _ranks;
 	};
 
 ////////////////////////////////////////////////////////////////
@@ -1024,14 +1055,37 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		uint64_t lookup(const elem_t& elem)
 		{
 			if(! _built) return ULLONG_MAX;
-			
-			//auto hashes = _hasher(elem);
-			uint64_t non_minimal_hp,minimal_hp;
-
 
 			hash_pair_t bbhash;  int level;
 			uint64_t level_hash = getLevel(bbhash,elem,&level);
 
+			return lookup_at_level(elem, level_hash, level);
+		}
+
+		// lookup of the key elem whose first two hashes, i.e. the ones of the hasher's h0 and h1, are
+		// precomputed into bbhash; e.g. from a rolling hash
+		uint64_t lookup(const elem_t& elem, hash_pair_t bbhash)
+		{
+			if(! _built) return ULLONG_MAX;
+
+			int level;
+			uint64_t level_hash = getLevel_hashed(bbhash, &level);
+
+			return lookup_at_level(elem, level_hash, level);
+		}
+
+		// prefetch the first-level bitset word to be probed by the lookup of the key whose first two
+		// hashes are bbhash; most lookups are resolved at that level
+		void prefetch(const hash_pair_t& bbhash) const
+		{
+			if(_built)
+				_levels[0].bitset.prefetch(fastrange64(bbhash[0], _levels[0].hash_domain));
+		}
+
+		uint64_t lookup_at_level(const elem_t& elem, const uint64_t level_hash, const int level)
+		{
+			uint64_t non_minimal_hp,minimal_hp;
+
 			if( level == (_nb_levels-1))
 			{
 				auto in_final_map  = _final_hash.find (elem);
@@ -1061,11 +1115,111 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			return minimal_hp;
 		}
 
+		// batched lookup of the n keys at elems into res: the lookups are interleaved level by level,
+		// and the bitset (and then rank) accesses of each key are prefetched one step ahead of use,
+		// so that many cache misses are in flight at once instead of one per lookup
+		void lookup(const elem_t* elems, const size_t n, uint64_t* res)
+		{
+			lookup_batch(elems, n, res,
+				[&](hash_pair_t& bbhash, const size_t i){ return _hasher.h0(bbhash, elems[i]); },
+				[&](hash_pair_t& bbhash, const size_t i){ return _hasher.h1(bbhash, elems[i]); });
+		}
+
+		// batched lookup of the n keys at elems into res, with the first two hashes of the keys precomputed
+		// into hashes, as in the lookup of a single key with precomputed hashes
+		void lookup(const elem_t* elems, const hash_pair_t* hashes, const size_t n, uint64_t* res)
+		{
+			lookup_batch(elems, n, res,
+				[&](hash_pair_t& bbhash, const size_t i){ return (bbhash = hashes[i])[0]; },
+				[&](hash_pair_t& bbhash, const size_t){ return bbhash[1]; });
+		}
+
+		// batched lookup of the n keys at elems into res, where hash_0(bbhash, i) and hash_1(bbhash, i)
+		// provide the first two hashes of the i'th key of the current group, as h0 and h1 of the hasher
+		template <typename T_hash_0, typename T_hash_1>
+		void lookup_batch(const elem_t* elems, const size_t n, uint64_t* res, T_hash_0 hash_0, T_hash_1 hash_1)
+		{
+			static constexpr size_t group_sz = 64;
+
+			hash_pair_t bbhash[group_sz];
+			uint64_t level_hash[group_sz];
+			int hit_level[group_sz];
+			uint32_t active[group_sz];
+
+			if(! _built)
+			{
+				std::fill(res, res + n, ULLONG_MAX);
+				return;
+			}
+
+			for(size_t base = 0; base < n; base += group_sz)
+			{
+				const elem_t* const elem = elems + base;
+				uint64_t* const out = res + base;
+				const size_t m = std::min(group_sz, n - base);
+
+				for(size_t i = 0; i < m; i++)
+				{
+					active[i] = i;
+					hit_level[i] = -1;
+					level_hash[i] = hash_0(bbhash[i], base + i);
+					_levels[0].bitset.prefetch(fastrange64(level_hash[i], _levels[0].hash_domain));
+				}
+
+				size_t active_count = m;
+				for(int ii = 0; ii < (_nb_levels - 1) && active_count > 0; ii++)
+				{
+					size_t remaining = 0;
+					for(size_t j = 0; j < active_count; j++)
+					{
+						const uint32_t i = active[j];
+						const uint64_t pos = fastrange64(level_hash[i], _levels[ii].hash_domain);
+
+						if(_levels[ii].bitset.get(pos))
+						{
+							hit_level[i] = ii;
+							out[i] = pos;
+							_levels[ii].bitset.prefetch_rank(pos);
+						}
+						else
+						{
+							active[remaining++] = i;
+							if(ii + 1 < _nb_levels - 1)
+							{
+								level_hash[i] = (ii == 0 ? hash_1(bbhash[i], base + i) : _hasher.next(bbhash[i]));
+								_levels[ii + 1].bitset.prefetch(fastrange64(level_hash[i], _levels[ii + 1].hash_domain));
+							}
+						}
+					}
+
+					active_count = remaining;
+				}
+
+				//keys falling through all the levels are in the final exact hash
+				for(size_t j = 0; j < active_count; j++)
+				{
+					const uint32_t i = active[j];
+					auto in_final_map = _final_hash.find(elem[i]);
+					out[i] = (in_final_map == _final_hash.end() ? ULLONG_MAX : in_final_map->second + _lastbitsetrank);
+				}
+
+				for(size_t i = 0; i < m; i++)
+					if(hit_level[i] >= 0)
+						out[i] = _levels[hit_level[i]].bitset.rank(out[i]);
+			}
+		}
+
 		uint64_t nbKeys() const
 		{
             return _nelem;
         }
 
+		//the bit array of the first (and the largest) level
+		const uint64_t* firstLevelData() const
+		{
+			return _nb_levels > 0 ? _levels[0].bitset.data() : nullptr;
+		}
+
 		uint64_t totalBitSize()
 		{
 
@@ -1438,6 +1592,27 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 		}
 
 
+		//compute level and returns hash of last level reached, with the first two hashes precomputed into bbhash
+		uint64_t getLevel_hashed(hash_pair_t & bbhash, int * res_level)
+		{
+			int level = 0;
+			uint64_t hash_raw=0;
+
+			for (int ii = 0; ii<(_nb_levels-1); ii++ )
+			{
+				hash_raw = (ii < 2 ? bbhash[ii] : _hasher.next(bbhash));
+
+				if( _levels[ii].get(hash_raw) )
+					break;
+
+				level++;
+			}
+
+			*res_level = level;
+			return hash_raw;
+		}
+
+
 		//insert into bitarray
 		void insertIntoLevel(uint64_t level_hash, int i)
 		{
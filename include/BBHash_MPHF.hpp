@@ -0,0 +1,171 @@
+
+#ifndef BBHASH_MPHF_HPP
+#define BBHASH_MPHF_HPP
+
+
+
+#include "Kmer.hpp"
+#include "Kmer_Hasher.hpp"
+#include "BBHash/BooPHF.h"
+#include "Huge_Pages.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <iostream>
+
+
+template <uint16_t k> class Kmer_Container;
+
+
+// A minimal perfect hash function (MPHF) over k-mers, backed by BBHash.
+// Ref: Limasset et al. Fast and scalable minimal perfect hashing for massive key sets. SEA 2017.
+template <uint16_t k>
+class BBHash_MPHF
+{
+    typedef boomphf::mphf<Kmer<k>, Kmer_Hasher<k>> mphf_t;  // The BBHash function type.
+    typedef boomphf::hash_pair_t hash_pair_t;   // The first two hashes of a key in BBHash.
+
+private:
+
+    // Seeds of the first two hashes of the keys in BBHash; the hashes of the later levels
+    // are derived from these two.
+    static constexpr uint64_t seed_0 = 0xAAAAAAAA55555555ULL;
+    static constexpr uint64_t seed_1 = 0x33333333CCCCCCCCULL;
+
+    // Empiricial bits-per-key requirement for each gamma in the range (0, 10].
+    static constexpr double bits_per_gamma[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                3.06, 3.07, 3.11, 3.16, 3.22, 3.29, 3.36, 3.44, 3.53, 3.62,
+                                                3.71, 3.80, 3.90, 4.00, 4.10, 4.20, 4.30, 4.40, 4.50, 4.61,
+                                                4.71, 4.82, 4.92, 5.03, 5.13, 5.24, 5.35, 5.45, 5.56, 5.67,
+                                                5.78, 5.89, 6.00, 6.10, 6.21, 6.32, 6.43, 6.54, 6.65, 6.76,
+                                                6.87, 6.98, 7.09, 7.20, 7.31, 7.42, 7.53, 7.64, 7.75, 7.86,
+                                                7.97, 8.08, 8.20, 8.31, 8.42, 8.53, 8.64, 8.75, 8.86, 8.97,
+                                                9.08, 9.20, 9.31, 9.42, 9.53, 9.64, 9.75, 9.86, 9.98, 10.09,
+                                                10.20, 10.31, 10.42, 10.53, 10.64, 10.76, 10.87, 10.98, 11.09, 11.20,
+                                                11.31, 11.43, 11.54, 11.65, 11.76, 11.87, 11.99, 12.10, 12.21, 12.32,
+                                                12.43};
+
+    std::unique_ptr<mphf_t> mph;    // The BBHash function.
+
+    class Key_Array_Iterator;   // Iterator over an in-memory array of keys, in the form BBHash streams keys.
+
+
+public:
+
+    // The minimum gamma-value that we require for BBHash.
+    static constexpr double gamma_min = 2.0;
+
+    // The maximum gamma-value that we may use with BBHash.
+    static constexpr double gamma_max = 10.0;
+
+    // The resolution of gamma that we support.
+    static constexpr double gamma_resolution = 0.1;
+
+    // Estimated working memory (in bytes) per key of a build, besides the keys
+    // themselves: the bitvectors of the levels and their collisions.
+    static constexpr std::size_t build_bytes_per_key = 4;
+
+    // Returns the expected number of bits per key for the MPHF with gamma-value `gamma`.
+    static double bits_per_key(double gamma);
+
+    // Returns the maximum gamma-value for which the MPHF is expected to use at
+    // most `max_bits_per_key` bits per key.
+    static double gamma(double max_bits_per_key);
+
+    // Builds the MPHF over the k-mers present at the KMC database container
+    // `kmer_container`, using `thread_count` number of threads and the gamma-
+    // value `gamma`. Uses the directory at `working_dir_path` to store
+    // temporary files.
+    void build(const Kmer_Container<k>& kmer_container, uint16_t thread_count, const std::string& working_dir_path, double gamma);
+
+    // Builds the MPHF over the `n` k-mers at `kmers`, using `thread_count`
+    // number of threads and the gamma-value `gamma`. Uses the directory at
+    // `working_dir_path` to store temporary files.
+    void build(const Kmer<k>* kmers, std::size_t n, uint16_t thread_count, const std::string& working_dir_path, double gamma);
+
+    // Returns the value (in `[0, n)` for `n` keys) of the key `kmer`.
+    uint64_t lookup(const Kmer<k>& kmer) const;
+
+    // Returns the value of the key `kmer`, with `kmer_hash` as its rolling hash.
+    uint64_t lookup(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`. The lookups are
+    // batched and their memory accesses are prefetched, hence it is faster than
+    // `n` individual lookups.
+    void lookup(const Kmer<k>* kmers, std::size_t n, uint64_t* res) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`, with `kmer_hash` as
+    // the rolling hashes of the keys.
+    void lookup(const Kmer<k>* kmers, const Kmer_Rolling_Hash<k>* kmer_hash, std::size_t n, uint64_t* res) const;
+
+    // Prefetches the memory of the MPHF to be accessed first by the lookup of
+    // the key `kmer`, with `kmer_hash` as its rolling hash.
+    void prefetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Returns the size of the MPHF in bits.
+    uint64_t bit_size() const;
+
+    // Returns the page backing obtained for the bit array of the first level,
+    // i.e. the largest randomly accessed storage of the MPHF.
+    Page_Backing backing() const;
+
+    // Saves the MPHF into the stream `output`.
+    void save(std::ostream& output) const;
+
+    // Loads an MPHF from the file at path `file_path`. BBHash's structure is
+    // not laid out to be mapped, so it is always read fully; hence `populate`
+    // is ignored.
+    void load(const std::string& file_path, bool populate = false);
+};
+
+
+template <uint16_t k>
+inline uint64_t BBHash_MPHF<k>::lookup(const Kmer<k>& kmer) const
+{
+    return mph->lookup(kmer);
+}
+
+
+template <uint16_t k>
+inline uint64_t BBHash_MPHF<k>::lookup(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    return mph->lookup(kmer, hash_pair_t{kmer_hash(seed_0), kmer_hash(seed_1)});
+}
+
+
+template <uint16_t k>
+inline void BBHash_MPHF<k>::lookup(const Kmer<k>* const kmers, const std::size_t n, uint64_t* const res) const
+{
+    mph->lookup(kmers, n, res);
+}
+
+
+template <uint16_t k>
+inline void BBHash_MPHF<k>::lookup(const Kmer<k>* const kmers, const Kmer_Rolling_Hash<k>* const kmer_hash, const std::size_t n, uint64_t* const res) const
+{
+    constexpr std::size_t batch_size = 64;  // Number of keys whose hashes are materialized at a time.
+    hash_pair_t h[batch_size];
+
+    for(std::size_t batch = 0; batch < n; batch += batch_size)
+    {
+        const std::size_t count = std::min(batch_size, n - batch);
+        for(std::size_t i = 0; i < count; ++i)
+            h[i] = {kmer_hash[batch + i](seed_0), kmer_hash[batch + i](seed_1)};
+
+        mph->lookup(kmers + batch, h, count, res + batch);
+    }
+}
+
+
+template <uint16_t k>
+inline void BBHash_MPHF<k>::prefetch(const Kmer<k>&, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    mph->prefetch(hash_pair_t{kmer_hash(seed_0), 0});
+}
+
+
+
+#endif
@@ -0,0 +1,109 @@
+
+#ifndef BGZF_READER_HPP
+#define BGZF_READER_HPP
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+// A reader for BGZF-compressed files, i.e. concatenations of independent gzip blocks
+// each holding at most 64 KB of data, that inflates the blocks in parallel. A
+// background thread reads the compressed blocks off the file into a ring of slots,
+// a number of worker threads inflate those, and the reader hands over the inflated
+// blocks in their order in the file.
+// Reference: https://samtools.github.io/hts-specs/SAMv1.pdf (section 4.1)
+class BGZF_Reader
+{
+private:
+
+    // A BGZF block and its state in the ring.
+    struct Block
+    {
+        enum class State: uint8_t
+        {
+            empty,  // the slot is free;
+            read,   // the compressed block has been read into the slot;
+            inflated    // the block has been inflated.
+        };
+
+        std::vector<uint8_t> in;    // The compressed block.
+        std::vector<char> out;  // The inflated block.
+        State state = State::empty;
+    };
+
+    static constexpr std::size_t SLOTS_PER_THREAD = 8;  // Number of block slots in the ring per worker thread.
+    static constexpr std::size_t HEADER_SIZE = 12;  // Size of the fixed part of a gzip header, up-to the extra field length.
+    static constexpr std::size_t FOOTER_SIZE = 8;   // Size of a gzip footer: CRC32 and the inflated size.
+
+    const std::string file_path;    // Path to the file.
+    std::FILE* file_ptr;    // Pointer to the file.
+
+    const std::size_t slot_count;   // Number of block slots in the ring.
+    std::unique_ptr<Block[]> block; // Ring of the block slots.
+
+    uint64_t blocks_read = 0;   // Number of blocks read off the file.
+    uint64_t blocks_claimed = 0;    // Number of blocks claimed by the worker threads for inflation.
+    uint64_t blocks_consumed = 0;   // Number of blocks handed over completely from the reader.
+    bool eof = false;   // Whether all the blocks have been read off the file.
+    bool stop = false;  // Whether the reading and the inflation are to be stopped.
+
+    std::mutex mutex_;  // Mutex guarding the ring.
+    std::condition_variable slot_freed; // Condition of some slot being freed.
+    std::condition_variable block_read; // Condition of some block being read, or of the end of the file.
+    std::condition_variable block_inflated; // Condition of some block being inflated, or of the end of the file.
+
+    std::unique_ptr<std::thread> disk_reader;   // The thread reading the compressed blocks off the file.
+    std::vector<std::thread> inflater;  // The threads inflating the blocks.
+
+    std::size_t out_pos = 0;    // Position of the next byte to hand over from the current block.
+    bool curr_block = false;    // Whether the current block is present at the head of the ring.
+
+
+    // Reads the next compressed block off the file into `buf`. Returns `false` iff the
+    // file has no more blocks.
+    bool read_block(std::vector<uint8_t>& buf);
+
+    // Inflates the compressed block `in` into `out`.
+    void inflate_block(const std::vector<uint8_t>& in, std::vector<char>& out) const;
+
+    // Reads the compressed blocks off the file into the ring, until the end of the file.
+    void read_blocks();
+
+    // Inflates the blocks read into the ring, until the end of the file.
+    void inflate_blocks();
+
+    // Searches the BGZF block-size subfield in the gzip extra field `extra` of size `xlen`.
+    // Returns `true` iff it's found, in which case the size of the block is put into
+    // `block_size`.
+    static bool parse_block_size(const uint8_t* extra, std::size_t xlen, std::size_t& block_size);
+
+
+public:
+
+    // Constructs a reader for the BGZF file at path `file_path`, inflating its blocks
+    // with `thread_count` threads.
+    BGZF_Reader(const std::string& file_path, uint16_t thread_count);
+
+    // Destructs the reader, stopping its threads.
+    ~BGZF_Reader();
+
+    // Returns `true` iff the file at path `file_path` is a BGZF file.
+    static bool is_BGZF(const std::string& file_path);
+
+    // Reads up-to `len` bytes of the inflated content into `buf`. Returns the number of
+    // bytes read; `0` is returned iff the content has been read completely.
+    int read(void* buf, unsigned len);
+};
+
+
+
+#endif
@@ -40,6 +40,12 @@ private:
     const bool save_mph_;   // Option to save the MPH over the vertex set of the de Bruijn graph.
     const bool save_buckets_;   // Option to save the DFA-states collection of the vertices of the de Bruijn graph.
     const bool save_vertices_;  // Option to save the vertex set of the de Bruijn graph (in KMC database format).
+    const bool populate_loads_; // Option to read saved MPHF and DFA-states files fully into memory at load, instead of on-demand.
+    const bool explicit_huge_pages_;    // Option to back the hash table with explicitly reserved (hugetlbfs) huge pages, if available.
+    const uint64_t partition_count_;    // Number of minimizer-partitions of the hash table.
+    const bool in_memory_dbs_;  // Option to keep the edge and the vertex databases in memory (at a RAM-backed directory).
+    const bool cache_refs_; // Option to cache the 2-bit encoded references from the first pass over them, for the later passes.
+    const bool direct_io_;  // Option to write the output with direct I/O, bypassing the page cache.
 #ifdef CF_DEVELOP_MODE
     const double gamma_;    // The gamma parameter for the BBHash MPHF.
 #endif
@@ -94,7 +100,13 @@ public:
                     bool path_cover,
                     bool save_mph,
                     bool save_buckets,
-                    bool save_vertices
+                    bool save_vertices,
+                    bool populate_loads,
+                    bool explicit_huge_pages,
+                    uint64_t partition_count,
+                    bool in_memory_dbs,
+                    bool cache_refs,
+                    bool direct_io
 #ifdef CF_DEVELOP_MODE
                     , double gamma
 #endif
@@ -267,6 +279,48 @@ public:
     }
 
 
+    // Returns whether the option to read saved MPHF and DFA-states files fully into memory at load is specified or not.
+    bool populate_loads() const
+    {
+        return populate_loads_;
+    }
+
+
+    // Returns whether the option to back the hash table with explicitly reserved (hugetlbfs) huge pages is specified or not.
+    bool explicit_huge_pages() const
+    {
+        return explicit_huge_pages_;
+    }
+
+
+    // Returns the number of minimizer-partitions of the hash table.
+    uint64_t partition_count() const
+    {
+        return partition_count_;
+    }
+
+
+    // Returns whether the option to keep the edge and the vertex databases in memory is specified or not.
+    bool in_memory_dbs() const
+    {
+        return in_memory_dbs_;
+    }
+
+
+    // Returns whether the option to cache the 2-bit encoded references from the first pass over them is specified or not.
+    bool cache_refs() const
+    {
+        return cache_refs_;
+    }
+
+
+    // Returns whether the option to write the output with direct I/O is specified or not.
+    bool direct_io() const
+    {
+        return direct_io_;
+    }
+
+
     // Returns the path to the optional file storing meta-information about the graph and cuttlefish executions.
     const std::string json_file_path() const
     {
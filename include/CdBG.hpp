@@ -10,6 +10,7 @@
 #include "Data_Logistics.hpp"
 #include "Unipaths_Meta_info.hpp"
 #include "dBG_Info.hpp"
+#include "Parallel_Writer.hpp"
 #include "spdlog/sinks/basic_file_sink.h"
 
 #include <cstdint>
@@ -20,11 +21,13 @@
 #include <utility>
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY> class Kmer_Hash_Table;
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_> class Kmer_Hash_Table;
 template <uint16_t k> class Directed_Kmer;
 template <uint16_t k> class Annotated_Kmer;
 template <uint16_t k> class kmer_Enumeration_Stats;
-template <uint16_t k> class Thread_Pool;
+class Thread_Pool;
+class Sequence_Batch;
+class Ref_Cache;
 template <typename T_id_, typename T_info_> class Job_Queue;
 
 
@@ -32,8 +35,6 @@ template <typename T_id_, typename T_info_> class Job_Queue;
 template <uint16_t k>
 class CdBG
 {
-    friend class Thread_Pool<k>;
-
 private:
 
     const Build_Params params;    // Required parameters wrapped in one object.
@@ -45,12 +46,31 @@ private:
 
     dBG_Info<k> dbg_info;   // Wrapper object for structural information of the graph.
 
+    std::unique_ptr<Ref_Cache> ref_cache;   // Cache of the 2-bit encoded references from the classification pass, for the output pass.
+
     static constexpr double bits_per_vertex = 8.71; // Expected number of bits required per vertex by Cuttlefish 2.
     static constexpr std::size_t parser_memory = 256 * 1024U * 1024U;   // An empirical estimation of the memory used by the sequence parser. 256 MB.
 
     // Minimum size of a partition to be processed by one thread.
     static constexpr uint16_t PARTITION_SIZE_THRESHOLD = 1;
 
+    // Maximum number of k-mers in a range of a sequence to be processed as one task, unless
+    // no thread is idle to take over parts of it.
+    static constexpr std::size_t TASK_GRAIN_SIZE = 64 * 1024;
+
+    // Sequences shorter than this are batched together, up-to this many bases, to be processed as one task.
+    static constexpr std::size_t BATCH_SIZE_THRESHOLD = TASK_GRAIN_SIZE;
+
+    // Up-to one in this many threads (`-t`) parses the references in the background—reading the
+    // reference files, concurrently for multi-file collections, and inflating BGZF files; the rest
+    // process the parsed sequences. The parser is reserved only the threads it can put to use: a
+    // reader per reference file, and more only for the inflaters of BGZF files.
+    static constexpr uint16_t REF_PARSER_THREAD_SHARE = 4;
+
+
+    // Number of k-mers whose hash table lookups are batched together during classification.
+    static constexpr std::size_t kmer_batch_size = 64;
+
     // `output_buffer[t_id]` holds output content yet to be written to the disk from thread number `t_id`.
     std::vector<std::string> output_buffer;
 
@@ -62,7 +82,10 @@ private:
     std::vector<uint64_t> link_added;
 
     // Capacities for the memory pre-allocation of each output buffer, and the threshold buffer size
-    // that triggers a disk-flush.
+    // that triggers a disk-flush. The buffers are flushed into the shared output writer, which holds
+    // `Parallel_Writer::memory()` bytes (64 MB) of blocks while open, on top of the buffers, and runs
+    // a background thread beyond the thread count; the blocks are counted against the memory budget
+    // in `ref_cache_memory()`.
     static constexpr size_t BUFFER_THRESHOLD = 100 * 1024;  // 100 KB.
     static constexpr size_t BUFFER_CAPACITY = 1.1 * BUFFER_THRESHOLD;   // 110% of the buffer threshold.
 
@@ -72,19 +95,13 @@ private:
     // Number of backing worker threads for `spdlog`, i.e. the threads that actually make the writes to sink.
     static constexpr uint16_t ASYNC_LOG_N_THREADS = 1;
 
-    // `spdlog` thread pool for outputting unitigs (or GFA segments and connections).
-    std::shared_ptr<spdlog::details::thread_pool> tp_output;
-
     // `spdlog` thread pool for outputting GFA paths.
     std::shared_ptr<spdlog::details::thread_pool> tp_path;
 
     typedef std::shared_ptr<spdlog::logger> logger_t;
 
-    // The asynchronous output logger (for GFA segments and connections).
-    logger_t output;
-
-    // Copies of the asynchronous logger `output` for each thread.
-    std::vector<logger_t> output_;
+    // The output writer (for unitigs, or GFA segments and connections), shared by the threads.
+    Parallel_Writer output;
 
     // `path_output_[t_id]` and `overlap_output_[t_id]` are the output loggers for the paths
     // and the overlaps between the links in the paths respectively, produced from the
@@ -117,6 +134,18 @@ private:
     // NB: only the existence of the output meta-info file is checked for this purpose.
     bool is_constructed() const;
 
+    // Returns the number of background threads parsing the references, out of the `-t` threads;
+    // it is sized to the reference input, and to the state of the reference cache.
+    uint16_t ref_parser_thread_count() const;
+
+    // Returns the number of threads processing the parsed sequences, out of the `-t` threads.
+    uint16_t worker_thread_count() const;
+
+    // Returns the memory limit (in bytes) for the cache of the 2-bit encoded references,
+    // beyond which it's spilled to the working directory: the memory budget left from the
+    // hash table, the sequence parser, the output writer, and an in-memory vertex database.
+    std::size_t ref_cache_memory() const;
+
     // Enumerates the vertices of the de Bruijn graph and returns summary statistics of the
     // enumearation.
     kmer_Enumeration_Stats<k> enumerate_vertices() const;
@@ -130,12 +159,17 @@ private:
     void classify_vertices();
 
     // Returns the maximum temporary disk-usage incurred by some execution of the algorithm,
-    // that has its vertices-enumeration stats in `vertex_stats`.
-    static std::size_t max_disk_usage(const kmer_Enumeration_Stats<k>& vertex_stats);
+    // that has its vertices-enumeration stats in `vertex_stats`. A vertex database kept in
+    // memory does not count towards it.
+    std::size_t max_disk_usage(const kmer_Enumeration_Stats<k>& vertex_stats) const;
 
     // Distributes the classification task for the sequence `seq` of length
     // `seq_len` to the thread pool `thread_pool`.
-    void distribute_classification(const char* seq, size_t seq_len, Thread_Pool<k>& thread_pool);
+    void distribute_classification(const char* seq, size_t seq_len, Thread_Pool& thread_pool);
+
+    // Distributes the classification task for the batch of sequences `batch` to the
+    // thread pool `thread_pool` as one task, and clears the batch.
+    void distribute_classification(Sequence_Batch& batch, Thread_Pool& thread_pool);
 
     // Processes classification of the valid k-mers present at the sequence `seq`
     // (of length `seq_len`) that have their starting indices between (inclusive)
@@ -158,31 +192,36 @@ private:
     // processed subsequence, i.e. the index following the end of it.
     size_t process_contiguous_subseq(const char* seq, size_t seq_len, size_t right_end, size_t start_idx);
 
-    // Processes classification for the directed version `kmer` of some k-mer
-    // in the sequence that is isolated, i.e. does not have any adjacent k-mers.
+    // Computes the hash table buckets of the canonical versions of the `count`
+    // (at most `kmer_batch_size`) consecutive valid k-mers of the sequence `seq`
+    // starting at the index `start_idx`, into `bucket`; and prefetches them.
+    void fetch_buckets(const char* seq, size_t start_idx, size_t count, uint64_t* bucket) const;
+
+    // Processes classification for some k-mer in the sequence, with hash table
+    // bucket `bucket`, that is isolated, i.e. does not have any adjacent k-mers.
     // Returns `false` iff an attempted state transition for the k-mer failed.
-    bool process_isolated_kmer(const Directed_Kmer<k>& kmer);
+    bool process_isolated_kmer(uint64_t bucket);
 
     // Processes classification (partially) for the directed version `kmer` of
     // the first k-mer in some sequence, where the directed version of the next
     // k-mer in the sequence is `next_kmer`, and the base character succeeding
-    // the first k-mer is `next_char`. Returns `false` iff an attempted state
-    // transition for the k-mer failed.
-    bool process_leftmost_kmer(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>& next_kmer, char next_char);
+    // the first k-mer is `next_char`. `bucket` is the hash table bucket of the
+    // k-mer. Returns `false` iff an attempted state transition for the k-mer failed.
+    bool process_leftmost_kmer(const Directed_Kmer<k>& kmer, uint64_t bucket, const Directed_Kmer<k>& next_kmer, char next_char);
 
     // Processes classification (partially) for the directed version `kmer` of
     // the last k-mer in some sequence, where the base character preceding the
-    // last k-mer is `prev_char`. Returns `false` iff an attempted state transition
-    // for the k-mer failed.
-    bool process_rightmost_kmer(const Directed_Kmer<k>& kmer, char prev_char);
+    // last k-mer is `prev_char`. `bucket` is the hash table bucket of the k-mer.
+    // Returns `false` iff an attempted state transition for the k-mer failed.
+    bool process_rightmost_kmer(const Directed_Kmer<k>& kmer, uint64_t bucket, char prev_char);
 
     // Processes classification (partially) for the directed version `kmer` of
     // some internal k-mer in some sequence, where the directed version of the
     // next k-mer in the sequence is `next_kmer`, the base character preceding
     // the k-mer is `prev_char`, and the base character succeeding the k-mer is
-    // `next_char`. Returns `false` iff an attempted state transition for the
-    // k-mer failed.
-    bool process_internal_kmer(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>& next_kmer, char prev_char, char next_char);
+    // `next_char`. `bucket` is the hash table bucket of the k-mer. Returns
+    // `false` iff an attempted state transition for the k-mer failed.
+    bool process_internal_kmer(const Directed_Kmer<k>& kmer, uint64_t bucket, const Directed_Kmer<k>& next_kmer, char prev_char, char next_char);
 
     // Returns a Boolean denoting whether the canonical k-mer `kmer_hat` forms a
     // self loop with the canonical k-mer `next_kmer_hat` in the sequence. This
@@ -192,9 +231,10 @@ private:
     // Processes (partial) classification for the directed version `kmer` of
     // some k-mer in a sequence that forms a self-loop with its next k-mer in
     // the sequence. The directed version of the next k-mer is `next_kmer`, and
-    // the base character preceding the k-mer is `prev_char`. Returns `false`
-    // iff an attempted state transition for the k-mer failed.
-    bool process_loop(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>& next_kmer, char prev_char = 0);
+    // the base character preceding the k-mer is `prev_char`. `bucket` is the
+    // hash table bucket of the k-mer. Returns `false` iff an attempted state
+    // transition for the k-mer failed.
+    bool process_loop(const Directed_Kmer<k>& kmer, uint64_t bucket, const Directed_Kmer<k>& next_kmer, char prev_char = 0);
 
 
     /* Writer methods */
@@ -208,7 +248,12 @@ private:
 
     // Distributes the outputting task of the maximal unitigs in plain format for
     // the sequence `seq` of length `seq_len` to the thread pool `thread_pool`.
-    void distribute_output_plain(const char* seq, size_t seq_len, Thread_Pool<k>& thread_pool);
+    void distribute_output_plain(const char* seq, size_t seq_len, Thread_Pool& thread_pool);
+
+    // Distributes the outputting task of the maximal unitigs in plain format for the
+    // batch of sequences `batch` to the thread pool `thread_pool` as one task, and
+    // clears the batch.
+    void distribute_output_plain(Sequence_Batch& batch, Thread_Pool& thread_pool);
 
     // Outputs the distinct maximal unitigs (in canonical form) of the compacted de
     // Bruijn graph in GFA format.
@@ -216,7 +261,7 @@ private:
 
     // Distributes the outputting task of the maximal unitigs in GFA format for
     // the sequence `seq` of length `seq_len` to the thread pool `thread_pool`.
-    void distribute_output_gfa(const char* seq, size_t seq_len, Thread_Pool<k>& thread_pool);
+    void distribute_output_gfa(const char* seq, size_t seq_len, Thread_Pool& thread_pool);
 
     // Outputs the distinct maximal unitigs (in canonical form) of the compacted de
     // Bruijn graph in a GFA-reduced format.
@@ -224,7 +269,7 @@ private:
 
     // Distributes the outputting task of the maximal unitigs in a GFA-reduced
     // format for the sequence `seq` of length `seq_len` to the thread pool `thread_pool`.
-    void distribute_output_gfa_reduced(const char* seq, size_t seq_len, Thread_Pool<k>& thread_pool);
+    void distribute_output_gfa_reduced(const char* seq, size_t seq_len, Thread_Pool& thread_pool);
 
     // Clears the output file content.
     void clear_output_file() const;
@@ -232,8 +277,11 @@ private:
     // Sets a unique prefix for the temporary files to be used during GFA output.
     void set_temp_file_prefixes(const std::string& working_dir);
 
-    // Initializes the output logger of each thread.
-    void init_output_loggers();
+    // Opens the output writer, appending to the output file.
+    void open_output_writer();
+
+    // Closes the output writer, writing out all the output put to it.
+    void close_output_writer();
 
     // Resets the path output streams (depending on the GFA version) for each
     // thread. Needs to be invoked before processing each new sequence. The
@@ -393,20 +441,23 @@ private:
 
     // Ensures that the string `buf` has enough free space to append a log of length
     // `log_len` at its end without overflowing its capacity by flushing its content
-    // to the logger `log` if necessary. The request is non-binding in the sense that
+    // to the writer `sink` if necessary. The request is non-binding in the sense that
     // if the capacity of the buffer `buf` is smaller than `log_len`, then this method
     // does not ensure enough buffer space.
-    static void ensure_buffer_space(std::string& buf, size_t log_len, const logger_t& log);
+    static void ensure_buffer_space(std::string& buf, size_t log_len, Parallel_Writer& sink);
 
     // Writes the string `str` to the logger `log`, and empties `str`.
     static void flush_buffer(std::string& str, const logger_t& log);
 
+    // Writes the string `str` to the writer `sink`, and empties `str`.
+    static void flush_buffer(std::string& str, Parallel_Writer& sink);
+
     // Puts the content of the string `str` to the logger `log`.
     static void write(const std::string& str, const logger_t& log);
 
     // Checks the output buffer for the thread number `thread_id`. If the buffer
     // size exceeds `BUFFER_THRESHOLD`, then the buffer content is put into the
-    // corresponding logger of the thread, and the buffer is emptied.
+    // output writer, and the buffer is emptied.
     void check_output_buffer(uint16_t thread_id);
 
     // Checks the path buffer (and overlap buffer if using GFA1). If the buffer
@@ -420,16 +471,10 @@ private:
     // Flushes the path buffers (one for each thread).
     void flush_path_buffers();
 
-    // Flushes (non-blocking) all the loggers (output, path, and overlap (GFA1-specific)).
-    void flush_loggers();   // TODO: Make it const after removing timing profiles.
-
-    // Flushes (non-blocking) the output (segments and connections) logger.
-    void flush_output_logger();
-
     // Flushes (non-blocking) GFA path-output specific loggers.
     void flush_path_loggers();
 
-    // Closes (shuts down) all the loggers, with required flushing as necessary.
+    // Closes (shuts down) all the loggers and the output writer, with required flushing as necessary.
     void close_loggers();
 
     // Closes the path-output specific loggers, with required flushing as necessary.
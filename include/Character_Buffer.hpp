@@ -6,6 +6,7 @@
 
 #include "Spin_Lock.hpp"
 #include "Async_Logger_Wrapper.hpp"
+#include "Parallel_Writer.hpp"
 #include "FASTA_Record.hpp"
 
 #include <cstdint>
@@ -60,6 +61,12 @@ public:
     template <uint16_t k, typename T_container_>
     void rotate_append_cycle(const FASTA_Record<T_container_>& fasta_cycle, std::size_t pivot);
 
+    // Appends a FASTA record with the identifier `id` and a sequence of length `seq_len`
+    // to the buffer, where the sequence is written into the buffer by `append_seq`,
+    // directly from its source. Flushes are possible.
+    template <typename T_seq_writer_>
+    void append_fasta_rec(uint64_t id, std::size_t seq_len, const T_seq_writer_& append_seq);
+
     // Destructs the buffer object, flushing it if content are present.
     ~Character_Buffer();
 };
@@ -112,6 +119,18 @@ private:
 };
 
 
+template <>
+class Character_Buffer_Flusher<Parallel_Writer>
+{
+    template <std::size_t, typename> friend class Character_Buffer;
+
+private:
+
+    // Writes the content of the vector `buf` to the sink `sink`.
+    static void write(const std::vector<char>& buf, Parallel_Writer& sink);
+};
+
+
 template <std::size_t CAPACITY, typename T_sink_>
 inline Character_Buffer<CAPACITY, T_sink_>::Character_Buffer(T_sink_& sink):
     sink(sink)
@@ -157,6 +176,21 @@ inline void Character_Buffer<CAPACITY, T_sink_>::rotate_append_cycle(const FASTA
 }
 
 
+template <std::size_t CAPACITY, typename T_sink_>
+template <typename T_seq_writer_>
+inline void Character_Buffer<CAPACITY, T_sink_>::append_fasta_rec(const uint64_t id, const std::size_t seq_len, const T_seq_writer_& append_seq)
+{
+    const fmt::format_int header(id);
+    ensure_space(1 + header.size() + 1 + seq_len + 1);  // One extra byte for `>`, and two for the line-breaks.
+
+    buffer.emplace_back('>');   // Append the header.
+    buffer.insert(buffer.end(), header.data(), header.data() + header.size());
+    buffer.emplace_back('\n');  // Break line.
+    append_seq(buffer); // Append the sequence.
+    buffer.emplace_back('\n');  // Break line.
+}
+
+
 template <std::size_t CAPACITY, typename T_sink_>
 inline void Character_Buffer<CAPACITY, T_sink_>::ensure_space(const std::size_t append_size)
 {
@@ -217,4 +251,10 @@ inline void Character_Buffer_Flusher<Async_Logger_Wrapper>::write(std::vector<ch
 }
 
 
+inline void Character_Buffer_Flusher<Parallel_Writer>::write(const std::vector<char>& buf, Parallel_Writer& sink)
+{
+    sink.write(buf.data(), buf.size());
+}
+
+
 #endif
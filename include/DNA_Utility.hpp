@@ -9,6 +9,10 @@
 #include <cstdint>
 #include <cstddef>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 
 class DNA_Utility
 {
@@ -100,6 +104,14 @@ private:
         DNA::Base::N, DNA::Base::A, DNA::Base::C, DNA::Base::G, DNA::Base::T
     };
 
+    // Returns the index of the first character in `seq` of length `len` that is a
+    // placeholder iff `T_placeholder_` is `true`, or that is a base otherwise. Returns
+    // `len` if there is no such character. Blocks of 32 (with AVX2) or 16 (with SSE2)
+    // characters are classified together: a character is a base iff its upper-cased
+    // value is one of `A`, `C`, `G`, and `T`.
+    template <bool T_placeholder_>
+    static std::size_t find_first(const char* seq, std::size_t len);
+
 
 public:
 
@@ -133,6 +145,20 @@ public:
         return IS_PLACEHOLDER[uint8_t(base)];
     }
 
+    // Returns the index of the first placeholder character in `seq` of length `len`,
+    // or `len` if there is none.
+    static std::size_t find_placeholder(const char* const seq, const std::size_t len)
+    {
+        return find_first<true>(seq, len);
+    }
+
+    // Returns the index of the first base (i.e. non-placeholder) character in `seq` of
+    // length `len`, or `len` if there is none.
+    static std::size_t find_base(const char* const seq, const std::size_t len)
+    {
+        return find_first<false>(seq, len);
+    }
+
     // Returns the upper-case equivalent of the character `base`.
     static char upper(const char base)
     {
@@ -155,5 +181,44 @@ public:
 };
 
 
+template <bool T_placeholder_>
+inline std::size_t DNA_Utility::find_first(const char* const seq, const std::size_t len)
+{
+    std::size_t idx = 0;
+
+#if defined(__AVX2__)
+    const __m256i upper_mask = _mm256_set1_epi8(static_cast<char>(0xDF));
+    for(; idx + 32 <= len; idx += 32)
+    {
+        const __m256i upper = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(seq + idx)), upper_mask);
+        const __m256i is_base = _mm256_or_si256(
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(upper, _mm256_set1_epi8('A')), _mm256_cmpeq_epi8(upper, _mm256_set1_epi8('C'))),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(upper, _mm256_set1_epi8('G')), _mm256_cmpeq_epi8(upper, _mm256_set1_epi8('T'))));
+        const uint32_t base_bits = static_cast<uint32_t>(_mm256_movemask_epi8(is_base));
+        const uint32_t hit = (T_placeholder_ ? ~base_bits : base_bits);
+        if(hit)
+            return idx + __builtin_ctz(hit);
+    }
+#elif defined(__SSE2__)
+    const __m128i upper_mask = _mm_set1_epi8(static_cast<char>(0xDF));
+    for(; idx + 16 <= len; idx += 16)
+    {
+        const __m128i upper = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(seq + idx)), upper_mask);
+        const __m128i is_base = _mm_or_si128(
+                                    _mm_or_si128(_mm_cmpeq_epi8(upper, _mm_set1_epi8('A')), _mm_cmpeq_epi8(upper, _mm_set1_epi8('C'))),
+                                    _mm_or_si128(_mm_cmpeq_epi8(upper, _mm_set1_epi8('G')), _mm_cmpeq_epi8(upper, _mm_set1_epi8('T'))));
+        const uint32_t base_bits = static_cast<uint32_t>(_mm_movemask_epi8(is_base));
+        const uint32_t hit = (T_placeholder_ ? ~base_bits & 0xFFFFU : base_bits);
+        if(hit)
+            return idx + __builtin_ctz(hit);
+    }
+#endif
+
+    for(; idx < len && is_placeholder(seq[idx]) != T_placeholder_; ++idx);
+
+    return idx;
+}
+
+
 
 #endif
@@ -18,6 +18,7 @@ class Data_Logistics
 private:
 
     const Build_Params& params;    // The construction parameters passed to Cuttlefish.
+    const std::string run_id;   // Identifier of this execution, distinguishing its temporary files from those of concurrent ones.
 
 
 public:
@@ -31,12 +32,24 @@ public:
     // Returns the path prefix for temporary files used by Cuttlefish.
     const std::string working_dir_path() const;
 
+    // Returns the path prefix for the temporary files private to this execution.
+    const std::string temp_file_prefix() const;
+
+    // Returns whether the edge database is kept in memory, i.e. at a RAM-backed directory.
+    bool in_memory_edge_db() const;
+
+    // Returns whether the vertex database is kept in memory, i.e. at a RAM-backed directory.
+    bool in_memory_vertex_db() const;
+
     // Returns the path prefix to the edge database being used by Cuttlefish.
     const std::string edge_db_path() const;
 
     // Returns the path prefix to the vertex database being used by Cuttlefish.
     const std::string vertex_db_path() const;
 
+    // Returns the path to the file that the reference cache is spilled to, if it is.
+    const std::string ref_cache_path() const;
+
     // Returns the path to the final output file by Cuttlefish.
     const std::string output_file_path() const;
 };
@@ -24,11 +24,16 @@ private:
     Kmer<k> kmer_;  // The observed k-mer for the vertex.
     Kmer<k> kmer_bar_;  // Reverse complement of the k-mer observed for the vertex.
     const Kmer<k>* kmer_hat_ptr;    // Pointer to the canonical form of the k-mer associated to the vertex.
+    Kmer_Rolling_Hash<k> kmer_hash; // Rolling hash of the k-mer observed for the vertex.
     uint64_t h; // Hash value of the vertex, i.e. hash of the canonical k-mer.
 
     // Initialize the data of the class once the observed k-mer `kmer_` is set.
     void init(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Initialize the data of the class, except the hash value, once the observed
+    // k-mer `kmer_` is set.
+    void init();
+
 
 public:
 
@@ -61,6 +66,21 @@ public:
     // and uses the hash table `hash` to get the hash value of the vertex.
     void from_suffix(const Kmer<k + 1>& e, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Configures the vertex with the k-mer `v`, without its hash value. The hash value must
+    // be set later through `set_hash`.
+    void from_kmer(const Kmer<k>& v);
+
+    // Configures the vertex with the source (i.e. prefix) k-mer of the edge (k + 1)-mer `e`,
+    // without its hash value. The hash value must be set later through `set_hash`.
+    void from_prefix(const Kmer<k + 1>& e);
+
+    // Configures the vertex with the sink (i.e. suffix) k-mer of the edge (k + 1)-mer `e`,
+    // without its hash value. The hash value must be set later through `set_hash`.
+    void from_suffix(const Kmer<k + 1>& e);
+
+    // Sets the hash value of the vertex to `h`.
+    void set_hash(uint64_t h);
+
     // Returns the observed k-mer for the vertex.
     const Kmer<k>& kmer() const;
 
@@ -73,12 +93,20 @@ public:
     // Returns the hash value of the vertex.
     uint64_t hash() const;
 
+    // Returns the rolling hash of the k-mer observed for the vertex.
+    const Kmer_Rolling_Hash<k>& rolling_hash() const;
+
     // Transforms this vertex to another by chopping off the first base from the associated
     // observed k-mer, and appending the nucleobase `b` to the end, i.e. effecitively
     // rolling the associated k-mer by one base "forward". The hash table `hash` is used
     // to get the hash value of the new vertex.
     void roll_forward(cuttlefish::base_t b, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Rolls the associated k-mer by one base forward, appending the nucleobase `b`, as per
+    // the above; without the hash value of the new vertex. The hash value must be set later
+    // through `set_hash`.
+    void roll_forward(cuttlefish::base_t b);
+
     // Returns the side of the vertex which is to be the incidence side of some bidirected
     // edge instance if this vertex instance were to be the source vertex (i.e. prefix k-mer)
     // of that edge.
@@ -97,11 +125,19 @@ public:
 
 template <uint16_t k>
 inline void Directed_Vertex<k>::init(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash)
+{
+    init();
+
+    h = hash(*kmer_hat_ptr, kmer_hash);
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::init()
 {
     kmer_bar_.as_reverse_complement(kmer_);
     kmer_hat_ptr = Kmer<k>::canonical(kmer_, kmer_bar_);
-
-    h = hash(*kmer_hat_ptr);
+    kmer_hash = kmer_.rolling_hash(kmer_bar_);
 }
 
 
@@ -118,6 +154,7 @@ inline Directed_Vertex<k>::Directed_Vertex(const Directed_Vertex<k>& rhs):
     kmer_(rhs.kmer_),
     kmer_bar_(rhs.kmer_bar_),
     kmer_hat_ptr(rhs.kmer_hat_ptr == &rhs.kmer_ ? &kmer_ : &kmer_bar_),
+    kmer_hash(rhs.kmer_hash),
     h(rhs.h)
 {}
 
@@ -128,6 +165,7 @@ inline const Directed_Vertex<k>& Directed_Vertex<k>::operator=(const Directed_Ve
     kmer_ = rhs.kmer_;
     kmer_bar_ = rhs.kmer_bar_;
     kmer_hat_ptr = (rhs.kmer_hat_ptr == &rhs.kmer_ ? &kmer_ : &kmer_bar_);
+    kmer_hash = rhs.kmer_hash;
     h = rhs.h;
 
     return *this;
@@ -165,6 +203,37 @@ inline void Directed_Vertex<k>::from_suffix(const Kmer<k + 1>& e, const Kmer_Has
 }
 
 
+template <uint16_t k>
+inline void Directed_Vertex<k>::from_kmer(const Kmer<k>& v)
+{
+    kmer_ = v;
+    init();
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::from_prefix(const Kmer<k + 1>& e)
+{
+    kmer_.from_prefix(e);
+    init();
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::from_suffix(const Kmer<k + 1>& e)
+{
+    kmer_.from_suffix(e);
+    init();
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::set_hash(const uint64_t h)
+{
+    this->h = h;
+}
+
+
 template <uint16_t k>
 inline const Kmer<k>& Directed_Vertex<k>::kmer() const
 {
@@ -193,13 +262,30 @@ inline uint64_t Directed_Vertex<k>::hash() const
 }
 
 
+template <uint16_t k>
+inline const Kmer_Rolling_Hash<k>& Directed_Vertex<k>::rolling_hash() const
+{
+    return kmer_hash;
+}
+
+
 template <uint16_t k>
 inline void Directed_Vertex<k>::roll_forward(const cuttlefish::base_t b, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash)
 {
+    kmer_hash.roll(kmer_.front(), b);
     kmer_.roll_to_next_kmer(b, kmer_bar_);
     kmer_hat_ptr = Kmer<k>::canonical(kmer_, kmer_bar_);
 
-    h = hash(*kmer_hat_ptr);
+    h = hash(*kmer_hat_ptr, kmer_hash);
+}
+
+
+template <uint16_t k>
+inline void Directed_Vertex<k>::roll_forward(const cuttlefish::base_t b)
+{
+    kmer_hash.roll(kmer_.front(), b);
+    kmer_.roll_to_next_kmer(b, kmer_bar_);
+    kmer_hat_ptr = Kmer<k>::canonical(kmer_, kmer_bar_);
 }
 
 
@@ -11,7 +11,7 @@
 #include <cstdint>
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY> class Kmer_Hash_Table;
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_> class Kmer_Hash_Table;
 
 
 // Class for an instance of a bidirected edge.
@@ -46,6 +46,14 @@ public:
     // the edge (k + 1)-mer (updatable using `e()`) is modified.
     void configure(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Configures the edge data from the underlying (k + 1)-mer, except the
+    // hash values of the endpoint vertices. Those must be set later through
+    // `set_hashes`. This is to support batched hashing of the vertices.
+    void configure();
+
+    // Sets the hash values of the endpoints `u` and `v` to `h_u` and `h_v`.
+    void set_hashes(uint64_t h_u, uint64_t h_v);
+
     // Returns `true` iff the edge is a loop.
     bool is_loop() const;
 };
@@ -80,6 +88,22 @@ inline void Edge<k>::configure(const Kmer_Hash_Table<k, cuttlefish::BITS_PER_REA
 }
 
 
+template <uint16_t k>
+inline void Edge<k>::configure()
+{
+    u_.from_prefix(e_),
+    v_.from_suffix(e_);
+}
+
+
+template <uint16_t k>
+inline void Edge<k>::set_hashes(const uint64_t h_u, const uint64_t h_v)
+{
+    u_.set_hash(h_u),
+    v_.set_hash(h_v);
+}
+
+
 template <uint16_t k>
 inline bool Edge<k>::is_loop() const
 {
@@ -12,7 +12,7 @@
 #include <cstdint>
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY> class Kmer_Hash_Table;
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_> class Kmer_Hash_Table;
 
 
 // A class denoting an endpoint of a bidirected edge instance.
@@ -65,6 +65,17 @@ public:
     // and uses the hash table `hash` to get the hash value of the vertex.
     void from_suffix(const Kmer<k + 1>& e, const Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash);
 
+    // Configures the endpoint with the source (i.e. prefix) k-mer of the edge (k + 1)-mer `e`,
+    // without the hash value of the vertex. The hash value must be set later with `set_hash`.
+    void from_prefix(const Kmer<k + 1>& e);
+
+    // Configures the endpoint with the sink (i.e. suffix) k-mer of the edge (k + 1)-mer `e`,
+    // without the hash value of the vertex. The hash value must be set later with `set_hash`.
+    void from_suffix(const Kmer<k + 1>& e);
+
+    // Sets the hash value of the vertex associated to this endpoint to `h`.
+    void set_hash(uint64_t h);
+
     // Returns the neighboring endpoint of this endpoint that's connected with an edge encoded
     // with the code `e`, from the point-of-view of this endpoint. Uses the hash table `hash`
     // to get the hash value of the corresponding neighbor vertex.
@@ -112,6 +123,33 @@ inline void Endpoint<k>::from_suffix(const Kmer<k + 1>& e, const Kmer_Hash_Table
 }
 
 
+template <uint16_t k>
+inline void Endpoint<k>::from_prefix(const Kmer<k + 1>& e)
+{
+    v.from_prefix(e);
+
+    s = exit_side();
+    this->e = exit_edge(e);
+}
+
+
+template <uint16_t k>
+inline void Endpoint<k>::from_suffix(const Kmer<k + 1>& e)
+{
+    v.from_suffix(e);
+
+    s = entrance_side();
+    this->e = entrance_edge(e);
+}
+
+
+template <uint16_t k>
+inline void Endpoint<k>::set_hash(const uint64_t h)
+{
+    v.set_hash(h);
+}
+
+
 template <uint16_t k>
 inline cuttlefish::side_t Endpoint<k>::exit_side() const
 {
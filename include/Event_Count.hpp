@@ -0,0 +1,93 @@
+
+#ifndef EVENT_COUNT_HPP
+#define EVENT_COUNT_HPP
+
+
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+
+// A waiting construct for threads that await some condition over shared state,
+// e.g. task statuses, to hold. A waiter spins on the condition for a short while,
+// and then parks (blocks) on the event-count until some notifier signals a change
+// of the shared state. Notifications are cheap when no waiter is parked.
+// Reference: http://cbloomrants.blogspot.com/2011/07/07-08-11-who-ordered-event-count.html
+class Event_Count
+{
+private:
+
+    static constexpr uint32_t SPIN_COUNT = 1024;    // Number of checks of the condition before parking.
+    static constexpr uint32_t YIELD_AFTER = 64; // Number of checks of the condition before yielding the CPU between checks.
+
+    std::atomic<uint32_t> epoch{0}; // Number of notifications having reached some parked waiter.
+    std::atomic<uint32_t> waiters{0};   // Number of waiters about to park or parked.
+    std::mutex mutex_;  // Mutex guarding the parking of the waiters.
+    std::condition_variable cv; // Condition variable to park the waiters at.
+
+
+public:
+
+    // Waits until the condition `ready` holds. `ready` must observe the shared
+    // state with sequentially-consistent loads, and the notifiers must update
+    // it with sequentially-consistent stores, for a wake-up not to be lost.
+    template <typename T_pred_> void await(const T_pred_& ready);
+
+    // Wakes up all the parked waiters; to be invoked after updating the shared
+    // state that the waiters' conditions are over.
+    void notify_all();
+};
+
+
+template <typename T_pred_>
+inline void Event_Count::await(const T_pred_& ready)
+{
+    for(uint32_t i = 0; i < SPIN_COUNT; ++i)
+    {
+        if(ready())
+            return;
+
+        if(i >= YIELD_AFTER)
+            std::this_thread::yield();
+    }
+
+
+    while(true)
+    {
+        // Announce the intent to park before re-checking the condition, so that a
+        // notifier updating the state after the check sees the waiter.
+        waiters++;
+        const uint32_t key = epoch;
+        if(ready())
+        {
+            waiters--;
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv.wait(lock, [this, key](){ return epoch != key; });
+        lock.unlock();
+
+        waiters--;
+    }
+}
+
+
+inline void Event_Count::notify_all()
+{
+    if(waiters == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    epoch++;
+    lock.unlock();
+
+    cv.notify_all();
+}
+
+
+
+#endif
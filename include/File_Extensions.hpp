@@ -23,6 +23,7 @@ namespace cuttlefish
         constexpr char gfa2_ext[] = ".gfa2";
         constexpr char seg_ext[] = ".cf_seg";
         constexpr char seq_ext[] = ".cf_seq";
+        constexpr char ref_cache_ext[] = ".cf_rc";
     }
 }
 
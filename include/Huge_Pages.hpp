@@ -0,0 +1,118 @@
+
+#ifndef HUGE_PAGES_HPP
+#define HUGE_PAGES_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+
+// Page-size backings of memory regions.
+enum class Page_Backing: uint8_t
+{
+    regular,            // Base (4 KB) pages.
+    transparent_huge,   // Transparent huge pages (THP).
+    explicit_huge,      // Explicitly reserved huge pages (hugetlbfs).
+};
+
+
+// Allocation of large memory regions backed by 2 MB huge pages, to cut the TLB
+// misses of uniformly random accesses into them (e.g. the hash table buckets
+// and the MPHF). A region is backed by explicitly reserved huge pages if those
+// are enabled and available; otherwise it is aligned to the huge page size and
+// advised for transparent huge pages, with regular pages as the fallback.
+class Huge_Pages
+{
+private:
+
+    static std::atomic<bool> explicit_enabled;  // Whether to try explicitly reserved huge pages for allocations.
+
+
+    // Returns `bytes` rounded up to a multiple of the huge page size.
+    static std::size_t round_up(std::size_t bytes);
+
+    // Returns a `bytes`-sized memory region backed by explicitly reserved huge
+    // pages, or `nullptr` if those are unavailable.
+    static void* map_explicit(std::size_t bytes);
+
+    // Returns a `bytes`-sized memory region aligned to the huge page size and
+    // advised for transparent huge pages, or `nullptr` if the mapping fails.
+    static void* map_transparent(std::size_t bytes);
+
+
+public:
+
+    // Size of a huge page in bytes.
+    static constexpr std::size_t page_size = 2 * 1024 * 1024;
+
+    // Allocations smaller than this many bytes are not backed by huge pages.
+    static constexpr std::size_t min_bytes = page_size;
+
+    // Sets whether allocations are to try explicitly reserved (hugetlbfs)
+    // huge pages first.
+    static void enable_explicit(bool enable);
+
+    // Allocates a zero-initialized memory region of `bytes` bytes. Throws
+    // `std::bad_alloc` on failure.
+    static void* allocate(std::size_t bytes);
+
+    // Frees the memory region `ptr` of `bytes` bytes, allocated by `allocate`.
+    static void deallocate(void* ptr, std::size_t bytes);
+
+    // Returns the page backing actually obtained for the memory at address
+    // `ptr`, as reported by the kernel.
+    static Page_Backing backing(const void* ptr);
+
+    // Returns a textual description of the page backing `backing`.
+    static const char* to_string(Page_Backing backing);
+};
+
+
+// An STL-compatible allocator for objects of type `T_`, backing large
+// allocations with huge pages through `Huge_Pages`.
+template <typename T_>
+class Huge_Page_Allocator
+{
+public:
+
+    typedef T_ value_type;
+
+
+    Huge_Page_Allocator() = default;
+
+    template <typename U_>
+    Huge_Page_Allocator(const Huge_Page_Allocator<U_>&)
+    {}
+
+    // Allocates zero-initialized memory for `n` objects of type `T_`.
+    T_* allocate(std::size_t n)
+    {
+        return static_cast<T_*>(Huge_Pages::allocate(n * sizeof(T_)));
+    }
+
+    // Frees the memory at `ptr`, allocated for `n` objects of type `T_`.
+    void deallocate(T_* ptr, std::size_t n)
+    {
+        Huge_Pages::deallocate(ptr, n * sizeof(T_));
+    }
+};
+
+
+template <typename T_, typename U_>
+inline bool operator==(const Huge_Page_Allocator<T_>&, const Huge_Page_Allocator<U_>&)
+{
+    return true;
+}
+
+
+template <typename T_, typename U_>
+inline bool operator!=(const Huge_Page_Allocator<T_>&, const Huge_Page_Allocator<U_>&)
+{
+    return false;
+}
+
+
+
+#endif
@@ -28,6 +28,8 @@ namespace cuttlefish
 #endif
         constexpr Output_Format OP_FORMAT = Output_Format::fa;
         constexpr char WORK_DIR[] = ".";
+        constexpr uint64_t PARTITION_COUNT = 1; // No partitioning of the hash table.
+        constexpr char IN_MEMORY_DIR[] = "/dev/shm/";  // RAM-backed (tmpfs) directory for in-memory databases.
     }
 }
 
@@ -6,9 +6,9 @@
 
 #include "DNA_Utility.hpp"
 #include "Kmer_Utility.hpp"
+#include "Kmer_Rolling_Hash.hpp"
 #include "utility.hpp"
 #include "kmc_api/kmc_file.h"
-#include "xxHash/xxh3.h"
 
 #include <cstdint>
 #include <cstddef>
@@ -45,11 +45,11 @@ private:
     // A k-mer `n_{k - 1} ... n_1 n_0` is stored in the array `kmer_data` such that, `kmer_data[0]`
     // stores the suffix `n_63 ... n_0`, then `kmer_data[1]` stores `n_127 ... n_64`, and so on.
     // That is, the suffix is aligned with a byte boundary.
-    // TODO: reverse this store-order of the data — i.e. `n_{k - 1}` as the least significant base
-    // (so stored in `kmer_data[0]`) and `n_0` as the most significant base (so stored in `kmer_data[0]`).
-    // This would optimize at least the following:
-    //      i) `from_KMC_data` () — aligning with the KMC data alignment and thus `memcpy` instead of bit-twiddling;
-    //      ii) `operator<` — `memcmp` instead of highest-to-lowest index looping comparison.
+    // NB: reversing this store-order, to have `memcmp` order the k-mers, does not pay off on
+    // little-endian machines — the bytes of each word would still compare in the wrong order. (It
+    // would also change the hashes of the k-mers, needing a bump of the saved hash tables' format
+    // version, `cuttlefish::HASH_TABLE_FORMAT_VERSION`.) The comparisons and the reverse
+    // complements work word-wise, branch-free, instead.
     uint64_t kmer_data[NUM_INTS];
 
 
@@ -92,9 +92,17 @@ public:
     // Copy assignment operator.
     Kmer<k>& operator=(const Kmer<k>& rhs);
 
-    // Returns a 64-bit hash value for the k-mer.
+    // Returns a 64-bit hash value for the k-mer, with the seed `seed`. It's identical
+    // for the k-mer and its reverse complement, and is the value of the rolling hash
+    // `Kmer_Rolling_Hash<k>` of the k-mer for `seed`.
     uint64_t to_u64(uint64_t seed=0) const;
 
+    // Returns the rolling hash of the k-mer.
+    Kmer_Rolling_Hash<k> rolling_hash() const;
+
+    // Returns the rolling hash of the k-mer, given its reverse complement `rev_compl`.
+    Kmer_Rolling_Hash<k> rolling_hash(const Kmer<k>& rev_compl) const;
+
     // Gets the k-mer from the KMC api object `kmer_api`.
     void from_CKmerAPI(const CKmerAPI& kmer_api);
 
@@ -215,6 +223,38 @@ public:
     // Accumulates the counts of the l-mers of the k-mer into `count`.
     template <uint8_t l>
     void count_lmers(std::vector<uint64_t>& count) const;
+
+    // Returns the l-minimizer for the k-mer over the canonical forms of its
+    // l-mers, under a pseudo-random ordering of the l-mers. It is identical
+    // for the k-mer and its reverse complement.
+    template <uint8_t l>
+    minimizer_t canonical_minimizer() const;
+
+    // Returns the canonical l-minimizer for the k-mer, as above; and sets `pos`
+    // to the index of the first base of its last occurrence in the k-mer, with
+    // the indices counted from the back of the k-mer.
+    template <uint8_t l>
+    minimizer_t canonical_minimizer(uint16_t& pos) const;
+
+    // Returns the rank of the l-mer `lmer` in the pseudo-random ordering of the
+    // l-mers for the canonical minimizers. Distinct l-mers have distinct ranks.
+    static uint64_t minimizer_order(uint64_t lmer);
+
+    // Returns the first `l` bases of the k-mer as an integer, with the first
+    // base being the most significant one.
+    template <uint16_t l>
+    uint64_t leading_bases() const;
+
+    // Returns the `l` bases of the k-mer starting at its `pos`'th base (0-based)
+    // as an integer, with the first of those being the most significant one.
+    uint64_t bases_at(uint16_t pos, uint16_t l) const;
+
+    // Gets the k-mer's KMC raw-binary representation, as in a KMC database with
+    // a prefix-length of `prefix_len`: the first `prefix_len` bases are put into
+    // `prefix`, and the remaining bases are packed four per byte—the first base
+    // at the most significant bits—into `suffix`. `k - prefix_len` must be a
+    // multiple of 4.
+    void to_KMC_data(uint16_t prefix_len, uint64_t& prefix, uint8_t* suffix) const;
 };
 
 
@@ -259,8 +299,21 @@ inline void Kmer<k>::left_shift()
 template <uint16_t k>
 inline uint64_t Kmer<k>::to_u64(const uint64_t seed) const
 {
-    constexpr uint16_t NUM_BYTES = (k + 3) / 4;
-    return XXH3_64bits_withSeed(kmer_data, NUM_BYTES, seed);
+    return rolling_hash()(seed);
+}
+
+
+template <uint16_t k>
+inline Kmer_Rolling_Hash<k> Kmer<k>::rolling_hash() const
+{
+    return rolling_hash(reverse_complement());
+}
+
+
+template <uint16_t k>
+inline Kmer_Rolling_Hash<k> Kmer<k>::rolling_hash(const Kmer<k>& rev_compl) const
+{
+    return Kmer_Rolling_Hash<k>(kmer_data, rev_compl.kmer_data);
 }
 
 
@@ -288,9 +341,15 @@ inline Kmer<k>::Kmer(const char* const label)
     for(uint16_t data_idx = 0; data_idx < packed_word_count; ++data_idx)
         kmer_data[data_idx] = Kmer_Utility::encode<32>((label + k) - (data_idx << 5) - 32);
 
-    // Get the partially packed (highest index) word's binary representation.
+    // Get the partially packed (highest index) word's binary representation. With at least
+    // 32 bases in the label, its first 32 bases are encoded at once and the excess dropped.
     if constexpr((k & 31) > 0)
-        kmer_data[NUM_INTS - 1] = Kmer_Utility::encode<k & 31>(label);
+    {
+        if constexpr(k > 32)
+            kmer_data[NUM_INTS - 1] = Kmer_Utility::encode_word(label) >> (2 * (32 - (k & 31)));
+        else
+            kmer_data[NUM_INTS - 1] = Kmer_Utility::encode<k & 31>(label);
+    }
 }
 
 
@@ -416,53 +475,46 @@ inline Kmer<k> Kmer<k>::reverse_complement() const
 template <uint16_t k>
 inline void Kmer<k>::as_reverse_complement(const Kmer<k>& other)
 {
-    // Working with bytes instead of 64-bit words at a time.
-
-    uint8_t* const rev_compl = reinterpret_cast<uint8_t*>(kmer_data);
-    const uint8_t* const data = reinterpret_cast<const uint8_t*>(other.kmer_data);
-
+    // Reverse complement the words in reverse order; this places the reverse complement
+    // at the high end of the words' collection, with `32 * NUM_INTS - k` padding bases
+    // at its low end.
 
-    // Get the reverse complement for the fully packed bytes.
+    uint64_t rev_compl[NUM_INTS];
+    for(uint16_t idx = 0; idx < NUM_INTS; ++idx)
+        rev_compl[idx] = Kmer_Utility::reverse_complement_word(other.kmer_data[NUM_INTS - 1 - idx]);
 
-    constexpr uint16_t packed_byte_count = k / 4;
-    for(uint16_t byte_idx = 0; byte_idx < packed_byte_count; ++byte_idx)
-        rev_compl[packed_byte_count - 1 - byte_idx] = Kmer_Utility::reverse_complement(data[byte_idx]);
 
+    // Right-shift the collection by the padding bases to align the suffix with the word boundary.
 
-    // Get the reverse complement for the only byte that might be partially packed (possible for the highest-indexed byte only).
+    constexpr uint16_t pad_bits = 2 * (32 * NUM_INTS - k);
+    if constexpr(pad_bits > 0)
+    {
+        for(uint16_t idx = 0; idx + 1 < NUM_INTS; ++idx)
+            rev_compl[idx] = (rev_compl[idx] >> pad_bits) | (rev_compl[idx + 1] << (64 - pad_bits));
 
-    constexpr uint16_t rem_base_count = k % 4;
-    if constexpr(rem_base_count == 0)
-        return;
-    
-    rev_compl[packed_byte_count] = 0;
-    left_shift<rem_base_count>();
+        rev_compl[NUM_INTS - 1] >>= pad_bits;
+    }
 
-    for(int i = 0; i < rem_base_count; ++i)
-        rev_compl[0] |= (DNA_Utility::complement(DNA::Base((data[packed_byte_count] & (0b11 << (2 * i))) >> (2 * i)))
-                                        << (2 * (rem_base_count - 1 - i)));
+    std::memcpy(kmer_data, rev_compl, sizeof(rev_compl));
 }
 
 
 template <uint16_t k>
 inline bool Kmer<k>::operator<(const Kmer<k>& rhs) const
 {
-    for(int16_t idx = NUM_INTS - 1; idx >= 0; --idx)
-        if(kmer_data[idx] != rhs.kmer_data[idx])
-            return kmer_data[idx] < rhs.kmer_data[idx];
+    // Branch-free comparison: the lower words only decide the order when the higher ones are equal.
+    bool less = false;
+    for(uint16_t idx = 0; idx < NUM_INTS; ++idx)
+        less = (kmer_data[idx] < rhs.kmer_data[idx]) | ((kmer_data[idx] == rhs.kmer_data[idx]) & less);
 
-    return false;
+    return less;
 }
 
 
 template <uint16_t k>
 inline bool Kmer<k>::operator>(const Kmer<k>& rhs) const
 {
-    for(int16_t idx = NUM_INTS - 1; idx >= 0; --idx)
-        if(kmer_data[idx] != rhs.kmer_data[idx])
-            return kmer_data[idx] > rhs.kmer_data[idx];
-
-    return false;
+    return rhs < *this;
 }
 
 
@@ -523,8 +575,8 @@ template <uint16_t k>
 inline void Kmer<k>::roll_to_next_kmer(const DNA::Base base, Kmer<k>& rev_compl)
 {
     // Logically, since a left shift moves the MSN out of the length `k` boundary, the clearing of the base
-    // may seem redundant. But, the `to_u64` hashing method implementation works with bytes — not clearing
-    // out this base breaks the consistency of the hashing.
+    // may seem redundant. But, the comparisons and the reverse complements work with whole words — not
+    // clearing out this base breaks their consistency.
     kmer_data[NUM_INTS - 1] &= CLEAR_MSN_MASK;
     left_shift();
     kmer_data[0] |= base;
@@ -570,7 +622,13 @@ inline void Kmer<k>::roll_backward(const DNA::Extended_Base edge)
 template <uint16_t k>
 inline Kmer<k> Kmer<k>::canonical(const Kmer<k>& rev_compl) const
 {
-    return std::min(*this, rev_compl);
+    // Select the lesser one word-wise through a mask, without branching; ties go to this k-mer.
+    const uint64_t mask = -static_cast<uint64_t>(rev_compl < *this);
+    Kmer<k> min_kmer;
+    for(uint16_t idx = 0; idx < NUM_INTS; ++idx)
+        min_kmer.kmer_data[idx] = kmer_data[idx] ^ ((kmer_data[idx] ^ rev_compl.kmer_data[idx]) & mask);
+
+    return min_kmer;
 }
 
 
@@ -757,4 +815,106 @@ inline void Kmer<k>::count_lmers(std::vector<uint64_t>& count) const
 
 
 
+template <uint16_t k>
+template <uint8_t l>
+inline typename Kmer<k>::minimizer_t Kmer<k>::canonical_minimizer() const
+{
+    uint16_t pos;
+    return canonical_minimizer<l>(pos);
+}
+
+
+template <uint16_t k>
+template <uint8_t l>
+inline typename Kmer<k>::minimizer_t Kmer<k>::canonical_minimizer(uint16_t& pos) const
+{
+    static_assert(l <= k && l <= 16, "invalid minimizer length");
+
+    constexpr uint64_t lmer_mask = (1ULL << (2 * l)) - 1;
+
+    uint64_t lmer = 0;  // The current l-mer.
+    uint64_t lmer_bar = 0;  // Reverse complement of the current l-mer.
+    uint64_t minmzr = 0;
+    uint64_t min_order = ~0ULL;
+
+    // The l-mers are scanned from the back of the k-mer, so the first one found of a
+    // minimum order is its last occurrence.
+    for(uint16_t idx = 0; idx < k; ++idx)
+    {
+        const uint64_t base = (kmer_data[idx >> 5] >> (2 * (idx & 31))) & 0b11;
+        lmer = (lmer >> 2) | (base << (2 * (l - 1)));
+        lmer_bar = ((lmer_bar << 2) | (base ^ 0b11)) & lmer_mask;
+
+        if(idx + 1 >= l)
+        {
+            const uint64_t canonical_lmer = std::min(lmer, lmer_bar);
+            const uint64_t order = minimizer_order(canonical_lmer);
+            if(min_order > order)
+            {
+                min_order = order;
+                minmzr = canonical_lmer;
+                pos = idx;
+            }
+        }
+    }
+
+
+    return static_cast<minimizer_t>(minmzr);
+}
+
+
+template <uint16_t k>
+inline uint64_t Kmer<k>::minimizer_order(const uint64_t lmer)
+{
+    constexpr uint64_t order_mult = 0x9E3779B97F4A7C15ULL; // Odd multiplier, so that the ordering has no ties across distinct l-mers.
+
+    return lmer * order_mult;
+}
+
+
+template <uint16_t k>
+template <uint16_t l>
+inline uint64_t Kmer<k>::leading_bases() const
+{
+    static_assert(l <= k && l <= 32, "invalid leading bases count");
+
+    uint64_t bases = 0;
+    for(uint16_t idx = k; idx > k - l; --idx)
+        bases = (bases << 2) | ((kmer_data[(idx - 1) >> 5] >> (2 * ((idx - 1) & 31))) & 0b11);
+
+    return bases;
+}
+
+
+template <uint16_t k>
+inline uint64_t Kmer<k>::bases_at(const uint16_t pos, const uint16_t l) const
+{
+    assert(pos + l <= k && l <= 32);
+
+    uint64_t bases = 0;
+    for(uint16_t idx = k - pos; idx > k - pos - l; --idx)
+        bases = (bases << 2) | ((kmer_data[(idx - 1) >> 5] >> (2 * ((idx - 1) & 31))) & 0b11);
+
+    return bases;
+}
+
+
+template <uint16_t k>
+inline void Kmer<k>::to_KMC_data(const uint16_t prefix_len, uint64_t& prefix, uint8_t* const suffix) const
+{
+    assert(prefix_len <= k && (k - prefix_len) % 4 == 0);
+
+    const auto base_at = [this](const uint16_t idx){ return (kmer_data[idx >> 5] >> (2 * (idx & 31))) & 0b11; };
+
+    prefix = 0;
+    int32_t idx = k - 1;    // Index of the next base to pack; the first base is at index `k - 1`.
+    for(; idx >= k - prefix_len; --idx)
+        prefix = (prefix << 2) | base_at(idx);
+
+    for(uint16_t byte = 0; idx >= 0; ++byte, idx -= 4)
+        suffix[byte] = static_cast<uint8_t>((base_at(idx) << 6) | (base_at(idx - 1) << 4) | (base_at(idx - 2) << 2) | base_at(idx - 3));
+}
+
+
+
 #endif
@@ -0,0 +1,92 @@
+
+#ifndef KMER_DB_WRITER_HPP
+#define KMER_DB_WRITER_HPP
+
+
+
+#include "Kmer.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+
+
+// Writer of a KMC (version 2) database of a set of k-mers, without counters, so
+// that the set can be read back with `Kmer_Container` and its iterators. The
+// k-mers must be supplied in sorted order. Encoding a chunk of k-mers into their
+// raw-binary records is separated from appending the records to the database,
+// so that multiple threads may encode concurrently.
+template <uint16_t k>
+class Kmer_DB_Writer
+{
+private:
+
+    // Version of the KMC database format written.
+    static constexpr uint32_t kmc_version = 0x200;
+
+    // Length of the signatures of the database. Only a single bin is written,
+    // so the signature map is a placeholder.
+    static constexpr uint32_t signature_len = 5;
+
+    // Maximum length of the prefixes of the k-mers stored at the LUT.
+    static constexpr uint16_t max_lut_prefix_len = 12;
+
+    const std::string db_path;  // Path prefix of the database.
+    const uint16_t lut_prefix_len;  // Length of the prefixes of the k-mers stored at the LUT.
+    const std::size_t suff_size;    // Size of the suffix record of a k-mer in bytes.
+    std::ofstream suff_file;    // The suffix file of the database.
+    std::vector<uint64_t> prefix_count; // `prefix_count[p]` is the number of k-mers with the prefix `p`.
+    uint64_t kmer_count_;   // Number of k-mers appended to the database.
+
+
+    // Returns a suitable LUT prefix length for a database of roughly
+    // `kmer_count_estimate` k-mers.
+    static uint16_t lut_prefix_length(uint64_t kmer_count_estimate);
+
+
+public:
+
+    // Constructs a writer for a KMC database at the path prefix `db_path`, that
+    // is expected to have around `kmer_count_estimate` k-mers.
+    Kmer_DB_Writer(const std::string& db_path, uint64_t kmer_count_estimate);
+
+    // Returns the size of the raw-binary record of a k-mer in bytes.
+    std::size_t record_size() const;
+
+    // Encodes the `n` sorted k-mers at `kmers` into their raw-binary records at
+    // `suff_buf`, and the run-length encoding of their prefixes, as pairs of the
+    // form <prefix, count>, into `pref_runs`. It is thread-safe.
+    void encode(const Kmer<k>* kmers, std::size_t n, std::vector<uint8_t>& suff_buf, std::vector<std::pair<uint64_t, uint64_t>>& pref_runs) const;
+
+    // Appends the k-mer records `suff_buf` with prefixes `pref_runs`, as encoded
+    // by `encode`, to the database. The k-mers must succeed the ones appended
+    // earlier in the sorted order.
+    void append(const std::vector<uint8_t>& suff_buf, const std::vector<std::pair<uint64_t, uint64_t>>& pref_runs);
+
+    // Completes the database, writing its prefix file.
+    void close();
+
+    // Returns the number of k-mers appended to the database.
+    uint64_t kmer_count() const;
+};
+
+
+template <uint16_t k>
+inline std::size_t Kmer_DB_Writer<k>::record_size() const
+{
+    return suff_size;
+}
+
+
+template <uint16_t k>
+inline uint64_t Kmer_DB_Writer<k>::kmer_count() const
+{
+    return kmer_count_;
+}
+
+
+
+#endif
@@ -11,7 +11,7 @@
 #include <cstdint>
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY> class Kmer_Hash_Table;
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_> class Kmer_Hash_Table;
 
 
 // Wrapper class acting as an API to the entries of the bitvector used as hash table for k-mers.
@@ -24,16 +24,13 @@ class Kmer_Hash_Entry_API
 template <>
 class Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER>
 {
-    template <uint16_t k, uint8_t BITS_PER_KEY>
+    template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
     friend class Kmer_Hash_Table;
 
-    typedef compact::iterator_imp::lhs_setter<cuttlefish::state_code_t, cuttlefish::BITS_PER_REF_KMER, uint64_t, true, 64U> bitvector_entry_t;
-
-
 private:
 
-    // Position information (base pointer and offset) for the bitvector entry.
-    bitvector_entry_t bv_entry;
+    // Index of the hash table bucket for the entry.
+    uint64_t bucket;
 
     // Value read from the bitvector entry when the object is constructed; is immutable.
     const State state_read;
@@ -42,9 +39,9 @@ private:
     State state;
 
 
-    // Constructs an API to the bitvector entry `bv_entry`.
-    Kmer_Hash_Entry_API(const bitvector_entry_t& bv_entry):
-        bv_entry(bv_entry), state_read(bv_entry)
+    // Constructs an API to the entry at the bucket `bucket`, which is read to have the state-code `code`.
+    Kmer_Hash_Entry_API(const uint64_t bucket, const cuttlefish::state_code_t code):
+        bucket(bucket), state_read(code)
     {
         state = state_read;
     }
@@ -78,16 +75,13 @@ public:
 template <>
 class Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER>
 {
-    template <uint16_t k, uint8_t BITS_PER_KMER>
+    template <uint16_t k, uint8_t BITS_PER_KMER, typename T_MPHF_>
     friend class Kmer_Hash_Table;
 
-    typedef compact::iterator_imp::lhs_setter<cuttlefish::state_code_t, cuttlefish::BITS_PER_READ_KMER, uint64_t, true, 64U> bitvector_entry_t;
-
-
 private:
 
-    // Position information (base pointer and offset) for the bitvector entry.
-    bitvector_entry_t bv_entry;
+    // Index of the hash table bucket for the entry.
+    uint64_t bucket;
 
     // Value read from the bitvector entry when the object is constructed; is immutable.
     const State_Read_Space state_read;
@@ -96,9 +90,9 @@ private:
     State_Read_Space state_;
 
 
-    // Constructs an API to the bitvector entry `bv_entry`.
-    Kmer_Hash_Entry_API(const bitvector_entry_t& bv_entry):
-        bv_entry(bv_entry), state_read(bv_entry)
+    // Constructs an API to the entry at the bucket `bucket`, which is read to have the state-code `code`.
+    Kmer_Hash_Entry_API(const uint64_t bucket, const cuttlefish::state_code_t code):
+        bucket(bucket), state_read(code)
     {
         state_ = state_read;
     }
@@ -9,10 +9,11 @@
 #include "Kmer_Hasher.hpp"
 #include "State.hpp"
 #include "Kmer_Hash_Entry_API.hpp"
-#include "Spin_Lock.hpp"
-#include "Sparse_Lock.hpp"
-#include "BBHash/BooPHF.h"
-#include "compact_vector/compact_vector.hpp"
+#include "Atomic_Bit_Vector.hpp"
+#include "BBHash_MPHF.hpp"
+#include "PTHash_MPHF.hpp"
+#include "Partitioned_MPHF.hpp"
+#include "Huge_Pages.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -22,44 +23,25 @@
 class Build_Params;
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
 class Kmer_Hash_Table
 {
-    typedef boomphf::mphf<Kmer<k>, Kmer_Hasher<k>> mphf_t;    // The MPH function type.
+    typedef Partitioned_MPHF<k, T_MPHF_> mphf_t;    // The MPH function type.
 
-    typedef compact::ts_vector<cuttlefish::state_code_t, BITS_PER_KEY, uint64_t, std::allocator<uint64_t>> bitvector_t;
+    typedef Atomic_Bit_Vector<BITS_PER_KEY> bitvector_t;
 
 private:
 
-    // The minimum gamma-value that we require for BBHash.
-    static constexpr double gamma_min = 2.0;
-
-    // The maximum gamma-value that we may use with BBHash.
-    static constexpr double gamma_max = 10.0;
-
-    // The minimum bits per hash key we require for BBHash.
-    static constexpr double min_bits_per_hash_key = 3.71;
-
-    // Empiricial bits-per-key requirement for each gamma in the range (0, 10].
-    static constexpr double bits_per_gamma[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                                3.06, 3.07, 3.11, 3.16, 3.22, 3.29, 3.36, 3.44, 3.53, 3.62,
-                                                3.71, 3.80, 3.90, 4.00, 4.10, 4.20, 4.30, 4.40, 4.50, 4.61,
-                                                4.71, 4.82, 4.92, 5.03, 5.13, 5.24, 5.35, 5.45, 5.56, 5.67,
-                                                5.78, 5.89, 6.00, 6.10, 6.21, 6.32, 6.43, 6.54, 6.65, 6.76,
-                                                6.87, 6.98, 7.09, 7.20, 7.31, 7.42, 7.53, 7.64, 7.75, 7.86,
-                                                7.97, 8.08, 8.20, 8.31, 8.42, 8.53, 8.64, 8.75, 8.86, 8.97,
-                                                9.08, 9.20, 9.31, 9.42, 9.53, 9.64, 9.75, 9.86, 9.98, 10.09,
-                                                10.20, 10.31, 10.42, 10.53, 10.64, 10.76, 10.87, 10.98, 11.09, 11.20,
-                                                11.31, 11.43, 11.54, 11.65, 11.76, 11.87, 11.99, 12.10, 12.21, 12.32,
-                                                12.43};
-
-    // The resolution of gamma that we support.
-    static constexpr double gamma_resolution = 0.1;
-
-    // The gamma parameter of the BBHash function.
-    // Lowest bits/elem is achieved with gamma = 1, higher values lead to larger mphf but faster construction/query.
+    // The gamma parameter of the MPH function. For BBHash, lowest bits/elem is achieved with gamma = 1;
+    // and in general, higher values lead to larger mphf but faster construction/query.
     double gamma;
 
+    // Memory budget (in bytes) of the hash table; 0 if it has none.
+    std::size_t memory_budget = 0;
+
+    // Whether `gamma` has been set to fit the hash table in its memory budget.
+    bool gamma_fit = false;
+
     // Path to the underlying k-mer database, over which the hash table is constructed.
     const std::string kmc_db_path;
 
@@ -72,30 +54,33 @@ private:
 
     // The buckets collection (raw `State` representations) for the hash table structure.
     // Keys (`Kmer<k>`) are passed to the MPHF, and the resulting function-value is used as index into the buckets table.
+    // Concurrent accesses to the buckets are lock-free, through compare-and-swap operations over the bitvector words.
     bitvector_t hash_table;
 
-    // Number of locks for mutually exclusive access for threads to the same indices into the bitvector `hash_table`.
-    // TODO: increase locks and check note at the end about the false `const` issue.
-    constexpr static uint64_t lock_count{65536};
-
-    // The locks to maintain mutually exclusive access for threads to the same indices into the bitvector `hash_table`.
-    mutable Sparse_Lock<Spin_Lock> sparse_lock;
-
     
     // Sets the `gamma` parameter of the hash function to the maximum amount so that the
     // hash table does not incur more than `max_memory` bytes of space.
     void set_gamma(std::size_t max_memory);
 
+    // Returns `true` iff the built MPH function `mph` and the buckets exceed the memory
+    // budget of the hash table.
+    bool exceeds_memory() const;
+
     // Builds the minimal perfect hash function `mph` over the set of
     // k-mers present at the KMC database container `kmer_container`,
     // using `thread_count` number of threads. Uses the directory
-    // at `working_dir_path` to store temporary files. If the MPHF is
-    // found present at the file `mph_file_path`, then it is loaded
-    // instead.
-    void build_mph_function(uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path);
-
-    // Loads an MPH function from the file at `file_path` into `mph`.
-    void load_mph_function(const std::string& file_path);
+    // at `working_dir_path` to store temporary files, and the path
+    // prefix `temp_file_prefix` for the temporary files of the
+    // partitions. If the MPHF is found present at the file
+    // `mph_file_path`, then it is loaded instead—read fully into
+    // memory at once if `populate` is `true`. A built MPHF
+    // partitions the k-mers into `partition_count` parts.
+    void build_mph_function(uint16_t thread_count, const std::string& working_dir_path, const std::string& temp_file_prefix, const std::string& mph_file_path, bool populate = false, uint64_t partition_count = 1);
+
+    // Loads an MPH function from the file at `file_path` into `mph`. The file
+    // is memory-mapped where the MPHF backend supports it, and is read fully
+    // into memory at once if `populate` is `true`.
+    void load_mph_function(const std::string& file_path, bool populate = false);
 
     // Saves the MPH function `mph` into a file at `file_path`.
     void save_mph_function(const std::string& file_path) const;
@@ -103,6 +88,10 @@ private:
 
 public:
 
+    // Canonical minimizer of rolling k-mers, that partitions the k-mers of the table;
+    // see `Partitioned_MPHF::rolling_minimizer_t`.
+    typedef typename mphf_t::rolling_minimizer_t rolling_minimizer_t;
+
     // Constructs a k-mer hash table where the table is to be built over the k-mer
     // database with path prefix `kmer_db_path`.
     Kmer_Hash_Table(const std::string& kmer_db_path);
@@ -125,18 +114,75 @@ public:
 
     // Constructs a minimal perfect hash function (specifically, the BBHash) for
     // the collection of k-mers present at the KMC database at path `kmc_db_path`,
-    // using up-to `thread_count` number of threads. The existence of an MPHF is
+    // using up-to `thread_count` number of threads. Temporary files are stored in
+    // the directory at `working_dir_path`, those of the MPHF partitions with the
+    // path prefix `temp_file_prefix`. The existence of an MPHF is
     // checked at the path `mph_file_path`—if found, it is loaded from the file.
     // If `save_mph` is specified, then the MPHF is saved into the file `mph_file_path`.
-    void construct(uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path, const bool save_mph = false);
+    // A loaded MPHF is read fully into memory at once if `populate` is `true`.
+    // A built MPHF partitions the k-mers by their minimizers into `partition_count`
+    // parts, with contiguous buckets per partition; a loaded one keeps its own.
+    void construct(uint16_t thread_count, const std::string& working_dir_path, const std::string& temp_file_prefix, const std::string& mph_file_path, const bool save_mph = false, const bool populate = false, uint64_t partition_count = 1);
+
+    // Returns the number of partitions of the k-mers in the hash table.
+    uint64_t partition_count() const;
+
+    // Returns the partition of the k-mer `kmer`. A k-mer and its reverse
+    // complement are in the same partition, and the buckets of a partition
+    // are contiguous.
+    uint64_t partition(const Kmer<k>& kmer) const;
 
     // Returns the id / number of the bucket in the hash table that is
     // supposed to store value items for the key `kmer`.
     uint64_t bucket_id(const Kmer<k>& kmer) const;
 
+    // Returns the id / number of the bucket in the hash table for the key
+    // `kmer`, with `kmer_hash` as its rolling hash.
+    uint64_t bucket_id(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Returns the id / number of the bucket in the hash table for the key
+    // `kmer`, with `kmer_hash` as its rolling hash and `minimizer` as its
+    // canonical minimizer.
+    uint64_t bucket_id(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, uint64_t minimizer) const;
+
+    // Computes the ids / numbers of the buckets in the hash table for the `n`
+    // keys at `kmers` into `ids`. The MPHF lookups for the keys are interleaved
+    // and their memory accesses are prefetched, hence it is much faster than `n`
+    // separate `bucket_id` queries for large tables.
+    void bucket_ids(const Kmer<k>* kmers, std::size_t n, uint64_t* ids) const;
+
+    // Computes the ids / numbers of the buckets in the hash table for the `n`
+    // keys at `kmers`, with `minimizer` as their canonical minimizers, into `ids`.
+    void bucket_ids(const Kmer<k>* kmers, const uint64_t* minimizer, std::size_t n, uint64_t* ids) const;
+
+    // Computes the ids / numbers of the buckets in the hash table for the `n`
+    // keys at `kmers`, with `kmer_hash` as their rolling hashes, into `ids`.
+    void bucket_ids(const Kmer<k>* kmers, const Kmer_Rolling_Hash<k>* kmer_hash, std::size_t n, uint64_t* ids) const;
+
+    // Computes the ids / numbers of the buckets in the hash table for the `n`
+    // keys at `kmers`, with `kmer_hash` as their rolling hashes and `minimizer`
+    // as their canonical minimizers, into `ids`.
+    void bucket_ids(const Kmer<k>* kmers, const Kmer_Rolling_Hash<k>* kmer_hash, const uint64_t* minimizer, std::size_t n, uint64_t* ids) const;
+
     // Returns the hash value of the k-mer `kmer`.
     uint64_t operator()(const Kmer<k>& kmer) const;
 
+    // Returns the hash value of the k-mer `kmer`, with `kmer_hash` as its rolling hash.
+    uint64_t operator()(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Prefetches the state-entries of the `n` buckets with ids `ids` into the
+    // cache, so that a following batch of accesses into them do not stall.
+    void fetch(const uint64_t* ids, std::size_t n) const;
+
+    // Prefetches the memory of the MPHF to be accessed first in computing the
+    // bucket id of the key `kmer`, with `kmer_hash` as its rolling hash.
+    void fetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Prefetches the memory of the MPHF to be accessed first in computing the
+    // bucket id of the key `kmer`, with `kmer_hash` as its rolling hash and
+    // `minimizer` as its canonical minimizer.
+    void fetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, uint64_t minimizer) const;
+
     // Returns an API to the entry (in the hash table) for a k-mer hashing
     // to the bucket number `bucket_id` of the hash table. The API wraps
     // the hash table position and the state value at that position.
@@ -171,6 +217,10 @@ public:
     // Transforms the state-entry in the hash-table that's at the bucket with ID
     // `bucket_id` through the function `transform`.
     void update(uint64_t bucket_id, cuttlefish::state_code_t (*transform)(cuttlefish::state_code_t));
+
+    // Transforms the state-entries in the hash-table that are at the `n` buckets
+    // with IDs `ids` through the function `transform`.
+    void update(const uint64_t* ids, std::size_t n, cuttlefish::state_code_t (*transform)(cuttlefish::state_code_t));
     
     // Attempts to update the hash table entries for the API objects `api_1` and
     // `api_2` concurrently, i.e. both the updates need to happen in a tied manner
@@ -182,6 +232,15 @@ public:
     // Returns the number of keys in the hash table.
     uint64_t size() const;
 
+    // Returns the memory (in bytes) of the hash table, i.e. of its MPHF and buckets.
+    std::size_t memory() const;
+
+    // Returns the page backing obtained for the hash table buckets.
+    Page_Backing bucket_backing() const;
+
+    // Returns the page backing obtained for the MPHF.
+    Page_Backing mphf_backing() const;
+
     // Clears the hash-table. Do not invoke on an unused object.
     void clear();
 
@@ -189,7 +248,10 @@ public:
     void save_hash_buckets(const std::string& file_path) const;
 
     // Loads the hash table buckets `hash_table` from the file at `file_path`.
-    void load_hash_buckets(const std::string& file_path);
+    // The file is memory-mapped copy-on-write, so that the buckets are used
+    // in-place without being copied; it is read fully into memory at once if
+    // `populate` is `true`, and is faulted-in on demand otherwise.
+    void load_hash_buckets(const std::string& file_path, bool populate = false);
 
     // Saves the hash table (i.e. the hash function and the buckets) into file
     // paths determined from the parameters collection `params`.
@@ -208,147 +270,191 @@ public:
 };
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY>::bucket_id(const Kmer<k>& kmer) const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::partition_count() const
+{
+    return mph->partition_count();
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::partition(const Kmer<k>& kmer) const
+{
+    return mph->partition(kmer);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_id(const Kmer<k>& kmer) const
 {
     return mph->lookup(kmer);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY>::operator()(const Kmer<k>& kmer) const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_id(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    return mph->lookup(kmer, kmer_hash);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_id(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, const uint64_t minimizer) const
+{
+    return mph->lookup(kmer, kmer_hash, minimizer);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_ids(const Kmer<k>* const kmers, const std::size_t n, uint64_t* const ids) const
+{
+    mph->lookup(kmers, n, ids);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_ids(const Kmer<k>* const kmers, const uint64_t* const minimizer, const std::size_t n, uint64_t* const ids) const
+{
+    mph->lookup(kmers, minimizer, n, ids);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_ids(const Kmer<k>* const kmers, const Kmer_Rolling_Hash<k>* const kmer_hash, const std::size_t n, uint64_t* const ids) const
+{
+    mph->lookup(kmers, kmer_hash, n, ids);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_ids(const Kmer<k>* const kmers, const Kmer_Rolling_Hash<k>* const kmer_hash, const uint64_t* const minimizer, const std::size_t n, uint64_t* const ids) const
+{
+    mph->lookup(kmers, kmer_hash, minimizer, n, ids);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::operator()(const Kmer<k>& kmer) const
 {
     return bucket_id(kmer);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY>::operator[](const uint64_t bucket_id)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::operator()(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const
 {
-    sparse_lock.lock(bucket_id);
-    const Kmer_Hash_Entry_API<BITS_PER_KEY> r(hash_table[bucket_id]);
-    sparse_lock.unlock(bucket_id);
-    
-    return r;
+    return bucket_id(kmer, kmer_hash);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY>::operator[](const Kmer<k>& kmer)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::fetch(const uint64_t* const ids, const std::size_t n) const
 {
-    return operator[](bucket_id(kmer));
+    for(std::size_t i = 0; i < n; ++i)
+        hash_table.prefetch(ids[i]);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::fetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    mph->prefetch(kmer, kmer_hash);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline const State Kmer_Hash_Table<k, BITS_PER_KEY>::operator[](const Kmer<k>& kmer) const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::fetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, const uint64_t minimizer) const
 {
-    const uint64_t bucket = bucket_id(kmer);
+    mph->prefetch(kmer, kmer_hash, minimizer);
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::operator[](const uint64_t bucket_id)
+{
+    return Kmer_Hash_Entry_API<BITS_PER_KEY>(bucket_id, hash_table.load(bucket_id));
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::operator[](const Kmer<k>& kmer)
+{
+    return operator[](bucket_id(kmer));
+}
 
-    sparse_lock.lock(bucket);
-    const State state(hash_table[bucket]);
-    sparse_lock.unlock(bucket);
 
-    return state;
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline const State Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::operator[](const Kmer<k>& kmer) const
+{
+    return State(hash_table.load(bucket_id(kmer)));
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY>::at(const Kmer<k>& kmer)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::at(const Kmer<k>& kmer)
 {
     return operator[](kmer);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY>::at(const uint64_t bucket_id)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline Kmer_Hash_Entry_API<BITS_PER_KEY> Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::at(const uint64_t bucket_id)
 {
     return operator[](bucket_id);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline bool Kmer_Hash_Table<k, BITS_PER_KEY>::update(Kmer_Hash_Entry_API<BITS_PER_KEY>& api)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline bool Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::update(Kmer_Hash_Entry_API<BITS_PER_KEY>& api)
 {
-    // const auto it = &(api.bv_entry);
-    // const uint64_t lidx = (std::distance(hash_table.begin(), it)) / lock_range_size;
-    // locks_[lidx].lock();
-    // const bool success = (api.bv_entry == api.get_read_state());
-    // if (success) {
-    //     api.bv_entry = api.get_current_state();
-    // }
-    // locks_[lidx].unlock();
-    // return success;
-
-    const uint64_t bucket = std::distance(hash_table.begin(), &(api.bv_entry));
-
-    sparse_lock.lock(bucket);
-    const bool success = (api.bv_entry == api.get_read_state());
-    if(success)
-        api.bv_entry = api.get_current_state();
-    sparse_lock.unlock(bucket);
-    
-    return success;
+    return hash_table.cas(api.bucket, api.get_read_state(), api.get_current_state());
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::update(const uint64_t bucket_id, const State_Read_Space& state)
+{
+    hash_table.store(bucket_id, state.get_state());
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline void Kmer_Hash_Table<k, BITS_PER_KEY>::update(const uint64_t bucket_id, const State_Read_Space& state)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::update(const uint64_t bucket_id, cuttlefish::state_code_t (* const transform)(cuttlefish::state_code_t))
 {
-    sparse_lock.lock(bucket_id);
-    hash_table[bucket_id] = state.get_state();
-    sparse_lock.unlock(bucket_id);
+    hash_table.transform(bucket_id, transform);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline void Kmer_Hash_Table<k, BITS_PER_KEY>::update(const uint64_t bucket_id, cuttlefish::state_code_t (* const transform)(cuttlefish::state_code_t))
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::update(const uint64_t* const ids, const std::size_t n, cuttlefish::state_code_t (* const transform)(cuttlefish::state_code_t))
 {
-    sparse_lock.lock(bucket_id);
-    hash_table[bucket_id] = transform(hash_table[bucket_id]);
-    sparse_lock.unlock(bucket_id);
+    fetch(ids, n);
+    for(std::size_t i = 0; i < n; ++i)
+        hash_table.transform(ids[i], transform);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline bool Kmer_Hash_Table<k, BITS_PER_KEY>::update_concurrent(Kmer_Hash_Entry_API<BITS_PER_KEY>& api_1, Kmer_Hash_Entry_API<BITS_PER_KEY>& api_2)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline bool Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::update_concurrent(Kmer_Hash_Entry_API<BITS_PER_KEY>& api_1, Kmer_Hash_Entry_API<BITS_PER_KEY>& api_2)
 {
-    Kmer_Hash_Entry_API<BITS_PER_KEY>* api_l = &api_1;
-    Kmer_Hash_Entry_API<BITS_PER_KEY>* api_r = &api_2;
-    uint64_t bucket_l = std::distance(hash_table.begin(), &(api_1.bv_entry));
-    uint64_t bucket_r = std::distance(hash_table.begin(), &(api_2.bv_entry));
-
-    // Resolution for potential deadlocks.
-    if(bucket_l > bucket_r)
-        std::swap(api_l, api_r),
-        std::swap(bucket_l, bucket_r);
-
-
-    sparse_lock.lock(bucket_l);
-    bool success = (api_l->bv_entry == api_l->get_read_state());
-    if(success)
-    {
-        sparse_lock.lock_if_different(bucket_l, bucket_r);
-
-        success = (api_r->bv_entry == api_r->get_read_state());
-        if(success)
-            api_l->bv_entry = api_l->get_current_state(),
-            api_r->bv_entry = api_r->get_current_state();
-        
-        sparse_lock.unlock_if_different(bucket_l, bucket_r);
-    }
-    sparse_lock.unlock(bucket_l);
-
-    return success;
+    return hash_table.cas_pair( api_1.bucket, api_1.get_read_state(), api_1.get_current_state(),
+                                api_2.bucket, api_2.get_read_state(), api_2.get_current_state());
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY>::size() const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline uint64_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::size() const
 {
     return kmer_count;
 }
 
 
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+inline std::size_t Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::memory() const
+{
+    return mph->bit_size() / 8 + hash_table.bytes();
+}
+
+
 
 #endif
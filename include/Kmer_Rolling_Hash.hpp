@@ -0,0 +1,155 @@
+
+#ifndef KMER_ROLLING_HASH_HPP
+#define KMER_ROLLING_HASH_HPP
+
+
+
+#include "DNA.hpp"
+
+#include <cstdint>
+
+
+// A canonical rolling hash for k-mers, in the spirit of ntHash: the k-mer and its reverse
+// complement are hashed separately, with hashes that are updated in constant time as the
+// k-mer rolls by a base; and the seeded hash values are drawn from the pair of these, so
+// that a k-mer and its reverse complement have the same hash values.
+// Each strand is hashed to its Karp-Rabin fingerprint: its 2-bit encoding as an integer,
+// modulo the Mersenne prime `M = 2^61 - 1`; instead of ntHash's sums of rotated base-hashes,
+// whose rotations of 64-bit words repeat every 64 bases and hence cancel out equal bases 64
+// positions apart for k > 64. As `4^32 = 2^64 = 2^3 (mod M)`, the fingerprints are computed
+// word-wise from the k-mer encodings, and a multiplication by a power of 2 modulo `M` is a
+// 61-bit rotation.
+// Ref: Karp and Rabin. Efficient randomized pattern-matching algorithms. IBM J. Res. Dev. 1987.
+//      Mohamadi et al. ntHash: recursive nucleotide hashing. Bioinformatics 2016.
+template <uint16_t k>
+class Kmer_Rolling_Hash
+{
+private:
+
+    // Number of 64-bit words packing a k-mer.
+    static constexpr uint16_t NUM_INTS = (k + 31) / 32;
+
+    // The modulus of the fingerprints.
+    static constexpr uint64_t M = (uint64_t(1) << 61) - 1;
+
+    // Residue of `4^(k - 1)`, i.e. the place value of the first base of a k-mer.
+    static constexpr uint64_t FRONT_PLACE = uint64_t(1) << ((2 * (k - 1)) % 61);
+
+    // `OUT_FWD[b]` is the residue of `-b * 4^k`, i.e. of the base `b` being chopped off
+    // the front of a k-mer that has been shifted a place up.
+    static constexpr uint64_t OUT_FWD[4] =
+        {0, M - (uint64_t(1) << ((2 * k) % 61)), M - ((uint64_t(2) << ((2 * k) % 61)) % M), M - ((uint64_t(3) << ((2 * k) % 61)) % M)};
+
+    // `IN_REV[b]` is the residue of `~b * 4^(k - 1)`, i.e. of the complement of the base
+    // `b` at the front of a reverse complement k-mer.
+    static constexpr uint64_t IN_REV[4] = {(3 * FRONT_PLACE) % M, (2 * FRONT_PLACE) % M, FRONT_PLACE, 0};
+
+    uint64_t fwd;   // Fingerprint of the forward strand, i.e. of the k-mer.
+    uint64_t rev;   // Fingerprint of the reverse strand, i.e. of the reverse complement of the k-mer.
+
+
+    // Returns a value congruent to `x` modulo `M`, and at most `M + 7`.
+    static uint64_t fold(uint64_t x);
+
+    // Returns the residue of `x`.
+    static uint64_t reduce(uint64_t x);
+
+    // Returns a value congruent to `x * 2^s` modulo `M`, and at most `M`, for `x <= M`
+    // and `0 <= s < 61`.
+    static uint64_t mul_pow_2(uint64_t x, uint16_t s);
+
+    // Returns the fingerprint of the k-mer packed at `kmer_data`.
+    static uint64_t fingerprint(const uint64_t* kmer_data);
+
+
+public:
+
+    // Constructs an empty hash.
+    Kmer_Rolling_Hash()
+    {}
+
+    // Constructs the hash of the k-mer packed at `kmer_data` with its reverse complement
+    // packed at `rev_compl_data`, both in the layout of `Kmer<k>`.
+    Kmer_Rolling_Hash(const uint64_t* kmer_data, const uint64_t* rev_compl_data);
+
+    // Updates the hash for the k-mer being rolled by one base, i.e. chopping off
+    // its first base `out` and appending the base `in` to its end.
+    void roll(DNA::Base out, DNA::Base in);
+
+    // Returns the hash value of the k-mer for the seed `seed`. It's identical for
+    // the k-mer and its reverse complement.
+    uint64_t operator()(uint64_t seed) const;
+};
+
+
+template <uint16_t k>
+inline uint64_t Kmer_Rolling_Hash<k>::fold(const uint64_t x)
+{
+    return (x & M) + (x >> 61);
+}
+
+
+template <uint16_t k>
+inline uint64_t Kmer_Rolling_Hash<k>::reduce(uint64_t x)
+{
+    // Branch-free, as the comparison is unpredictable.
+    x = fold(x);
+    return x - (M & (uint64_t(0) - (x >= M)));
+}
+
+
+template <uint16_t k>
+inline uint64_t Kmer_Rolling_Hash<k>::mul_pow_2(const uint64_t x, const uint16_t s)
+{
+    return ((x << s) & M) | (x >> (61 - s));
+}
+
+
+template <uint16_t k>
+inline uint64_t Kmer_Rolling_Hash<k>::fingerprint(const uint64_t* const kmer_data)
+{
+    // The words at their place values `2^(64 * idx) = 2^(3 * idx) (mod M)`, summed up; each
+    // word is split into its low 61 and high 3 bits, which are multiplied as rotations. The
+    // terms are independent of each other, unlike in Horner's rule.
+    uint64_t r = 0;
+    for(uint16_t idx = 0; idx < NUM_INTS; ++idx)
+    {
+        const uint16_t s = (3 * idx) % 61;
+        r = fold(r) + mul_pow_2(kmer_data[idx] & M, s) + mul_pow_2(kmer_data[idx] >> 61, s);
+    }
+
+    return reduce(r);
+}
+
+
+template <uint16_t k>
+inline Kmer_Rolling_Hash<k>::Kmer_Rolling_Hash(const uint64_t* const kmer_data, const uint64_t* const rev_compl_data):
+    fwd(fingerprint(kmer_data)),
+    rev(fingerprint(rev_compl_data))
+{}
+
+
+template <uint16_t k>
+inline void Kmer_Rolling_Hash<k>::roll(const DNA::Base out, const DNA::Base in)
+{
+    // The bases move a place up in the forward strand, and a place down in the reverse
+    // strand—a division by 4 modulo `M` is a multiplication by `2^59`.
+    fwd = reduce((fwd << 2) + OUT_FWD[out] + in);
+    rev = reduce(mul_pow_2(reduce(rev + (M - (DNA::T - out))), 59) + IN_REV[in]);
+}
+
+
+template <uint16_t k>
+inline uint64_t Kmer_Rolling_Hash<k>::operator()(const uint64_t seed) const
+{
+    // The smaller and the larger fingerprints are mixed through a 128-bit product, as in wyhash.
+    const uint64_t lo = (fwd < rev ? fwd : rev);
+    const uint64_t hi = (fwd < rev ? rev : fwd);
+    const __uint128_t p = static_cast<__uint128_t>(lo ^ seed ^ 0xe7037ed1a0b428dbULL) * (hi ^ (seed >> 7) ^ 0xa0761d6478bd642fULL);
+
+    return static_cast<uint64_t>(p) ^ static_cast<uint64_t>(p >> 64);
+}
+
+
+
+#endif
@@ -0,0 +1,101 @@
+
+#ifndef KMER_ROLLING_MINIMIZER_HPP
+#define KMER_ROLLING_MINIMIZER_HPP
+
+
+
+#include "Kmer.hpp"
+
+#include <cstdint>
+#include <algorithm>
+
+
+// The canonical l-minimizer of a k-mer (as `Kmer<k>::canonical_minimizer<l>()`), updated
+// as the k-mer rolls by a base. The l-mer entering the k-mer at each roll is compared
+// against the current minimizer in constant time; only when the last occurrence of the
+// minimizer leaves the k-mer is it computed afresh, in `O(k)` time. For random sequences,
+// that happens once per around `(k - l + 1) / 2` rolls.
+template <uint16_t k, uint8_t l>
+class Kmer_Rolling_Minimizer
+{
+private:
+
+    static constexpr uint64_t lmer_mask = (uint64_t(1) << (2 * l)) - 1;
+
+    uint64_t lmer = 0;  // The last l-mer of the k-mer.
+    uint64_t lmer_bar = 0;  // Reverse complement of the last l-mer of the k-mer.
+    uint64_t min_order = 0; // Order of the minimizer.
+    uint64_t minmzr = 0;    // The minimizer.
+    uint16_t pos = 0;   // Index of the first base of the last occurrence of the minimizer, counted from the back of the k-mer.
+
+
+public:
+
+    // Constructs an empty minimizer.
+    Kmer_Rolling_Minimizer()
+    {}
+
+    // Constructs the minimizer of the k-mer `kmer`.
+    Kmer_Rolling_Minimizer(const Kmer<k>& kmer);
+
+    // Computes the minimizer afresh for the k-mer `kmer`.
+    void reset(const Kmer<k>& kmer);
+
+    // Updates the minimizer for the k-mer having been rolled by a base, into `kmer`.
+    void roll(const Kmer<k>& kmer);
+
+    // Returns the minimizer.
+    uint64_t operator()() const;
+};
+
+
+template <uint16_t k, uint8_t l>
+inline Kmer_Rolling_Minimizer<k, l>::Kmer_Rolling_Minimizer(const Kmer<k>& kmer)
+{
+    reset(kmer);
+}
+
+
+template <uint16_t k, uint8_t l>
+inline void Kmer_Rolling_Minimizer<k, l>::reset(const Kmer<k>& kmer)
+{
+    minmzr = kmer.template canonical_minimizer<l>(pos);
+    min_order = Kmer<k>::minimizer_order(minmzr);
+
+    lmer = kmer.bases_at(k - l, l);
+    lmer_bar = 0;
+    for(uint16_t idx = 0; idx < l; ++idx)
+        lmer_bar = (lmer_bar << 2) | (((lmer >> (2 * idx)) & 0b11) ^ 0b11);
+}
+
+
+template <uint16_t k, uint8_t l>
+inline void Kmer_Rolling_Minimizer<k, l>::roll(const Kmer<k>& kmer)
+{
+    const uint64_t base = kmer.back();
+    lmer = ((lmer << 2) | base) & lmer_mask;
+    lmer_bar = (lmer_bar >> 2) | ((base ^ 0b11) << (2 * (l - 1)));
+
+    // A tie is the same l-mer, whose later occurrence stays longer in the k-mer.
+    const uint64_t canonical_lmer = std::min(lmer, lmer_bar);
+    const uint64_t order = Kmer<k>::minimizer_order(canonical_lmer);
+    if(order <= min_order)
+    {
+        min_order = order;
+        minmzr = canonical_lmer;
+        pos = l - 1;
+    }
+    else if(++pos >= k)
+        reset(kmer);
+}
+
+
+template <uint16_t k, uint8_t l>
+inline uint64_t Kmer_Rolling_Minimizer<k, l>::operator()() const
+{
+    return minmzr;
+}
+
+
+
+#endif
@@ -7,6 +7,7 @@
 #include "Kmer.hpp"
 #include "Kmer_Container.hpp"
 #include "kmc_api/kmc_file.h"
+#include "Event_Count.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -14,6 +15,8 @@
 #include <vector>
 #include <string>
 #include <thread>
+#include <atomic>
+#include <algorithm>
 
 
 // Data required by the consumers to correctly parse raw binary k-mers.
@@ -28,9 +31,11 @@ struct alignas(L1_CACHE_LINE_SIZE)
     // uint64_t pad_[1];           // Padding to avoid false-sharing.
 };
 
-// An "iterator" class to iterate over a k-mer database on disk, where a single producer thread
-// (sequentially) reads the raw binary representations of the k-mers from disk, and a number of
-// different consumer threads fetch (and parse) the raw binary k-mers.
+// An "iterator" class to iterate over a k-mer database on disk, where producer threads read the
+// raw binary representations of the k-mers from disk, and a number of different consumer threads
+// fetch (and parse) the raw binary k-mers. A single producer reads the database sequentially; with
+// many consumers, multiple producers read disjoint ranges of the prefix space of the database
+// concurrently, each at its own offsets.
 // Note: in a technical sense, it's not an iterator.
 template <uint16_t k>
 class Kmer_SPMC_Iterator
@@ -41,16 +46,20 @@ class Kmer_SPMC_Iterator
 private:
 
     const Kmer_Container<k>* const kmer_container;  // The associated k-mer container over which to iterate.
-    CKMC_DB kmer_database; // The k-mer database object.
 
     const uint64_t kmer_count;  // Number of k-mers present in the underlying database.
     const size_t consumer_count;  // Total number of consumer threads of the iterator.
+    const size_t producer_count;  // Total number of producer threads of the iterator.
 
-    uint64_t kmers_read;    // Number of raw k-mers read (off disk) by the iterator.
+    std::unique_ptr<CKMC_DB[]> kmer_database{nullptr}; // The k-mer database objects, one for each producer.
 
-    std::unique_ptr<std::thread> reader{nullptr};   // The thread doing the actual disk-read of the binary data, i.e. the producer thread.
+    std::atomic<uint64_t> kmers_read;   // Number of raw k-mers read (off disk) by the iterator.
+
+    std::vector<std::unique_ptr<std::thread>> reader;   // The threads doing the actual disk-read of the binary data, i.e. the producer threads.
 
     static constexpr size_t BUF_SZ_PER_CONSUMER = (1 << 24);   // Size of the consumer-specific buffers (in bytes): 16 MB.
+    static constexpr size_t CONSUMERS_PER_PRODUCER = 16;    // Number of consumers to be fed by each producer.
+    static constexpr size_t MAX_PRODUCER_COUNT = 8; // Maximum number of producers of an iterator.
 
     std::vector<Consumer_Data> consumer;   // Parsing data required for each consumer.
 
@@ -58,26 +67,46 @@ private:
     enum class Task_Status: uint8_t
     {
         pending,    // k-mers yet to be provided;
+        filling,    // k-mers are being provided by some producer;
         available,  // k-mers are available and waiting to be parsed and processed;
         no_more,    // no k-mers will be provided anymore.
     };
 
-    volatile Task_Status* task_status{nullptr}; // Collection of the task statuses of the consumers.
+    std::atomic<Task_Status>* task_status{nullptr}; // Collection of the task statuses of the consumers.
+    std::unique_ptr<Event_Count[]> task_event{nullptr}; // Collection of the events of k-mers being provided to the consumers, or of them being informed of no more k-mers.
+    mutable Event_Count idle_event; // Event of some consumer becoming idle, i.e. pending on k-mers.
+
+
+    // Waits until either k-mers are available for the consumer with id `consumer_id`, or it
+    // is informed that no more k-mers will be provided. Returns `true` iff k-mers are available.
+    bool await_task(size_t consumer_id);
+
+    // Marks the consumer with id `consumer_id` as pending on k-mers.
+    void mark_pending(size_t consumer_id);
+
 
+    // Returns the number of producers to feed `consumer_count` consumers.
+    static size_t producer_count_for(size_t consumer_count);
 
-    // Opens the k-mer database file with the path prefix `db_path`.
-    void open_kmer_database(const std::string& db_path);
+    // Opens the k-mer database file with the path prefix `db_path` for the producer
+    // with id `producer_id`.
+    void open_kmer_database(size_t producer_id, const std::string& db_path);
 
-    // Closes the k-mer database file.
-    void close_kmer_database();
+    // Closes the k-mer database file of the producer with id `producer_id`.
+    void close_kmer_database(size_t producer_id);
 
-    // Reads raw binary k-mer representations from the underlying k-mer database, and
-    // makes those available for consumer threads. Reading continues until the database
-    // has been depleted.
-    void read_raw_kmers();
+    // Splits the prefix space of the database into ranges having roughly equal numbers
+    // of k-mers, and restricts the listing of each producer to its range.
+    void partition_prefixes();
 
-    // Returns the id (number) of an idle consumer thread.
-    size_t get_idle_consumer() const;
+    // Reads raw binary k-mer representations from the k-mer database range of the
+    // producer with id `producer_id`, and makes those available for consumer threads.
+    // Reading continues until the range has been depleted.
+    void read_raw_kmers(size_t producer_id);
+
+    // Claims and returns the id (number) of an idle consumer thread, starting the
+    // search from the id `start_id`.
+    size_t get_idle_consumer(size_t start_id) const;
 
 
 public:
@@ -101,9 +130,16 @@ public:
     iterator& operator=(const iterator& rhs) = delete;
 
     // Tries to fetch and parse the next k-mer for the consumer with id `consumer_id` into `kmer`.
-    // Returns `true` iff it's successful, i.e. k-mers were remaining for this consumer.
+    // Returns `true` iff it's successful, i.e. k-mers were remaining for this consumer. Waits for
+    // k-mers to be provided to the consumer if it's pending on those.
     bool value_at(size_t consumer_id, Kmer<k>& kmer);
 
+    // Tries to fetch and parse up-to `max` next k-mers for the consumer with id `consumer_id` into
+    // `out`. Returns the number of k-mers parsed; `0` is returned iff no k-mers were remaining for
+    // this consumer at the moment. Waits for k-mers to be provided to the consumer if it's pending
+    // on those.
+    std::size_t next_chunk(size_t consumer_id, Kmer<k>* out, std::size_t max);
+
     // Returns `true` iff this and `rhs` — both the iterators refer to the same container and
     // the same number of raw k-mers have been read (from disk) for both.
     bool operator==(const iterator& rhs) const;
@@ -122,7 +158,7 @@ public:
 
     // Waits for the disk-reads of the raw k-mers to be completed, and then waits for the consumers
     // to finish their ongoing tasks; then signals them that no more data are to be provided, and
-    // also closes the k-mer database. 
+    // also closes the k-mer databases.
     void seize_production();
 
     // Returns `true` iff tasks might be provided to the consumer with id `consumer_id` in future.
@@ -148,6 +184,7 @@ inline Kmer_SPMC_Iterator<k>::Kmer_SPMC_Iterator(const Kmer_Container<k>* const
     kmer_container(kmer_container),
     kmer_count{kmer_container->size()},
     consumer_count{consumer_count},
+    producer_count{producer_count_for(consumer_count)},
     kmers_read{at_end ? kmer_count : 0}
 {
     if(!(at_begin ^ at_end))
@@ -163,7 +200,8 @@ inline Kmer_SPMC_Iterator<k>::Kmer_SPMC_Iterator(const iterator& other):
     kmer_container(other.kmer_container),
     kmer_count{other.kmer_count},
     consumer_count{other.consumer_count},
-    kmers_read{other.kmers_read}
+    producer_count{other.producer_count},
+    kmers_read{other.kmers_read.load()}
 {}
 
 
@@ -183,9 +221,16 @@ inline Kmer_SPMC_Iterator<k>::~Kmer_SPMC_Iterator()
 
 
 template <uint16_t k>
-inline void Kmer_SPMC_Iterator<k>::open_kmer_database(const std::string& db_path)
+inline size_t Kmer_SPMC_Iterator<k>::producer_count_for(const size_t consumer_count)
 {
-    if(!kmer_database.open_for_cuttlefish_listing(db_path))
+    return std::max(std::min(consumer_count / CONSUMERS_PER_PRODUCER, MAX_PRODUCER_COUNT), static_cast<size_t>(1));
+}
+
+
+template <uint16_t k>
+inline void Kmer_SPMC_Iterator<k>::open_kmer_database(const size_t producer_id, const std::string& db_path)
+{
+    if(!kmer_database[producer_id].open_for_cuttlefish_listing(db_path))
     {
         std::cerr << "Error opening k-mer database with prefix " << db_path << ". Aborting.\n";
         std::exit(EXIT_FAILURE);
@@ -194,9 +239,9 @@ inline void Kmer_SPMC_Iterator<k>::open_kmer_database(const std::string& db_path
 
 
 template <uint16_t k>
-inline void Kmer_SPMC_Iterator<k>::close_kmer_database()
+inline void Kmer_SPMC_Iterator<k>::close_kmer_database(const size_t producer_id)
 {
-    if(!kmer_database.Close())
+    if(!kmer_database[producer_id].Close())
     {
         std::cerr << "Error closing k-mer database. Aborting.\n";
         std::exit(EXIT_FAILURE);
@@ -204,6 +249,39 @@ inline void Kmer_SPMC_Iterator<k>::close_kmer_database()
 }
 
 
+template <uint16_t k>
+inline void Kmer_SPMC_Iterator<k>::partition_prefixes()
+{
+    const CKMC_DB& db = kmer_database[0];
+    const uint64_t prefix_end = db.prefix_count() - 1;  // The last entry of the prefix file is a guard.
+
+    uint64_t range_begin = 0;
+    for(size_t p_id = 0; p_id < producer_count; ++p_id)
+    {
+        uint64_t range_end = prefix_end;
+        if(p_id + 1 < producer_count)
+        {
+            // Find the first prefix at or after which the next producer's share of the k-mers starts.
+            const uint64_t kmer_boundary = (kmer_count / producer_count) * (p_id + 1);
+            uint64_t lo = range_begin, hi = prefix_end;
+            while(lo < hi)
+            {
+                const uint64_t mid = lo + (hi - lo) / 2;
+                if(db.prefix_suffix_idx(mid) < kmer_boundary)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            range_end = lo;
+        }
+
+        kmer_database[p_id].restrict_listing(range_begin, range_end);
+        range_begin = range_end;
+    }
+}
+
+
 template <uint16_t k>
 inline void Kmer_SPMC_Iterator<k>::launch_production()
 {
@@ -212,7 +290,8 @@ inline void Kmer_SPMC_Iterator<k>::launch_production()
 
     // Initialize the buffers and the parsing data structures.
 
-    task_status = new volatile Task_Status[consumer_count];
+    task_status = new std::atomic<Task_Status>[consumer_count];
+    task_event.reset(new Event_Count[consumer_count]);
 
     consumer.resize(consumer_count);
     for(size_t id = 0; id < consumer_count; ++id)
@@ -226,36 +305,46 @@ inline void Kmer_SPMC_Iterator<k>::launch_production()
         task_status[id] = Task_Status::pending;
     }
 
-    // Open the underlying k-mer database.
-    open_kmer_database(kmer_container->container_location());
-
-    // Launch the background disk-reader thread.
-    reader.reset(
-        new std::thread([this]()
-            {
-                read_raw_kmers();
-            }
-        )
-    );
+    // Open the underlying k-mer database, once for each producer.
+    kmer_database.reset(new CKMC_DB[producer_count]);
+    for(size_t p_id = 0; p_id < producer_count; ++p_id)
+        open_kmer_database(p_id, kmer_container->container_location());
+
+    if(producer_count > 1)
+        partition_prefixes();
+
+    // Launch the background disk-reader threads.
+    reader.resize(producer_count);
+    for(size_t p_id = 0; p_id < producer_count; ++p_id)
+        reader[p_id].reset(
+            new std::thread([this, p_id]()
+                {
+                    read_raw_kmers(p_id);
+                }
+            )
+        );
 }
 
 
 template <uint16_t k>
 inline bool Kmer_SPMC_Iterator<k>::launched() const
 {
-    return reader != nullptr;
+    return !reader.empty();
 }
 
 
 template <uint16_t k>
-inline void Kmer_SPMC_Iterator<k>::read_raw_kmers()
+inline void Kmer_SPMC_Iterator<k>::read_raw_kmers(const size_t producer_id)
 {
-    while(!kmer_database.Eof())
+    CKMC_DB& db = kmer_database[producer_id];
+    const size_t start_id = (producer_id * consumer_count) / producer_count;    // Producers search for idle consumers from spread-out positions.
+
+    while(!db.Eof())
     {
-        const size_t consumer_id = get_idle_consumer();
+        const size_t consumer_id = get_idle_consumer(start_id);
         Consumer_Data& consumer_state = consumer[consumer_id];
 
-        consumer_state.kmers_available = kmer_database.read_raw_suffixes(consumer_state.suff_buf, consumer_state.pref_buf, BUF_SZ_PER_CONSUMER);
+        consumer_state.kmers_available = db.read_raw_suffixes(consumer_state.suff_buf, consumer_state.pref_buf, BUF_SZ_PER_CONSUMER);
         consumer_state.pref_it = consumer_state.pref_buf.begin();
 
         if(!consumer_state.kmers_available)
@@ -268,24 +357,38 @@ inline void Kmer_SPMC_Iterator<k>::read_raw_kmers()
 
         consumer_state.kmers_parsed = 0;
         task_status[consumer_id] = Task_Status::available;
+        task_event[consumer_id].notify_all();
     }
 }
 
 
 template <uint16_t k>
-inline size_t Kmer_SPMC_Iterator<k>::get_idle_consumer() const
+inline size_t Kmer_SPMC_Iterator<k>::get_idle_consumer(const size_t start_id) const
 {
-    size_t id{0};
+    size_t id{start_id};
 
-    while(task_status[id] != Task_Status::pending)  // busy-wait
-    {
-        // id = (id + 1) % consumer_count;
-        id++;
-        if(id == consumer_count)
-            id = 0;
-    }
+    // Sweeps over the consumers once, trying to claim an idle one.
+    const auto claim_idle =
+        [this, &id]()
+        {
+            for(size_t i = 0; i < consumer_count; ++i)
+            {
+                Task_Status status = Task_Status::pending;
+                if(task_status[id] == Task_Status::pending &&
+                    task_status[id].compare_exchange_strong(status, Task_Status::filling, std::memory_order_acquire))
+                    return true;
+
+                // id = (id + 1) % consumer_count;
+                id++;
+                if(id == consumer_count)
+                    id = 0;
+            }
+
+            return false;
+        };
 
-    return id;     
+    idle_event.await(claim_idle);
+    return id;
 }
 
 
@@ -293,49 +396,97 @@ template <uint16_t k>
 inline void Kmer_SPMC_Iterator<k>::seize_production()
 {
     // Wait for the disk-reads to be completed.
-    if(!reader->joinable())
+    for(auto& r : reader)
     {
-        std::cerr << "Early termination encountered for the database reader thread. Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
+        if(!r->joinable())
+        {
+            std::cerr << "Early termination encountered for a database reader thread. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
 
-    reader->join();
+        r->join();
+    }
 
 
     // Wait for the consumers to finish consumption, and signal them that the means of production have been seized.
     for(size_t id = 0; id < consumer_count; ++id)
     {
-        while(task_status[id] != Task_Status::pending); // busy-wait
+        idle_event.await([this, id](){ return task_status[id] == Task_Status::pending; });
         
         task_status[id] = Task_Status::no_more;
+        task_event[id].notify_all();
     }
 
-    // Close the underlying k-mer database.
-    close_kmer_database();
+    // Close the underlying k-mer databases.
+    for(size_t p_id = 0; p_id < producer_count; ++p_id)
+        close_kmer_database(p_id);
+}
+
+
+template <uint16_t k>
+inline bool Kmer_SPMC_Iterator<k>::await_task(const size_t consumer_id)
+{
+    task_event[consumer_id].await(
+        [this, consumer_id]()
+        {
+            const Task_Status status = task_status[consumer_id];
+            return status == Task_Status::available || status == Task_Status::no_more;
+        });
+
+    return task_available(consumer_id);
+}
+
+
+template <uint16_t k>
+inline void Kmer_SPMC_Iterator<k>::mark_pending(const size_t consumer_id)
+{
+    task_status[consumer_id] = Task_Status::pending;
+    idle_event.notify_all();
 }
 
 
 template <uint16_t k>
 inline bool Kmer_SPMC_Iterator<k>::value_at(const size_t consumer_id, Kmer<k>& kmer)
 {
-    // TODO: try to delay this `volatile` access as much as possible, as each access directly hits the actual memory location.
-    if(!task_available(consumer_id))
+    if(!await_task(consumer_id))
         return false;
 
     auto& ts = consumer[consumer_id];
     if(ts.kmers_parsed == ts.kmers_available)
     {
-        task_status[consumer_id] = Task_Status::pending;
+        mark_pending(consumer_id);
         return false;
     }
 
-    kmer_database.parse_kmer_buf<k>(ts.pref_it, ts.suff_buf, ts.kmers_parsed * kmer_database.suff_record_size(), kmer);
+    // The producers' databases share the same parameters, so any of these can parse the k-mers.
+    kmer_database[0].parse_kmer_buf<k>(ts.pref_it, ts.suff_buf, ts.kmers_parsed * kmer_database[0].suff_record_size(), kmer);
     ts.kmers_parsed++;
 
     return true;
 }
 
 
+template <uint16_t k>
+inline std::size_t Kmer_SPMC_Iterator<k>::next_chunk(const size_t consumer_id, Kmer<k>* const out, const std::size_t max)
+{
+    if(!await_task(consumer_id))
+        return 0;
+
+    auto& ts = consumer[consumer_id];
+    if(ts.kmers_parsed == ts.kmers_available)
+    {
+        mark_pending(consumer_id);
+        return 0;
+    }
+
+    const std::size_t n = std::min(static_cast<std::size_t>(ts.kmers_available - ts.kmers_parsed), max);
+    kmer_database[0].parse_kmer_buf<k>(ts.pref_it, ts.suff_buf, ts.kmers_parsed * kmer_database[0].suff_record_size(), out, n);
+    ts.kmers_parsed += n;
+
+    return n;
+}
+
+
 template <uint16_t k>
 inline bool Kmer_SPMC_Iterator<k>::operator==(const iterator& rhs) const
 {
@@ -367,14 +518,14 @@ inline bool Kmer_SPMC_Iterator<k>::task_available(const size_t consumer_id) cons
 template <uint16_t k>
 inline std::size_t Kmer_SPMC_Iterator<k>::memory() const
 {
-    return CKMC_DB::pref_buf_memory() + (consumer_count * BUF_SZ_PER_CONSUMER);
+    return (producer_count * CKMC_DB::pref_buf_memory()) + (consumer_count * BUF_SZ_PER_CONSUMER);
 }
 
 
 template <uint16_t k>
 inline std::size_t Kmer_SPMC_Iterator<k>::memory(const std::size_t consumer_count)
 {
-    return CKMC_DB::pref_buf_memory() + (consumer_count * BUF_SZ_PER_CONSUMER);
+    return (producer_count_for(consumer_count) * CKMC_DB::pref_buf_memory()) + (consumer_count * BUF_SZ_PER_CONSUMER);
 }
 
 
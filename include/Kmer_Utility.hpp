@@ -8,6 +8,10 @@
 
 #include <cstdint>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 
 class Kmer_Utility
 {
@@ -34,6 +38,9 @@ private:
         240, 176, 112,  48, 224, 160,  96,  32, 208, 144,  80,  16, 192, 128,  64,   0
     };
 
+    // Returns the 64-bit word with the bit `i` of `x` at its bit `2i`.
+    static uint64_t spread_bits(uint32_t x);
+
 
 public:
 
@@ -45,17 +52,98 @@ public:
         return REVERSE_COMPLEMENT_BYTE[byte];
     }
 
+    // Returns the word `w` with the order of its 32 2-bit bases reversed.
+    static uint64_t reverse_bases(uint64_t w);
+
+    // Returns the reverse complement of the 32-mer `w`, in the `DNA::Base` representation.
+    static uint64_t reverse_complement_word(uint64_t w);
+
     // Returns the binary encoding word of the literal k-mer `label`.
     template <uint16_t k>
     static uint64_t encode(const char* label);
+
+    // Returns the binary encoding word of the 32 bases at `label`. The bases are encoded
+    // all at once with AVX2 or SSE2, and one at a time otherwise.
+    static uint64_t encode_word(const char* label);
 };
 
 
+inline uint64_t Kmer_Utility::spread_bits(const uint32_t x)
+{
+    uint64_t w = x;
+    w = (w | (w << 16)) & 0x0000FFFF0000FFFFULL;
+    w = (w | (w <<  8)) & 0x00FF00FF00FF00FFULL;
+    w = (w | (w <<  4)) & 0x0F0F0F0F0F0F0F0FULL;
+    w = (w | (w <<  2)) & 0x3333333333333333ULL;
+    w = (w | (w <<  1)) & 0x5555555555555555ULL;
+
+    return w;
+}
+
+
+inline uint64_t Kmer_Utility::reverse_bases(uint64_t w)
+{
+    // Reverse the bytes, then the nibbles in each byte, and then the 2-bit groups in each nibble.
+    w = __builtin_bswap64(w);
+    w = ((w >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((w & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    w = ((w >> 2) & 0x3333333333333333ULL) | ((w & 0x3333333333333333ULL) << 2);
+
+    return w;
+}
+
+
+inline uint64_t Kmer_Utility::reverse_complement_word(const uint64_t w)
+{
+    // The complement of a base `b` in the `DNA::Base` representation is `3 - b`, i.e. `~b`.
+    return reverse_bases(~w);
+}
+
+
+inline uint64_t Kmer_Utility::encode_word(const char* const label)
+{
+#if defined(__SSE2__)
+    // The `DNA::Base` encoding of a base `c`, in either case, is `((c >> 1) ^ (c >> 2)) & 0b11`.
+    // The low and the high bits of the encodings are gathered into a mask each, with the
+    // bit `i` of a mask from the `i`'th base.
+    uint32_t lo_bits, hi_bits;
+
+#if defined(__AVX2__)
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(label));
+    const __m256i code = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi16(v, 1), _mm256_srli_epi16(v, 2)), _mm256_set1_epi8(0b11));
+    lo_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(code, 7)));
+    hi_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(code, 6)));
+#else
+    const __m128i v_0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(label));
+    const __m128i v_1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(label + 16));
+    const __m128i code_0 = _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(v_0, 1), _mm_srli_epi16(v_0, 2)), _mm_set1_epi8(0b11));
+    const __m128i code_1 = _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(v_1, 1), _mm_srli_epi16(v_1, 2)), _mm_set1_epi8(0b11));
+    lo_bits =   static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(code_0, 7))) |
+                (static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(code_1, 7))) << 16);
+    hi_bits =   static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(code_0, 6))) |
+                (static_cast<uint32_t>(_mm_movemask_epi8(_mm_slli_epi16(code_1, 6))) << 16);
+#endif
+
+    // Interleave the masks, putting the `i`'th base at the bits `2i` and `2i + 1`; then
+    // reverse the order of the 2-bit groups, as the first base is to be the most significant.
+    return reverse_bases(spread_bits(lo_bits) | (spread_bits(hi_bits) << 1));
+#else
+    uint64_t w = 0;
+    for(uint16_t i = 0; i < 32; ++i)
+        w = (w << 2) | DNA_Utility::map_base(label[i]);
+
+    return w;
+#endif
+}
+
+
 template <uint16_t k>
 inline uint64_t Kmer_Utility::encode(const char* const label)
 {
     static_assert(0 < k && k <= 32, "invalid k-mer label length for machine word encoding");
 
+    if constexpr(k == 32)
+        return encode_word(label);
+
     if constexpr(k > 1)
         return (static_cast<uint64_t>(DNA_Utility::map_base(*label)) << (2 * (k - 1))) | encode<k - 1>(label + 1);
 
@@ -5,7 +5,6 @@
 
 
 #include "Unitig_Scratch.hpp"
-#include "FASTA_Record.hpp"
 #include "Character_Buffer.hpp"
 
 #include <cstdint>
@@ -40,8 +39,10 @@ private:
 
 public:
 
-    // Constructs an empty scratch space for the unitig.
-    Maximal_Unitig_Scratch();
+    // Constructs an empty scratch space for the unitig, with the labels and the
+    // hashes of its unitig pieces kept in slabs from the arenas `label_arena` and
+    // `hash_arena`, respectively.
+    Maximal_Unitig_Scratch(Slab_Arena<char>& label_arena, Slab_Arena<uint64_t>& hash_arena);
 
     // Returns the unitig scratch `u_b` or `u_f`, based on `s` (see note above
     // class body).
@@ -55,11 +56,11 @@ public:
     bool is_linear() const;
 
     // Returns the hashes of the vertices of the unitig at side `s`.
-    const std::vector<uint64_t>& unitig_hash(cuttlefish::side_t s) const;
+    const Slab_Vector<uint64_t>& unitig_hash(cuttlefish::side_t s) const;
 
     // Returns the hashes of the vertices in the maximal unitig in case it's
     // a DCC.
-    const std::vector<uint64_t>& cycle_hash() const;
+    const Slab_Vector<uint64_t>& cycle_hash() const;
 
     // Returns the count of vertices in the maximal unitig.
     std::size_t size() const;
@@ -84,11 +85,8 @@ public:
     // Returns `true` iff the maximal unitig has been marked as a cycle.
     bool is_cycle() const;
 
-    // Returns a FASTA record of the maximal unitig (in canonical form).
-    // Applicable when the maximal unitig is linear.
-    const FASTA_Record<std::vector<char>> fasta_rec() const;
-
-    // Adds a corresponding FASTA record for the maximal unitig into `buffer`.
+    // Adds a corresponding FASTA record for the maximal unitig (in canonical
+    // form) into `buffer`, writing the labels of its unitig pieces directly.
     template <std::size_t CAPACITY, typename T_sink_> void add_fasta_rec_to_buffer(Character_Buffer<CAPACITY, T_sink_>& buffer) const;
 };
 
@@ -129,14 +127,14 @@ inline void Maximal_Unitig_Scratch<k>::mark_linear()
 
 
 template <uint16_t k>
-inline const std::vector<uint64_t>& Maximal_Unitig_Scratch<k>::unitig_hash(const cuttlefish::side_t s) const
+inline const Slab_Vector<uint64_t>& Maximal_Unitig_Scratch<k>::unitig_hash(const cuttlefish::side_t s) const
 {
     return (s == cuttlefish::side_t::back ? unitig_back.hash() : unitig_front.hash());
 }
 
 
 template <uint16_t k>
-inline const std::vector<uint64_t>& Maximal_Unitig_Scratch<k>::cycle_hash() const
+inline const Slab_Vector<uint64_t>& Maximal_Unitig_Scratch<k>::cycle_hash() const
 {
     return cycle->hash();
 }
@@ -193,23 +191,33 @@ inline bool Maximal_Unitig_Scratch<k>::is_cycle() const
 }
 
 
-template <uint16_t k>
-inline const FASTA_Record<std::vector<char>> Maximal_Unitig_Scratch<k>::fasta_rec() const
-{
-    return is_canonical() ?
-            FASTA_Record<std::vector<char>>(id(), unitig_front.label(), unitig_back.label(), 0, k) :
-            FASTA_Record<std::vector<char>>(id(), unitig_back.label(), unitig_front.label(), 0, k);
-}
-
-
 template <uint16_t k>
 template <std::size_t CAPACITY, typename T_sink_>
 inline void Maximal_Unitig_Scratch<k>::add_fasta_rec_to_buffer(Character_Buffer<CAPACITY, T_sink_>& buffer) const
 {
     if(is_linear())
-        buffer += fasta_rec();
+    {
+        // The label is the first piece's, glued with the second's past their common vertex.
+        const Unitig_Scratch<k>& first = (is_canonical() ? unitig_front : unitig_back);
+        const Unitig_Scratch<k>& second = (is_canonical() ? unitig_back : unitig_front);
+        buffer.append_fasta_rec(id(), first.label_size() + second.label_size() - k,
+                                [&first, &second](std::vector<char>& buf)
+                                {
+                                    first.append_label(buf, 0, first.label_size());
+                                    second.append_label(buf, k, second.label_size());
+                                });
+    }
     else
-        buffer.template rotate_append_cycle<k>(FASTA_Record<std::vector<char>>(id(), cycle->label()), cycle->min_vertex_idx());
+    {
+        // The cycle is right-rotated so that its signature vertex starts the label.
+        const std::size_t pivot = cycle->min_vertex_idx();
+        buffer.append_fasta_rec(id(), cycle->label_size(),
+                                [this, pivot](std::vector<char>& buf)
+                                {
+                                    cycle->append_label(buf, pivot, cycle->label_size());
+                                    cycle->append_label(buf, k - 1, k - 1 + pivot);
+                                });
+    }
 }
 
 
@@ -0,0 +1,84 @@
+
+#ifndef MEMORY_MAPPED_FILE_HPP
+#define MEMORY_MAPPED_FILE_HPP
+
+
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <iostream>
+
+
+// A private (copy-on-write) memory-mapping of a file, so that serialized data
+// structures can be used in-place without copying them through streams. Writes
+// into the mapping are never carried to the file.
+class Memory_Mapped_File
+{
+private:
+
+    void* addr; // Address of the mapping.
+    std::size_t size_;  // Size of the mapped file in bytes.
+
+
+public:
+
+    // Alignment (in bytes) of the sections of the files laid out to be mapped.
+    static constexpr std::size_t page_size = 4096;
+
+    // Maps the file at path `file_path` into memory. If `populate` is `true`,
+    // then the file is read fully into memory at once (`MAP_POPULATE`);
+    // otherwise, pages are faulted in on demand, and the mapping is advised to
+    // be accessed at random if `random_access` is `true`.
+    Memory_Mapped_File(const std::string& file_path, bool populate = false, bool random_access = true);
+
+    Memory_Mapped_File(const Memory_Mapped_File&) = delete;
+    Memory_Mapped_File& operator=(const Memory_Mapped_File&) = delete;
+
+    // Unmaps the file.
+    ~Memory_Mapped_File();
+
+    // Returns the address of the mapped file content.
+    const char* data() const;
+
+    // Returns a writable address of the mapped file content.
+    char* data();
+
+    // Returns the size of the mapped file in bytes.
+    std::size_t size() const;
+
+    // Returns the smallest offset at least `offset` that is aligned to `page_size`.
+    static std::size_t page_align(std::size_t offset);
+
+    // Pads the stream `output`, which is at offset `offset`, with zeros to the
+    // next `page_size`-aligned offset. Returns the padded offset.
+    static std::size_t pad(std::ostream& output, std::size_t offset);
+};
+
+
+inline const char* Memory_Mapped_File::data() const
+{
+    return static_cast<const char*>(addr);
+}
+
+
+inline char* Memory_Mapped_File::data()
+{
+    return static_cast<char*>(addr);
+}
+
+
+inline std::size_t Memory_Mapped_File::size() const
+{
+    return size_;
+}
+
+
+inline std::size_t Memory_Mapped_File::page_align(const std::size_t offset)
+{
+    return (offset + page_size - 1) / page_size * page_size;
+}
+
+
+
+#endif
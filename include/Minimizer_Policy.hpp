@@ -26,6 +26,7 @@ private:
     static constexpr uint8_t MAX_LEN = 16;
     
     static constexpr uint32_t NUM_LMERS = 0b1U << (2 * l);   // Number of different possible `l`-mers.
+    static constexpr std::size_t PARSE_CHUNK_SZ = 64;   // Number of k-mers parsed from the database at a time by a thread.
     std::string kmer_db_path;   // Path to the underlying k-mer database.
     std::vector<uint32_t> order;    // `order[i]` denotes the order of the minimizer `i` in the policy.
 
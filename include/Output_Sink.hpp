@@ -5,6 +5,7 @@
 
 
 #include "Async_Logger_Wrapper.hpp"
+#include "Parallel_Writer.hpp"
 #include "spdlog/spdlog.h"
 
 #include <fstream>
@@ -71,5 +72,32 @@ public:
 };
 
 
+template <>
+class Output_Sink<Parallel_Writer>
+{
+private:
+
+    Parallel_Writer output_;
+
+
+public:
+
+    void init_sink(const std::string& output_file_path, const bool direct_io = false)
+    {
+        output_.open(output_file_path, direct_io);
+    }
+
+    Parallel_Writer& sink()
+    {
+        return output_;
+    }
+
+    void close_sink()
+    {
+        output_.close();
+    }
+};
+
+
 
 #endif
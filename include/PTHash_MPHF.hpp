@@ -0,0 +1,375 @@
+
+#ifndef PTHASH_MPHF_HPP
+#define PTHASH_MPHF_HPP
+
+
+
+#include "Kmer.hpp"
+#include "Memory_Mapped_File.hpp"
+#include "Huge_Pages.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+
+template <uint16_t k> class Kmer_Container;
+template <uint16_t k> class Kmer_SPMC_Iterator;
+
+
+// A partitioned PTHash-style minimal perfect hash function (MPHF) over k-mers.
+// The keys are split into partitions by their hashes; each partition is a table
+// of size `n / alpha` for its `n` keys, where the keys are grouped into buckets
+// and each bucket stores a "pilot" value—the keys of a bucket are placed at
+// positions determined by their hashes and the pilot of the bucket. A lookup
+// thus costs one random access to the packed pilots (and an infrequent access
+// to the remapping of the overflowing positions), in contrast to BBHash's
+// multiple level-wise accesses.
+// Ref: Pibiri and Trani. PTHash: Revisiting FCH Minimal Perfect Hashing. SIGIR 2021.
+template <uint16_t k>
+class PTHash_MPHF
+{
+private:
+
+    // Meta-information of a partition of the keys.
+    struct Partition
+    {
+        uint64_t offset;            // Number of keys in the preceding partitions.
+        uint64_t table_size;        // Number of positions in the partition's table.
+        uint64_t pilot_offset;      // Bit-offset of the partition's pilots into the packed pilots.
+        uint64_t remap_offset;      // Offset of the partition's remapped positions into the remapping.
+        uint32_t key_count;         // Number of keys in the partition.
+        uint32_t bucket_count;      // Number of buckets in the partition.
+        uint32_t dense_bucket_count;    // Number of buckets receiving the dense share of the keys.
+        uint8_t pilot_width;        // Number of bits used per pilot of the partition.
+    };
+
+    // Expected number of keys per partition.
+    static constexpr uint64_t partition_size = (1U << 21);
+
+    // Load factor of the partition tables.
+    static constexpr double alpha = 0.99;
+
+    // Fraction of the keys that are mapped to the dense buckets.
+    static constexpr double dense_key_fraction = 0.6;
+
+    // Fraction of the buckets that are dense.
+    static constexpr double dense_bucket_fraction = 0.3;
+
+    // Empirical bits-per-key requirement for each integral `gamma` (i.e. the
+    // bucket-count constant `c`) in the range [0, 8].
+    static constexpr double bits_per_gamma[] = {0, 0, 0, 2.67, 3.00, 3.24, 3.59, 4.00, 4.22};
+
+    // Maximum number of seeds tried for a build, before giving up on the keys as
+    // having some identical fingerprints, which no seed can tell apart.
+    static constexpr uint64_t max_seed_attempts = 64;
+
+    uint64_t seed;  // Seed for the hashes of the keys.
+    uint64_t key_count; // Number of keys in the function.
+    uint64_t partition_count;   // Number of partitions of the keys.
+    uint64_t pilot_words;   // Number of words in the packed pilots.
+    uint64_t remap_size;    // Number of remapped positions.
+
+    // Storage of the function when it is built in memory.
+    std::vector<Partition> partition_buf;
+    std::vector<uint64_t, Huge_Page_Allocator<uint64_t>> pilot_buf;
+    std::vector<uint32_t> remap_buf;
+
+    // Storage of the function when it is loaded by memory-mapping its file.
+    std::unique_ptr<Memory_Mapped_File> mapping;
+
+    const Partition* partition; // Meta-information of the partitions.
+    const uint64_t* pilot;  // Packed pilots of the buckets of all the partitions.
+    const uint32_t* remap;  // Remapped positions of the keys hashing beyond their partition ranges.
+
+
+    // Returns a 64-bit mix of `x`; the mixing is bijective.
+    static uint64_t mix(uint64_t x);
+
+    // Returns `x` mapped uniformly into the range `[0, n)`.
+    static uint64_t fast_range(uint64_t x, uint64_t n);
+
+    // Returns the hash of the pilot value `p`.
+    static uint64_t pilot_hash(uint64_t p);
+
+    // Returns the hash of the key `kmer`.
+    uint64_t hash(const Kmer<k>& kmer) const;
+
+    // Computes the values of the `n` keys into `res`, where `key_hash(i)` is the hash of
+    // the `i`'th key.
+    template <typename T_key_hash_>
+    void lookup_batch(std::size_t n, uint64_t* res, T_key_hash_ key_hash) const;
+
+    // Returns the partition of the key with hash `h`.
+    uint64_t partition_id(uint64_t h) const;
+
+    // Returns the bucket of the key with hash `h` in its partition `p`.
+    static uint64_t bucket_id(uint64_t h, const Partition& p);
+
+    // Returns the position of the key with hash `h` in a table of size
+    // `table_size`, given the pilot `p` of its bucket.
+    static uint64_t position(uint64_t h, uint64_t p, uint64_t table_size);
+
+    // Returns the pilot of the bucket `b` of the partition `p`.
+    uint64_t pilot_of(uint64_t b, const Partition& p) const;
+
+    // Returns the value of the key with hash `h` in its partition `p`.
+    uint64_t value(uint64_t h, const Partition& p) const;
+
+    // Collects the hashes of the k-mers provided to the consumer thread with ID
+    // `thread_id` by the k-mer parser `parser` into `hashes`, per partition.
+    void collect_hashes(Kmer_SPMC_Iterator<k>& parser, uint16_t thread_id, std::vector<std::vector<uint64_t>>& hashes) const;
+
+    // Builds the partition `p` over the key-hashes `hashes`, with `c` as the
+    // bucket-count constant. The pilots of the buckets and the remapped positions
+    // of the partition are put into `pilots` and `remapped`. Returns `false` iff
+    // two keys have the same hash, in which case the function is to be rebuilt
+    // with a different seed.
+    static bool build_partition(std::vector<uint64_t>& hashes, double c, Partition& p, std::vector<uint32_t>& pilots, std::vector<uint32_t>& remapped);
+
+    // Builds the partitions over the key-hashes `hashes` collected by each
+    // thread, using `thread_count` number of threads, with `c` as the
+    // bucket-count constant. Returns `false` iff the build failed for the
+    // current seed.
+    bool build_partitions(std::vector<std::vector<std::vector<uint64_t>>>& hashes, uint16_t thread_count, double c);
+
+    // Moves to the next seed after a failed build that started with the seed
+    // `initial_seed`. Aborts if `max_seed_attempts` seeds have been tried.
+    void reseed(uint64_t initial_seed);
+
+
+public:
+
+    // The minimum gamma-value (bucket-count constant) that we support.
+    static constexpr double gamma_min = 4.0;
+
+    // The maximum gamma-value (bucket-count constant) that we support.
+    static constexpr double gamma_max = 8.0;
+
+    // The resolution of gamma that we support.
+    static constexpr double gamma_resolution = 1.0;
+
+    // Estimated working memory (in bytes) per key of a build, besides the keys
+    // themselves: mostly the collected key-hashes, with their vectors' slack.
+    static constexpr std::size_t build_bytes_per_key = 16;
+
+    // Constructs an empty MPHF.
+    PTHash_MPHF();
+
+    // Returns the expected number of bits per key for the MPHF with gamma-value `gamma`.
+    static double bits_per_key(double gamma);
+
+    // Returns the maximum gamma-value for which the MPHF is expected to use at
+    // most `max_bits_per_key` bits per key.
+    static double gamma(double max_bits_per_key);
+
+    // Builds the MPHF over the k-mers present at the KMC database container
+    // `kmer_container`, using `thread_count` number of threads. The gamma-value
+    // `gamma` is used as the bucket-count constant for the partitions. The
+    // working directory at `working_dir_path` is not used.
+    void build(const Kmer_Container<k>& kmer_container, uint16_t thread_count, const std::string& working_dir_path, double gamma);
+
+    // Builds the MPHF over the `n` k-mers at `kmers`, using `thread_count`
+    // number of threads and `gamma` as the bucket-count constant. The working
+    // directory at `working_dir_path` is not used.
+    void build(const Kmer<k>* kmers, std::size_t n, uint16_t thread_count, const std::string& working_dir_path, double gamma);
+
+    // Returns the value (in `[0, n)` for `n` keys) of the key `kmer`. The
+    // value is arbitrary for keys not in the set of the function.
+    uint64_t lookup(const Kmer<k>& kmer) const;
+
+    // Returns the value of the key `kmer`, with `kmer_hash` as its rolling hash.
+    uint64_t lookup(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`. The lookups are
+    // batched and their memory accesses are prefetched, hence it is faster than
+    // `n` individual lookups.
+    void lookup(const Kmer<k>* kmers, std::size_t n, uint64_t* res) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`, with `kmer_hash` as
+    // the rolling hashes of the keys.
+    void lookup(const Kmer<k>* kmers, const Kmer_Rolling_Hash<k>* kmer_hash, std::size_t n, uint64_t* res) const;
+
+    // Prefetches the pilot of the key `kmer`, with `kmer_hash` as its rolling
+    // hash, i.e. the memory to be accessed by its lookup.
+    void prefetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Returns the size of the MPHF in bits.
+    uint64_t bit_size() const;
+
+    // Returns the page backing obtained for the pilots, i.e. the randomly
+    // accessed storage of the MPHF.
+    Page_Backing backing() const;
+
+    // Saves the MPHF into the stream `output`. The sections of the function
+    // are laid out at page-aligned offsets, so that the file can be mapped.
+    void save(std::ostream& output) const;
+
+    // Loads an MPHF from the file at path `file_path`, by mapping it into
+    // memory, i.e. without copying. If `populate` is `true`, then the file is
+    // read into memory at once; otherwise its pages are faulted-in on demand.
+    void load(const std::string& file_path, bool populate = false);
+};
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::mix(uint64_t x)
+{
+    // The finalizer of the 64-bit MurmurHash3.
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::fast_range(const uint64_t x, const uint64_t n)
+{
+    return static_cast<uint64_t>((static_cast<__uint128_t>(x) * n) >> 64);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::pilot_hash(const uint64_t p)
+{
+    return mix(p ^ 0x9e3779b97f4a7c15ULL);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::hash(const Kmer<k>& kmer) const
+{
+    return kmer.to_u64(seed);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::partition_id(const uint64_t h) const
+{
+    return fast_range(h, partition_count);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::bucket_id(const uint64_t h, const Partition& p)
+{
+    constexpr uint64_t dense_threshold = static_cast<uint64_t>(dense_key_fraction * (1ULL << 32));
+    const uint64_t x = mix(h);
+    const uint64_t hi = x >> 32, lo = x & 0xffffffffULL;
+
+    if(lo < dense_threshold || p.dense_bucket_count == p.bucket_count)
+        return (hi * p.dense_bucket_count) >> 32;
+
+    return p.dense_bucket_count + ((hi * (p.bucket_count - p.dense_bucket_count)) >> 32);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::position(const uint64_t h, const uint64_t p, const uint64_t table_size)
+{
+    return fast_range(mix(h ^ pilot_hash(p)), table_size);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::pilot_of(const uint64_t b, const Partition& p) const
+{
+    const uint64_t bit_idx = p.pilot_offset + b * p.pilot_width;
+    const uint64_t word_idx = (bit_idx >> 6);
+    const uint8_t shift = (bit_idx & 63);
+
+    uint64_t val = (pilot[word_idx] >> shift);
+    if(shift + p.pilot_width > 64)
+        val |= (pilot[word_idx + 1] << (64 - shift));
+
+    return val & ((1ULL << p.pilot_width) - 1);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::value(const uint64_t h, const Partition& p) const
+{
+    const uint64_t pos = position(h, pilot_of(bucket_id(h, p), p), p.table_size);
+    return p.offset + (pos < p.key_count ? pos : remap[p.remap_offset + (pos - p.key_count)]);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::lookup(const Kmer<k>& kmer) const
+{
+    const uint64_t h = hash(kmer);
+    return value(h, partition[partition_id(h)]);
+}
+
+
+template <uint16_t k>
+inline uint64_t PTHash_MPHF<k>::lookup(const Kmer<k>&, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    const uint64_t h = kmer_hash(seed);
+    return value(h, partition[partition_id(h)]);
+}
+
+
+template <uint16_t k>
+template <typename T_key_hash_>
+inline void PTHash_MPHF<k>::lookup_batch(const std::size_t n, uint64_t* const res, const T_key_hash_ key_hash) const
+{
+    constexpr std::size_t group_size = 64;  // Number of keys whose pilot-accesses are overlapped.
+    uint64_t h[group_size];
+    uint64_t b[group_size];
+
+    for(std::size_t group = 0; group < n; group += group_size)
+    {
+        const std::size_t count = std::min(group_size, n - group);
+
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            h[i] = key_hash(group + i);
+            const Partition& p = partition[partition_id(h[i])];
+            b[i] = bucket_id(h[i], p);
+            __builtin_prefetch(pilot + ((p.pilot_offset + b[i] * p.pilot_width) >> 6));
+        }
+
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            const Partition& p = partition[partition_id(h[i])];
+            const uint64_t pos = position(h[i], pilot_of(b[i], p), p.table_size);
+            res[group + i] = p.offset + (pos < p.key_count ? pos : remap[p.remap_offset + (pos - p.key_count)]);
+        }
+    }
+}
+
+
+template <uint16_t k>
+inline void PTHash_MPHF<k>::lookup(const Kmer<k>* const kmers, const std::size_t n, uint64_t* const res) const
+{
+    lookup_batch(n, res, [&](const std::size_t i){ return hash(kmers[i]); });
+}
+
+
+template <uint16_t k>
+inline void PTHash_MPHF<k>::lookup(const Kmer<k>*, const Kmer_Rolling_Hash<k>* const kmer_hash, const std::size_t n, uint64_t* const res) const
+{
+    lookup_batch(n, res, [&](const std::size_t i){ return kmer_hash[i](seed); });
+}
+
+
+template <uint16_t k>
+inline void PTHash_MPHF<k>::prefetch(const Kmer<k>&, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    const uint64_t h = kmer_hash(seed);
+    const Partition& p = partition[partition_id(h)];
+    __builtin_prefetch(pilot + ((p.pilot_offset + bucket_id(h, p) * p.pilot_width) >> 6));
+}
+
+
+
+#endif
@@ -0,0 +1,142 @@
+
+#ifndef PARALLEL_WRITER_HPP
+#define PARALLEL_WRITER_HPP
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+// A file writer for concurrent appends from many threads. The output is laid out as
+// consecutive fixed-size blocks. An append claims its byte range in the output with an
+// atomic increment, and copies its content into the in-memory blocks covering the range,
+// concurrently with the other appends. The append completing a block hands it off through
+// a lock-free MPSC (multi-producer single-consumer) queue to a background thread, which
+// writes the blocks with `pwritev` at their precomputed file offsets, coalescing the
+// consecutive ones; so the completed blocks need no ordering. The blocks are recycled
+// through a bounded ring, and are page-aligned so that the output can be written with
+// direct I/O (`O_DIRECT`), bypassing the page cache.
+class Parallel_Writer
+{
+private:
+
+    static constexpr std::size_t BLOCK_SZ = 4 * 1024 * 1024;    // Size of a block: 4 MB.
+    static constexpr std::size_t BLOCK_ALIGN = 4096;    // Alignment of the blocks, in memory and in the file, for direct I/O.
+    static constexpr std::size_t RING_SZ = 16;  // Number of blocks in the ring, bounding the memory used to 64 MB.
+    static constexpr std::size_t MAX_COALESCE = 16; // Maximum number of consecutive blocks written together.
+
+    // A slot of the ring, containing a block of the output.
+    struct alignas(L1_CACHE_LINE_SIZE) Block
+    {
+        char* data; // Content of the block.
+        std::atomic<uint64_t> id;   // Index of the block in the output that occupies the slot.
+        std::atomic<std::size_t> filled;    // Number of bytes copied into the block.
+        Block* next;    // Next block in the hand-off queue.
+    };
+
+    std::string file_path;  // Path to the output file.
+    int fd = -1;    // Descriptor of the output file.
+    bool direct_io = false; // Whether the output is written with direct I/O.
+    uint64_t base = 0;  // File offset where the output begins, i.e. the size of the file at its opening.
+
+    char* mem = nullptr;    // Memory backing the blocks of the ring.
+    std::unique_ptr<Block[]> ring;  // The ring of blocks; the block with index `b` occupies the slot `b % RING_SZ`.
+    std::atomic<uint64_t> end;  // Size of the output claimed by the appends.
+
+    std::atomic<Block*> pending;    // The hand-off queue of the completed blocks, as a lock-free stack taken off whole by the writer thread.
+    std::atomic<bool> writer_idle;  // Whether the writer thread is waiting for blocks.
+    bool closing = false;   // Whether the writer is being closed.
+    std::mutex mutex_;  // Mutex for the writer thread to wait on.
+    std::condition_variable block_ready;    // Condition of some block being handed off, or of the writer being closed.
+    std::unique_ptr<std::thread> writer;    // The background thread writing the completed blocks.
+
+
+    // Returns the slot of the block with index `b`, after waiting for its earlier occupant
+    // to be written out.
+    Block& acquire_block(uint64_t b);
+
+    // Hands off the completed block `block` to the writer thread.
+    void hand_off(Block* block);
+
+    // Writes out the completed blocks as they are handed off, until the writer is closed.
+    void write_blocks();
+
+    // Writes out the `count` consecutive blocks at `block`, in order of their indices, and
+    // recycles their slots.
+    void write_out(Block* const* block, std::size_t count);
+
+    // Writes `len` bytes from `buf` at the file offset `offset`.
+    void write_at(const char* buf, std::size_t len, uint64_t offset) const;
+
+
+public:
+
+    // Returns the memory (in bytes) held by a writer while its output file is open, i.e.
+    // the ring of the blocks. The writer also runs a background thread meanwhile.
+    static constexpr std::size_t memory() { return RING_SZ * BLOCK_SZ; }
+
+    // Constructs a writer without any output file.
+    Parallel_Writer();
+
+    Parallel_Writer(const Parallel_Writer&) = delete;
+    Parallel_Writer& operator=(const Parallel_Writer&) = delete;
+
+    // Destructs the writer, closing the output file if it's open.
+    ~Parallel_Writer();
+
+    // Opens the file at path `output_file_path` for output, appending to its existing
+    // content. The output is written with direct I/O if `direct` is `true`, and the file
+    // system and the existing content's size support it.
+    void open(const std::string& output_file_path, bool direct = false);
+
+    // Appends `len` bytes from `str` to the output. Thread-safe.
+    void write(const char* str, std::size_t len);
+
+    // Writes out all the appended content, and closes the output file. The appends are to be
+    // complete before.
+    void close();
+};
+
+
+inline Parallel_Writer::Block& Parallel_Writer::acquire_block(const uint64_t b)
+{
+    Block& block = ring[b % RING_SZ];
+    while(block.id.load(std::memory_order_acquire) != b)
+        std::this_thread::yield();
+
+    return block;
+}
+
+
+inline void Parallel_Writer::write(const char* str, std::size_t len)
+{
+    uint64_t offset = end.fetch_add(len, std::memory_order_relaxed);
+
+    while(len > 0)
+    {
+        const std::size_t block_offset = offset % BLOCK_SZ;
+        const std::size_t n = std::min(len, BLOCK_SZ - block_offset);
+        Block& block = acquire_block(offset / BLOCK_SZ);
+
+        std::memcpy(block.data + block_offset, str, n);
+        if(block.filled.fetch_add(n, std::memory_order_acq_rel) + n == BLOCK_SZ)
+            hand_off(&block);
+
+        str += n;
+        offset += n;
+        len -= n;
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,324 @@
+
+#ifndef PARTITIONED_MPHF_HPP
+#define PARTITIONED_MPHF_HPP
+
+
+
+#include "Kmer.hpp"
+#include "Kmer_Rolling_Minimizer.hpp"
+#include "Huge_Pages.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <limits>
+
+
+template <uint16_t k> class Kmer_Container;
+template <uint16_t k> class Kmer_SPMC_Iterator;
+class Spin_Lock;
+
+
+// A minimal perfect hash function (MPHF) over k-mers, partitioned by their
+// l-minimizers: the keys are split into a number of partitions, each with its
+// own MPHF of type `T_MPHF_`, built independently. The values of the keys of a
+// partition form a contiguous range, so that the hash table buckets of each
+// partition are contiguous too. The minimizers are taken over canonical l-mers,
+// so a k-mer and its reverse complement—and mostly, adjacent k-mers too—fall
+// in the same partition. With a single partition, it is just `T_MPHF_`, up to
+// the header of its saved file.
+template <uint16_t k, typename T_MPHF_>
+class Partitioned_MPHF
+{
+    typedef T_MPHF_ base_t; // The MPHF type of the partitions.
+
+private:
+
+    // Length of the minimizers partitioning the keys.
+    static constexpr uint8_t l = (k < 11 ? k : 11);
+
+    // Marker at the beginning of the saved files of the MPHFs.
+    static constexpr uint64_t file_magic = 0x46485050'4D544643ULL;
+
+    // Number of keys buffered per partition by each thread before being written to disk.
+    static constexpr std::size_t key_buf_size = 1024;
+
+    uint64_t partition_count_;  // Number of partitions of the keys.
+    std::size_t max_memory; // Memory budget (in bytes) for the concurrent builds of the partitions.
+    std::string temp_file_prefix;   // Path prefix for the temporary files of the keys of the partitions.
+    std::vector<std::unique_ptr<base_t>> mphf; // The MPHFs of the partitions.
+    std::vector<uint64_t> offset;   // `offset[p]` is the number of keys in the partitions preceding `p`.
+
+
+    // Returns the path to the file for the partition `p` of the MPHF saved at `file_path`.
+    static std::string partition_file_path(const std::string& file_path, uint64_t p);
+
+    // Returns the path to the temporary file for the keys of the partition `p`.
+    std::string key_file_path(uint64_t p) const;
+
+    // Reads the format version, the partition count, and the offsets of the MPHF
+    // saved at `file_path` into `version`, `partition_count`, and `offset`. Returns
+    // `false` iff the file is not of a saved MPHF.
+    static bool read_header(const std::string& file_path, uint32_t& version, uint64_t& partition_count, std::vector<uint64_t>& offset);
+
+    // Distributes the keys provided to the thread with ID `thread_id` by the k-mer
+    // parser `parser` to the key files `key_file` of their partitions, and counts
+    // them per partition into `key_count`. The spin-locks `lock` guard the files.
+    void partition_keys(Kmer_SPMC_Iterator<k>& parser, uint16_t thread_id, std::vector<std::ofstream>& key_file, std::vector<uint64_t>& key_count, Spin_Lock* lock) const;
+
+    // Computes the values of the `n` keys into `res`, with `partition_of(i)` being the
+    // partition of the `i`'th key, looking up each run of keys `[i, j)` from the same
+    // partition `p` with `lookup_run(p, i, j)`.
+    template <typename T_partition_, typename T_lookup_run_>
+    void lookup_runs(std::size_t n, uint64_t* res, T_partition_ partition_of, T_lookup_run_ lookup_run) const;
+
+
+public:
+
+    // Canonical minimizer of rolling k-mers, that partitions the keys. Callers rolling
+    // through k-mers may maintain it to pass to the lookups, saving their `O(k)`
+    // computation of the minimizers.
+    typedef Kmer_Rolling_Minimizer<k, l> rolling_minimizer_t;
+
+    // The minimum gamma-value that the MPHF supports.
+    static constexpr double gamma_min = base_t::gamma_min;
+
+    // The maximum gamma-value that the MPHF supports.
+    static constexpr double gamma_max = base_t::gamma_max;
+
+    // The resolution of gamma that the MPHF supports.
+    static constexpr double gamma_resolution = base_t::gamma_resolution;
+
+    // Constructs an empty MPHF that is to be built with `partition_count` partitions.
+    // The concurrent builds of the partitions use at most around `max_memory` bytes
+    // of memory, and the keys of the partitions are distributed to temporary files
+    // with the path prefix `temp_file_prefix`.
+    Partitioned_MPHF(uint64_t partition_count = 1, std::size_t max_memory = std::numeric_limits<std::size_t>::max(), const std::string& temp_file_prefix = "");
+
+    // Returns the expected number of bits per key for the MPHF with gamma-value `gamma`.
+    static double bits_per_key(double gamma);
+
+    // Returns the maximum gamma-value for which the MPHF is expected to use at
+    // most `max_bits_per_key` bits per key.
+    static double gamma(double max_bits_per_key);
+
+    // Returns the number of partitions of the keys.
+    uint64_t partition_count() const;
+
+    // Returns the partition of the key `kmer`.
+    uint64_t partition(const Kmer<k>& kmer) const;
+
+    // Returns the partition of the keys with the canonical minimizer `minimizer`.
+    uint64_t partition_of_minimizer(uint64_t minimizer) const;
+
+    // Builds the MPHF over the k-mers present at the KMC database container
+    // `kmer_container`, using `thread_count` number of threads and the gamma-
+    // value `gamma`. Uses the directory at `working_dir_path` to store temporary
+    // files. With multiple partitions, the keys are first distributed to per-
+    // partition files, and then the partitions are built in parallel—each
+    // loading its keys into memory—as many at a time as fit in the memory budget.
+    void build(const Kmer_Container<k>& kmer_container, uint16_t thread_count, const std::string& working_dir_path, double gamma);
+
+    // Returns the value (in `[0, n)` for `n` keys) of the key `kmer`.
+    uint64_t lookup(const Kmer<k>& kmer) const;
+
+    // Returns the value of the key `kmer`, with `kmer_hash` as its rolling hash.
+    uint64_t lookup(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Returns the value of the key `kmer`, with `kmer_hash` as its rolling hash and
+    // `minimizer` as its canonical minimizer.
+    uint64_t lookup(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, uint64_t minimizer) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`. Runs of keys from
+    // the same partition are looked up in batches from that partition.
+    void lookup(const Kmer<k>* kmers, std::size_t n, uint64_t* res) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`, with `kmer_hash` as
+    // the rolling hashes of the keys, as per the batched lookup above.
+    void lookup(const Kmer<k>* kmers, const Kmer_Rolling_Hash<k>* kmer_hash, std::size_t n, uint64_t* res) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`, with `minimizer` as
+    // their canonical minimizers, as per the batched lookup above.
+    void lookup(const Kmer<k>* kmers, const uint64_t* minimizer, std::size_t n, uint64_t* res) const;
+
+    // Computes the values of the `n` keys `kmers` into `res`, with `kmer_hash` as
+    // the rolling hashes of the keys and `minimizer` as their canonical minimizers,
+    // as per the batched lookup above.
+    void lookup(const Kmer<k>* kmers, const Kmer_Rolling_Hash<k>* kmer_hash, const uint64_t* minimizer, std::size_t n, uint64_t* res) const;
+
+    // Prefetches the memory of the MPHF to be accessed first by the lookup of
+    // the key `kmer`, with `kmer_hash` as its rolling hash.
+    void prefetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const;
+
+    // Prefetches the memory of the MPHF to be accessed first by the lookup of the
+    // key `kmer`, with `kmer_hash` as its rolling hash and `minimizer` as its
+    // canonical minimizer.
+    void prefetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, uint64_t minimizer) const;
+
+    // Returns the size of the MPHF in bits.
+    uint64_t bit_size() const;
+
+    // Returns the page backing obtained for the MPHF of the largest partition.
+    Page_Backing backing() const;
+
+    // Saves the MPHF into the file at path `file_path`, as a header tagged with
+    // the format version `cuttlefish::HASH_TABLE_FORMAT_VERSION`; the partitions
+    // are saved into separate files alongside.
+    void save(const std::string& file_path) const;
+
+    // Loads an MPHF from the file at path `file_path`, with its saved number of
+    // partitions. Files of other format versions are rejected. If `populate` is
+    // `true`, then the files are read into memory at once; otherwise they may be
+    // faulted-in on demand.
+    void load(const std::string& file_path, bool populate = false);
+
+    // Removes the files of the MPHF saved at path `file_path`. Returns `false`
+    // iff some file could not be removed.
+    static bool remove(const std::string& file_path);
+};
+
+
+template <uint16_t k, typename T_MPHF_>
+inline uint64_t Partitioned_MPHF<k, T_MPHF_>::partition_count() const
+{
+    return partition_count_;
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline uint64_t Partitioned_MPHF<k, T_MPHF_>::partition(const Kmer<k>& kmer) const
+{
+    if(partition_count_ == 1)
+        return 0;
+
+    return partition_of_minimizer(kmer.template canonical_minimizer<l>());
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline uint64_t Partitioned_MPHF<k, T_MPHF_>::partition_of_minimizer(const uint64_t minimizer) const
+{
+    // Fibonacci hashing of the minimizer, mapped uniformly into the partition range.
+    const uint64_t h = minimizer * 0xC2B2AE3D27D4EB4FULL;
+    return static_cast<uint64_t>((static_cast<__uint128_t>(h) * partition_count_) >> 64);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline uint64_t Partitioned_MPHF<k, T_MPHF_>::lookup(const Kmer<k>& kmer) const
+{
+    if(partition_count_ == 1)
+        return mphf[0]->lookup(kmer);
+
+    const uint64_t p = partition(kmer);
+    return offset[p] + mphf[p]->lookup(kmer);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline uint64_t Partitioned_MPHF<k, T_MPHF_>::lookup(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    if(partition_count_ == 1)
+        return mphf[0]->lookup(kmer, kmer_hash);
+
+    const uint64_t p = partition(kmer);
+    return offset[p] + mphf[p]->lookup(kmer, kmer_hash);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline uint64_t Partitioned_MPHF<k, T_MPHF_>::lookup(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, const uint64_t minimizer) const
+{
+    if(partition_count_ == 1)
+        return mphf[0]->lookup(kmer, kmer_hash);
+
+    const uint64_t p = partition_of_minimizer(minimizer);
+    return offset[p] + mphf[p]->lookup(kmer, kmer_hash);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline void Partitioned_MPHF<k, T_MPHF_>::prefetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash) const
+{
+    mphf[partition(kmer)]->prefetch(kmer, kmer_hash);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline void Partitioned_MPHF<k, T_MPHF_>::prefetch(const Kmer<k>& kmer, const Kmer_Rolling_Hash<k>& kmer_hash, const uint64_t minimizer) const
+{
+    mphf[partition_count_ == 1 ? 0 : partition_of_minimizer(minimizer)]->prefetch(kmer, kmer_hash);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+template <typename T_partition_, typename T_lookup_run_>
+inline void Partitioned_MPHF<k, T_MPHF_>::lookup_runs(const std::size_t n, uint64_t* const res, const T_partition_ partition_of, const T_lookup_run_ lookup_run) const
+{
+    if(partition_count_ == 1)
+    {
+        lookup_run(0, 0, n);
+        return;
+    }
+
+
+    std::size_t i = 0;
+    uint64_t p = (n > 0 ? partition_of(0) : 0);
+    while(i < n)
+    {
+        std::size_t j = i + 1;
+        uint64_t p_next = p;
+        while(j < n && (p_next = partition_of(j)) == p)
+            j++;
+
+        lookup_run(p, i, j);
+        for(std::size_t idx = i; idx < j; ++idx)
+            res[idx] += offset[p];
+
+        i = j;
+        p = p_next;
+    }
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline void Partitioned_MPHF<k, T_MPHF_>::lookup(const Kmer<k>* const kmers, const std::size_t n, uint64_t* const res) const
+{
+    lookup_runs(n, res,
+        [&](const std::size_t i){ return partition(kmers[i]); },
+        [&](const uint64_t p, const std::size_t i, const std::size_t j){ mphf[p]->lookup(kmers + i, j - i, res + i); });
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline void Partitioned_MPHF<k, T_MPHF_>::lookup(const Kmer<k>* const kmers, const Kmer_Rolling_Hash<k>* const kmer_hash, const std::size_t n, uint64_t* const res) const
+{
+    lookup_runs(n, res,
+        [&](const std::size_t i){ return partition(kmers[i]); },
+        [&](const uint64_t p, const std::size_t i, const std::size_t j){ mphf[p]->lookup(kmers + i, kmer_hash + i, j - i, res + i); });
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline void Partitioned_MPHF<k, T_MPHF_>::lookup(const Kmer<k>* const kmers, const uint64_t* const minimizer, const std::size_t n, uint64_t* const res) const
+{
+    lookup_runs(n, res,
+        [&](const std::size_t i){ return partition_of_minimizer(minimizer[i]); },
+        [&](const uint64_t p, const std::size_t i, const std::size_t j){ mphf[p]->lookup(kmers + i, j - i, res + i); });
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+inline void Partitioned_MPHF<k, T_MPHF_>::lookup(const Kmer<k>* const kmers, const Kmer_Rolling_Hash<k>* const kmer_hash, const uint64_t* const minimizer, const std::size_t n, uint64_t* const res) const
+{
+    lookup_runs(n, res,
+        [&](const std::size_t i){ return partition_of_minimizer(minimizer[i]); },
+        [&](const uint64_t p, const std::size_t i, const std::size_t j){ mphf[p]->lookup(kmers + i, kmer_hash + i, j - i, res + i); });
+}
+
+
+
+#endif
@@ -8,6 +8,7 @@
 #include "Build_Params.hpp"
 #include "Data_Logistics.hpp"
 #include "Kmer_Hash_Table.hpp"
+#include "Unitig_Seeds.hpp"
 #include "dBG_Info.hpp"
 
 #include <cstddef>
@@ -27,6 +28,7 @@ private:
     const Build_Params params;  // Required parameters (wrapped inside).
     const Data_Logistics logistics; // Data logistics manager for the algorithm execution.
     std::unique_ptr<Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>> hash_table; // Hash table for the vertices (canonical k-mers) of the graph.
+    std::unique_ptr<Unitig_Seeds<k>> seeds; // Seed vertices for the maximal unitigs extraction, recorded over the DFA-states computation.
 
     dBG_Info<k> dbg_info;   // Wrapper object for structural information of the graph.
 
@@ -37,8 +39,8 @@ private:
     // enumearation.
     kmer_Enumeration_Stats<k + 1> enumerate_edges() const;
 
-    // Enumerates the vertices of the de Bruijn graph using at most `max_memory` amount of
-    // memory, and returns summary statistics of the enumeration.
+    // Enumerates the vertices of the de Bruijn graph from its edges, using at most
+    // `max_memory` amount of memory, and returns summary statistics of the enumeration.
     kmer_Enumeration_Stats<k> enumerate_vertices(std::size_t max_memory) const;
 
     // Constructs the Cuttlefish hash table for the `vertex_count` vertices of the graph.
@@ -56,10 +58,19 @@ private:
     // NB: only the existence of the output meta-info file is checked for this purpose.
     bool is_constructed() const;
 
+    // Returns the memory (in bytes) currently held by the databases of the graph that are
+    // kept in memory.
+    std::size_t in_memory_db_size() const;
+
+    // Returns the memory limit (in bytes) for the seed vertices of the unitigs extraction:
+    // the memory budget left from the hash table, the edges parser, the output writer of
+    // the extraction, and the in-memory databases.
+    std::size_t seed_memory() const;
+
     // Returns the maximum temporary disk-usage incurred by some execution of the algorithm,
     // that has its edges-enumeration stats in `edge_stats` and vertices-enumeration stats
-    // in `vertex_stats`.
-    static std::size_t max_disk_usage(const kmer_Enumeration_Stats<k + 1>& edge_stats, const kmer_Enumeration_Stats<k>& vertex_stats);
+    // in `vertex_stats`. Databases kept in memory do not count towards it.
+    std::size_t max_disk_usage(const kmer_Enumeration_Stats<k + 1>& edge_stats, const kmer_Enumeration_Stats<k>& vertex_stats) const;
 
 
 public:
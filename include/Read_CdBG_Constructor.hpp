@@ -9,27 +9,31 @@
 #include "State_Read_Space.hpp"
 #include "Edge.hpp"
 #include "Endpoint.hpp"
+#include "Unitig_Seeds.hpp"
 #include "Build_Params.hpp"
 #include "Progress_Tracker.hpp"
 
 #include <cstdint>
+#include <cstddef>
 #include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
 
 
 template <uint16_t k> class Kmer_SPMC_Iterator;
-template <uint16_t k> class Thread_Pool;
+class Thread_Pool;
 
 
 // A class to construct compacted read de Bruijn graphs.
 template <uint16_t k>
 class Read_CdBG_Constructor
 {
-    friend class Thread_Pool<k>;
-
 private:
 
     const Build_Params params;  // Required parameters (wrapped inside).
     Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table; // Hash table for the vertices (canonical k-mers) of the graph.
+    Unitig_Seeds<k>* const seeds;   // Seed vertices for the maximal unitigs extraction, to be recorded over the DFA-states computation, if any.
 
     uint64_t edge_count_;    // Number of edges in the underlying graph.
     
@@ -39,16 +43,44 @@ private:
     
     Progress_Tracker progress_tracker;  // Progress tracker for the DFA states computation task.
 
+    static constexpr std::size_t edge_batch_size = 128; // Number of edges whose endpoints are hashed together in a batch.
+    static constexpr std::size_t route_batch_size = 1024;   // Number of edges routed together to some other thread.
+
+    // Collection of edges routed to a thread from the others.
+    struct Edge_Inbox
+    {
+        Spin_Lock lock; // Lock guarding the inbox.
+        std::vector<Edge<k>> edges; // The routed edges.
+    };
+
+    // With a partitioned hash table, each thread owns the partitions `p` with `p % thread_count` being
+    // its id, and the edges are routed to the owners of the partitions of their `u`-endpoints; so that
+    // each thread mostly updates buckets from its own partitions.
+    std::unique_ptr<Edge_Inbox[]> inbox;    // Inboxes of the routed edges, per thread.
+    std::atomic<uint16_t> routers_done; // Number of threads done with parsing and routing edges.
+
 
     // Distributes the DFA-states computation task — disperses the graph edges (i.e. (k + 1)-mers)
     // parsed by the parser `edge_parser` to the worker threads in the thread pool `thread_pool`,
     // for the edges to be processed by making appropriate state transitions for their endpoints.
-    void distribute_states_computation(Kmer_SPMC_Iterator<k + 1>* edge_parser, Thread_Pool<k>& thread_pool);
+    void distribute_states_computation(Kmer_SPMC_Iterator<k + 1>* edge_parser, Thread_Pool& thread_pool);
 
     // Processes the edges provided to the thread with id `thread_id` from the parser `edge_parser`,
     // based on the end-purpose of extracting either the maximal unitigs or a maximal path cover.
     void process_edges(Kmer_SPMC_Iterator<k + 1>* edge_parser, uint16_t thread_id);
 
+    // Fetches a batch of at most `edge_batch_size` edges provided to the thread with id `thread_id`
+    // from the parser `edge_parser` into `edge`, and sets the hash values of their endpoints through
+    // batched lookups into the hash table. `vertex` and `h` are scratch spaces for the endpoint
+    // vertices and their hash values, of size `2 * edge_batch_size` each. Returns the number of
+    // edges fetched.
+    std::size_t fetch_edge_batch(Kmer_SPMC_Iterator<k + 1>* edge_parser, uint16_t thread_id, Edge<k>* edge, Kmer<k>* vertex, uint64_t* h);
+
+    // Sets the hash values of the endpoints of the `n` edges `edge` through batched lookups into the
+    // hash table. `vertex` and `h` are scratch spaces for the endpoint vertices and their hash values,
+    // of size `2 * n` each.
+    void hash_edge_batch(Edge<k>* edge, std::size_t n, Kmer<k>* vertex, uint64_t* h);
+
     // Processes the edges provided to the thread with id `thread_id` from the parser `edge_parser`,
     // i.e. makes state-transitions for the DFA of the vertices `u` and `v` for each bidirected edge
     // `(u, v)` provided to that thread, in order to construct a CdBG.
@@ -59,21 +91,55 @@ private:
     // `(u, v)` provided to that thread, to construct a maximal path cover of the dBG.
     void process_path_cover_edges(Kmer_SPMC_Iterator<k + 1>* edge_parser, uint16_t thread_id);
 
+    // Processes the edges provided to the thread with id `thread_id` from the parser `edge_parser`
+    // with a partitioned hash table: the edges of partitions owned by other threads are routed to
+    // them, and the edges of its own partitions—parsed or routed to it—are processed by this thread.
+    void process_routed_edges(Kmer_SPMC_Iterator<k + 1>* edge_parser, uint16_t thread_id);
+
+    // Processes the `n` edges `edge`, hashing their endpoints in batches of at most `edge_batch_size`
+    // edges using the scratch spaces `vertex` and `h`; and adds the number of edges processed to
+    // `edge_count` and to the progress counter `progress`. The edges are processed by the thread
+    // with id `thread_id`.
+    void process_edge_batch(Edge<k>* edge, std::size_t n, Kmer<k>* vertex, uint64_t* h, uint64_t& edge_count, uint64_t& progress, uint16_t thread_id);
+
+    // Makes the state-transitions for the DFA of the vertices `u` and `v` for the bidirected edge
+    // `e = (u, v)`, in order to construct a CdBG. Records the seed vertices for the maximal unitigs
+    // extraction found with the transitions, if required, on behalf of the thread with id `thread_id`:
+    // the flanking seeds, and `u` as a cover seed if neither `u` nor `v` had any edge before `e`.
+    void process_cdbg_edge(const Edge<k>& e, uint16_t thread_id);
+
     // Adds the information of an incident edge `e` to the side `s` of some vertex `v`, all wrapped
     // inside the edge-endpoint object `endpoint` — making the appropriate state transitions for the
-    // DFA of `v`. Returns `false` iff an attempted state transition failed.
-    bool add_incident_edge(const Endpoint<k>& endpoint);
-    
+    // DFA of `v`. Also stores the edge encodings of the incidence information of the side `s` before
+    // and after to this addition, in `e_old` and `e_new` respectively, and the state of `v` before
+    // the addition in `st_old`. Returns `false` iff an attempted state transition failed.
+    bool add_incident_edge(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_old, cuttlefish::edge_encoding_t& e_new, State_Read_Space& st_old);
+
     // Adds the information of an incident loop that connects the two different endpoints of some
     // vertex `v`, wrapped inside the edge-endpoint object `endpoint` — making the appropriate state
-    // transition for the DFA of `v`. Returns `false` iff an attempted state transition failed.
-    bool add_crossing_loop(const Endpoint<k>& endpoint);
+    // transition for the DFA of `v`. Also stores the edge encodings of the incidence information of
+    // the front and the back sides before this addition, in `e_front` and `e_back` respectively.
+    // Returns `false` iff an attempted state transition failed.
+    bool add_crossing_loop(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_front, cuttlefish::edge_encoding_t& e_back);
 
     // Adds the information of an incident loop for some vertex `v` that connects its side `s` to
     // the side itself, all wrapped inside the edge-endpoint object `endpoint` — making the
-    // appropriate state transition for the DFA of `v`. Returns `false` iff an attempted state
-    // transition failed.
-    bool add_one_sided_loop(const Endpoint<k>& endpoint);
+    // appropriate state transition for the DFA of `v`. Also stores the edge encoding of the incidence
+    // information of the side `s` before this addition, in `e_old`. Returns `false` iff an attempted
+    // state transition failed.
+    bool add_one_sided_loop(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_old);
+
+    // Records the seed vertices for the maximal unitigs extraction from the addition of an edge
+    // `(u, v)` to the endpoint `u_end` of `u`, with `v_end` being the endpoint of `v`: the edge
+    // changed the incidence information of the side of `u` from the encoding `e_old` to `e_new`.
+    // If the side is branching, then `v` is a seed. If the edge made it branching, then `u` and the
+    // neighbor of `u` through its earlier edge at the side are seeds too. The seeds are recorded
+    // on behalf of the thread with id `thread_id`.
+    void record_seeds(const Endpoint<k>& u_end, const Endpoint<k>& v_end, cuttlefish::edge_encoding_t e_old, cuttlefish::edge_encoding_t e_new, uint16_t thread_id);
+
+    // Records the neighbor of the endpoint `v_end` through the edge encoded with `e` at its side as
+    // a seed vertex, on behalf of the thread with id `thread_id`; if such an edge is present.
+    void record_neighbor(const Endpoint<k>& v_end, cuttlefish::edge_encoding_t e, uint16_t thread_id);
 
     // Adds the information of the edge `e = {u, v}` to its endpoint vertices `u` and `v` iff this
     // edge connects sides of `u` and `v` that do not have any edges added yet, which ensures that
@@ -86,8 +152,9 @@ private:
 public:
 
     // Consructs a read-CdBG builder object, with the required parameters wrapped in `params`, and uses
-    // the Cuttlefish hash table `hash_table`.
-    Read_CdBG_Constructor(const Build_Params& params, Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table);
+    // the Cuttlefish hash table `hash_table`. If `seeds` is provided, then the seed vertices for the
+    // maximal unitigs extraction are recorded into it over the DFA-states computation.
+    Read_CdBG_Constructor(const Build_Params& params, Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table, Unitig_Seeds<k>* seeds = nullptr);
 
     // Computes the states of the DFA in the de Bruijn graph with the edge set at path prefix `edge_db_path`.
     void compute_DFA_states(const std::string& edge_db_path);
@@ -103,27 +170,6 @@ public:
 /*
 private:
 
-    // Adds the information of an incident edge `e` to the side `s` of some vertex `v`, all wrapped
-    // inside the edge-endpoint object `endpoint` — making the appropriate state transitions for the
-    // DFA of `v`. Also stores the edge encodings of the incidence information of the side `s` before
-    // and after to this addition, in `e_old` and `e_new` respectively. Returns `false` iff an
-    // attempted state transition failed.
-    bool add_incident_edge(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_old, cuttlefish::edge_encoding_t& e_new);
-
-    // Adds the information of an incident loop that connects the two different endpoints of some
-    // vertex `v`, wrapped inside the edge-endpoint object `endpoint` — making the appropriate state
-    // transition for the DFA of `v`. Also stores the edge encodings of the incidence information of
-    // the front and the back sides before this addition, in `e_front` and `e_back` respectively.
-    // Returns `false` iff an attempted state transition failed.
-    bool add_crossing_loop(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_front, cuttlefish::edge_encoding_t& e_back);
-
-    // Adds the information of an incident loop for some vertex `v` that connects its side `s` to
-    // the side itself, all wrapped inside the edge-endpoint object `endpoint` — making the
-    // appropriate state transition for the DFA of `v`. Also stores the edge encoding of the incidence
-    // information of the side `s` before this addition, in `e_old`. Returns `false` iff an attempted
-    // state transition failed.
-    bool add_one_sided_loop(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_old);
-
     // If the endpoint object `v_end` connects to some neighboring endpoint `w_end` through a unique
     // edge encoded with `e`, then discards the incidence information of `w_end` — making the
     // appropriate state transition for the corresponding neighboring vertex `w`.
@@ -147,19 +193,21 @@ private:
 
 
 template <uint16_t k>
-inline bool Read_CdBG_Constructor<k>::add_incident_edge(const Endpoint<k>& endpoint)
+inline bool Read_CdBG_Constructor<k>::add_incident_edge(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_old, cuttlefish::edge_encoding_t& e_new, State_Read_Space& st_old)
 {
     // Fetch the hash table entry for the vertex associated to the endpoint.
 
     Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket = hash_table[endpoint.hash()];
     State_Read_Space& state = bucket.get_state();
+    st_old = state;
     const cuttlefish::edge_encoding_t e_curr = state.edge_at(endpoint.side());
+    e_old = e_new = e_curr;
 
     // If we've already discarded the incidence information for this side, then a self-transition happens.
     if(e_curr == cuttlefish::edge_encoding_t::N)
         return true;    // The side has already been determined to be branching—nothing to update here anymore.
 
-    cuttlefish::edge_encoding_t e_new = endpoint.edge();
+    e_new = endpoint.edge();
     if(e_curr != cuttlefish::edge_encoding_t::E)    // The side is not empty.
     {
         // We can get away without updating the same value again, because — (1) even if this DFA's state changes
@@ -179,7 +227,7 @@ inline bool Read_CdBG_Constructor<k>::add_incident_edge(const Endpoint<k>& endpo
 
 
 template <uint16_t k>
-inline bool Read_CdBG_Constructor<k>::add_crossing_loop(const Endpoint<k>& endpoint)
+inline bool Read_CdBG_Constructor<k>::add_crossing_loop(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_front, cuttlefish::edge_encoding_t& e_back)
 {
     // Fetch the hash table entry for the DFA of vertex associated to the endpoint.
     
@@ -187,6 +235,8 @@ inline bool Read_CdBG_Constructor<k>::add_crossing_loop(const Endpoint<k>& endpo
     State_Read_Space& state = bucket.get_state();
 
     const State_Read_Space state_curr = state;
+    e_front = state.edge_at(cuttlefish::side_t::front);
+    e_back = state.edge_at(cuttlefish::side_t::back);
 
     if(state.edge_at(cuttlefish::side_t::front) != cuttlefish::edge_encoding_t::N)   // Discard the front-incidence information, if not done already.
         state.update_edge_at(cuttlefish::side_t::front, cuttlefish::edge_encoding_t::N);
@@ -200,15 +250,16 @@ inline bool Read_CdBG_Constructor<k>::add_crossing_loop(const Endpoint<k>& endpo
 
 
 template <uint16_t k>
-inline bool Read_CdBG_Constructor<k>::add_one_sided_loop(const Endpoint<k>& endpoint)
+inline bool Read_CdBG_Constructor<k>::add_one_sided_loop(const Endpoint<k>& endpoint, cuttlefish::edge_encoding_t& e_old)
 {
     // Fetch the hash table entry for the vertex associated to the endpoint.
 
     Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket = hash_table[endpoint.hash()];
     State_Read_Space& state = bucket.get_state();
+    e_old = state.edge_at(endpoint.side());
 
     // We can get away without updating the same value again: see detailed comment in `add_incident_edge`.
-    if(state.edge_at(endpoint.side()) == cuttlefish::edge_encoding_t::N) // The incidence information has already been discarded.
+    if(e_old == cuttlefish::edge_encoding_t::N) // The incidence information has already been discarded.
         return true;
 
     // Discard the incidence information.
@@ -222,12 +273,12 @@ bool Read_CdBG_Constructor<k>::add_path_cover_edge(const Edge<k>& e)
 {
     // Fetch the hash table entry for the vertices associated to the endpoints.
 
-    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket_u = hash_table[e.u().canonical()];
+    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket_u = hash_table[e.u().hash()];
     State_Read_Space& st_u = bucket_u.get_state();
     if(st_u.edge_at(e.u().side()) != cuttlefish::edge_encoding_t::E)
         return false;
     
-    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket_v = hash_table[e.v().canonical()];
+    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_READ_KMER> bucket_v = hash_table[e.v().hash()];
     State_Read_Space& st_v = bucket_v.get_state();
     if(st_v.edge_at(e.v().side()) != cuttlefish::edge_encoding_t::E)
         return false;
@@ -240,5 +291,81 @@ bool Read_CdBG_Constructor<k>::add_path_cover_edge(const Edge<k>& e)
 }
 
 
+template <uint16_t k>
+inline void Read_CdBG_Constructor<k>::process_cdbg_edge(const Edge<k>& e, const uint16_t thread_id)
+{
+    if(e.is_loop())
+        if(e.u().side() != e.v().side())    // It is a crossing loop.
+        {
+            cuttlefish::edge_encoding_t e_front, e_back;    // Edges incident to the front and to the back of the vertex before the loop.
+            while(!add_crossing_loop(e.u(), e_front, e_back));
+
+            if(seeds != nullptr)
+            {
+                seeds->add(e.u().canonical(), e.u().hash(), thread_id);
+                record_neighbor(e.u(), e.u().side() == cuttlefish::side_t::front ? e_front : e_back, thread_id);
+                record_neighbor(e.v(), e.v().side() == cuttlefish::side_t::front ? e_front : e_back, thread_id);
+            }
+        }
+        else    // A one-sided loop.
+        {
+            cuttlefish::edge_encoding_t e_old;  // Edge incident to the side of the vertex before the loop.
+            while(!add_one_sided_loop(e.u(), e_old));
+
+            if(seeds != nullptr)
+            {
+                seeds->add(e.u().canonical(), e.u().hash(), thread_id);
+                record_neighbor(e.u(), e_old, thread_id);
+            }
+        }
+    else    // It connects two endpoints `u` and `v` of two distinct vertex.
+    {
+        // Whether `v` is without any edge, prior to the addition of the edge to `u`.
+        const bool v_isolated = (seeds != nullptr && seeds->covering() && hash_table[e.v().hash()].state() == State_Read_Space());
+
+        cuttlefish::edge_encoding_t e_u_old, e_u_new;   // Edges incident to the side of `u`, before and after the addition of the edge.
+        cuttlefish::edge_encoding_t e_v_old, e_v_new;   // Edges incident to the side of `v`, before and after the addition of the edge.
+        State_Read_Space st_u_old, st_v_old;    // States of `u` and `v` before the addition of the edge.
+        while(!add_incident_edge(e.u(), e_u_old, e_u_new, st_u_old));
+        while(!add_incident_edge(e.v(), e_v_old, e_v_new, st_v_old));
+
+        if(seeds != nullptr)
+        {
+            // The first edge added to a connected component finds both its endpoints without any edge.
+            if(v_isolated && st_u_old == State_Read_Space())
+                seeds->add_cover(e.u().canonical(), e.u().hash(), thread_id);
+
+            record_seeds(e.u(), e.v(), e_u_old, e_u_new, thread_id);
+            record_seeds(e.v(), e.u(), e_v_old, e_v_new, thread_id);
+        }
+    }
+}
+
+
+template <uint16_t k>
+inline void Read_CdBG_Constructor<k>::record_seeds(const Endpoint<k>& u_end, const Endpoint<k>& v_end, const cuttlefish::edge_encoding_t e_old, const cuttlefish::edge_encoding_t e_new, const uint16_t thread_id)
+{
+    if(e_new != cuttlefish::edge_encoding_t::N)
+        return;
+
+    seeds->add(v_end.canonical(), v_end.hash(), thread_id);
+    if(e_old != cuttlefish::edge_encoding_t::N) // The side has just become branching.
+    {
+        seeds->add(u_end.canonical(), u_end.hash(), thread_id);
+        record_neighbor(u_end, e_old, thread_id);
+    }
+}
+
+
+template <uint16_t k>
+inline void Read_CdBG_Constructor<k>::record_neighbor(const Endpoint<k>& v_end, const cuttlefish::edge_encoding_t e, const uint16_t thread_id)
+{
+    if(e == cuttlefish::edge_encoding_t::E || e == cuttlefish::edge_encoding_t::N)
+        return;
+
+    const Endpoint<k> w_end = v_end.neighbor_endpoint(e, hash_table);
+    seeds->add(w_end.canonical(), w_end.hash(), thread_id);
+}
+
 
 #endif
@@ -6,45 +6,81 @@
 
 #include "globals.hpp"
 #include "DNA_Utility.hpp"
+#include "dBG_Utilities.hpp"
 #include "Kmer_Hash_Table.hpp"
 #include "Directed_Vertex.hpp"
 #include "Maximal_Unitig_Scratch.hpp"
 #include "Build_Params.hpp"
 #include "Spin_Lock.hpp"
-#include "Async_Logger_Wrapper.hpp"
+#include "Parallel_Writer.hpp"
 #include "Output_Sink.hpp"
 #include "Unipaths_Meta_info.hpp"
 #include "Progress_Tracker.hpp"
+#include "Unitig_Seeds.hpp"
 
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <atomic>
 
 
 // Forward declarations.
 template <uint16_t k> class Kmer_SPMC_Iterator;
-template <uint16_t k> class Thread_Pool;
+class Thread_Pool;
 
 
 // A class to extract the vertices from a compacted de Bruin graph — which are the maximal unitigs of some ordinary de Bruijn graph.
 template <uint16_t k>
 class Read_CdBG_Extractor
 {
-    friend class Thread_Pool<k>;
-
 private:
 
+    // A walk extracting the maximal unitig containing some seed vertex. A thread advances a
+    // number of walks in a round-robin manner, one step at a time, so that the hash table
+    // accesses of a walk's next vertex are in flight while the others are being advanced.
+    struct Unitig_Walk
+    {
+        // Stage of the walk, i.e. the pending lookup step of its current vertex.
+        enum class Stage: uint8_t
+        {
+            idle,   // The walk is not in progress.
+            rolled, // The vertex has been reached, and its MPHF lookup memory is prefetched.
+            hashed, // The vertex has been hashed, and its state-entry is prefetched.
+        };
+
+        Maximal_Unitig_Scratch<k> maximal_unitig;   // Scratch space to build the maximal unitig.
+        Kmer<k> v_hat;  // The seed vertex.
+        uint64_t h_v_hat;   // Hash value of the seed vertex.
+        State_Read_Space st_v_hat;  // State of the seed vertex.
+        Directed_Vertex<k> v;   // The current vertex of the walk.
+        typename Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>::rolling_minimizer_t v_minimizer;  // Canonical minimizer of `v`, rolled along with a partitioned hash table.
+        State_Read_Space state; // State of the vertex `v`.
+        cuttlefish::side_t s_walk;  // The side of `v_hat` through which the current unitig is being walked.
+        cuttlefish::side_t s_v; // The side of `v` through which to exit it.
+        cuttlefish::base_t b_ext;   // The nucleobase of the edge through which `v` has been entered.
+        bool seeding;   // Whether `v` is the seed vertex, i.e. the walk is yet to start.
+        Stage stage = Stage::idle;  // Stage of the walk.
+
+        // Constructs an idle walk, with its scratch space kept in slabs from the arenas
+        // `label_arena` and `hash_arena`.
+        Unitig_Walk(Slab_Arena<char>& label_arena, Slab_Arena<uint64_t>& hash_arena):
+            maximal_unitig(label_arena, hash_arena)
+        {}
+    };
+
     const Build_Params params;  // Required parameters (wrapped inside).
     Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table; // Hash table for the vertices (i.e. canonical k-mers) of the original (uncompacted) de Bruijn graph.
 
-    // typedef std::ofstream sink_t;
-    typedef Async_Logger_Wrapper sink_t;
+    typedef Parallel_Writer sink_t;
     Output_Sink<sink_t> output_sink;    // Sink for the output maximal unitigs.
 
     // TODO: give these limits more thoughts, especially their exact impact on the memory usage.
     static constexpr std::size_t BUFF_SZ = 100 * 1024ULL;   // 100 KB (soft limit) worth of maximal unitig records (FASTA) can be retained in memory, at most, before flushing.
+    static constexpr std::size_t PARSE_CHUNK_SZ = 64;   // Number of vertices parsed from the database at a time by a thread.
+    static constexpr std::size_t WALK_COUNT = 16;   // Number of unitig walks advanced in an interleaved manner by a thread.
 
     mutable uint64_t vertices_scanned = 0;    // Total number of vertices scanned from the database.
+    std::atomic<uint64_t> vertices_unextracted; // Number of vertices yet to be extracted into maximal unitigs; the vertices provided afterwards are skipped unhashed.
     mutable Spin_Lock lock; // Mutual exclusion lock to access various unique resources by threads spawned off this class' methods.
 
     mutable uint64_t vertices_marked = 0;   // Total number of vertices marked as present in maximal unitigs; used for the extraction of detached chordless cycle(s), if any.
@@ -55,30 +91,38 @@ private:
 
 
     // Distributes the maximal unitigs extraction task — disperses the graph vertices (i.e. k-mers)
-    // parsed by the parser `vertex_parser` to the worker threads in the thread pool `thread_pool`,
+    // provided by the source `vertex_source` to the worker threads in the thread pool `thread_pool`,
     // for the unitpath-flanking vertices to be identified and the corresponding unipaths to be extracted.
-    void distribute_unipaths_extraction(Kmer_SPMC_Iterator<k>* vertex_parser, Thread_Pool<k>& thread_pool);
-
-    // Prcesses the vertices provided to the thread with id `thread_id` from the parser
-    // `vertex_parser`, i.e. for each vertex `v` provided to that thread, attempts to
-    // piece-wise construct its containing maximal unitig.
-    void process_vertices(Kmer_SPMC_Iterator<k>* vertex_parser, uint16_t thread_id);
-
-    // Extracts the maximal unitig `p` that contains the vertex `v_hat`, and `maximal_unitig` is
-    // used as the working scratch for the extraction, i.e. to build and store the two unitigs
-    // connecting to the two sides of `v_hat`. Returns `true` iff the extraction is successful,
-    // which happens when `p` is attempted for output-marking first by this thread.
-    bool extract_maximal_unitig(const Kmer<k>& v_hat, Maximal_Unitig_Scratch<k>& maximal_unitig);
-
-    // Traverses a unitig starting from the vertex `v_hat`, exiting it through the side `s_v_hat`.
-    // The DFA of `v_hat` is supposed to have the state `st_v`. `unitig` is used as the working
-    // scratch to build the unitig. Returns `true` iff the unitig could have been traversed
-    // maximally up-to its endpoint in the direction of the walk from `v_hat`, which is possible
-    // iff no other thread output-marks it in the meantime.
-    bool walk_unitig(const Kmer<k>& v_hat, State_Read_Space st_v, cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig);
+    // The source is either a parser of the vertex-database, or the seed vertices of the maximal unitigs.
+    template <typename T_vertex_source_>
+    void distribute_unipaths_extraction(T_vertex_source_* vertex_source, Thread_Pool& thread_pool);
+
+    // Prcesses the vertices provided to the thread with id `thread_id` from the source
+    // `vertex_source`, i.e. for each vertex `v` provided to that thread, attempts to
+    // piece-wise construct its containing maximal unitig. Up-to `WALK_COUNT` vertices
+    // are processed at a time, with their unitig walks interleaved.
+    template <typename T_vertex_source_>
+    void process_vertices(T_vertex_source_* vertex_source, uint16_t thread_id);
+
+    // Starts the walk `w` to extract the maximal unitig containing the vertex `v_hat`.
+    void start_walk(const Kmer<k>& v_hat, Unitig_Walk& w);
+
+    // Advances the walk `w` by one lookup step of its current vertex. When the state of the
+    // vertex is available, the walk proceeds until it rolls onto the next vertex—to be looked
+    // up in its next step—or it completes. Returns `true` iff the walk completes in this step
+    // with the successful extraction of the maximal unitig `p` containing its seed vertex,
+    // which happens when `p` is attempted for output-marking first by this thread. `p` is
+    // then present at the scratch of `w`.
+    bool advance_walk(Unitig_Walk& w);
+
+    // Tries to exit the current vertex `v` of the walk `w` through its side `s_v`, with the
+    // DFA of `v` having the state `state`. Returns `true` iff the walk is not at an endpoint,
+    // in which case `w` is rolled onto the next vertex and the MPHF memory to be accessed for
+    // that vertex is prefetched.
+    bool exit_vertex(Unitig_Walk& w) const;
 
     // Marks all the vertices which have their hashes present in `path_hashes` as outputted.
-    void mark_path(const std::vector<uint64_t>& path_hashes);
+    void mark_path(const Slab_Vector<uint64_t>& path_hashes);
 
     // Marks all the vertices in the constituent unitigs of `maximal_unitig` as outputted.
     void mark_maximal_unitig(const Maximal_Unitig_Scratch<k>& maximal_unitig);
@@ -101,8 +145,9 @@ public:
     Read_CdBG_Extractor(const Build_Params& params, Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table);
 
     // Extracts the maximal unitigs of the de Bruijn graph with the vertex set at path prefix `vertex_db_path`,
-    // into the output file at `output_file_path`.
-    void extract_maximal_unitigs(const std::string& vertex_db_path, const std::string& output_file_path);    
+    // into the output file at `output_file_path`. If usable seed vertices `seeds` are provided, then the
+    // walks start from those first, and the vertex set is scanned only if some unitig is not covered.
+    void extract_maximal_unitigs(const std::string& vertex_db_path, const std::string& output_file_path, Unitig_Seeds<k>* seeds = nullptr);
 
     // Returns the parameters collection for the compacted graph construction.
     const Build_Params& get_params() const;
@@ -246,10 +291,13 @@ inline bool Read_CdBG_Extractor<k>::mark_vertex(const Directed_Vertex<k>& v)
 
 
 template <uint16_t k>
-inline void Read_CdBG_Extractor<k>::mark_path(const std::vector<uint64_t>& path_hashes)
+inline void Read_CdBG_Extractor<k>::mark_path(const Slab_Vector<uint64_t>& path_hashes)
 {
-    for(const uint64_t hash: path_hashes)
-        hash_table.update(hash, State_Read_Space::mark_outputted);
+    path_hashes.for_each(
+        [this](const uint64_t hash)
+        {
+            hash_table.update(hash, State_Read_Space::mark_outputted);
+        });
 }
 
 
@@ -267,82 +315,136 @@ inline void Read_CdBG_Extractor<k>::mark_maximal_unitig(const Maximal_Unitig_Scr
 
 
 template <uint16_t k>
-inline bool Read_CdBG_Extractor<k>::extract_maximal_unitig(const Kmer<k>& v_hat, Maximal_Unitig_Scratch<k>& maximal_unitig)
+inline void Read_CdBG_Extractor<k>::start_walk(const Kmer<k>& v_hat, Unitig_Walk& w)
+{
+    w.v_hat = v_hat;
+    w.v.from_kmer(v_hat);
+    if(hash_table.partition_count() > 1)
+        w.v_minimizer.reset(v_hat);
+    w.seeding = true;
+
+    hash_table.fetch(w.v.canonical(), w.v.rolling_hash(), w.v_minimizer());
+    w.stage = Unitig_Walk::Stage::rolled;
+}
+
+
+template <uint16_t k>
+inline bool Read_CdBG_Extractor<k>::advance_walk(Unitig_Walk& w)
 {
     static constexpr cuttlefish::side_t back = cuttlefish::side_t::back;
     static constexpr cuttlefish::side_t front = cuttlefish::side_t::front;
+    typedef typename Unitig_Walk::Stage Stage;
 
 
-    State_Read_Space state = hash_table[v_hat].state(); // State of the vertex `v_hat`.
-    if(state.is_outputted())    // The containing maximal unitig has already been outputted.
-        return false;
-
+    if(w.stage == Stage::rolled)
+    {
+        const uint64_t h = hash_table.bucket_id(w.v.canonical(), w.v.rolling_hash(), w.v_minimizer());
+        w.v.set_hash(h);
+        hash_table.fetch(&h, 1);
 
-    maximal_unitig.mark_linear();
-    
-    if(!walk_unitig(v_hat, state, back, maximal_unitig.unitig(back)))
+        w.stage = Stage::hashed;
         return false;
+    }
 
-    if(maximal_unitig.unitig(back).is_cycle())
-        maximal_unitig.mark_cycle(back);
-    else
-        if(!walk_unitig(v_hat, state, front, maximal_unitig.unitig(front)))
-            return false;
-
-
-    if(!mark_vertex(maximal_unitig.sign_vertex()))
+    if(w.stage != Stage::hashed)
         return false;
 
-    maximal_unitig.finalize();
-    return true;
-}
 
+    w.state = hash_table[w.v.hash()].state();
+    bool side_done = false; // Whether the walk through the side `s_walk` of the seed vertex has reached an endpoint.
 
-template <uint16_t k>
-inline bool Read_CdBG_Extractor<k>::walk_unitig(const Kmer<k>& v_hat, const State_Read_Space st_v, const cuttlefish::side_t s_v_hat, Unitig_Scratch<k>& unitig)
-{
-    // Data structures to be reused per each vertex extension of the unitig.
+    if(w.seeding)
+    {
+        if(w.state.is_outputted())  // The containing maximal unitig has already been outputted.
+        {
+            w.stage = Stage::idle;
+            return false;
+        }
 
-    cuttlefish::side_t s_v = s_v_hat;   // The side of the current vertex `v_hat` through which to extend the unitig, i.e. exit `v_hat`.
-    Directed_Vertex<k> v(s_v == cuttlefish::side_t::back ? v_hat : v_hat.reverse_complement(), hash_table); // Current vertex being added to the unitig.
-    State_Read_Space state = st_v;  // State of the vertex `v`.
-    cuttlefish::edge_encoding_t e_v;    // The potential next edge from `v` to include into the unitig.
-    cuttlefish::base_t b_ext;   // The nucleobase corresponding to the edge `e_v` and the exiting side `s_v` from `v` to potentially add to the literal form of the unitig.
-    
-    unitig.init(v); // Initialize the unitig with the current vertex.
+        w.seeding = false;
+        w.h_v_hat = w.v.hash();
+        w.st_v_hat = w.state;
+        w.maximal_unitig.mark_linear();
+
+        w.s_walk = w.s_v = back;
+        w.maximal_unitig.unitig(back).init(w.v);
+    }
+    else
+    {
+        w.s_v = w.v.entrance_side();
+
+        if(w.state.is_outputted())
+        {
+            // If `s_v` was a branching side, then the walk just crossed to a different unitig; so this
+            // unitig is depleted. Otherwise, `s_v` must belong to this unitig. In that case, the unitig
+            // has already been outputted earlier.
+            if(!w.state.was_branching_side(w.s_v))
+            {
+                w.stage = Stage::idle;
+                return false;
+            }
+
+            side_done = true;
+        }
+        else if(w.state.is_branching_side(w.s_v))   // Crossed an endpoint and reached a different unitig.
+            side_done = true;
+        else if(!w.maximal_unitig.unitig(w.s_walk).extend(w.v, DNA_Utility::map_char(w.b_ext)))
+            side_done = true;   // The unitig is a DCC (Detached Chordless Cycle).
+        else    // Still within the unitig.
+            w.s_v = cuttlefish::opposite_side(w.s_v);
+    }
 
 
-    while(true)
+    while(side_done || !exit_vertex(w))
     {
-        e_v = state.edge_at(s_v);
-        if(cuttlefish::is_fuzzy_edge(e_v))  // Reached an endpoint.
-            break;
+        if(w.s_walk == back && !w.maximal_unitig.unitig(back).is_cycle())
+        {
+            // Walk the unitig through the front of the seed vertex.
+            w.v.from_kmer(w.v_hat.reverse_complement());
+            w.v.set_hash(w.h_v_hat);
+            if(hash_table.partition_count() > 1)
+                w.v_minimizer.reset(w.v.kmer());
+            w.state = w.st_v_hat;
+            w.s_walk = w.s_v = front;
+            w.maximal_unitig.unitig(front).init(w.v);
+
+            side_done = false;
+            continue;
+        }
+
+        if(w.s_walk == back)
+            w.maximal_unitig.mark_cycle(back);
+
+        w.stage = Stage::idle;
+        if(!mark_vertex(w.maximal_unitig.sign_vertex()))
+            return false;
 
-        b_ext = (s_v == cuttlefish::side_t::back ? DNA_Utility::map_base(e_v) : DNA_Utility::complement(DNA_Utility::map_base(e_v)));
-        v.roll_forward(b_ext, hash_table);  // Walk to the next vertex.
+        w.maximal_unitig.finalize();
+        return true;
+    }
 
-        state = hash_table[v.hash()].state();
-        s_v = v.entrance_side();
 
-        if(state.is_outputted())
-            return state.was_branching_side(s_v);   // If `s_v` was a branching side, then the walk just crossed to a different unitig;
-                                                    // so this unitig is depleted. Otherwise, `s_v` must belong to this unitig. In that
-                                                    // case, the unitig has already been outputted earlier.
+    return false;   // Rolled onto the next vertex, to be looked up in the walk's next step.
+}
 
-        if(state.is_branching_side(s_v))    // Crossed an endpoint and reached a different unitig.
-            break;
 
-        // Still within the unitig.
-        if(!unitig.extend(v, DNA_Utility::map_char(b_ext)))
-            break;  // The unitig is a DCC (Detached Chordless Cycle).
+template <uint16_t k>
+inline bool Read_CdBG_Extractor<k>::exit_vertex(Unitig_Walk& w) const
+{
+    const cuttlefish::edge_encoding_t e_v = w.state.edge_at(w.s_v);  // The potential next edge from `v` to include into the unitig.
+    if(cuttlefish::is_fuzzy_edge(e_v))  // Reached an endpoint.
+        return false;
 
-        s_v = cuttlefish::opposite_side(s_v);
-    }
+    w.b_ext = (w.s_v == cuttlefish::side_t::back ? DNA_Utility::map_base(e_v) : DNA_Utility::complement(DNA_Utility::map_base(e_v)));
+    w.v.roll_forward(w.b_ext);  // Walk to the next vertex.
+    if(hash_table.partition_count() > 1)
+        w.v_minimizer.roll(w.v.kmer());
 
+    hash_table.fetch(w.v.canonical(), w.v.rolling_hash(), w.v_minimizer());
 
+    w.stage = Unitig_Walk::Stage::rolled;
     return true;
 }
 
 
-
 #endif
@@ -0,0 +1,116 @@
+
+#ifndef REF_CACHE_HPP
+#define REF_CACHE_HPP
+
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+
+
+// A cache of parsed reference sequences, to be replayed in later passes over the
+// references without decompressing and parsing them again. The bases are packed into
+// 2 bits each, with the runs of placeholder bases kept alongside; so a sequence is
+// replayed with its placeholders as 'N's and its bases in upper-case. The cache is
+// kept in memory up-to a limit, and spilled to a file beyond it.
+class Ref_Cache
+{
+private:
+
+    // Header of a cached sequence record. The record consists of the header, followed by
+    // the name of the sequence, the runs of placeholder bases as (start, length) pairs,
+    // and the packed bases.
+    struct Record_Header
+    {
+        uint64_t ref_id;    // Id (number) of the reference containing the sequence.
+        uint64_t seq_id;    // Id (number) of the sequence in its reference.
+        uint64_t seq_len;   // Length of the sequence.
+        uint64_t name_len;  // Length of the name of the sequence.
+        uint64_t n_run_count;   // Number of runs of placeholder bases in the sequence.
+    };
+
+    static constexpr std::size_t SPILL_BUF_SZ = 4 * 1024 * 1024;    // Size of the buffer flushed to the spill file at a time: 4 MB.
+
+    const std::string spill_file_path;  // Path to the file to spill the cache to.
+    const std::size_t memory_limit; // Memory limit (in bytes) to keep the cache in.
+
+    std::vector<uint8_t> buf;   // The cached records in memory, or the ones yet to be flushed if spilled.
+    std::ofstream spill_output; // Output stream to the spill file.
+    std::ifstream spill_input;  // Input stream from the spill file.
+    bool spilled_ = false;  // Whether the cache has been spilled to the file.
+    bool sealed_ = false;   // Whether the cache has been filled completely.
+    std::size_t size_ = 0;  // Size of the cache (in bytes).
+    std::size_t read_pos = 0;   // Position of the next record to replay, if the cache is in memory.
+
+    std::vector<std::string> ref_path_;   // `ref_path_[i]` is the path to the reference with id `i + 1`.
+
+    std::vector<std::pair<uint64_t, uint64_t>> n_run;   // Runs of placeholder bases of the sequence being replayed.
+    std::vector<uint8_t> packed;    // Packed bases of the sequence being replayed.
+    std::vector<uint8_t> record;    // Record of the sequence being cached, if it's encoded by the cache itself.
+
+
+    // Appends `len` bytes from `data` to the cache.
+    void append(const void* data, std::size_t len);
+
+    // Flushes the buffered records to the spill file.
+    void flush();
+
+    // Reads `len` bytes of the cache into `data`. Returns `false` iff the cache has been
+    // replayed completely.
+    bool fetch(void* data, std::size_t len);
+
+
+public:
+
+    // Constructs an empty cache, kept in memory up-to `memory_limit` bytes and spilled
+    // to the file at path `spill_file_path` beyond it.
+    Ref_Cache(const std::string& spill_file_path, std::size_t memory_limit);
+
+    // Destructs the cache, removing its spill file, if any.
+    ~Ref_Cache();
+
+    // Encodes the sequence `seq` of length `seq_len` with name `name`, being the sequence
+    // number `seq_id` in the reference number `ref_id`, into a cache record at `record`.
+    // Independent of any cache, so that the sequences can be encoded by the threads
+    // parsing them.
+    static void encode(const char* name, const char* seq, std::size_t seq_len, uint64_t ref_id, uint64_t seq_id, std::vector<uint8_t>& record);
+
+    // Adds the encoded sequence record `record`, of a sequence in the reference number
+    // `ref_id` at path `ref_path`, to the cache.
+    void add(const std::vector<uint8_t>& record, const std::string& ref_path, uint64_t ref_id);
+
+    // Adds the sequence `seq` of length `seq_len` with name `name`, being the sequence
+    // number `seq_id` in the reference number `ref_id` at path `ref_path`, to the cache.
+    void add(const char* name, const char* seq, std::size_t seq_len, const std::string& ref_path, uint64_t ref_id, uint64_t seq_id);
+
+    // Marks the cache as filled completely.
+    void seal();
+
+    // Returns `true` iff the cache has been filled completely.
+    bool sealed() const;
+
+    // Returns `true` iff the cache has been spilled to its file.
+    bool spilled() const;
+
+    // Returns the size of the cache (in bytes).
+    std::size_t size() const;
+
+    // Starts replaying the cache from its first sequence.
+    void rewind();
+
+    // If sequences are remaining to be replayed, decodes the next one into `seq` and its
+    // name into `name`, puts its reference's and its own ids into `ref_id` and `seq_id`,
+    // and returns `true`. Returns `false` otherwise.
+    bool read_next_seq(std::string& seq, std::string& name, uint64_t& ref_id, uint64_t& seq_id);
+
+    // Returns the path to the reference with id `ref_id`.
+    const std::string& ref_path(uint64_t ref_id) const;
+};
+
+
+
+#endif
@@ -9,31 +9,111 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 #include <queue>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 
 class Seq_Input;
+class BGZF_Reader;
+class Ref_Cache;
 struct _KSEQ_DATA;  // Forward declaration for `kseq`'s sequence-data format.
 
 
-// Wrapper class to parse FASTA/FASTQ files using the `kseq` library.
+// Wrapper class to parse FASTA/FASTQ files using the `kseq` library. In the read-ahead
+// mode, a background thread decompresses and parses the sequences ahead of their use,
+// into a ring of sequence buffers bounded in memory, while the current one is processed.
+// With multiple reader threads, that many references are parsed concurrently, while the
+// sequences are still read in the order of the references in the input collection.
+// BGZF-compressed references are inflated in parallel. The background threads—the
+// readers, and the disk readers and the inflaters of the BGZF references—are all
+// counted against a thread budget. The parsed sequences can also be
+// recorded into a reference cache, which later parsers replay instead of the references;
+// the sequences are encoded for the cache by the threads parsing them.
 class Ref_Parser
 {
     typedef _KSEQ_DATA kseq_t;
 
+    friend int read_reference(Ref_Parser* ref_parser, void* buf, unsigned len);
+
 private:
 
+    // A parsed sequence, buffered in the read-ahead mode.
+    struct Seq_Record
+    {
+        std::string seq;    // The sequence.
+        std::string name;   // Name of the sequence.
+        std::string ref_path;   // Path to the reference containing the sequence.
+        uint64_t ref_id;    // Id (number) of the reference containing the sequence.
+        uint64_t seq_id;    // Id (number) of the sequence in its reference.
+        std::vector<uint8_t> cache_record;  // The sequence encoded as a reference cache record, if it's being cached.
+
+        // Returns the memory (in bytes) held by the record's buffers.
+        std::size_t bytes() const { return seq.capacity() + cache_record.capacity(); }
+    };
+
+    // Queue of the parsed sequences of a reference, in the multi-reader mode.
+    struct Ref_Queue
+    {
+        std::deque<Seq_Record> seq; // The parsed sequences yet to be read.
+        bool parsed = false;    // Whether the reference has been parsed completely.
+    };
+
+    static constexpr std::size_t READ_AHEAD_BUF_COUNT = 4;  // Number of sequence buffers in the read-ahead mode.
+    static constexpr std::size_t READ_AHEAD_MEMORY = 256 * 1024U * 1024U;   // Memory limit (soft) for the sequences parsed ahead, as per their buffers' capacities; at least one is always buffered: 256 MB.
+    static constexpr std::size_t READ_AHEAD_IDLE_BUF_MEMORY = READ_AHEAD_MEMORY / READ_AHEAD_BUF_COUNT;  // Maximum capacity kept by a freed sequence buffer for reuse.
+    static constexpr std::size_t REF_WINDOW_PER_READER = 2; // Number of references that can be parsed ahead of the current one per reader thread, in the multi-reader mode.
+    static constexpr uint16_t BGZF_AUX_THREADS = 2;  // Number of threads per reader, besides the inflaters, parsing a BGZF-compressed reference: the reader itself and the disk reader.
+
     std::queue<std::string> ref_paths;  // Collection of the reference file paths.
-    gzFile file_ptr = nullptr;  // Pointer to the reference file being parsed.
+    gzFile file_ptr = nullptr;  // Pointer to the reference file being parsed, if it's not BGZF-compressed.
+    std::unique_ptr<BGZF_Reader> bgzf_reader;   // Reader of the reference file being parsed, if it's BGZF-compressed.
     kseq_t* parser = nullptr;   // The kseq parser for the reference file being parsed.
 
     std::string curr_ref_path;  // Path to the reference currently being parsed.
     uint64_t ref_count = 0; // Number of the reference currently being parsed.
     uint64_t seq_id_; // Number of the current sequence (in the current reference).
 
-
-    // Constructs a parser for the reference input collection `refs`.
-    Ref_Parser(const std::vector<std::string>& refs);
+    const bool read_ahead;  // Whether the sequences are parsed ahead of their use by a background thread.
+    const uint16_t reader_count;    // Number of threads parsing references concurrently in the read-ahead mode.
+    uint16_t inflate_thread_count;  // Number of threads inflating the blocks of a BGZF-compressed reference; these are inflated through zlib's single stream if it's 0.
+    Ref_Cache* const cache; // Cache to record the parsed sequences into, or to replay the sequences from, if any.
+    const bool replay;  // Whether the sequences are replayed from the cache.
+    std::vector<Seq_Record> record; // Ring of the sequence buffers in the read-ahead mode.
+    std::size_t head = 0;   // Index of the current sequence's buffer in the ring.
+    std::size_t filled = 0; // Number of filled buffers in the ring, including the current sequence's.
+    bool curr_seq = false;  // Whether the current sequence is present at the head of the ring.
+    std::vector<std::string> ref_path_list; // Collection of the reference file paths, in the multi-reader mode.
+    std::vector<Ref_Queue> ref_queue;   // Window of the sequence queues of the references being parsed, in the multi-reader mode.
+    uint64_t next_ref = 0;  // Index of the next reference to be parsed, in the multi-reader mode.
+    uint64_t curr_ref_idx = 0;  // Index of the reference being read from, in the multi-reader mode.
+    std::size_t buffered_bytes = 0; // Total memory of the buffers of the sequences in the ring.
+    bool parse_done = false;    // Whether the references have been parsed completely.
+    bool stop = false;  // Whether the background parsing is to be stopped.
+    std::mutex mutex_;  // Mutex guarding the ring.
+    std::condition_variable seq_filled; // Condition of some sequence being parsed into the ring.
+    std::condition_variable seq_freed;  // Condition of some sequence buffer being freed in the ring.
+    std::vector<std::thread> reader;    // The background threads parsing the sequences ahead.
+
+    double parse_time_ = 0; // Time spent (in seconds) in decompressing and parsing the sequences.
+    double wait_time_ = 0;  // Time spent (in seconds) in waiting for sequences parsed ahead.
+
+
+    // Constructs a parser for the reference input collection `refs`, parsing ahead iff
+    // `read_ahead` is `true`, with up-to `thread_count` background threads, and
+    // recording into or replaying from the cache `cache`.
+    Ref_Parser(const std::vector<std::string>& refs, bool read_ahead, uint16_t thread_count, Ref_Cache* cache);
+
+    // Returns the number of reader threads for parsing the references `refs` ahead
+    // with up-to `thread_count` background threads.
+    static uint16_t reader_thread_count(const std::vector<std::string>& refs, uint16_t thread_count);
+
+    // Returns `true` iff some reference in `refs` is BGZF-compressed.
+    static bool has_BGZF(const std::vector<std::string>& refs);
 
     // Opens the reference at path `reference_path`.
     void open_reference(const std::string& reference_path);
@@ -41,14 +121,65 @@ private:
     // Opens the next reference to be parsed from the collection `ref_file_paths`.
     bool open_next_reference();
 
+    // If sequences are remaining to be parsed, parses the next one into the kseq
+    // buffer and returns `true`. Returns `false` otherwise.
+    bool parse_next_seq();
+
+    // Parses the next sequence, if remaining, as per `parse_next_seq`, tracking the time spent.
+    bool parse_next_seq_timed();
+
+    // If sequences are remaining to be read in the read-ahead mode, waits for the next one
+    // to be present at the head of the ring and returns `true`. Returns `false` otherwise.
+    bool fetch_next_seq();
+
+    // Closes the internal kseq parser for the current reference.
+    void close_reference();
+
+    // Launches the background thread parsing the sequences ahead.
+    void launch_read_ahead();
+
+    // Parses the sequences into the ring of buffers until the references are parsed
+    // completely, or the parsing is stopped.
+    void read_ahead_seqs();
+
+    // Launches the background threads parsing the references concurrently.
+    void launch_multi_read_ahead();
+
+    // Parses references, claimed one at a time, into their sequence queues until all
+    // the references are parsed, or the parsing is stopped.
+    void read_ahead_refs();
+
+    // If sequences are remaining to be read in the multi-reader mode, moves the next one
+    // to the head of the ring and returns `true`. Returns `false` otherwise. The lock
+    // `lock` on the ring is to be held.
+    bool pop_next_seq(std::unique_lock<std::mutex>& lock);
+
+    // Stops the background parsing, if it's ongoing.
+    void stop_read_ahead();
+
 
 public:
 
-    // Constructs a parser for the file at path `file_path`.
-    Ref_Parser(const std::string& file_path);
+    // Constructs a parser for the file at path `file_path`, parsing ahead iff `read_ahead` is `true`.
+    Ref_Parser(const std::string& file_path, bool read_ahead = false);
+
+    // Constructs a parser for the reference input collection present at `ref_input`,
+    // parsing ahead iff `read_ahead` is `true`, with up-to `thread_count` background
+    // threads in total. These are split between reader threads, each parsing a
+    // reference concurrently, and the inflaters of the BGZF-compressed references;
+    // a single reference gets all the threads. If a cache `cache` is provided: if it
+    // has been filled completely, the sequences are replayed from it (ahead of their use)
+    // instead of the references; otherwise, the parsed sequences are recorded into it.
+    Ref_Parser(const Seq_Input& ref_input, bool read_ahead = false, uint16_t thread_count = 1, Ref_Cache* cache = nullptr);
 
-    // Constructs a parser for the reference input collection present at `ref_input`.
-    Ref_Parser(const Seq_Input& ref_input);
+    // Returns the number of background threads, out of up-to `thread_count` ones, that a
+    // parser can put to use in parsing the reference input collection `ref_input` ahead:
+    // a reader per reference at most, and the inflaters beside only if some reference is
+    // BGZF-compressed.
+    static uint16_t thread_demand(const Seq_Input& ref_input, uint16_t thread_count);
+
+    // Destructs the parser.
+    ~Ref_Parser();
 
     // Returns the path to the reference currently being parsed.
     const std::string& curr_ref() const;
@@ -75,7 +206,14 @@ public:
     // Returns the name (as parsed) of the current sequence in the buffer.
     const char* seq_name() const;
 
-    // Closes the internal kseq parser for the current reference.
+    // Returns the time spent (in seconds) in decompressing and parsing the sequences;
+    // valid after closing the parser.
+    double parse_time() const;
+
+    // Returns the time spent (in seconds) in waiting for the sequences parsed ahead.
+    double wait_time() const;
+
+    // Closes the parser.
     void close();
 };
 
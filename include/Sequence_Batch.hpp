@@ -0,0 +1,92 @@
+
+#ifndef SEQUENCE_BATCH_HPP
+#define SEQUENCE_BATCH_HPP
+
+
+
+#include <cstddef>
+#include <vector>
+
+
+// A batch of sequences packed into one buffer, with the boundaries of the
+// sequences kept alongside, so that many short sequences can be processed
+// together as one task.
+class Sequence_Batch
+{
+private:
+
+    std::vector<char> buf;  // The concatenated sequences.
+    std::vector<std::size_t> end_;  // `end_[i]` is the ending offset (exclusive) of the `i`'th sequence in the buffer.
+
+
+public:
+
+    // Appends the sequence `seq` of length `seq_len` to the batch.
+    void add(const char* seq, std::size_t seq_len);
+
+    // Returns the number of sequences in the batch.
+    std::size_t size() const;
+
+    // Returns `true` iff the batch has no sequences.
+    bool empty() const;
+
+    // Returns the total length of the sequences in the batch.
+    std::size_t bytes() const;
+
+    // Returns a pointer to the `i`'th sequence in the batch.
+    const char* seq(std::size_t i) const;
+
+    // Returns the length of the `i`'th sequence in the batch.
+    std::size_t seq_len(std::size_t i) const;
+
+    // Clears the batch.
+    void clear();
+};
+
+
+inline void Sequence_Batch::add(const char* const seq, const std::size_t seq_len)
+{
+    buf.insert(buf.end(), seq, seq + seq_len);
+    end_.push_back(buf.size());
+}
+
+
+inline std::size_t Sequence_Batch::size() const
+{
+    return end_.size();
+}
+
+
+inline bool Sequence_Batch::empty() const
+{
+    return end_.empty();
+}
+
+
+inline std::size_t Sequence_Batch::bytes() const
+{
+    return buf.size();
+}
+
+
+inline const char* Sequence_Batch::seq(const std::size_t i) const
+{
+    return buf.data() + (i == 0 ? 0 : end_[i - 1]);
+}
+
+
+inline std::size_t Sequence_Batch::seq_len(const std::size_t i) const
+{
+    return end_[i] - (i == 0 ? 0 : end_[i - 1]);
+}
+
+
+inline void Sequence_Batch::clear()
+{
+    buf.clear();
+    end_.clear();
+}
+
+
+
+#endif
@@ -0,0 +1,69 @@
+
+#ifndef SLAB_ARENA_HPP
+#define SLAB_ARENA_HPP
+
+
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+
+// An arena of fixed-size slabs of elements of type `T_`, to back growable sequences
+// without reallocations: a sequence grows by acquiring more slabs, and its elements
+// never move. Released slabs are recycled, so the memory held is proportional to the
+// longest sequences present together. Not thread-safe; it is meant to be per thread.
+template <typename T_>
+class Slab_Arena
+{
+public:
+
+    static constexpr std::size_t SLAB_SZ = 4096;    // Number of elements in a slab.
+
+private:
+
+    std::vector<std::unique_ptr<T_[]>> slab;    // All the slabs allocated by the arena.
+    std::vector<T_*> free_slab;  // The slabs available for acquisition.
+
+
+public:
+
+    // Constructs an empty arena.
+    Slab_Arena()
+    {}
+
+    Slab_Arena(const Slab_Arena&) = delete;
+    Slab_Arena& operator=(const Slab_Arena&) = delete;
+
+    // Returns a free slab from the arena.
+    T_* acquire();
+
+    // Returns the slab `s` back to the arena.
+    void release(T_* s);
+};
+
+
+template <typename T_>
+inline T_* Slab_Arena<T_>::acquire()
+{
+    if(free_slab.empty())
+    {
+        slab.emplace_back(new T_[SLAB_SZ]);
+        return slab.back().get();
+    }
+
+    T_* const s = free_slab.back();
+    free_slab.pop_back();
+    return s;
+}
+
+
+template <typename T_>
+inline void Slab_Arena<T_>::release(T_* const s)
+{
+    free_slab.push_back(s);
+}
+
+
+
+#endif
@@ -0,0 +1,186 @@
+
+#ifndef SLAB_VECTOR_HPP
+#define SLAB_VECTOR_HPP
+
+
+
+#include "Slab_Arena.hpp"
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+
+// A growable sequence of elements of type `T_`, stored in slabs acquired from a
+// `Slab_Arena`. Growing the sequence never reallocates or moves its elements, and
+// clearing it returns its slabs to the arena.
+template <typename T_>
+class Slab_Vector
+{
+private:
+
+    static constexpr std::size_t SLAB_SZ = Slab_Arena<T_>::SLAB_SZ;
+
+    Slab_Arena<T_>* arena;  // The arena backing the sequence.
+    std::vector<T_*> slab;  // The slabs of the sequence, in order.
+    std::size_t size_ = 0;  // Number of elements in the sequence.
+
+
+public:
+
+    // Constructs an empty sequence backed by the arena `arena`.
+    explicit Slab_Vector(Slab_Arena<T_>& arena);
+
+    // Constructs a sequence by moving the content of `rhs`, leaving it empty.
+    Slab_Vector(Slab_Vector&& rhs);
+
+    Slab_Vector(const Slab_Vector&) = delete;
+    Slab_Vector& operator=(const Slab_Vector&) = delete;
+
+    // Destructs the sequence, returning its slabs to the arena.
+    ~Slab_Vector();
+
+    // Appends the element `x` to the sequence.
+    void push_back(const T_& x);
+
+    // Appends the `n` elements at `x` to the sequence.
+    void append(const T_* x, std::size_t n);
+
+    // Clears the sequence, returning its slabs to the arena.
+    void clear();
+
+    // Returns the number of elements in the sequence.
+    std::size_t size() const;
+
+    // Applies `f` to each element of the sequence, in order.
+    template <typename T_f_> void for_each(T_f_ f) const;
+
+    // Appends the elements at the indices `[begin, end)` of the sequence to `buf`.
+    void copy_to(std::vector<T_>& buf, std::size_t begin, std::size_t end) const;
+
+    // Appends the elements at the indices `[begin, end)` of the sequence to `buf`
+    // in reverse order, mapped through `f`.
+    template <typename T_f_> void reverse_copy_to(std::vector<T_>& buf, std::size_t begin, std::size_t end, T_f_ f) const;
+};
+
+
+template <typename T_>
+inline Slab_Vector<T_>::Slab_Vector(Slab_Arena<T_>& arena):
+    arena(&arena)
+{}
+
+
+template <typename T_>
+inline Slab_Vector<T_>::Slab_Vector(Slab_Vector&& rhs):
+    arena(rhs.arena),
+    slab(std::move(rhs.slab)),
+    size_(rhs.size_)
+{
+    rhs.slab.clear();
+    rhs.size_ = 0;
+}
+
+
+template <typename T_>
+inline Slab_Vector<T_>::~Slab_Vector()
+{
+    clear();
+}
+
+
+template <typename T_>
+inline void Slab_Vector<T_>::push_back(const T_& x)
+{
+    if(size_ == slab.size() * SLAB_SZ)
+        slab.push_back(arena->acquire());
+
+    slab[size_ / SLAB_SZ][size_ % SLAB_SZ] = x;
+    size_++;
+}
+
+
+template <typename T_>
+inline void Slab_Vector<T_>::append(const T_* x, std::size_t n)
+{
+    while(n > 0)
+    {
+        if(size_ == slab.size() * SLAB_SZ)
+            slab.push_back(arena->acquire());
+
+        const std::size_t off = size_ % SLAB_SZ;
+        const std::size_t len = std::min(SLAB_SZ - off, n);
+        std::copy_n(x, len, slab.back() + off);
+
+        x += len, n -= len, size_ += len;
+    }
+}
+
+
+template <typename T_>
+inline void Slab_Vector<T_>::clear()
+{
+    for(T_* const s : slab)
+        arena->release(s);
+
+    slab.clear();
+    size_ = 0;
+}
+
+
+template <typename T_>
+inline std::size_t Slab_Vector<T_>::size() const
+{
+    return size_;
+}
+
+
+template <typename T_>
+template <typename T_f_>
+inline void Slab_Vector<T_>::for_each(T_f_ f) const
+{
+    for(std::size_t s = 0; s < slab.size(); ++s)
+    {
+        const T_* const data = slab[s];
+        const std::size_t len = std::min(SLAB_SZ, size_ - s * SLAB_SZ);
+        for(std::size_t i = 0; i < len; ++i)
+            f(data[i]);
+    }
+}
+
+
+template <typename T_>
+inline void Slab_Vector<T_>::copy_to(std::vector<T_>& buf, std::size_t begin, const std::size_t end) const
+{
+    while(begin < end)
+    {
+        const T_* const data = slab[begin / SLAB_SZ] + begin % SLAB_SZ;
+        const std::size_t len = std::min(SLAB_SZ - begin % SLAB_SZ, end - begin);
+        buf.insert(buf.end(), data, data + len);
+
+        begin += len;
+    }
+}
+
+
+template <typename T_>
+template <typename T_f_>
+inline void Slab_Vector<T_>::reverse_copy_to(std::vector<T_>& buf, const std::size_t begin, std::size_t end, T_f_ f) const
+{
+    const std::size_t old_size = buf.size();
+    buf.resize(old_size + (end - begin));
+    T_* out = buf.data() + old_size;
+
+    while(end > begin)
+    {
+        const std::size_t s = (end - 1) / SLAB_SZ;
+        const std::size_t lo = std::max(begin, s * SLAB_SZ);
+        for(const T_* p = slab[s] + (end - s * SLAB_SZ); p != slab[s] + (lo - s * SLAB_SZ);)
+            *out++ = f(*--p);
+
+        end = lo;
+    }
+}
+
+
+
+#endif
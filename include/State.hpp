@@ -6,26 +6,23 @@
 
 #include "globals.hpp"
 #include "Vertex.hpp"
-#include "compact_vector/compact_iterator.hpp"
 
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY> class Kmer_Hash_Table;
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_> class Kmer_Hash_Table;
 template <uint8_t BITS_PER_KEY> class Kmer_Hash_Entry_API;
 
 
 class State
 {
-    template <uint16_t k, uint8_t BITS_PER_KEY>
+    template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
     friend class Kmer_Hash_Table;
 
     friend class Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER>;
 
-    typedef compact::iterator_imp::lhs_setter<cuttlefish::state_code_t, cuttlefish::BITS_PER_REF_KMER, uint64_t, true, 64U> ref_bitvector_entry_t;
-
 private:
 
     // The code of the state.
@@ -35,9 +32,6 @@ private:
     // Constructs a `State` with the provided code `state`.
     State(cuttlefish::state_code_t code);
 
-    // Constructs a `State` from the state stored at the bitvector entry `bv_entry`.
-    State(const ref_bitvector_entry_t& bv_entry);
-
     // Sets the DNA base 2-bit encoding at the bits b1 and b0 of `code`.
     // Requirement: the two bits must be zero before the call, for consistent behavior.
     void set_nibble_lower_half(cuttlefish::base_t base);
@@ -116,21 +110,6 @@ inline State::State(const cuttlefish::state_code_t code):
 }
 
 
-inline State::State(const ref_bitvector_entry_t& bv_entry)
-{
-    // CAS vector `fetch` does not work.
-    // bv_entry.fetch_val(vertex_code);
-
-    code = bv_entry;
-
-    if(code == 0b00001 || code == 0b00010)
-    {
-        std::cerr << "Invalid state " << (uint16_t)code << " encountered during construction from bitvector entry. Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
-}
-
-
 inline cuttlefish::state_code_t State::get_state() const
 {
     return code;
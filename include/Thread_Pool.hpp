@@ -4,107 +4,144 @@
 
 
 
-#include "Task_Params.hpp"
+#include "Spin_Lock.hpp"
+#include "Event_Count.hpp"
 
 #include <cstddef>
 #include <cstdint>
 #include <vector>
+#include <deque>
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
 
 
-// A basic thread pool class to support avoidance of latency incurred with frequent
-// construction and destruction of threads throughout the compaction algorithm.
-template <uint16_t k>
+// A work-stealing thread pool to support avoidance of latency incurred with frequent
+// construction and destruction of threads throughout the compaction algorithm. Tasks
+// are closures, and each thread has its own deque of tasks: a thread executes tasks
+// off the back of its own deque, and when it runs dry, steals ones off the front of
+// the others' deques. Ranges of work are split lazily into halves, so that the idle
+// threads steal the larger chunks of the work remaining.
 class Thread_Pool
 {
 public:
 
-    // Types of tasks supported by the thread pool.
-    enum class Task_Type
-    {
-        classification,
-        output_plain,
-        output_gfa,
-        output_gfa_reduced,
-        compute_states_read_space,
-        extract_unipaths_read_space,
-    };
+    // A task, to be executed with the id of the thread executing it.
+    typedef std::function<void(uint16_t)> Task;
 
 
 private:
 
-    // Status of tasks provided to each thread in the pool.
-    enum class Task_Status: uint8_t
+    // Deque of the tasks of a thread.
+    struct alignas(L1_CACHE_LINE_SIZE)
+        Task_Deque
     {
-        pending,    // tasks yet to be provided;
-        available,  // a task is available and waiting to be processed;
-        no_more     // no tasks will be provided anymore.
+        Spin_Lock lock; // Lock guarding the deque.
+        std::deque<Task> task;  // The tasks.
     };
-    
+
 
     // Number of threads in the pool.
     const uint16_t thread_count;
-    
-    // The de Bruijn graph object that this thread pool is operating with.
-    void* const dBG;
-
-    // The type of task that this thread pool will execute.
-    const Task_Type task_type;
 
-    // Collection of the task statuses of each thread.
-    volatile Task_Status* const task_status;
+    // Collection of the task deques of each thread.
+    std::unique_ptr<Task_Deque[]> task_deque;
 
     // The collection of the threads in the pool.
     std::vector<std::thread> thread_pool;
 
-    // Collection of the task parameters for each thread.
-    std::vector<Classification_Task_Params> classify_params;
-    std::vector<Output_Task_Params> output_params;
-    std::vector<Read_dBG_Compaction_Params> read_dBG_compaction_params;
+    std::atomic<uint64_t> queued_count; // Number of tasks present in the deques.
+    std::atomic<uint64_t> pending_count;    // Number of tasks yet to be completed.
+    std::atomic<bool> closed;   // Whether the pool has been closed.
 
+    std::atomic<uint16_t> next_deque;   // Round-robin counter for the deque to submit the next task from outside the pool to.
 
-    // Marks the thread number `thread_id` as busy with some task.
-    void assign_task(uint16_t thread_id);
+    Event_Count work_event; // Event of some task being submitted, or of the pool being closed.
+    Event_Count done_event; // Event of some submitted task being completed.
 
-    // Marks the thread number `thread_id` as free to accept tasks.
-    void free_thread(uint16_t thread_id);
 
-    // Runs tasks with the thread number `thread_id` as long as new tasks are provided
-    // to it. Halts at receiving a signal (through `task_status[thread_id]`) that no
-    // more tasks will be provided.
-    void task(uint16_t thread_id);
+    // Pushes the task `task` to the back of the deque of the thread number `thread_id`.
+    void push(uint16_t thread_id, Task task);
 
+    // Tries to pop a task off the back of the deque of the thread number `thread_id`
+    // into `task`. Returns `true` iff it's successful.
+    bool pop(uint16_t thread_id, Task& task);
 
-public:
+    // Tries to steal a task off the front of some other thread's deque for the thread
+    // number `thread_id` into `task`. Returns `true` iff it's successful.
+    bool steal(uint16_t thread_id, Task& task);
+
+    // Runs tasks with the thread number `thread_id` as long as tasks are submitted to
+    // the pool. Halts when the pool is closed.
+    void run(uint16_t thread_id);
 
-    // Constructs a thread pool with `thread_count` number of threads to operate
-    // on the de Brujin graph `dBG` for tasks of type `task_type`.
-    Thread_Pool(uint16_t thread_count, void* dBG, Task_Type task_type);
+    // Executes the function `f` over the range `[begin, end)` with the thread number
+    // `thread_id`, splitting off the right halves of the range as tasks for the others
+    // to steal while it's larger than `grain_size`.
+    template <typename T_func_>
+    void execute_range(uint16_t thread_id, std::size_t begin, std::size_t end, std::size_t grain_size, const std::shared_ptr<T_func_>& f);
 
-    // Returns the id (number) of an idle thread from the pool.
-    uint16_t get_idle_thread() const;
 
-    // Waits until the thread number `thread_id` becomes idle.
-    void get_thread(uint16_t thread_id) const;
+public:
+
+    // Constructs a thread pool with `thread_count` number of threads.
+    Thread_Pool(uint16_t thread_count);
 
-    // Assigns a classification task to the thread number `thread_id` with the provided parameters.
-    void assign_classification_task(uint16_t thread_id, const char* seq, size_t seq_len, size_t left_end, size_t right_end);
+    // Submits the task `task` to the pool. Thread-safe.
+    void submit(Task task);
 
-    // Assigns an outputting task to the thread number `thread_id` with the provided parameters.
-    void assign_output_task(uint16_t thread_id, const char* seq, size_t seq_len, size_t left_end, size_t right_end);
+    // Submits the execution of the function `f` over the range `[begin, end)` to the pool.
+    // `f` is invoked as `f(thread_id, l, r)` over disjoint subranges `[l, r)` covering the
+    // range, each of size at most `grain_size` unless no thread is idle to take over parts
+    // of it, where `thread_id` is the id of the thread executing it.
+    template <typename T_func_>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain_size, const T_func_& f);
 
-    // Assigns a read-dBG compaction task, either DFA-states computation or maximal unitigs extraction,
-    // to the thread number `thread_id`; the edges (i.e. (k + 1)-mers) or vertices (i.e. k-mers),
-    // respectively, are parsed using `parser`.
-    void assign_read_dBG_compaction_task(void* parser, uint16_t thread_id);
+    // Waits until at most `max_pending` tasks submitted to the pool are yet to be completed.
+    void wait_pending(uint64_t max_pending);
 
-    // Waits until all the threads in the pool have completed their active tasks.
-    void wait_completion() const;
+    // Waits until all the tasks submitted to the pool have been completed.
+    void wait_completion();
 
     // Closes the thread pool.
     void close();
 };
 
 
+template <typename T_func_>
+inline void Thread_Pool::parallel_for(const std::size_t begin, const std::size_t end, const std::size_t grain_size, const T_func_& f)
+{
+    if(begin >= end)
+        return;
+
+    const std::shared_ptr<T_func_> func = std::make_shared<T_func_>(f);
+    submit(
+        [this, begin, end, grain_size, func](const uint16_t thread_id)
+        {
+            execute_range(thread_id, begin, end, grain_size, func);
+        });
+}
+
+
+template <typename T_func_>
+inline void Thread_Pool::execute_range(const uint16_t thread_id, const std::size_t begin, std::size_t end, const std::size_t grain_size, const std::shared_ptr<T_func_>& f)
+{
+    while(end - begin > grain_size)
+    {
+        const std::size_t mid = begin + (end - begin) / 2;
+        push(thread_id,
+            [this, mid, end, grain_size, f](const uint16_t t_id)
+            {
+                execute_range(t_id, mid, end, grain_size, f);
+            });
+
+        end = mid;
+    }
+
+    (*f)(thread_id, begin, end);
+}
+
+
 
 #endif
@@ -5,7 +5,8 @@
 
 
 #include "Directed_Vertex.hpp"
-#include "dBG_Utilities.hpp"
+#include "Slab_Vector.hpp"
+#include "DNA_Utility.hpp"
 
 #include <cstddef>
 #include <cstdint>
@@ -13,15 +14,14 @@
 
 
 // =============================================================================
-// A class to keep scratch data (i.e. working space) for unitigs.
+// A class to keep scratch data (i.e. working space) for unitigs. The label and the
+// hashes of a unitig are kept in slabs from arenas, so that long unitigs grow
+// without reallocations, and the memory is shared among the scratches of a thread.
 template <uint16_t k>
 class Unitig_Scratch
 {
 private:
 
-    // 100K (soft limit) unitig vertices can be retained in memory, at most, before reallocations.
-    static constexpr std::size_t BUFF_SZ = 100 * 1024UL;
-
     Directed_Vertex<k> anchor;      // The anchor vertex of the unitig traversal.
     Directed_Vertex<k> endpoint_;   // The current end of the unitig through which farther extensions can be done.
                                     // (The side for the extension is to be handled by the client code, although can
@@ -30,9 +30,11 @@ private:
     std::size_t vertex_idx;         // Index of the vertex in the path being traversed.
     std::size_t min_v_idx;          // Index of the lexicographically minimum vertex in the path.
     
-    std::vector<char> label_;       // Literal label of the unitig.
-    std::vector<uint64_t> hash_;    // Hashes of the constituent vertices of the unitig.
+    Slab_Vector<char> label_;       // Literal label of the unitig, as traversed.
+    Slab_Vector<uint64_t> hash_;    // Hashes of the constituent vertices of the unitig.
+    bool rc_;                       // Whether the unitig is the reverse complement of its traversed label.
     bool is_cycle_;                 // Whether the unitig is cyclical or not.
+    std::vector<char> kmer_label;   // Scratch space for the label of the first vertex of the unitig.
 
 
     // Clears the scratch data.
@@ -40,8 +42,9 @@ private:
 
 public:
 
-    // Constructs an empty unitig scratch.
-    Unitig_Scratch();
+    // Constructs an empty unitig scratch, with its label and hashes kept in slabs
+    // from the arenas `label_arena` and `hash_arena`, respectively.
+    Unitig_Scratch(Slab_Arena<char>& label_arena, Slab_Arena<uint64_t>& hash_arena);
 
     // Initializes the unitig scratch with the vertex `v`.
     void init(const Directed_Vertex<k>& v);
@@ -51,14 +54,18 @@ public:
     // not render itself a cycle.
     bool extend(const Directed_Vertex<k>& v, char b);
 
-    // Reverse complements the unitig.
+    // Reverse complements the unitig. The label is not transformed in place, but is
+    // reverse complemented on its output.
     void reverse_complement();
 
-    // Returns the literal label of the unitig.
-    const std::vector<char>& label() const;
+    // Returns the length of the literal label of the unitig.
+    std::size_t label_size() const;
+
+    // Appends the literal label of the unitig at the indices `[begin, end)` to `buf`.
+    void append_label(std::vector<char>& buf, std::size_t begin, std::size_t end) const;
 
     // Returns the hash collection of the unitig vertices.
-    const std::vector<uint64_t>& hash() const;
+    const Slab_Vector<uint64_t>& hash() const;
 
     // Returns the current extension-end vertex of the unitig.
     const Directed_Vertex<k>& endpoint() const;
@@ -93,8 +100,10 @@ inline void Unitig_Scratch<k>::init(const Directed_Vertex<k>& v)
     min_vertex_ = endpoint_ = anchor = v;
     min_v_idx = vertex_idx = 0;
 
-    endpoint_.kmer().get_label(label_);
-    hash_.emplace_back(endpoint_.hash());
+    endpoint_.kmer().get_label(kmer_label);
+    label_.append(kmer_label.data(), k);
+    hash_.push_back(endpoint_.hash());
+    rc_ = false;
     is_cycle_ = false;
 }
 
@@ -116,8 +125,8 @@ inline bool Unitig_Scratch<k>::extend(const Directed_Vertex<k>& v, const char b)
         min_vertex_ = endpoint_,
         min_v_idx = vertex_idx;
 
-    label_.emplace_back(b);
-    hash_.emplace_back(endpoint_.hash());
+    label_.push_back(b);
+    hash_.push_back(endpoint_.hash());
 
     return true;
 }
@@ -126,20 +135,30 @@ inline bool Unitig_Scratch<k>::extend(const Directed_Vertex<k>& v, const char b)
 template <uint16_t k>
 inline void Unitig_Scratch<k>::reverse_complement()
 {
-    cuttlefish::reverse_complement(label_);
+    rc_ = !rc_;
     min_v_idx = (hash_.size() - 1 - min_v_idx);
 }
 
 
 template <uint16_t k>
-inline const std::vector<char>& Unitig_Scratch<k>::label() const
+inline std::size_t Unitig_Scratch<k>::label_size() const
+{
+    return label_.size();
+}
+
+
+template <uint16_t k>
+inline void Unitig_Scratch<k>::append_label(std::vector<char>& buf, const std::size_t begin, const std::size_t end) const
 {
-    return label_;
+    if(!rc_)
+        label_.copy_to(buf, begin, end);
+    else
+        label_.reverse_copy_to(buf, label_.size() - end, label_.size() - begin, [](const char c){ return DNA_Utility::complement(c); });
 }
 
 
 template <uint16_t k>
-inline const std::vector<uint64_t>& Unitig_Scratch<k>::hash() const
+inline const Slab_Vector<uint64_t>& Unitig_Scratch<k>::hash() const
 {
     return hash_;
 }
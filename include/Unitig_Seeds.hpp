@@ -0,0 +1,145 @@
+
+#ifndef UNITIG_SEEDS_HPP
+#define UNITIG_SEEDS_HPP
+
+
+
+#include "Kmer.hpp"
+#include "Atomic_Bit_Vector.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+
+// A collection of seed vertices for the maximal unitigs extraction, recorded during the
+// DFA-states computation. The flanking seeds are the vertices having branching sides, and the
+// vertices adjacent to branching sides: each maximal unitig with an endpoint other than a
+// dead-end (i.e. a side without any edge) has such a vertex. The rest of the maximal unitigs
+// are the isolated paths and the DCCs (Detached Chordless Cycles), i.e. the connected
+// components without any branching vertex. These are covered by the cover seeds: an endpoint
+// `u` of each edge `(u, v)` that finds both `u` and `v` without any edge when added to `u`—the
+// first edge added to a component is such one. As the vertex set is enumerated from the edge
+// set, the seeds cover all the maximal unitigs.
+// A vertex is recorded at most once, with its recording tracked at its hash table bucket.
+// The seeds are recorded into lists per thread, and are consumed in chunks concurrently.
+// The record-tracking bitmap and the lists are bounded by a memory budget. If the flanking
+// seeds overflow it, all the seeds are dropped; otherwise, the cover seeds are dropped to make
+// room for them. The extraction then falls back to scanning the vertices for the maximal
+// unitigs not extracted from the seeds.
+template <uint16_t k>
+class Unitig_Seeds
+{
+private:
+
+    // List of the seeds recorded by a thread.
+    struct alignas(L1_CACHE_LINE_SIZE) Seed_List
+    {
+        std::vector<Kmer<k>> seed;  // The recorded flanking seeds.
+        std::vector<Kmer<k>> cover; // The recorded cover seeds.
+        std::atomic<uint64_t> consumed; // Number of the seeds claimed for consumption, the flanking ones first.
+    };
+
+    const uint16_t thread_count;    // Number of threads recording and consuming the seeds.
+    const uint64_t max_seeds_per_thread;    // Maximum number of seeds to be recorded by a thread.
+    Atomic_Bit_Vector<1> recorded;  // Whether the vertex of each hash table bucket has been recorded.
+    std::unique_ptr<Seed_List[]> list;  // Lists of the recorded seeds, per thread.
+    std::atomic<bool> overflown;    // Whether some thread has exceeded its seed limit.
+    std::atomic<bool> cover_dropped;    // Whether the cover seeds have been dropped for exceeding the seed limit.
+    bool sealed = false;    // Whether the seeds have been recorded completely.
+
+
+public:
+
+    // Constructs an empty collection of seeds for a graph with `vertex_count` vertices, to
+    // be recorded and consumed by `thread_count` threads, within `max_memory` bytes. The
+    // budget is to exceed `tracking_memory(vertex_count)`.
+    Unitig_Seeds(uint64_t vertex_count, uint16_t thread_count, std::size_t max_memory);
+
+    // Returns the memory (in bytes) used in tracking the recordings of the seeds for a graph
+    // with `vertex_count` vertices.
+    static std::size_t tracking_memory(uint64_t vertex_count);
+
+    // Records the vertex `v`, with hash value `h`, as a flanking seed by the thread with id
+    // `thread_id`, if it has not been recorded yet.
+    void add(const Kmer<k>& v, uint64_t h, uint16_t thread_id);
+
+    // Records the vertex `v`, with hash value `h`, as a cover seed by the thread with id
+    // `thread_id`, if it has not been recorded yet.
+    void add_cover(const Kmer<k>& v, uint64_t h, uint16_t thread_id);
+
+    // Returns `true` iff the cover seeds are still being recorded.
+    bool covering() const { return !cover_dropped; }
+
+    // Marks the seeds as recorded completely, and releases the record-tracking data—and
+    // the seeds too, the ones that have overflown their memory budget.
+    void seal();
+
+    // Returns the maximum number of seeds that can be recorded by a thread.
+    uint64_t max_seeds() const { return max_seeds_per_thread; }
+
+    // Returns `true` iff the flanking seeds have been recorded completely within their memory
+    // limit, i.e. the seeds can be used for the extraction.
+    bool usable() const;
+
+    // Returns `true` iff the seeds cover all the maximal unitigs, i.e. the cover seeds have
+    // been recorded completely within their memory limit too.
+    bool complete() const;
+
+    // Returns the number of recorded seeds.
+    uint64_t size() const;
+
+    // Returns `true` iff seeds are remaining to be consumed by the thread with id `thread_id`.
+    bool tasks_expected(uint16_t thread_id) const;
+
+    // Fetches a chunk of at most `max` seeds, not consumed yet, into `out` for the thread with
+    // id `thread_id`. Returns the number of seeds fetched. Thread-safe.
+    std::size_t next_chunk(uint16_t thread_id, Kmer<k>* out, std::size_t max);
+};
+
+
+template <uint16_t k>
+inline void Unitig_Seeds<k>::add(const Kmer<k>& v, const uint64_t h, const uint16_t thread_id)
+{
+    if(recorded.load(h) || !recorded.cas(h, 0, 1))
+        return;
+
+    Seed_List& l = list[thread_id];
+    if(l.seed.size() + l.cover.size() == max_seeds_per_thread)
+    {
+        if(l.cover.empty())
+        {
+            overflown = true;
+            return;
+        }
+
+        // The scan for the unseeded unitigs supersedes the cover seeds.
+        cover_dropped = true;
+        std::vector<Kmer<k>>().swap(l.cover);
+    }
+
+    l.seed.push_back(v);
+}
+
+
+template <uint16_t k>
+inline void Unitig_Seeds<k>::add_cover(const Kmer<k>& v, const uint64_t h, const uint16_t thread_id)
+{
+    if(cover_dropped || recorded.load(h) || !recorded.cas(h, 0, 1))
+        return;
+
+    Seed_List& l = list[thread_id];
+    if(l.seed.size() + l.cover.size() == max_seeds_per_thread)
+    {
+        cover_dropped = true;
+        std::vector<Kmer<k>>().swap(l.cover);
+        return;
+    }
+
+    l.cover.push_back(v);
+}
+
+
+#endif
@@ -0,0 +1,102 @@
+
+#ifndef VERTEX_ENUMERATOR_HPP
+#define VERTEX_ENUMERATOR_HPP
+
+
+
+#include "Kmer.hpp"
+#include "kmer_Enumeration_Stats.hpp"
+#include "Spin_Lock.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+
+
+template <uint16_t k> class Kmer_SPMC_Iterator;
+template <uint16_t k> class Kmer_DB_Writer;
+
+
+// Enumerator of the vertices of a de Bruijn graph, i.e. the canonical k-mers,
+// from a KMC database of its edges, i.e. the (k + 1)-mers—without another KMC
+// execution. The edges are streamed and split into their canonical endpoint
+// k-mers, which are bucketed on disk by their first few bases. The buckets are
+// then sorted and deduplicated in parallel, and written out in order as a KMC
+// database of the vertices. A bucket too large for its sorter's share of the
+// memory is split further by its next few bases, recursively.
+template <uint16_t k>
+class Vertex_Enumerator
+{
+private:
+
+    // Number of leading bases of the vertices determining their buckets.
+    static constexpr uint16_t bucket_prefix_len = (k < 4 ? k : 4);
+
+    // Number of buckets of the vertices.
+    static constexpr std::size_t bucket_count = static_cast<std::size_t>(1) << (2 * bucket_prefix_len);
+
+    // Number of further bases of the vertices determining the sub-buckets of a split bucket.
+    static constexpr uint16_t split_prefix_len = 4;
+
+    // Number of vertices buffered per bucket by each thread before being written to disk.
+    static constexpr std::size_t vertex_buf_size = 1024;
+
+    // Number of vertices read at a time from a bucket being split.
+    static constexpr std::size_t split_buf_size = 65536;
+
+    const uint16_t thread_count;    // Number of threads to use in the enumeration.
+    const std::string temp_file_prefix; // Path prefix for the temporary files.
+
+    std::vector<std::ofstream> bucket_file; // The files of the buckets.
+    std::vector<uint64_t> bucket_size;  // Number of vertices (with some duplicates) written to each bucket.
+    std::unique_ptr<Spin_Lock[]> lock;  // Locks guarding the bucket files.
+
+
+    // Returns the path to the temporary file for the bucket `b`.
+    std::string bucket_file_path(std::size_t b) const;
+
+    // Splits the edges provided to the thread with ID `thread_id` by the parser
+    // `parser` into their canonical endpoint vertices, and distributes those to
+    // their buckets.
+    void split_edges(Kmer_SPMC_Iterator<k + 1>& parser, uint16_t thread_id);
+
+    // Sorts and deduplicates the buckets, using at most around `max_memory` bytes
+    // of memory, and writes the distinct vertices through the writer `writer`.
+    void sort_buckets(Kmer_DB_Writer<k>& writer, std::size_t max_memory);
+
+    // Reads the `size` vertices of the bucket at `file_path` into `vertices`,
+    // removes the bucket, and sorts and deduplicates the vertices.
+    static void load_bucket(const std::string& file_path, uint64_t size, std::vector<Kmer<k>>& vertices);
+
+    // Splits the bucket at `file_path`, of vertices sharing their first
+    // `prefix_len` bases, into sub-buckets by their next bases; and removes it.
+    // The sizes of the sub-buckets are put into `sub_size`.
+    static void split_bucket(const std::string& file_path, uint16_t prefix_len, std::vector<uint64_t>& sub_size);
+
+    // Sorts and deduplicates the bucket at `file_path`, of `size` vertices sharing
+    // their first `prefix_len` bases, and writes the distinct vertices through the
+    // writer `writer`—splitting it recursively into sub-buckets that fit in
+    // `max_memory` bytes of memory. `vertices`, `suff_buf`, and `pref_runs` are
+    // working buffers.
+    static void write_split_bucket(const std::string& file_path, uint64_t size, uint16_t prefix_len, std::size_t max_memory, Kmer_DB_Writer<k>& writer, std::vector<Kmer<k>>& vertices, std::vector<uint8_t>& suff_buf, std::vector<std::pair<uint64_t, uint64_t>>& pref_runs);
+
+
+public:
+
+    // Constructs a vertex enumerator that uses `thread_count` threads, and the
+    // path prefix `temp_file_prefix` for temporary files.
+    Vertex_Enumerator(uint16_t thread_count, const std::string& temp_file_prefix);
+
+    // Enumerates the vertices of the graph with its edges at the KMC database at
+    // `edge_db_path` into a KMC database at `vertex_db_path`, using at most
+    // around `max_memory` GB of memory. Returns summary statistics of the
+    // enumeration.
+    kmer_Enumeration_Stats<k> enumerate(const std::string& edge_db_path, std::size_t max_memory, const std::string& vertex_db_path);
+};
+
+
+
+#endif
@@ -5,6 +5,7 @@
 
 
 #include "nlohmann/json.hpp"
+#include "Huge_Pages.hpp"
 
 #include <cstdint>
 #include <string>
@@ -34,6 +35,7 @@ private:
     static constexpr const char* short_seqs_field = "short seqs";   // Category header for information about sequences shorter than length `k`.
     static constexpr const char* dcc_field = "detached chordless cycles (DCC) info";  // Category header for information about the DCCs.
     static constexpr const char* params_field = "parameters info"; // Category header for the graph build parameters.
+    static constexpr const char* memory_field = "memory info"; // Category header for information about the memory backing of the data structures.
 
 
     // Loads the JSON file from disk, if the corresponding file exists.
@@ -67,6 +69,10 @@ public:
     // Adds information about the extracted maximal unitigs from `cdbg`.
     void add_unipaths_info(const CdBG<k>& cdbg);
 
+    // Adds information about the page backings obtained for the hash table:
+    // `bucket_backing` for its buckets and `mphf_backing` for its MPHF.
+    void add_memory_info(Page_Backing bucket_backing, Page_Backing mphf_backing);
+
     // Adds information about the references shorter than length k.
     void add_short_seqs_info(const std::vector<std::pair<std::string, std::size_t>>& short_seqs);
 
@@ -58,9 +58,34 @@ namespace cuttlefish
 
     constexpr uint8_t BITS_PER_REF_KMER = 5;
     constexpr uint8_t BITS_PER_READ_KMER = 6;
+
+
+    // Version of the format of the saved hash table files, i.e. the MPHF and the buckets. It is
+    // to be bumped on changes to their layouts, or to the hashing or the state encodings of the
+    // k-mers; files of other versions are rejected on loading.
+    constexpr uint32_t HASH_TABLE_FORMAT_VERSION = 1;
 }
 
 
+// Forward declarations of the minimal perfect hash function (MPHF) backends.
+template <uint16_t k> class BBHash_MPHF;
+template <uint16_t k> class PTHash_MPHF;
+
+namespace cuttlefish
+{
+    // The MPHF backend for the k-mer hash tables, selected at build-time.
+#ifdef CF_PTHASH_MPHF
+    template <uint16_t k> using mphf_t = PTHash_MPHF<k>;
+#else
+    template <uint16_t k> using mphf_t = BBHash_MPHF<k>;
+#endif
+}
+
+// Forward declaration of the k-mer hash table, with its MPHF backend policy
+// defaulting to the build-time selection.
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_ = cuttlefish::mphf_t<k>> class Kmer_Hash_Table;
+
+
 // Metaprogramming macro-loops for instantiating required template instances.
 
 // Given some `x`, explicitly instantiates the class `class_name` for the template parameter `k` with `2x + 1`;
@@ -82,6 +107,10 @@ namespace cuttlefish
 #define INSTANTIATE_ALL(z, x, class_name)   template class class_name<2 * x + 1>;\
                                             template class class_name<2 * x + 2>;
 
+// Given some `x`, explicitly instantiates the class `class_name` for the template parameters `k` with `2x + 1`,
+// and the MPHF type with the one selected for that `k`; i.e. it is an instantiator for odd k-values.
+#define INSTANTIATE_PER_MPHF(z, x, class_name) template class class_name<2 * x + 1, cuttlefish::mphf_t<2 * x + 1>>;
+
 
 // BOOST_PP_REPEAT reference: https://www.boost.org/doc/libs/1_55_0/libs/preprocessor/doc/ref/repeat.html
 
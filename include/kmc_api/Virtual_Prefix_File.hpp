@@ -9,10 +9,11 @@
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
+#include <unistd.h>
 
 
 // A class to imitate the KMC3 prefix-file access as if it's in memory.
-// Note: only linear indexing is supported.
+// Note: linear indexing is efficient; random indexing reloads the buffer.
 class Virtual_Prefix_File
 {
 private:
@@ -29,8 +30,12 @@ private:
 
 
 	// Reads in as much data as possible from the prefix-file into the in-memory buffer,
-	// and returns the number of elements read.
-	std::size_t read_prefixes();
+	// starting at the prefix index `idx`, and returns the number of elements read.
+	std::size_t read_prefixes(std::size_t idx);
+
+	// Reads `bytes` bytes into `buf` from the prefix-file, from the offset of the prefix
+	// index `idx` onward.
+	void read_at(std::size_t idx, void* buf, std::size_t bytes) const;
 
 
 public:
@@ -55,22 +60,38 @@ public:
 	// Returns the data at index `idx` of the prefix-file.
 	uint64_t operator[](std::size_t idx);
 
+	// Returns the data at index `idx` of the prefix-file, without going through the
+	// in-memory buffer.
+	uint64_t at(std::size_t idx) const;
+
 	// Returns the size of the buffer in bytes.
 	static constexpr std::size_t memory();
 };
 
 
-inline std::size_t Virtual_Prefix_File::read_prefixes()
+inline void Virtual_Prefix_File::read_at(const std::size_t idx, void* const buf, const std::size_t bytes) const
 {
-	const std::size_t elems_to_read = std::min(prefix_file_elem_count - prefix_chunk_end_index, buffer_elem_count);
-	const std::size_t bytes_to_read = elems_to_read * sizeof(uint64_t);
-	const std::size_t bytes_read = std::fread(prefix_file_buf.data(), 1, bytes_to_read, fp);
-	
-	if(bytes_read != bytes_to_read)
+	// The prefixes start after the 4-byte marker of the file.
+	const off_t offset = 4 + idx * sizeof(uint64_t);
+	std::size_t bytes_read = 0;
+	while(bytes_read < bytes)
 	{
-		std::cerr << "Error reading the KMC database prefix file. Aborting.\n";
-		std::exit(EXIT_FAILURE);
+		const ssize_t read_count = ::pread(fileno(fp), static_cast<char*>(buf) + bytes_read, bytes - bytes_read, offset + bytes_read);
+		if(read_count <= 0)
+		{
+			std::cerr << "Error reading the KMC database prefix file. Aborting.\n";
+			std::exit(EXIT_FAILURE);
+		}
+
+		bytes_read += read_count;
 	}
+}
+
+
+inline std::size_t Virtual_Prefix_File::read_prefixes(const std::size_t idx)
+{
+	const std::size_t elems_to_read = std::min(prefix_file_elem_count - idx, buffer_elem_count);
+	read_at(idx, prefix_file_buf.data(), elems_to_read * sizeof(uint64_t));
 
 	return elems_to_read;
 }
@@ -84,16 +105,31 @@ inline uint64_t Virtual_Prefix_File::operator[](const std::size_t idx)
 	if(idx == prefix_file_elem_count - 1)
 		return total_kmers;
 
-	if(idx >= prefix_chunk_end_index)
+	if(idx < prefix_chunk_start_index || idx >= prefix_chunk_end_index)
 	{
 		prefix_chunk_start_index = idx;
-		prefix_chunk_end_index = idx + read_prefixes();
+		prefix_chunk_end_index = idx + read_prefixes(idx);
 	}
 
 	return prefix_file_buf[idx - prefix_chunk_start_index];
 }
 
 
+inline uint64_t Virtual_Prefix_File::at(const std::size_t idx) const
+{
+	if(idx >= prefix_file_elem_count)
+		return total_kmers + 1;
+
+	if(idx == prefix_file_elem_count - 1)
+		return total_kmers;
+
+	uint64_t prefix;
+	read_at(idx, &prefix, sizeof(prefix));
+
+	return prefix;
+}
+
+
 inline constexpr std::size_t Virtual_Prefix_File::memory()
 {
 	return buffer_elem_count * sizeof(uint64_t);
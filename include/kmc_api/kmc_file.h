@@ -21,6 +21,7 @@
 #include <unistd.h>
 #include <utility>
 #include <limits>
+#include <algorithm>
 
 
 struct CKMCFileInfo
@@ -61,6 +62,7 @@ class CKMC_DB
 	
 	uchar* sufix_file_buf;
 	uint64 sufix_number;			// The sufix's number to be listed
+	uint64 sufix_end;				// The (exclusive) sufix's number where listing ends; for Cuttlefish's ranged listing.
 	uint64 index_in_partial_buf;	// The current byte's number in an array "sufix_file_buf", for listing mode
 
 	uint32 kmer_length;
@@ -137,6 +139,16 @@ public:
 	// Returns the current suffix's index (i.e. the next one to be parsed).
 	uint64_t curr_suffix_idx() const;
 
+	// Returns the number of entries in the prefix file, including its guard entry.
+	uint64_t prefix_count() const;
+
+	// Returns the index of the first suffix having the prefix-file entry `prefix_idx`.
+	uint64_t prefix_suffix_idx(uint64_t prefix_idx) const;
+
+	// Restricts the listing to the suffixes of the prefix-file entries in the range
+	// `[prefix_begin, prefix_end)`. Only for the Cuttlefish listing mode.
+	void restrict_listing(uint64_t prefix_begin, uint64_t prefix_end);
+
 	// Reads up-to `max_bytes_to_read` bytes worth of raw suffix records into the buffer `suff_buf`.
 	// The prefixes corresponding to these suffixes are read into `pref_buf`, in the form
 	// <prefix, #corresponding_suffix>. Returns the number of suffixes read. `0` is returned if
@@ -148,6 +160,11 @@ public:
 	// where "abundance" is the count of remaining k-mers to be parsed having this "prefix". The
 	// iterator is adjusted accordingly for the next parse operation from the buffers.
 	template <uint16_t k> void parse_kmer_buf(std::vector<std::pair<uint64_t, uint64_t>>::iterator& prefix_it, const uint8_t* suff_buf, size_t buf_idx, Kmer<k>& kmer) const;
+
+	// Parses `n` consecutive raw binary k-mers from the `buf_idx`'th byte onward of the buffer
+	// `suff_buf`, into the Cuttlefish k-mer objects `kmers[0..n)`. The prefix of a run of k-mers
+	// sharing it is decoded only once. `prefix_it` is adjusted as in the single k-mer parse.
+	template <uint16_t k> void parse_kmer_buf(std::vector<std::pair<uint64_t, uint64_t>>::iterator& prefix_it, const uint8_t* suff_buf, size_t buf_idx, Kmer<k>* kmers, size_t n) const;
 	
 	// Returns the memory (in bytes) used by the prefix file buffer.
 	static constexpr std::size_t pref_buf_memory();
@@ -215,6 +232,13 @@ public:
 	private:
 		uint32 count_for_kmer_kmc1(CKmerAPI& kmer);
 		uint32 count_for_kmer_kmc2(CKmerAPI& kmer, uint32 bin_start_pos);
+
+		// Returns the KMC-aligned prefix `prefix`, shifted towards the MSD of the first KMC word.
+		uint64_t aligned_prefix(uint64_t prefix) const;
+
+		// Decodes the raw binary suffix at `suff` appended to the KMC-aligned prefix `temp_prefix`,
+		// into the Cuttlefish k-mer object `kmer`.
+		template <uint16_t k> void decode_suffix(uint64_t temp_prefix, const uint8_t* suff, Kmer<k>& kmer) const;
 };
 
 //-----------------------------------------------------------------------------------------------
@@ -494,6 +518,7 @@ inline uint64_t CKMC_DB::read_raw_suffixes(uint8_t* const suff_buf, std::vector<
 
 	const size_t max_suff_count = (suff_record_size() > 0 ?	max_bytes_to_read / suff_record_size() :
 															std::numeric_limits<std::size_t>::max());
+	const uint64_t suff_idx_start = sufix_number;	// Index of the first suffix to be read into the buffer `suff_buf`.
 	uint64_t suff_read_count = 0;	// Count of suffixes to be read into the buffer `suff_buf`.
 	pref_buf.clear();
 
@@ -526,7 +551,7 @@ inline uint64_t CKMC_DB::read_raw_suffixes(uint8_t* const suff_buf, std::vector<
 				pref_buf.emplace_back(prefix_index, suff_to_read);
 				suff_read_count += suff_to_read;
 
-				if(sufix_number == total_kmers)
+				if(sufix_number == sufix_end)
 					end_of_file = true;
 			}
 			else
@@ -543,10 +568,18 @@ inline uint64_t CKMC_DB::read_raw_suffixes(uint8_t* const suff_buf, std::vector<
 		prefix_index++;
 	}
 
+	// The suffixes are read with positional reads, so that multiple listings may share the file.
 	const size_t bytes_to_read = suff_read_count * suff_record_size();
-	const size_t bytes_read = std::fread(suff_buf, 1, bytes_to_read, file_suf);
-	if(bytes_read != bytes_to_read)
-		return 0;
+	const off_t offset = 4 + suff_idx_start * suff_record_size();	// The suffixes start after the 4-byte marker of the file.
+	size_t bytes_read = 0;
+	while(bytes_read < bytes_to_read)
+	{
+		const ssize_t read_count = ::pread(fileno(file_suf), suff_buf + bytes_read, bytes_to_read - bytes_read, offset + bytes_read);
+		if(read_count <= 0)
+			return 0;
+
+		bytes_read += read_count;
+	}
 
 	suf_file_left_to_read -= bytes_read;
 
@@ -554,6 +587,27 @@ inline uint64_t CKMC_DB::read_raw_suffixes(uint8_t* const suff_buf, std::vector<
 }
 
 
+inline uint64_t CKMC_DB::prefix_count() const
+{
+	return prefix_file_buf_size;
+}
+
+
+inline uint64_t CKMC_DB::prefix_suffix_idx(const uint64_t prefix_idx) const
+{
+	return std::min(prefix_virt_buf.at(prefix_idx), static_cast<uint64_t>(total_kmers));
+}
+
+
+inline void CKMC_DB::restrict_listing(const uint64_t prefix_begin, const uint64_t prefix_end)
+{
+	prefix_index = prefix_begin;
+	sufix_number = prefix_suffix_idx(prefix_begin);
+	sufix_end = prefix_suffix_idx(prefix_end);
+	end_of_file = (sufix_number >= sufix_end);
+}
+
+
 inline uint32_t CKMC_DB::suff_record_size() const
 {
 	return sufix_rec_size;
@@ -572,36 +626,33 @@ inline uint64_t CKMC_DB::curr_suffix_idx() const
 }
 
 
+inline uint64_t CKMC_DB::aligned_prefix(const uint64_t prefix) const
+{
+	const uint32_t off = (sizeof(prefix) * 8) - (lut_prefix_length * 2) - byte_alignment_ * 2;
+	return (prefix & prefix_mask_) << off;	// shift prefix towards MSD. "& prefix_mask" necessary for kmc2 db format
+}
+
+
 template <uint16_t k>
-inline void CKMC_DB::parse_kmer_buf(std::vector<std::pair<uint64_t, uint64_t>>::iterator& prefix_it, const uint8_t* const suff_buf, size_t buf_idx, Kmer<k>& kmer) const
+inline void CKMC_DB::decode_suffix(const uint64_t temp_prefix, const uint8_t* const suff, Kmer<k>& kmer) const
 {
 	static constexpr uint16_t NUM_INTS = (k + 31) / 32;
 	uint64_t kmc_data[NUM_INTS]{};
 
-	// Check if we have exhausted the currrent prefix.
-	if(prefix_it->second == 0)
-		++prefix_it;
-
-	const uint64_t prefix = prefix_it->first;
-	prefix_it->second--;
-
-	uint32_t off = (sizeof(prefix) * 8) - (lut_prefix_length * 2) - byte_alignment_ * 2;
-	const uint64_t temp_prefix = (prefix & prefix_mask_) << off;	// shift prefix towards MSD. "& prefix_mask" necessary for kmc2 db format
-
 	// Store prefix in a KMC alignment (differs in endianness from Cuttlefish's).
 	kmc_data[0] = temp_prefix;
 
 
 	// Parse suffix.
 	uint32_t row_idx{0};
-	uint64_t suff{0};
+	uint64_t suff_word{0};
 
-	off -= 8;
+	uint32_t off = (sizeof(temp_prefix) * 8) - (lut_prefix_length * 2) - byte_alignment_ * 2 - 8;
 	for(uint32 a = 0; a < sufix_size; a++)
 	{			
-		suff = suff_buf[buf_idx++];
-		suff = suff << off;
-		kmc_data[row_idx] = kmc_data[row_idx] | suff;
+		suff_word = suff[a];
+		suff_word = suff_word << off;
+		kmc_data[row_idx] = kmc_data[row_idx] | suff_word;
 
 		if(off == 0)				//the end of a word in kmer_data
 		{
@@ -612,14 +663,45 @@ inline void CKMC_DB::parse_kmer_buf(std::vector<std::pair<uint64_t, uint64_t>>::
 			off -= 8;
 	}
 
-	// Skip counter.
-	// buf_idx += counter_size;
-
 	// Parse KMC raw-binary k-mer data to Cuttlefish's k-mer format.
 	kmer.from_KMC_data(kmc_data);
 }
 
 
+template <uint16_t k>
+inline void CKMC_DB::parse_kmer_buf(std::vector<std::pair<uint64_t, uint64_t>>::iterator& prefix_it, const uint8_t* const suff_buf, const size_t buf_idx, Kmer<k>& kmer) const
+{
+	// Check if we have exhausted the currrent prefix.
+	if(prefix_it->second == 0)
+		++prefix_it;
+
+	prefix_it->second--;
+	decode_suffix(aligned_prefix(prefix_it->first), suff_buf + buf_idx, kmer);
+}
+
+
+template <uint16_t k>
+inline void CKMC_DB::parse_kmer_buf(std::vector<std::pair<uint64_t, uint64_t>>::iterator& prefix_it, const uint8_t* const suff_buf, const size_t buf_idx, Kmer<k>* const kmers, const size_t n) const
+{
+	const uint8_t* suff = suff_buf + buf_idx;
+	size_t parsed = 0;
+	while(parsed < n)
+	{
+		// Skip the exhausted prefixes.
+		while(prefix_it->second == 0)
+			++prefix_it;
+
+		const uint64_t run = std::min(static_cast<uint64_t>(n - parsed), prefix_it->second);
+		const uint64_t temp_prefix = aligned_prefix(prefix_it->first);
+		for(uint64_t i = 0; i < run; ++i, suff += sufix_rec_size)
+			decode_suffix(temp_prefix, suff, kmers[parsed + i]);
+
+		prefix_it->second -= run;
+		parsed += run;
+	}
+}
+
+
 inline constexpr std::size_t CKMC_DB::pref_buf_memory()
 {
 	return Virtual_Prefix_File::memory();
@@ -0,0 +1,173 @@
+
+#include "BBHash_MPHF.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "globals.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+
+template <uint16_t k> constexpr double BBHash_MPHF<k>::bits_per_gamma[];
+template <uint16_t k> constexpr double BBHash_MPHF<k>::gamma_min;
+template <uint16_t k> constexpr double BBHash_MPHF<k>::gamma_max;
+template <uint16_t k> constexpr double BBHash_MPHF<k>::gamma_resolution;
+
+
+template <uint16_t k>
+double BBHash_MPHF<k>::bits_per_key(const double gamma)
+{
+    const std::size_t gamma_idx = static_cast<std::size_t>(std::min(std::max(gamma, gamma_min), gamma_max) / gamma_resolution + 0.5);
+    return bits_per_gamma[gamma_idx];
+}
+
+
+template <uint16_t k>
+double BBHash_MPHF<k>::gamma(const double max_bits_per_key)
+{
+    const std::size_t gamma_idx = (std::upper_bound(bits_per_gamma, bits_per_gamma + (sizeof(bits_per_gamma) / sizeof(*bits_per_gamma)), max_bits_per_key) - 1) - bits_per_gamma;
+    return gamma_idx * gamma_resolution;
+}
+
+
+template <uint16_t k>
+void BBHash_MPHF<k>::build(const Kmer_Container<k>& kmer_container, const uint16_t thread_count, const std::string& working_dir_path, const double gamma)
+{
+    // auto data_iterator = boomphf::range(kmer_container.buf_begin(), kmer_container.buf_end());
+    const auto data_iterator = boomphf::range(kmer_container.spmc_begin(thread_count), kmer_container.spmc_end(thread_count));
+    mph.reset(new mphf_t(kmer_container.size(), data_iterator, working_dir_path, thread_count, gamma));
+
+    // std::cout << "Total data copy time to BBHash buffers " << mph->data_copy_time << "\n\n";
+}
+
+
+// An iterator over an in-memory array of keys. BBHash streams the keys of its
+// first levels through the consumer interface of `Kmer_SPMC_Iterator`, and of
+// its later levels through the usual sequential iterator interface; hence both
+// are provided.
+template <uint16_t k>
+class BBHash_MPHF<k>::Key_Array_Iterator
+{
+private:
+
+    const Kmer<k>* kmers;   // The array of keys.
+    std::size_t idx;    // Index of the current key.
+    std::size_t n;  // Number of keys in the array.
+
+
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Kmer<k> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Kmer<k>* pointer;
+    typedef const Kmer<k>& reference;
+
+
+    Key_Array_Iterator(const Kmer<k>* const kmers, const std::size_t idx, const std::size_t n):
+        kmers(kmers),
+        idx(idx),
+        n(n)
+    {}
+
+    const Kmer<k>& operator*() const
+    {
+        return kmers[idx];
+    }
+
+    Key_Array_Iterator& operator++()
+    {
+        idx++;
+        return *this;
+    }
+
+    bool operator==(const Key_Array_Iterator& rhs) const
+    {
+        return idx == rhs.idx;
+    }
+
+    bool operator!=(const Key_Array_Iterator& rhs) const
+    {
+        return idx != rhs.idx;
+    }
+
+    // The keys are already in memory; so there is no production to launch or seize.
+    bool launched() const { return true; }
+    void launch_production() {}
+    void seize_production() {}
+
+    bool tasks_expected(const std::size_t consumer_id) const
+    {
+        (void)consumer_id;
+        return __atomic_load_n(&idx, __ATOMIC_RELAXED) < n;
+    }
+
+    bool value_at(const std::size_t consumer_id, Kmer<k>& kmer)
+    {
+        (void)consumer_id;
+
+        const std::size_t i = __atomic_fetch_add(&idx, 1, __ATOMIC_RELAXED);
+        if(i >= n)
+            return false;
+
+        kmer = kmers[i];
+        return true;
+    }
+};
+
+
+template <uint16_t k>
+void BBHash_MPHF<k>::build(const Kmer<k>* const kmers, const std::size_t n, const uint16_t thread_count, const std::string& working_dir_path, const double gamma)
+{
+    // The keys are in memory, so the later levels re-iterate over them instead of reading from temporary
+    // files. BBHash's fast-mode of caching the remaining keys in memory is not supported, hence disabled.
+    const auto data_iterator = boomphf::range(Key_Array_Iterator(kmers, 0, n), Key_Array_Iterator(kmers, n, n));
+    mph.reset(new mphf_t(n, data_iterator, working_dir_path, thread_count, gamma, false, false, 0));
+}
+
+
+template <uint16_t k>
+uint64_t BBHash_MPHF<k>::bit_size() const
+{
+    return mph->totalBitSize();
+}
+
+
+template <uint16_t k>
+Page_Backing BBHash_MPHF<k>::backing() const
+{
+    const uint64_t* const data = mph->firstLevelData();
+    return data != nullptr ? Huge_Pages::backing(data) : Page_Backing::regular;
+}
+
+
+template <uint16_t k>
+void BBHash_MPHF<k>::save(std::ostream& output) const
+{
+    mph->save(output);
+}
+
+
+template <uint16_t k>
+void BBHash_MPHF<k>::load(const std::string& file_path, const bool populate)
+{
+    (void)populate;
+
+    std::ifstream input(file_path.c_str(), std::ifstream::in);
+    if(input.fail())
+    {
+        std::cerr << "Error opening file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    mph.reset(new mphf_t());
+    mph->load(input);
+
+    input.close();
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, BBHash_MPHF)
@@ -0,0 +1,260 @@
+
+#include "BGZF_Reader.hpp"
+#include "zlib.h"
+
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+
+BGZF_Reader::BGZF_Reader(const std::string& file_path, const uint16_t thread_count):
+    file_path(file_path),
+    file_ptr(std::fopen(file_path.c_str(), "rb")),
+    slot_count(SLOTS_PER_THREAD * std::max(thread_count, static_cast<uint16_t>(1))),
+    block(new Block[slot_count])
+{
+    if(file_ptr == nullptr)
+    {
+        std::cerr << "Error opening BGZF file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    // Launch the disk-reader and the inflater threads.
+    disk_reader.reset(
+        new std::thread([this]()
+            {
+                read_blocks();
+            }
+        )
+    );
+
+    for(uint16_t t_id = 0; t_id < std::max(thread_count, static_cast<uint16_t>(1)); ++t_id)
+        inflater.emplace_back(&BGZF_Reader::inflate_blocks, this);
+}
+
+
+BGZF_Reader::~BGZF_Reader()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop = true;
+    slot_freed.notify_all();
+    block_read.notify_all();
+    block_inflated.notify_all();
+    lock.unlock();
+
+    disk_reader->join();
+    for(auto& t : inflater)
+        t.join();
+
+    std::fclose(file_ptr);
+}
+
+
+bool BGZF_Reader::is_BGZF(const std::string& file_path)
+{
+    std::FILE* const fp = std::fopen(file_path.c_str(), "rb");
+    if(fp == nullptr)
+        return false;
+
+    // A BGZF block is a gzip member with the FEXTRA flag set, and the first subfield of its extra field
+    // is the block-size subfield: with identifiers 'B' and 'C', and length 2.
+    uint8_t header[HEADER_SIZE + 6];
+    const bool is_bgzf =    std::fread(header, 1, sizeof(header), fp) == sizeof(header) &&
+                            header[0] == 31 && header[1] == 139 && header[2] == 8 && (header[3] & 4) &&
+                            header[12] == 'B' && header[13] == 'C' && header[14] == 2 && header[15] == 0;
+
+    std::fclose(fp);
+    return is_bgzf;
+}
+
+
+bool BGZF_Reader::parse_block_size(const uint8_t* const extra, const std::size_t xlen, std::size_t& block_size)
+{
+    std::size_t pos = 0;
+    while(pos + 4 <= xlen)
+    {
+        const std::size_t slen = extra[pos + 2] | (extra[pos + 3] << 8);
+        if(extra[pos] == 'B' && extra[pos + 1] == 'C' && slen == 2 && pos + 6 <= xlen)
+        {
+            block_size = (extra[pos + 4] | (extra[pos + 5] << 8)) + 1;
+            return true;
+        }
+
+        pos += 4 + slen;
+    }
+
+
+    return false;
+}
+
+
+bool BGZF_Reader::read_block(std::vector<uint8_t>& buf)
+{
+    buf.resize(HEADER_SIZE);
+    const std::size_t header_read = std::fread(buf.data(), 1, HEADER_SIZE, file_ptr);
+    if(header_read == 0 && std::feof(file_ptr))
+        return false;
+
+    if(header_read != HEADER_SIZE || buf[0] != 31 || buf[1] != 139 || buf[2] != 8 || !(buf[3] & 4))
+    {
+        std::cerr << "Malformed BGZF block encountered in file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    const std::size_t xlen = buf[10] | (buf[11] << 8);
+    buf.resize(HEADER_SIZE + xlen);
+    std::size_t block_size;
+    if(std::fread(buf.data() + HEADER_SIZE, 1, xlen, file_ptr) != xlen ||
+        !parse_block_size(buf.data() + HEADER_SIZE, xlen, block_size) ||
+        block_size < HEADER_SIZE + xlen + FOOTER_SIZE)
+    {
+        std::cerr << "Malformed BGZF block encountered in file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    buf.resize(block_size);
+    const std::size_t rest = block_size - (HEADER_SIZE + xlen);
+    if(std::fread(buf.data() + HEADER_SIZE + xlen, 1, rest, file_ptr) != rest)
+    {
+        std::cerr << "Truncated BGZF block encountered in file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    return true;
+}
+
+
+void BGZF_Reader::inflate_block(const std::vector<uint8_t>& in, std::vector<char>& out) const
+{
+    const std::size_t xlen = in[10] | (in[11] << 8);
+    const uint8_t* const footer = in.data() + in.size() - FOOTER_SIZE;
+    const uint32_t crc = footer[0] | (footer[1] << 8) | (footer[2] << 16) | (static_cast<uint32_t>(footer[3]) << 24);
+    const uint32_t isize = footer[4] | (footer[5] << 8) | (footer[6] << 16) | (static_cast<uint32_t>(footer[7]) << 24);
+
+    out.resize(isize);
+    if(isize == 0)  // E.g. the end-of-file marker block.
+        return;
+
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    bool inflated = (inflateInit2(&zs, -15) == Z_OK);   // Raw deflate stream, without the zlib or gzip wrappers.
+    if(inflated)
+    {
+        zs.next_in = const_cast<Bytef*>(in.data() + HEADER_SIZE + xlen);
+        zs.avail_in = static_cast<uInt>(in.size() - HEADER_SIZE - xlen - FOOTER_SIZE);
+        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = isize;
+
+        inflated = (inflate(&zs, Z_FINISH) == Z_STREAM_END && zs.total_out == isize);
+        inflateEnd(&zs);
+    }
+
+    if(!inflated || crc32(0, reinterpret_cast<const Bytef*>(out.data()), isize) != crc)
+    {
+        std::cerr << "Corrupt BGZF block encountered in file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+void BGZF_Reader::read_blocks()
+{
+    while(true)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slot_freed.wait(lock, [this](){ return stop || blocks_read - blocks_consumed < slot_count; });
+        if(stop)
+            return;
+
+        // Only this thread fills free slots, so the slot can be filled outside the lock.
+        Block& b = block[blocks_read % slot_count];
+        lock.unlock();
+
+        const bool read = read_block(b.in);
+
+        lock.lock();
+        if(!read)
+        {
+            eof = true;
+            block_read.notify_all();
+            block_inflated.notify_all();
+
+            return;
+        }
+
+        b.state = Block::State::read;
+        blocks_read++;
+        block_read.notify_one();
+    }
+}
+
+
+void BGZF_Reader::inflate_blocks()
+{
+    while(true)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        block_read.wait(lock, [this](){ return stop || blocks_claimed < blocks_read || eof; });
+        if(stop || blocks_claimed == blocks_read)   // The latter implies the end of the file.
+            return;
+
+        Block& b = block[blocks_claimed % slot_count];
+        blocks_claimed++;
+        lock.unlock();
+
+        inflate_block(b.in, b.out);
+
+        lock.lock();
+        b.state = Block::State::inflated;
+        block_inflated.notify_all();
+    }
+}
+
+
+int BGZF_Reader::read(void* const buf, const unsigned len)
+{
+    char* const dest = static_cast<char*>(buf);
+    std::size_t bytes_read = 0;
+
+    while(bytes_read < len)
+    {
+        if(!curr_block)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            block_inflated.wait(lock,
+                [this]()
+                {
+                    return  (blocks_consumed < blocks_read && block[blocks_consumed % slot_count].state == Block::State::inflated) ||
+                            (eof && blocks_consumed == blocks_read);
+                });
+
+            if(blocks_consumed == blocks_read)  // The content has been read completely.
+                break;
+
+            curr_block = true;
+            out_pos = 0;
+        }
+
+
+        Block& b = block[blocks_consumed % slot_count];
+        const std::size_t n = std::min(static_cast<std::size_t>(len) - bytes_read, b.out.size() - out_pos);
+        std::memcpy(dest + bytes_read, b.out.data() + out_pos, n);
+        out_pos += n;
+        bytes_read += n;
+
+        // Free the slot of the current block once it's handed over completely.
+        if(out_pos == b.out.size())
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            b.state = Block::State::empty;
+            blocks_consumed++;
+            curr_block = false;
+            slot_freed.notify_one();
+        }
+    }
+
+
+    return static_cast<int>(bytes_read);
+}
@@ -25,7 +25,13 @@ Build_Params::Build_Params( const bool is_read_graph,
                             const bool path_cover,
                             const bool save_mph,
                             const bool save_buckets,
-                            const bool save_vertices
+                            const bool save_vertices,
+                            const bool populate_loads,
+                            const bool explicit_huge_pages,
+                            const uint64_t partition_count,
+                            const bool in_memory_dbs,
+                            const bool cache_refs,
+                            const bool direct_io
 #ifdef CF_DEVELOP_MODE
                             , const double gamma
 #endif
@@ -48,7 +54,13 @@ Build_Params::Build_Params( const bool is_read_graph,
         path_cover_(path_cover),
         save_mph_(save_mph),
         save_buckets_(save_buckets),
-        save_vertices_(save_vertices)
+        save_vertices_(save_vertices),
+        populate_loads_(populate_loads),
+        explicit_huge_pages_(explicit_huge_pages),
+        partition_count_(partition_count),
+        in_memory_dbs_(in_memory_dbs),
+        cache_refs_(cache_refs),
+        direct_io_(direct_io)
 #ifdef CF_DEVELOP_MODE
         , gamma_(gamma)
 #endif
@@ -85,6 +97,14 @@ bool Build_Params::is_valid() const
         valid = false;
     }
 
+
+    // The hash table must have at least one partition.
+    if(partition_count_ == 0)
+    {
+        std::cout << "The hash table requires at least one partition.\n";
+        valid = false;
+    }
+
     
     // Output directory must exist.
     const std::string op_dir = dirname(output_file_path_);
@@ -104,6 +124,14 @@ bool Build_Params::is_valid() const
     }
 
 
+    // The RAM-backed directory for in-memory databases must exist.
+    if(in_memory_dbs_ && !dir_exists(cuttlefish::_default::IN_MEMORY_DIR))
+    {
+        std::cout << "RAM-backed directory " << cuttlefish::_default::IN_MEMORY_DIR << " for in-memory databases does not exist.\n";
+        valid = false;
+    }
+
+
     // Memory budget options should not be mixed with.
     if(max_memory_  && !strict_memory_)
         std::cout << "Both a memory bound and the option for unrestricted memory usage specified. Unrestricted memory mode will be used.\n";
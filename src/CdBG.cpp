@@ -4,6 +4,8 @@
 #include "kmer_Enumerator.hpp"
 #include "Kmer_Container.hpp"
 #include "kmer_Enumeration_Stats.hpp"
+#include "Ref_Cache.hpp"
+#include "Ref_Parser.hpp"
 
 
 template <uint16_t k> 
@@ -66,6 +68,7 @@ void CdBG<k>::construct()
 
     std::cout << "\nComputing the DFA states.\n";
     classify_vertices();
+    dbg_info.add_memory_info(hash_table->bucket_backing(), hash_table->mphf_backing());
     if(params.track_short_seqs())
         dbg_info.add_short_seqs_info(short_seqs);
 
@@ -75,6 +78,7 @@ void CdBG<k>::construct()
 
     std::cout << "\nExtracting the maximal unitigs.\n";
     output_maximal_unitigs();
+    ref_cache.reset();  // Release the reference cache, if any.
 
     std::chrono::high_resolution_clock::time_point t_extract = std::chrono::high_resolution_clock::now();
     std::cout << "Extracted the maximal unitigs. Time taken = " << std::chrono::duration_cast<std::chrono::duration<double>>(t_extract - t_dfa).count() << " seconds.\n";
@@ -100,14 +104,20 @@ kmer_Enumeration_Stats<k> CdBG<k>::enumerate_vertices() const
 template <uint16_t k>
 void CdBG<k>::construct_hash_table(const uint64_t vertex_count)
 {
+    Huge_Pages::enable_explicit(params.explicit_huge_pages());
+
     std::size_t max_memory = std::max(process_peak_memory(), params.max_memory() * 1024U * 1024U * 1024U);
-    max_memory = (max_memory > parser_memory ? max_memory - parser_memory : 0);
+    const std::size_t db_memory = (logistics.in_memory_vertex_db() ? Kmer_Container<k>::database_size(logistics.vertex_db_path()) : 0);
+    if(db_memory > 0 && db_memory + parser_memory >= max_memory)
+        std::cout << "WARNING: the in-memory vertex database exceeds the memory limit. Consider increasing it, or not using the in-memory databases.\n";
+
+    max_memory = (max_memory > parser_memory + db_memory ? max_memory - (parser_memory + db_memory) : 0);
 
     hash_table = (params.strict_memory() ?
                     std::make_unique<Kmer_Hash_Table<k, cuttlefish::BITS_PER_REF_KMER>>(logistics.vertex_db_path(), vertex_count, max_memory) :
                     std::make_unique<Kmer_Hash_Table<k, cuttlefish::BITS_PER_REF_KMER>>(logistics.vertex_db_path(), vertex_count, max_memory, std::numeric_limits<double>::max()));
 
-    hash_table->construct(params.thread_count(), logistics.working_dir_path(), params.mph_file_path(), params.save_mph());
+    hash_table->construct(params.thread_count(), logistics.working_dir_path(), logistics.temp_file_prefix(), params.mph_file_path(), params.save_mph(), params.populate_loads(), params.partition_count());
 }
 
 
@@ -118,28 +128,54 @@ bool CdBG<k>::is_constructed() const
 }
 
 
+template <uint16_t k>
+uint16_t CdBG<k>::ref_parser_thread_count() const
+{
+    // A filled cache is replayed by a single background thread.
+    if(ref_cache != nullptr && ref_cache->sealed())
+        return 1;
+
+    // The parser is reserved only as many threads from its share as it can put to use for the references.
+    const uint16_t thread_share = std::max(params.thread_count() / REF_PARSER_THREAD_SHARE, 1);
+    return Ref_Parser::thread_demand(params.sequence_input(), thread_share);
+}
+
+
+template <uint16_t k>
+uint16_t CdBG<k>::worker_thread_count() const
+{
+    return std::max(params.thread_count() - ref_parser_thread_count(), 1);
+}
+
+
+template <uint16_t k>
+std::size_t CdBG<k>::ref_cache_memory() const
+{
+    const std::size_t max_memory = std::max(process_peak_memory(), params.max_memory() * 1024U * 1024U * 1024U);
+    const std::size_t db_memory = (logistics.in_memory_vertex_db() ? Kmer_Container<k>::database_size(logistics.vertex_db_path()) : 0);
+    const std::size_t used_memory = hash_table->memory() + parser_memory + Parallel_Writer::memory() + db_memory;
+
+    return max_memory > used_memory ? max_memory - used_memory : 0;
+}
+
+
 template <uint16_t k> 
 size_t CdBG<k>::search_valid_kmer(const char* const seq, const size_t left_end, const size_t right_end) const
 {
-    size_t valid_start_idx;
-    uint16_t base_count;
-    
-
     size_t idx = left_end;
     while(idx <= right_end)
     {
         // Go over the contiguous subsequence of 'N's.
-        for(; idx <= right_end && DNA_Utility::is_placeholder(seq[idx]); idx++);
+        idx += DNA_Utility::find_base(seq + idx, right_end + 1 - idx);
 
-        // Go over the contiguous subsequence of non-'N's.
+        // Go over the contiguous subsequence of non-'N's, up-to `k` of them.
         if(idx <= right_end)
         {
-            valid_start_idx = idx;
-            base_count = 0;
+            const size_t base_count = DNA_Utility::find_placeholder(seq + idx, k);
+            if(base_count == k)
+                return idx;
 
-            for(; idx <= right_end + k - 1 && !DNA_Utility::is_placeholder(seq[idx]); ++idx)
-                if(++base_count == k)
-                    return valid_start_idx;
+            idx += base_count;
         }
     }
 
@@ -149,9 +185,9 @@ size_t CdBG<k>::search_valid_kmer(const char* const seq, const size_t left_end,
 
 
 template <uint16_t k>
-std::size_t CdBG<k>::max_disk_usage(const kmer_Enumeration_Stats<k>& vertex_stats)
+std::size_t CdBG<k>::max_disk_usage(const kmer_Enumeration_Stats<k>& vertex_stats) const
 {
-    return std::max(vertex_stats.temp_disk_usage(), vertex_stats.db_size());
+    return std::max(vertex_stats.temp_disk_usage(), logistics.in_memory_vertex_db() ? 0 : vertex_stats.db_size());
 }
 
 
@@ -4,9 +4,13 @@
 #include "Directed_Kmer.hpp"
 #include "Ref_Parser.hpp"
 #include "Thread_Pool.hpp"
+#include "Sequence_Batch.hpp"
+#include "Ref_Cache.hpp"
 
+#include <algorithm>
 #include <iomanip>
 #include <chrono>
+#include <memory>
 
 
 template <uint16_t k>
@@ -23,19 +27,29 @@ void CdBG<k>::classify_vertices()
         std::cout << "Found the hash table buckets at file " << buckets_file_path << "\n";
         std::cout << "Loading the buckets.\n";
 
-        hash_table->load_hash_buckets(buckets_file_path);
+        hash_table->load_hash_buckets(buckets_file_path, params.populate_loads());
 
         std::cout << "Loaded the buckets into memory.\n";
     }
     else    // No buckets file name provided, or does not exist. Build and save (if specified) one now.
     {
-        // Open a parser for the FASTA / FASTQ file containing the reference.
-        Ref_Parser parser(params.sequence_input());
+        // Cache the parsed references for the output pass, if requested.
+        if(params.cache_refs())
+        {
+            const std::size_t cache_memory = ref_cache_memory();
+            if(cache_memory == 0)
+                std::cout << "No memory is left for the reference cache; it is spilled to the working directory.\n";
+
+            ref_cache = std::make_unique<Ref_Cache>(logistics.ref_cache_path(), cache_memory);
+        }
+
+        // Open a parser for the FASTA / FASTQ file containing the reference, parsing the sequences ahead in the background.
+        Ref_Parser parser(params.sequence_input(), true, ref_parser_thread_count(), ref_cache.get());
 
 
-        // Construct a thread pool.
-        const uint16_t thread_count = params.thread_count();
-        Thread_Pool<k> thread_pool(thread_count, this, Thread_Pool<k>::Task_Type::classification);
+        // Construct a thread pool, of the threads left from the parser.
+        const uint16_t thread_count = worker_thread_count();
+        Thread_Pool thread_pool(thread_count);
 
 
         // Track the maximum sequence buffer size used and the total length of the references.
@@ -43,6 +57,8 @@ void CdBG<k>::classify_vertices()
         uint64_t ref_len = 0;
         uint64_t seq_count = 0;
 
+        Sequence_Batch batch;   // Batch of short sequences to be classified together.
+
         // Parse sequences one-by-one, and continue partial classification of the k-mers through them.
         while(parser.read_next_seq())
         {
@@ -64,6 +80,16 @@ void CdBG<k>::classify_vertices()
                 continue;
             }
 
+            // Short sequences are batched together to be classified as one task, avoiding a barrier per sequence.
+            if(seq_len < BATCH_SIZE_THRESHOLD)
+            {
+                batch.add(seq, seq_len);
+                if(batch.bytes() >= BATCH_SIZE_THRESHOLD)
+                    distribute_classification(batch, thread_pool);
+
+                continue;
+            }
+
 
             // Single-threaded classification.
             // process_substring(seq, seq_len, 0, seq_len - k);
@@ -74,6 +100,11 @@ void CdBG<k>::classify_vertices()
             thread_pool.wait_completion();
         }
 
+        if(!batch.empty())
+            distribute_classification(batch, thread_pool);
+
+        thread_pool.wait_completion();
+
         std::cerr << "\nProcessed " << seq_count << " sequences. Total reference length: " << ref_len << " bases.\n";
         std::cout << "Maximum input sequence buffer size used: " << max_buf_sz / (1024 * 1024) << " MB.\n";
 
@@ -82,6 +113,11 @@ void CdBG<k>::classify_vertices()
 
         // Close the parser.
         parser.close();
+        std::cout << "Time spent in parsing the references: " << parser.parse_time() << " seconds;"
+                    " time spent waiting on the parser: " << parser.wait_time() << " seconds.\n";
+        if(ref_cache != nullptr)
+            std::cout << "Cached the references in " << ref_cache->size() / (1024 * 1024) << " MB"
+                        << (ref_cache->spilled() ? ", spilled to the working directory.\n" : ", in memory.\n");
 
 
         // Save the hash table buckets, if a file path is provided.
@@ -102,24 +138,33 @@ void CdBG<k>::classify_vertices()
 
 
 template <uint16_t k>
-void CdBG<k>::distribute_classification(const char* seq, const size_t seq_len, Thread_Pool<k>& thread_pool)
+void CdBG<k>::distribute_classification(const char* seq, const size_t seq_len, Thread_Pool& thread_pool)
 {
-    const uint16_t thread_count = params.thread_count();
-    const size_t task_size = (seq_len - k + 1) / thread_count;
-    const uint16_t partition_count = (task_size < PARTITION_SIZE_THRESHOLD ? 1 : thread_count);
+    // The k-mers are split into ranges lazily, as the threads go idle.
+    thread_pool.parallel_for(0, seq_len - k + 1, TASK_GRAIN_SIZE,
+        [this, seq, seq_len](uint16_t, const size_t left_end, const size_t right_end)
+        {
+            process_substring(seq, seq_len, left_end, right_end - 1);
+        });
+}
 
-    size_t left_end = 0;
-    size_t right_end;
 
-    for(uint16_t t_id = 0; t_id < partition_count; ++t_id)
-    {
-        right_end = (t_id == partition_count - 1 ? seq_len - k : left_end + task_size - 1);
+template <uint16_t k>
+void CdBG<k>::distribute_classification(Sequence_Batch& batch, Thread_Pool& thread_pool)
+{
+    // The batch is handed over to the task; the sequences are buffered in the batch, not the parser.
+    const std::shared_ptr<const Sequence_Batch> seqs = std::make_shared<const Sequence_Batch>(std::move(batch));
+    batch.clear();
 
-        const uint16_t idle_thread_id = thread_pool.get_idle_thread();
-        thread_pool.assign_classification_task(idle_thread_id, seq, seq_len, left_end, right_end);
+    thread_pool.submit(
+        [this, seqs](uint16_t)
+        {
+            for(size_t i = 0; i < seqs->size(); ++i)
+                process_substring(seqs->seq(i), seqs->seq_len(i), 0, seqs->seq_len(i) - k);
+        });
 
-        left_end += task_size;
-    }
+    // Bound the number of batches in flight, to bound the memory held by them.
+    thread_pool.wait_pending(2 * params.thread_count());
 }
 
 
@@ -144,78 +189,98 @@ void CdBG<k>::process_substring(const char* const seq, const size_t seq_len, con
 template <uint16_t k> 
 size_t CdBG<k>::process_contiguous_subseq(const char* const seq, const size_t seq_len, const size_t right_end, const size_t start_idx)
 {
-    size_t kmer_idx = start_idx;
+    // assert(start_idx <= seq_len - k);
 
-    // assert(kmer_idx <= seq_len - k);
+    // Index of the last valid k-mer of this contiguous subsequence, within the provided range.
+    const size_t end_idx = start_idx + DNA_Utility::find_placeholder(seq + start_idx + k, right_end - start_idx);
 
-    Directed_Kmer<k> curr_kmer(Kmer<k>(seq, kmer_idx));
+    uint64_t bucket[kmer_batch_size];   // Hash table buckets of the k-mers in the current batch.
+    Directed_Kmer<k> curr_kmer(Kmer<k>(seq, start_idx));
+    Directed_Kmer<k> next_kmer = curr_kmer;
 
-    // The subsequence contains only an isolated k-mer,
-    // i.e. there's no valid left or right neighboring k-mer to this k-mer.
-    if((kmer_idx == 0 || DNA_Utility::is_placeholder(seq[kmer_idx - 1])) &&
-        (kmer_idx + k == seq_len || DNA_Utility::is_placeholder(seq[kmer_idx + k])))
-        while(!process_isolated_kmer(curr_kmer));
-    else    // At least one valid neighbor exists, either to the left or to the right, or on both sides.
+    // The k-mers are processed in batches, so that the hash table lookups for a batch
+    // are done together and their memory accesses are overlapped.
+    for(size_t batch_start = start_idx; batch_start <= end_idx; batch_start += kmer_batch_size)
     {
-        // Process the leftmost k-mer of this contiguous subsequence.
+        const size_t batch_size = std::min(kmer_batch_size, end_idx - batch_start + 1);
+        fetch_buckets(seq, batch_start, batch_size, bucket);
 
-        // No valid right neighbor exists for the k-mer.
-        if(kmer_idx + k == seq_len || DNA_Utility::is_placeholder(seq[kmer_idx + k]))
+        for(size_t i = 0; i < batch_size; ++i)
         {
-            // A valid left neighbor exists at it's not an isolated k-mer.
-            while(!process_rightmost_kmer(curr_kmer, seq[kmer_idx - 1]));
+            const size_t kmer_idx = batch_start + i;
+            const bool has_left = (kmer_idx > 0 && !DNA_Utility::is_placeholder(seq[kmer_idx - 1]));
+            const bool has_right = (kmer_idx + k < seq_len && !DNA_Utility::is_placeholder(seq[kmer_idx + k]));
 
-            // The contiguous sequence ends at this k-mer.
-            return kmer_idx + k;
-        }
+            if(!has_right)
+            {
+                // The k-mer is isolated, i.e. there's no valid left or right neighboring k-mer to this k-mer.
+                if(!has_left)
+                    while(!process_isolated_kmer(bucket[i]));
+                // A valid left neighbor exists at it's not an isolated k-mer.
+                else
+                    while(!process_rightmost_kmer(curr_kmer, bucket[i], seq[kmer_idx - 1]));
 
-        // A valid right neighbor exists for the k-mer.
-        Directed_Kmer<k> next_kmer = curr_kmer;
-        next_kmer.roll_to_next_kmer(seq[kmer_idx + k]);
-        
-        // No valid left neighbor exists for the k-mer.
-        if(kmer_idx == 0 || DNA_Utility::is_placeholder(seq[kmer_idx - 1]))
-            while(!process_leftmost_kmer(curr_kmer, next_kmer, seq[kmer_idx + k]));
-        // Both left and right valid neighbors exist for this k-mer.
-        else
-            while(!process_internal_kmer(curr_kmer, next_kmer, seq[kmer_idx - 1], seq[kmer_idx + k]));
-        
-
-        // Process the internal k-mers of this contiguous subsequence.
-        // Each of these k-mers have valid neighbors to their left and right.
-        for(kmer_idx++; kmer_idx < right_end && !DNA_Utility::is_placeholder(seq[kmer_idx + k]); ++kmer_idx)
-        {
-            curr_kmer = next_kmer;
+                // The contiguous sequence ends at this k-mer.
+                continue;
+            }
+
+            // A valid right neighbor exists for the k-mer.
             next_kmer.roll_to_next_kmer(seq[kmer_idx + k]);
 
-            while(!process_internal_kmer(curr_kmer, next_kmer, seq[kmer_idx - 1], seq[kmer_idx + k]));
+            // No valid left neighbor exists for the k-mer.
+            if(!has_left)
+                while(!process_leftmost_kmer(curr_kmer, bucket[i], next_kmer, seq[kmer_idx + k]));
+            // Both left and right valid neighbors exist for this k-mer.
+            else
+                while(!process_internal_kmer(curr_kmer, bucket[i], next_kmer, seq[kmer_idx - 1], seq[kmer_idx + k]));
+
+            curr_kmer = next_kmer;
         }
+    }
 
 
-        // Process the rightmost k-mer of this contiguous subsequence. This does not coincide with the leftmost k-mer.
+    // Return the non-inclusive ending index of the processed contiguous subsequence.
+    return end_idx + k;
+}
+
+
+template <uint16_t k>
+void CdBG<k>::fetch_buckets(const char* const seq, const size_t start_idx, const size_t count, uint64_t* const bucket) const
+{
+    Kmer<k> kmer_hat[kmer_batch_size];  // Canonical forms of the k-mers in the batch.
+    Kmer_Rolling_Hash<k> kmer_hash[kmer_batch_size];    // Rolling hashes of the k-mers in the batch.
+    Directed_Kmer<k> kmer(Kmer<k>(seq, start_idx));
+
+    // With a partitioned hash table, the minimizers of the k-mers are rolled along too.
+    const bool partitioned = (hash_table->partition_count() > 1);
+    uint64_t minimizer[kmer_batch_size];    // Canonical minimizers of the k-mers in the batch.
+    typename Kmer_Hash_Table<k, cuttlefish::BITS_PER_REF_KMER>::rolling_minimizer_t kmer_minimizer;
+    if(partitioned)
+        kmer_minimizer.reset(kmer.kmer());
+
+    kmer_hash[0] = kmer.kmer().rolling_hash(kmer.rev_compl());
+    for(size_t i = 0; i < count; ++i)
+    {
+        kmer_hat[i] = kmer.canonical();
+        if(partitioned)
+            minimizer[i] = kmer_minimizer();
 
-        if(kmer_idx <= right_end)   // Required for the cases where the provided range has just length 1, so `start_idx = right_end`.
+        if(i + 1 < count)
         {
-            curr_kmer = next_kmer;
-        
-            // No valid right neighbor exists for the k-mer.
-            if(kmer_idx + k == seq_len || DNA_Utility::is_placeholder(seq[kmer_idx + k]))
-                while(!process_rightmost_kmer(curr_kmer, seq[kmer_idx - 1]));
-            // A valid right neighbor exists for the k-mer.
-            else
-            {
-                next_kmer.roll_to_next_kmer(seq[kmer_idx + k]);
+            kmer.roll_to_next_kmer(seq[start_idx + i + k]);
+            if(partitioned)
+                kmer_minimizer.roll(kmer.kmer());
 
-                while(!process_internal_kmer(curr_kmer, next_kmer, seq[kmer_idx - 1], seq[kmer_idx + k]));
-            }
+            kmer_hash[i + 1] = kmer_hash[i];
+            kmer_hash[i + 1].roll(DNA_Utility::map_base(seq[start_idx + i]), DNA_Utility::map_base(seq[start_idx + i + k]));
         }
-        else
-            kmer_idx--; // `kmer_idx` has to be the index of the last valid k-mer encountered.
     }
 
-
-    // Return the non-inclusive ending index of the processed contiguous subsequence.
-    return kmer_idx + k;
+    if(partitioned)
+        hash_table->bucket_ids(kmer_hat, kmer_hash, minimizer, count, bucket);
+    else
+        hash_table->bucket_ids(kmer_hat, kmer_hash, count, bucket);
+    hash_table->fetch(bucket, count);
 }
 
 
@@ -227,7 +292,7 @@ bool CdBG<k>::is_self_loop(const Kmer<k>& kmer_hat, const Kmer<k>& next_kmer_hat
 
 
 template <uint16_t k>
-bool CdBG<k>::process_loop(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>& next_kmer, const char prev_char)
+bool CdBG<k>::process_loop(const Directed_Kmer<k>& kmer, const uint64_t bucket, const Directed_Kmer<k>& next_kmer, const char prev_char)
 {
     // Note that, any loop that connects two different sides of a vertex makes it a
     // complex node. This is because, from whichever side you may try to include this
@@ -251,9 +316,8 @@ bool CdBG<k>::process_loop(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>&
     // a direct repeat, that produces a crossing loop. In either case, this is a complex node.
     if(!prev_char || kmer.kmer() == next_kmer.kmer())
     {
-        // Fetch the entry for `kmer_hat`.
-        const Kmer<k>& kmer_hat = kmer.canonical();
-        Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(kmer_hat);
+        // Fetch the entry for the canonical form of `kmer`.
+        Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(bucket);
         State& state = hash_table_entry.get_state();
         state = State(Vertex(cuttlefish::State_Class::multi_in_multi_out));
 
@@ -264,19 +328,19 @@ bool CdBG<k>::process_loop(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>&
     // The k-mer is internal, and the loop is one-sided. So it not possible to extend a maximal
     // unitig through that side, so this k-mer can equivalently be treated as a rightmost k-mer
     // (a sentinel) of some sequence.
-    return process_rightmost_kmer(kmer, prev_char);
+    return process_rightmost_kmer(kmer, bucket, prev_char);
 }
 
 
 template <uint16_t k> 
-bool CdBG<k>::process_leftmost_kmer(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>& next_kmer, const char next_char)
+bool CdBG<k>::process_leftmost_kmer(const Directed_Kmer<k>& kmer, const uint64_t bucket, const Directed_Kmer<k>& next_kmer, const char next_char)
 {
     const Kmer<k>& kmer_hat = kmer.canonical();
     const cuttlefish::dir_t dir = kmer.dir();
     const Kmer<k>& next_kmer_hat = next_kmer.canonical();
 
     // Fetch the entry for `kmer_hat`.
-    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(kmer_hat);
+    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(bucket);
     State& state = hash_table_entry.get_state();
 
     // The k-mer is already classified as a complex node.
@@ -285,7 +349,7 @@ bool CdBG<k>::process_leftmost_kmer(const Directed_Kmer<k>& kmer, const Directed
 
     // The k-mer forms a self-loop with the next k-mer.
     if(is_self_loop(kmer_hat, next_kmer_hat))
-        return process_loop(kmer, next_kmer);
+        return process_loop(kmer, bucket, next_kmer);
 
 
     const State old_state = state;
@@ -372,13 +436,12 @@ bool CdBG<k>::process_leftmost_kmer(const Directed_Kmer<k>& kmer, const Directed
 
 
 template <uint16_t k> 
-bool CdBG<k>::process_rightmost_kmer(const Directed_Kmer<k>& kmer, const char prev_char)
+bool CdBG<k>::process_rightmost_kmer(const Directed_Kmer<k>& kmer, const uint64_t bucket, const char prev_char)
 {
-    const Kmer<k>& kmer_hat = kmer.canonical();
     const cuttlefish::dir_t dir = kmer.dir();
 
-    // Fetch the entry for `kmer_hat`.
-    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(kmer_hat);
+    // Fetch the entry for the canonical form of `kmer`.
+    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(bucket);
     State& state = hash_table_entry.get_state();
 
     // The k-mer is already classified as a complex node.
@@ -471,14 +534,14 @@ bool CdBG<k>::process_rightmost_kmer(const Directed_Kmer<k>& kmer, const char pr
 
 
 template <uint16_t k> 
-bool CdBG<k>::process_internal_kmer(const Directed_Kmer<k>& kmer, const Directed_Kmer<k>& next_kmer, const char prev_char, const char next_char)
+bool CdBG<k>::process_internal_kmer(const Directed_Kmer<k>& kmer, const uint64_t bucket, const Directed_Kmer<k>& next_kmer, const char prev_char, const char next_char)
 {
     const Kmer<k>& kmer_hat = kmer.canonical();
     const cuttlefish::dir_t dir = kmer.dir();
     const Kmer<k>& next_kmer_hat = next_kmer.canonical();
 
     // Fetch the hash table entry for `kmer_hat`.
-    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(kmer_hat);
+    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(bucket);
     State& state = hash_table_entry.get_state();
 
     // The k-mer is already classified as a complex node.
@@ -487,7 +550,7 @@ bool CdBG<k>::process_internal_kmer(const Directed_Kmer<k>& kmer, const Directed
 
     // The k-mer forms a self-loop with the next k-mer.
     if(is_self_loop(kmer_hat, next_kmer_hat))
-        return process_loop(kmer, next_kmer, prev_char);
+        return process_loop(kmer, bucket, next_kmer, prev_char);
 
     
     const State old_state = state;
@@ -589,12 +652,10 @@ bool CdBG<k>::process_internal_kmer(const Directed_Kmer<k>& kmer, const Directed
 
 
 template <uint16_t k> 
-bool CdBG<k>::process_isolated_kmer(const Directed_Kmer<k>& kmer)
+bool CdBG<k>::process_isolated_kmer(const uint64_t bucket)
 {
-    const Kmer<k>& kmer_hat = kmer.canonical();
-
-    // Fetch the hash table entry for `kmer_hat`.
-    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(kmer_hat);
+    // Fetch the hash table entry for the k-mer.
+    Kmer_Hash_Entry_API<cuttlefish::BITS_PER_REF_KMER> hash_table_entry = hash_table->at(bucket);
     State& state = hash_table_entry.get_state();
 
 
@@ -12,7 +12,7 @@ void CdBG<k>::write_segment(const uint16_t thread_id, const char* const seq, con
     const size_t segment_len = end_kmer_idx - start_kmer_idx + k;
 
     
-    ensure_buffer_space(buffer, segment_len + 22, output_[thread_id]);
+    ensure_buffer_space(buffer, segment_len + 22, output);
     
     
     // The 'Name' field.
@@ -352,7 +352,7 @@ void CdBG<k>::write_gfa_segment(const uint16_t thread_id, const char* const seq,
     const size_t segment_len = end_kmer_idx - start_kmer_idx + k;
 
     
-    ensure_buffer_space(buffer, segment_len + 49, output_[thread_id]);
+    ensure_buffer_space(buffer, segment_len + 49, output);
 
     // The 'RecordType' field for segment lines.
     buffer += "S";
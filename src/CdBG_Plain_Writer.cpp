@@ -168,7 +168,7 @@ void CdBG<k>::write_path(const uint16_t thread_id, const char* const seq, const
     constexpr std::size_t header_len = 12;  // FASTA header len: '>' + <id> + '\n'
 
 
-    ensure_buffer_space(buffer, path_len + header_len, output_[thread_id]);
+    ensure_buffer_space(buffer, path_len + header_len, output);
 
     buffer += ">";
     buffer += fmt::format_int(unitig_id).c_str();
@@ -3,12 +3,16 @@
 #include "Ref_Parser.hpp"
 #include "Output_Format.hpp"
 #include "Thread_Pool.hpp"
+#include "Sequence_Batch.hpp"
 #include "Job_Queue.hpp"
+#include "Ref_Cache.hpp"
 #include "spdlog/spdlog.h"
 #include "spdlog/async.h"
 #include "spdlog/sinks/basic_file_sink.h"
 
 #include <iomanip>
+#include <memory>
+#include <algorithm>
 
 
 template <uint16_t k>
@@ -39,22 +43,23 @@ void CdBG<k>::output_maximal_unitigs_plain()
 
     
     const Seq_Input& reference_input = params.sequence_input();
-    const uint16_t thread_count = params.thread_count();
+    const uint16_t thread_count = worker_thread_count(); // The threads left from the parser.
 
-    // Open a parser for the FASTA / FASTQ file containing the reference.
-    Ref_Parser parser(reference_input);
+    // Open a parser for the FASTA / FASTQ file containing the reference, parsing the sequences ahead in the background;
+    // the sequences are replayed from the reference cache instead, if one has been filled in the classification pass.
+    Ref_Parser parser(reference_input, true, ref_parser_thread_count(), ref_cache.get());
 
 
-    // Clear the output file and initialize the output loggers.
+    // Clear the output file and open the output writer.
     clear_output_file();
-    init_output_loggers(); 
+    open_output_writer();
     
     // Allocate output buffers for each thread.
     allocate_output_buffers();
 
 
     // Construct a thread pool.
-    Thread_Pool<k> thread_pool(thread_count, this, Thread_Pool<k>::Task_Type::output_plain);
+    Thread_Pool thread_pool(thread_count);
 
 
     // Track the maximum sequence buffer size used and the total length of the references.
@@ -62,6 +67,8 @@ void CdBG<k>::output_maximal_unitigs_plain()
     uint64_t ref_len = 0;
     uint64_t seq_count = 0;
 
+    Sequence_Batch batch;   // Batch of short sequences to be output off together.
+
     // Parse sequences one-by-one, and output each unique maximal unitig encountered through them.
     while(parser.read_next_seq())
     {
@@ -78,6 +85,16 @@ void CdBG<k>::output_maximal_unitigs_plain()
         if(seq_len < k)
             continue;
 
+        // Short sequences are batched together to be output off as one task, avoiding a barrier per sequence.
+        if(seq_len < BATCH_SIZE_THRESHOLD)
+        {
+            batch.add(seq, seq_len);
+            if(batch.bytes() >= BATCH_SIZE_THRESHOLD)
+                distribute_output_plain(batch, thread_pool);
+
+            continue;
+        }
+
 
         // Single-threaded writing.
         // output_off_substring(0, seq, seq_len, 0, seq_len - k, output);
@@ -87,6 +104,11 @@ void CdBG<k>::output_maximal_unitigs_plain()
         thread_pool.wait_completion();
     }
 
+    if(!batch.empty())
+        distribute_output_plain(batch, thread_pool);
+
+    thread_pool.wait_completion();
+
     std::cout << "\nProcessed " << seq_count << " sequences. Total reference length: " << ref_len << " bases.\n";
     std::cout << "Maximum input sequence buffer size used: " << max_buf_sz / (1024 * 1024) << " MB.\n";
 
@@ -95,15 +117,15 @@ void CdBG<k>::output_maximal_unitigs_plain()
     thread_pool.close();
 
 
-    // Flush the buffers.
+    // Flush the buffers, and close the output writer.
     flush_output_buffers();
-
-    // Clear `spdlog`.
-    spdlog::drop_all();
+    close_output_writer();
 
 
     // Close the parser.
     parser.close();
+    std::cout << "Time spent in " << (ref_cache != nullptr ? "replaying the reference cache: " : "parsing the references: ") << parser.parse_time() << " seconds;"
+                " time spent waiting on the parser: " << parser.wait_time() << " seconds.\n";
 
 
     std::chrono::high_resolution_clock::time_point t_end = std::chrono::high_resolution_clock::now();
@@ -113,24 +135,34 @@ void CdBG<k>::output_maximal_unitigs_plain()
 
 
 template <uint16_t k>
-void CdBG<k>::distribute_output_plain(const char* const seq, const size_t seq_len, Thread_Pool<k>& thread_pool)
+void CdBG<k>::distribute_output_plain(const char* const seq, const size_t seq_len, Thread_Pool& thread_pool)
 {
-    const uint16_t thread_count = params.thread_count();
-    const size_t task_size = (seq_len - k + 1) / thread_count;
-    const uint16_t partition_count = (task_size < PARTITION_SIZE_THRESHOLD ? 1 : thread_count);
+    // The k-mers are split into ranges lazily, as the threads go idle; the output buffers
+    // used are of the threads executing the ranges.
+    thread_pool.parallel_for(0, seq_len - k + 1, TASK_GRAIN_SIZE,
+        [this, seq, seq_len](const uint16_t thread_id, const size_t left_end, const size_t right_end)
+        {
+            output_plain_off_substring(thread_id, seq, seq_len, left_end, right_end - 1);
+        });
+}
 
-    size_t left_end = 0;
-    size_t right_end;
 
-    for(uint16_t task_id = 0; task_id < partition_count; ++task_id)
-    {
-        right_end = (task_id == partition_count - 1 ? seq_len - k : left_end + task_size - 1);
-        
-        const uint16_t idle_thread_id = thread_pool.get_idle_thread();
-        thread_pool.assign_output_task(idle_thread_id, seq, seq_len, left_end, right_end);
+template <uint16_t k>
+void CdBG<k>::distribute_output_plain(Sequence_Batch& batch, Thread_Pool& thread_pool)
+{
+    // The batch is handed over to the task; the sequences are buffered in the batch, not the parser.
+    const std::shared_ptr<const Sequence_Batch> seqs = std::make_shared<const Sequence_Batch>(std::move(batch));
+    batch.clear();
 
-        left_end += task_size;
-    }
+    thread_pool.submit(
+        [this, seqs](const uint16_t thread_id)
+        {
+            for(size_t i = 0; i < seqs->size(); ++i)
+                output_plain_off_substring(thread_id, seqs->seq(i), seqs->seq_len(i), 0, seqs->seq_len(i) - k);
+        });
+
+    // Bound the number of batches in flight, to bound the memory held by them.
+    thread_pool.wait_pending(2 * params.thread_count());
 }
 
 
@@ -141,7 +173,7 @@ void CdBG<k>::output_maximal_unitigs_gfa()
 
 
     const Seq_Input& reference_input = params.sequence_input();
-    const uint16_t thread_count = params.thread_count();
+    const uint16_t thread_count = worker_thread_count(); // The threads left from the parser.
     const std::string& working_dir_path = params.working_dir_path();
 
 
@@ -161,11 +193,12 @@ void CdBG<k>::output_maximal_unitigs_gfa()
 
 
     // Construct a thread pool.
-    Thread_Pool<k> thread_pool(thread_count, this, Thread_Pool<k>::Task_Type::output_gfa);
+    Thread_Pool thread_pool(thread_count);
 
 
-    // Open a parser for the FASTA / FASTQ file containing the reference.
-    Ref_Parser parser(reference_input);
+    // Open a parser for the FASTA / FASTQ file containing the reference, parsing the sequences ahead in the background;
+    // the sequences are replayed from the reference cache instead, if one has been filled in the classification pass.
+    Ref_Parser parser(reference_input, true, ref_parser_thread_count(), ref_cache.get());
 
     // Track the maximum sequence buffer size used and the total length of the references.
     size_t max_buf_sz = 0;
@@ -190,10 +223,10 @@ void CdBG<k>::output_maximal_unitigs_gfa()
             continue;
 
 
-        // Initialize the output loggers.
-        // Note: `spdlog` appends to the output file by default, so the results are accumulated into the
-        // same output file; thus repeated initializations do not result in clearing out the output file.
-        init_output_loggers();
+        // Open the output writer.
+        // Note: the writer appends to the output file, so the results are accumulated into the same
+        // output file; thus repeated openings do not result in clearing out the output file.
+        open_output_writer();
 
         // Reset the path output streams for each thread.
         reset_path_loggers();
@@ -215,7 +248,7 @@ void CdBG<k>::output_maximal_unitigs_gfa()
 
         // Force flush all the in-memory logs (segments, connections, and broken paths), as the GFA path to be
         // appended to the same output sink file is written using a different mechanism (copy with `rdbuf()`)
-        // than using the `spdlog` logger.
+        // than using the output writer.
         close_loggers();
 
         // Write the GFA path for this sequence.
@@ -233,8 +266,9 @@ void CdBG<k>::output_maximal_unitigs_gfa()
 
 
     // Flush the buffers.
-    init_output_loggers();
+    open_output_writer();
     flush_output_buffers();
+    close_output_writer();
 
     // Close `spdlog`.
     spdlog::drop_all();
@@ -244,6 +278,8 @@ void CdBG<k>::output_maximal_unitigs_gfa()
 
     // Close the parser.
     parser.close();
+    std::cout << "Time spent in " << (ref_cache != nullptr ? "replaying the reference cache: " : "parsing the references: ") << parser.parse_time() << " seconds;"
+                " time spent waiting on the parser: " << parser.wait_time() << " seconds.\n";
 
 
     std::chrono::high_resolution_clock::time_point t_end = std::chrono::high_resolution_clock::now();
@@ -255,7 +291,7 @@ void CdBG<k>::output_maximal_unitigs_gfa()
 
 
 template <uint16_t k>
-void CdBG<k>::distribute_output_gfa(const char* const seq, const size_t seq_len, Thread_Pool<k>& thread_pool)
+void CdBG<k>::distribute_output_gfa(const char* const seq, const size_t seq_len, Thread_Pool& thread_pool)
 {
     const uint16_t thread_count = params.thread_count();
     const size_t task_size = (seq_len - k + 1) / thread_count;
@@ -264,12 +300,17 @@ void CdBG<k>::distribute_output_gfa(const char* const seq, const size_t seq_len,
     size_t left_end = 0;
     size_t right_end;
 
+    // The GFA paths are stitched together from the consecutive partitions in order, so the partitions
+    // are fixed, and the buffers used are of the partitions rather than of the threads executing them.
     for(uint16_t task_id = 0; task_id < partition_count; ++task_id)
     {
         right_end = (task_id == partition_count - 1 ? seq_len - k : left_end + task_size - 1);
         
-        thread_pool.get_thread(task_id);
-        thread_pool.assign_output_task(task_id, seq, seq_len, left_end, right_end);
+        thread_pool.submit(
+            [this, seq, seq_len, task_id, left_end, right_end](uint16_t)
+            {
+                output_gfa_off_substring(task_id, seq, seq_len, left_end, right_end);
+            });
 
         left_end += task_size;
     }
@@ -283,13 +324,13 @@ void CdBG<k>::output_maximal_unitigs_gfa_reduced()
 
 
     const Seq_Input& reference_input = params.sequence_input();
-    const uint16_t thread_count = params.thread_count();
+    const uint16_t thread_count = worker_thread_count(); // The threads left from the parser.
     const std::string& working_dir_path = params.working_dir_path();
 
 
-    // Clear the output file and initilize the output loggers.
+    // Clear the output file and open the output writer.
     clear_output_file();
-    init_output_loggers();
+    open_output_writer();
 
     // Set the prefixes of the temporary path output files. This is to avoid possible name
     // conflicts in the file system.
@@ -302,7 +343,7 @@ void CdBG<k>::output_maximal_unitigs_gfa_reduced()
 
 
     // Construct a thread pool.
-    Thread_Pool<k> thread_pool(thread_count, this, Thread_Pool<k>::Task_Type::output_gfa_reduced);
+    Thread_Pool thread_pool(thread_count);
 
     // Dedicated thread and job-queue to concatenate thread-specific tilings.
     std::unique_ptr<std::thread> concatenator{nullptr};
@@ -317,8 +358,9 @@ void CdBG<k>::output_maximal_unitigs_gfa_reduced()
     );
 
 
-    // Open a parser for the FASTA / FASTQ file containing the reference.
-    Ref_Parser parser(reference_input);
+    // Open a parser for the FASTA / FASTQ file containing the reference, parsing the sequences ahead in the background;
+    // the sequences are replayed from the reference cache instead, if one has been filled in the classification pass.
+    Ref_Parser parser(reference_input, true, ref_parser_thread_count(), ref_cache.get());
 
     // Track the maximum sequence buffer size used and the total length of the references.
     size_t max_buf_sz = 0;
@@ -400,14 +442,17 @@ void CdBG<k>::output_maximal_unitigs_gfa_reduced()
     concatenator->join();
 
 
-    // Flush the buffers.
+    // Flush the buffers, and close the output writer.
     flush_output_buffers();
+    close_output_writer();
 
     // Close `spdlog`.
     spdlog::drop_all();
 
     // Close the parser.
     parser.close();
+    std::cout << "Time spent in " << (ref_cache != nullptr ? "replaying the reference cache: " : "parsing the references: ") << parser.parse_time() << " seconds;"
+                " time spent waiting on the parser: " << parser.wait_time() << " seconds.\n";
 
 
     std::chrono::high_resolution_clock::time_point t_end = std::chrono::high_resolution_clock::now();
@@ -435,39 +480,22 @@ void CdBG<k>::clear_output_file() const
 
 
 template <uint16_t k>
-void CdBG<k>::init_output_loggers()
+void CdBG<k>::open_output_writer()
 {
     const cuttlefish::Output_Format gfa_v = params.output_format();
     const std::string& output_file_path = (gfa_v == cuttlefish::Output_Format::gfa_reduced ?
                                             params.segment_file_path() : params.output_file_path());
-    const uint16_t thread_count = params.thread_count();
 
+    // The threads put their buffers to the writer concurrently, each into its own range of the
+    // output; so the output step is not bottlenecked at a single (`spdlog`) background thread.
+    output.open(output_file_path, params.direct_io());
+}
 
-    // Initialize the global thread-pool of `spdlog` with restricting its default queue size from 8192 to
-    // a suitable one for us. This is required to restrict the memory-usage during the output step, as
-    // `spdlog` can continue on accumulating logs (each of max length `BUFFER_THRESHOLD`), i.e. `spdlog`
-    // itself can take up memory up-to (`BUFFER_THRESHOLD x #pending_log_message`), besides our own buffer
-    // memory of (`BUFFER_CAPACITY x #output_threads`).
-    
-    // NB: Possibly, `spdlog::shutdown()` resets the global `spdlog` thread pool — so if using the global
-    // thread pool, the following initializer needs to be invoked repeatedly after each shutdown.
-    // In the current GFA (and -reduced) scheme, the segments and edges logger and the thread-specific
-    // path loggers use separate thread pool instances, so we do not drop (and initialize) the global one.
-    // The global pool was used in an earlier implementation.
-    // spdlog::init_thread_pool(ASYNC_LOG_QUEUE_SZ, ASYNC_LOG_N_THREADS);
-
-    // Instantiate a `spdlog` thread pool for outputting unitigs (segments) and links / edges (for GFA).
-    tp_output = std::make_shared<spdlog::details::thread_pool>(ASYNC_LOG_QUEUE_SZ, ASYNC_LOG_N_THREADS);
-
-    // Open an asynchronous logger to write into the output file, and set its log message pattern.
-    // output = spdlog::basic_logger_mt<spdlog::async_factory>("async_output_logger", output_file_path);
-    auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(output_file_path);
-    output = std::make_shared<spdlog::async_logger>("async_output_logger", sink, tp_output, spdlog::async_overflow_policy::block);
-    output->set_pattern("%v");
-
-    output_.resize(thread_count);
-    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
-        output_[t_id] = output;
+
+template <uint16_t k>
+void CdBG<k>::close_output_writer()
+{
+    output.close();
 }
 
 
@@ -555,10 +583,10 @@ bool CdBG<k>::is_unipath_end(const cuttlefish::State_Class state_class, const cu
 
 
 template <uint16_t k>
-void CdBG<k>::ensure_buffer_space(std::string& buf, const size_t log_len, const logger_t& log)
+void CdBG<k>::ensure_buffer_space(std::string& buf, const size_t log_len, Parallel_Writer& sink)
 {
     if(buf.size() + log_len >= BUFFER_CAPACITY - 1)
-        flush_buffer(buf, log);
+        flush_buffer(buf, sink);
 }
 
 
@@ -571,6 +599,15 @@ void CdBG<k>::flush_buffer(std::string& str, const logger_t& log)
 }
 
 
+template <uint16_t k>
+void CdBG<k>::flush_buffer(std::string& str, Parallel_Writer& sink)
+{
+    sink.write(str.data(), str.size());
+
+    str.clear();
+}
+
+
 template <uint16_t k>
 void CdBG<k>::write(const std::string& str, const logger_t& log)
 {
@@ -582,7 +619,7 @@ template <uint16_t k>
 void CdBG<k>::check_output_buffer(const uint16_t thread_id)
 {
     if(output_buffer[thread_id].size() >= BUFFER_THRESHOLD)
-        flush_buffer(output_buffer[thread_id], output_[thread_id]);
+        flush_buffer(output_buffer[thread_id], output);
 }
 
 
@@ -593,22 +630,23 @@ void CdBG<k>::flush_output_buffers()
 
     for (uint16_t t_id = 0; t_id < thread_count; ++t_id)
         if(!output_buffer[t_id].empty())
-            flush_buffer(output_buffer[t_id], output_[t_id]);
+            flush_buffer(output_buffer[t_id], output);
 }
 
 
 template <uint16_t k>
 void CdBG<k>::close_loggers()
 {
-    flush_loggers();
+    flush_path_loggers();
 
     // Note: If using an async logger, `logger->flush()` posts a message to the queue requesting the flush
     // operation, so the function returns immediately. Hence a forceful eviction is necessary by shutdown.
     spdlog::shutdown();
 
     // Drop the `spdlog` thread pools. Required as `shutdown()` force-flushes messages from the global pool only.
-    tp_output.reset();
     tp_path.reset();
+
+    close_output_writer();
 }
 
 
@@ -628,22 +666,6 @@ void CdBG<k>::close_path_loggers()
 }
 
 
-template <uint16_t k>
-void CdBG<k>::flush_loggers()
-{
-    flush_output_logger();
-
-    flush_path_loggers();
-}
-
-
-template <uint16_t k>
-void CdBG<k>::flush_output_logger()
-{
-    output->flush();
-}
-
-
 template<uint16_t k>
 void CdBG<k>::flush_path_loggers()
 {
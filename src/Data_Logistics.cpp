@@ -2,10 +2,45 @@
 #include "Data_Logistics.hpp"
 #include "utility.hpp"
 
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+
+namespace
+{
+    // Path prefixes of the in-memory databases of this execution.
+    std::vector<std::string> in_memory_db_paths;
+
+    // Removes the in-memory databases left over at the exit of the execution, e.g.
+    // at an abort; as these would otherwise hold on to the memory.
+    void remove_in_memory_dbs()
+    {
+        for(const auto& db_path : in_memory_db_paths)
+        {
+            std::remove((db_path + ".kmc_pre").c_str());
+            std::remove((db_path + ".kmc_suf").c_str());
+        }
+    }
+}
+
 
 Data_Logistics::Data_Logistics(const Build_Params& build_params):
-    params(build_params)
-{}
+    params(build_params),
+    run_id(std::to_string(getpid()))
+{
+    if(!in_memory_edge_db() && !in_memory_vertex_db())
+        return;
+
+    if(in_memory_db_paths.empty())
+        std::atexit(remove_in_memory_dbs);
+
+    if(in_memory_edge_db())
+        in_memory_db_paths.push_back(edge_db_path());
+
+    if(in_memory_vertex_db())
+        in_memory_db_paths.push_back(vertex_db_path());
+}
 
 
 const std::vector<std::string> Data_Logistics::input_paths_collection() const
@@ -20,6 +55,35 @@ const std::string Data_Logistics::working_dir_path() const
 }
 
 
+const std::string Data_Logistics::temp_file_prefix() const
+{
+    return params.working_dir_path() + filename(params.output_prefix()) + "." + run_id + ".";
+}
+
+
+bool Data_Logistics::in_memory_edge_db() const
+{
+#ifdef CF_DEVELOP_MODE
+    if(!params.edge_db_path().empty())
+        return false;
+#endif
+
+    return params.in_memory_dbs();
+}
+
+
+bool Data_Logistics::in_memory_vertex_db() const
+{
+#ifdef CF_DEVELOP_MODE
+    if(!params.vertex_db_path().empty())
+        return false;
+#endif
+
+    // A saved vertex set outlives the execution, and hence is not kept in memory.
+    return params.in_memory_dbs() && !params.save_vertices();
+}
+
+
 const std::string Data_Logistics::edge_db_path() const
 {
 #ifdef CF_DEVELOP_MODE
@@ -27,7 +91,10 @@ const std::string Data_Logistics::edge_db_path() const
         return params.edge_db_path();
 #endif
 
-    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::edges_ext;
+    // The in-memory databases are in a directory shared system-wide, and hence are named uniquely per execution.
+    return in_memory_edge_db() ?
+            cuttlefish::_default::IN_MEMORY_DIR + filename(params.output_prefix()) + "." + run_id + cuttlefish::file_ext::edges_ext :
+            params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::edges_ext;
 }
 
 
@@ -38,7 +105,16 @@ const std::string Data_Logistics::vertex_db_path() const
         return params.vertex_db_path();
 #endif
 
-    return params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::vertices_ext;
+    return in_memory_vertex_db() ?
+            cuttlefish::_default::IN_MEMORY_DIR + filename(params.output_prefix()) + "." + run_id + cuttlefish::file_ext::vertices_ext :
+            params.working_dir_path() + filename(params.output_prefix()) + cuttlefish::file_ext::vertices_ext;
+}
+
+
+const std::string Data_Logistics::ref_cache_path() const
+{
+    // The cache is a temporary spill of the execution, and hence is named uniquely per execution, as the other temporary files.
+    return params.working_dir_path() + filename(params.output_prefix()) + "." + run_id + cuttlefish::file_ext::ref_cache_ext;
 }
 
 
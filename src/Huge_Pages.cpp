@@ -0,0 +1,144 @@
+
+#include "Huge_Pages.hpp"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cinttypes>
+#include <new>
+#include <string>
+#include <fstream>
+#include <sys/mman.h>
+
+
+constexpr std::size_t Huge_Pages::page_size;
+constexpr std::size_t Huge_Pages::min_bytes;
+std::atomic<bool> Huge_Pages::explicit_enabled(false);
+
+
+void Huge_Pages::enable_explicit(const bool enable)
+{
+    explicit_enabled = enable;
+}
+
+
+std::size_t Huge_Pages::round_up(const std::size_t bytes)
+{
+    return (bytes + page_size - 1) / page_size * page_size;
+}
+
+
+void* Huge_Pages::map_explicit(const std::size_t bytes)
+{
+#ifdef MAP_HUGETLB
+    void* const ptr = mmap(nullptr, round_up(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return ptr != MAP_FAILED ? ptr : nullptr;
+#else
+    (void)bytes;
+    return nullptr;
+#endif
+}
+
+
+void* Huge_Pages::map_transparent(const std::size_t bytes)
+{
+    // Over-map by a huge page and trim the ends, so that the region is aligned
+    // to the huge page size—the kernel can then back all of it with huge pages.
+    const std::size_t len = round_up(bytes);
+    char* const raw = static_cast<char*>(mmap(nullptr, len + page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if(raw == MAP_FAILED)
+        return nullptr;
+
+    char* const ptr = raw + (page_size - reinterpret_cast<std::uintptr_t>(raw) % page_size) % page_size;
+    if(ptr > raw)
+        munmap(raw, ptr - raw);
+    if(ptr + len < raw + len + page_size)
+        munmap(ptr + len, (raw + len + page_size) - (ptr + len));
+
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, len, MADV_HUGEPAGE);   // Falls back to regular pages if THP is unavailable.
+#endif
+
+    return ptr;
+}
+
+
+void* Huge_Pages::allocate(const std::size_t bytes)
+{
+    void* ptr = nullptr;
+    if(bytes < min_bytes)
+        ptr = std::calloc(bytes > 0 ? bytes : 1, 1);
+    else
+    {
+        if(explicit_enabled)
+            ptr = map_explicit(bytes);
+
+        if(ptr == nullptr)
+            ptr = map_transparent(bytes);
+    }
+
+    if(ptr == nullptr)
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+
+void Huge_Pages::deallocate(void* const ptr, const std::size_t bytes)
+{
+    if(ptr == nullptr)
+        return;
+
+    if(bytes < min_bytes)
+        std::free(ptr);
+    else
+        munmap(ptr, round_up(bytes));
+}
+
+
+Page_Backing Huge_Pages::backing(const void* const ptr)
+{
+    const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(ptr);
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool in_region = false; // Whether the lines being read describe the region containing `addr`.
+
+    while(std::getline(smaps, line))
+    {
+        std::uintptr_t beg, end;
+        char perms[5];
+        if(std::sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR " %4s", &beg, &end, perms) == 3)   // Header of a region.
+        {
+            if(in_region)
+                break;
+
+            in_region = (beg <= addr && addr < end);
+        }
+        else if(in_region)
+        {
+            std::size_t kb;
+            if(std::sscanf(line.c_str(), "KernelPageSize: %zu kB", &kb) == 1 && kb * 1024 >= page_size)
+                return Page_Backing::explicit_huge;
+
+            if(std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1 && kb > 0)
+                return Page_Backing::transparent_huge;
+        }
+    }
+
+    return Page_Backing::regular;
+}
+
+
+const char* Huge_Pages::to_string(const Page_Backing backing)
+{
+    switch(backing)
+    {
+    case Page_Backing::transparent_huge:
+        return "transparent huge pages";
+
+    case Page_Backing::explicit_huge:
+        return "explicit huge pages";
+
+    default:
+        return "regular pages";
+    }
+}
@@ -0,0 +1,124 @@
+
+#include "Kmer_DB_Writer.hpp"
+#include "globals.hpp"
+
+#include <iostream>
+#include <cstdlib>
+
+
+template <uint16_t k>
+Kmer_DB_Writer<k>::Kmer_DB_Writer(const std::string& db_path, const uint64_t kmer_count_estimate):
+    db_path(db_path),
+    lut_prefix_len(lut_prefix_length(kmer_count_estimate)),
+    suff_size((k - lut_prefix_len) / 4),
+    prefix_count(static_cast<std::size_t>(1) << (2 * lut_prefix_len), 0),
+    kmer_count_(0)
+{
+    const std::string suff_file_path(db_path + ".kmc_suf");
+    suff_file.open(suff_file_path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if(suff_file.fail())
+    {
+        std::cerr << "Error opening file " << suff_file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    suff_file.write("KMCS", 4);
+}
+
+
+template <uint16_t k>
+uint16_t Kmer_DB_Writer<k>::lut_prefix_length(const uint64_t kmer_count_estimate)
+{
+    // The suffixes need to be byte-aligned, so the prefix length is congruent to k modulo 4.
+    // It is grown while the LUT is expected to stay sparse relative to the k-mers.
+    uint16_t len = (k % 4 != 0 || k < 4 ? k % 4 : 4);
+    while(len + 4 <= max_lut_prefix_len && len + 4 < k && (static_cast<uint64_t>(1) << (2 * (len + 4))) <= kmer_count_estimate / 4)
+        len += 4;
+
+    return len;
+}
+
+
+template <uint16_t k>
+void Kmer_DB_Writer<k>::encode(const Kmer<k>* const kmers, const std::size_t n, std::vector<uint8_t>& suff_buf, std::vector<std::pair<uint64_t, uint64_t>>& pref_runs) const
+{
+    suff_buf.resize(n * suff_size);
+    pref_runs.clear();
+
+    uint64_t prefix;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        kmers[i].to_KMC_data(lut_prefix_len, prefix, suff_buf.data() + i * suff_size);
+
+        if(pref_runs.empty() || pref_runs.back().first != prefix)
+            pref_runs.emplace_back(prefix, 0);
+
+        pref_runs.back().second++;
+    }
+}
+
+
+template <uint16_t k>
+void Kmer_DB_Writer<k>::append(const std::vector<uint8_t>& suff_buf, const std::vector<std::pair<uint64_t, uint64_t>>& pref_runs)
+{
+    suff_file.write(reinterpret_cast<const char*>(suff_buf.data()), suff_buf.size());
+
+    for(const auto& run : pref_runs)
+    {
+        prefix_count[run.first] += run.second;
+        kmer_count_ += run.second;
+    }
+}
+
+
+template <uint16_t k>
+void Kmer_DB_Writer<k>::close()
+{
+    suff_file.write("KMCS", 4);
+    suff_file.close();
+    if(suff_file.fail())
+    {
+        std::cerr << "Error writing to file " << db_path << ".kmc_suf. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    const std::string pref_file_path(db_path + ".kmc_pre");
+    std::ofstream pref_file(pref_file_path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    pref_file.write("KMCP", 4);
+
+    // The LUT: the number of k-mers preceding each prefix, followed by a guard.
+    std::vector<uint64_t> lut(prefix_count.size() + 1);
+    lut[0] = 0;
+    for(std::size_t p = 0; p < prefix_count.size(); ++p)
+        lut[p + 1] = lut[p] + prefix_count[p];
+
+    pref_file.write(reinterpret_cast<const char*>(lut.data()), lut.size() * sizeof(uint64_t));
+
+    // The signature map, for a single bin.
+    const std::vector<uint32_t> signature_map((static_cast<std::size_t>(1) << (2 * signature_len)) + 1, 0);
+    pref_file.write(reinterpret_cast<const char*>(signature_map.data()), signature_map.size() * sizeof(uint32_t));
+
+    // The header.
+    const uint32_t header[] = {k, 0 /* mode */, 0 /* counter size */, lut_prefix_len, signature_len, 1 /* min count */, 1 /* max count */};
+    const uint8_t padding[28] = {0};    // The "single-strand" flag, unset, and reserved bytes.
+    constexpr uint32_t header_offset = sizeof(header) + sizeof(kmer_count_) + sizeof(padding) + sizeof(kmc_version);
+    pref_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    pref_file.write(reinterpret_cast<const char*>(&kmer_count_), sizeof(kmer_count_));
+    pref_file.write(reinterpret_cast<const char*>(padding), sizeof(padding));
+    pref_file.write(reinterpret_cast<const char*>(&kmc_version), sizeof(kmc_version));
+    pref_file.write(reinterpret_cast<const char*>(&header_offset), sizeof(header_offset));
+
+    pref_file.write("KMCP", 4);
+    pref_file.close();
+    if(pref_file.fail())
+    {
+        std::cerr << "Error writing to file " << pref_file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE_ALL, Kmer_DB_Writer)
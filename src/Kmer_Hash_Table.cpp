@@ -8,77 +8,83 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <limits>
 
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY> constexpr double Kmer_Hash_Table<k, BITS_PER_KEY>::gamma_min;
-template <uint16_t k, uint8_t BITS_PER_KEY> constexpr double Kmer_Hash_Table<k, BITS_PER_KEY>::gamma_max;
-template <uint16_t k, uint8_t BITS_PER_KEY> constexpr double Kmer_Hash_Table<k, BITS_PER_KEY>::min_bits_per_hash_key;
-template <uint16_t k, uint8_t BITS_PER_KEY> constexpr double Kmer_Hash_Table<k, BITS_PER_KEY>::bits_per_gamma[];
-template <uint16_t k, uint8_t BITS_PER_KEY> constexpr double Kmer_Hash_Table<k, BITS_PER_KEY>::gamma_resolution;
-
-
-template <uint16_t k, uint8_t BITS_PER_KEY>
-Kmer_Hash_Table<k, BITS_PER_KEY>::Kmer_Hash_Table(const std::string& kmc_db_path): Kmer_Hash_Table(kmc_db_path, Kmer_Container<k>::size(kmc_db_path))
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::Kmer_Hash_Table(const std::string& kmc_db_path): Kmer_Hash_Table(kmc_db_path, Kmer_Container<k>::size(kmc_db_path))
 {}
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-Kmer_Hash_Table<k, BITS_PER_KEY>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count):
-    gamma(gamma_min),
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count):
+    gamma(mphf_t::gamma_min),
     kmc_db_path(kmc_db_path),
     kmer_count(kmer_count),
-    hash_table(kmer_count),
-    sparse_lock(kmer_count, lock_count)
+    hash_table(kmer_count)
 {}
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-Kmer_Hash_Table<k, BITS_PER_KEY>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count, const std::size_t max_memory): Kmer_Hash_Table(kmc_db_path, kmer_count)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count, const std::size_t max_memory): Kmer_Hash_Table(kmc_db_path, kmer_count)
 {
+    memory_budget = max_memory;
     set_gamma(max_memory);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-Kmer_Hash_Table<k, BITS_PER_KEY>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count, const std::size_t max_memory, const double gamma):
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::Kmer_Hash_Table(const std::string& kmc_db_path, const uint64_t kmer_count, const std::size_t max_memory, const double gamma):
     Kmer_Hash_Table(kmc_db_path, kmer_count)
 {
+    memory_budget = max_memory;
+
     if(gamma > 0)
-        this->gamma = std::min(std::max(gamma, gamma_min), gamma_max);
+        this->gamma = std::min(std::max(gamma, mphf_t::gamma_min), mphf_t::gamma_max);
     else
         set_gamma(max_memory);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::set_gamma(const std::size_t max_memory)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::set_gamma(const std::size_t max_memory)
 {
+    gamma_fit = true;
+
     const std::size_t max_memory_bits = max_memory * 8U;
-    const std::size_t min_memory_bits = static_cast<std::size_t>(kmer_count * (min_bits_per_hash_key + BITS_PER_KEY));
+    const std::size_t min_memory_bits = static_cast<std::size_t>(kmer_count * (mphf_t::bits_per_key(mphf_t::gamma_min) + bitvector_t::bits_per_entry()));
     if(max_memory_bits > min_memory_bits)
     {
-        const double max_bits_per_hash_key = (static_cast<double>(max_memory_bits) / kmer_count) - BITS_PER_KEY;
-        const std::size_t gamma_idx = (std::upper_bound(bits_per_gamma, bits_per_gamma + (sizeof(bits_per_gamma) / sizeof(*bits_per_gamma)), max_bits_per_hash_key) - 1) - bits_per_gamma;
-        gamma = gamma_idx * gamma_resolution;
+        const double max_bits_per_hash_key = (static_cast<double>(max_memory_bits) / kmer_count) - bitvector_t::bits_per_entry();
+        gamma = std::min(mphf_t::gamma(max_bits_per_hash_key), mphf_t::gamma_max);
     }
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::build_mph_function(const uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+bool Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::exceeds_memory() const
+{
+    return memory_budget > 0 && mph->bit_size() + kmer_count * bitvector_t::bits_per_entry() > memory_budget * 8U;
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::build_mph_function(const uint16_t thread_count, const std::string& working_dir_path, const std::string& temp_file_prefix, const std::string& mph_file_path, const bool populate, const uint64_t partition_count)
 {
-    // The serialized BBHash file (saved from some earlier execution) exists.
+    // The serialized MPHF file (saved from some earlier execution) exists.
     if(!mph_file_path.empty() && file_exists(mph_file_path))
     {
         std::cout << "Found the MPHF at file " << mph_file_path << ".\n";
         std::cout << "Loading the MPHF.\n";
 
-        load_mph_function(mph_file_path);
+        load_mph_function(mph_file_path, populate);
 
         std::cout << "Loaded the MPHF into memory.\n";
+        if(mph->partition_count() > 1)
+            std::cout << "The MPHF has " << mph->partition_count() << " partitions.\n";
     }
-    else    // No BBHash file name provided, or does not exist. Build one now.
+    else    // No MPHF file name provided, or does not exist. Build one now.
     {
         // Open a container over the k-mer database.
         const Kmer_Container<k> kmer_container(kmc_db_path);
@@ -86,107 +92,101 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::build_mph_function(const uint16_t thread_
         // Build the MPHF.
         std::cout << "Building the MPHF from the k-mer database " << kmer_container.container_location() << ".\n";
 
-        // auto data_iterator = boomphf::range(kmer_container.buf_begin(), kmer_container.buf_end());
-        const auto data_iterator = boomphf::range(kmer_container.spmc_begin(thread_count), kmer_container.spmc_end(thread_count));
         std::cout << "Using gamma = " << gamma << ".\n";
-        mph = new mphf_t(kmer_count, data_iterator, working_dir_path, thread_count, gamma);
+        if(partition_count > 1)
+            std::cout << "Partitioning the k-mers into " << partition_count << " parts.\n";
+
+        // The buckets are allocated after the MPHF is built, so the build may use the memory budget
+        // excluding the MPHF itself.
+        const std::size_t mph_memory = static_cast<std::size_t>(kmer_count * mphf_t::bits_per_key(gamma) / 8);
+        const std::size_t build_memory = (memory_budget == 0 ? std::numeric_limits<std::size_t>::max() :
+                                            memory_budget > mph_memory ? memory_budget - mph_memory : 0);
+
+        mph = new mphf_t(partition_count, build_memory, temp_file_prefix);
+        mph->build(kmer_container, thread_count, working_dir_path, gamma);
+
+        // The gamma-value is set from an estimate of the bits-per-key of the MPHF, which the built
+        // function may exceed (e.g. for PTHash, its pilot widths are only known after the build);
+        // hence it is rebuilt with smaller gamma-values while it breaks the memory budget.
+        while(gamma_fit && exceeds_memory() && gamma > mphf_t::gamma_min)
+        {
+            gamma = std::max(gamma - mphf_t::gamma_resolution, mphf_t::gamma_min);
+            std::cout << "The MPHF exceeds the memory limit. Rebuilding it with gamma = " << gamma << ".\n";
+
+            delete mph;
+            mph = new mphf_t(partition_count, build_memory, temp_file_prefix);
+            mph->build(kmer_container, thread_count, working_dir_path, gamma);
+        }
+
+        if(gamma_fit && exceeds_memory())
+            std::cout << "WARNING: the MPHF exceeds the memory limit even with the minimum gamma = " << gamma << ".\n";
 
         std::cout << "Built the MPHF in memory.\n";
-
-        // std::cout << "Total data copy time to BBHash buffers " << mph->data_copy_time << "\n\n";
     }
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::load_mph_function(const std::string& file_path)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::load_mph_function(const std::string& file_path, const bool populate)
 {
-    std::ifstream input(file_path.c_str(), std::ifstream::in);
-    if(input.fail())
-    {
-        std::cerr << "Error opening file " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
-
     mph = new mphf_t();
-    mph->load(input);
-
-    input.close();
+    mph->load(file_path, populate);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::save_mph_function(const std::string& file_path) const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::save_mph_function(const std::string& file_path) const
 {
-    std::ofstream output(file_path.c_str(), std::ofstream::out);
-    if(output.fail())
-    {
-        std::cerr << "Error writing to file " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
-
-    mph->save(output);
-    
-    output.close();
+    mph->save(file_path);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::save_hash_buckets(const std::string& file_path) const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::save_hash_buckets(const std::string& file_path) const
 {
-    std::ofstream output(file_path.c_str(), std::ofstream::out);
+    std::ofstream output(file_path.c_str(), std::ofstream::out | std::ofstream::binary);
     if(output.fail())
     {
         std::cerr << "Error writing to file " << file_path << ". Aborting.\n";
         std::exit(EXIT_FAILURE);
     }
 
-    hash_table.serialize(output);
+    hash_table.serialize(output, cuttlefish::HASH_TABLE_FORMAT_VERSION);
     
     output.close();
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::load_hash_buckets(const std::string& file_path)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::load_hash_buckets(const std::string& file_path, const bool populate)
 {
-    std::ifstream input(file_path.c_str(), std::ifstream::in);
-    if(input.fail())
-    {
-        std::cerr << "Error opening file " << file_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
-
-    input.close();
-
-
-    hash_table.deserialize(file_path);
+    hash_table.deserialize(file_path, cuttlefish::HASH_TABLE_FORMAT_VERSION, populate);
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::save(const Build_Params& params) const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::save(const Build_Params& params) const
 {
     save_mph_function(params.mph_file_path());
     save_hash_buckets(params.buckets_file_path());
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::load(const Build_Params& params)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::load(const Build_Params& params)
 {
-    load_mph_function(params.mph_file_path());
-    load_hash_buckets(params.buckets_file_path());
+    load_mph_function(params.mph_file_path(), params.populate_loads());
+    load_hash_buckets(params.buckets_file_path(), params.populate_loads());
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::remove(const Build_Params& params) const
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::remove(const Build_Params& params) const
 {
     const std::string mph_file_path = params.mph_file_path();
     const std::string buckets_file_path = params.buckets_file_path();
 
-    if( (file_exists(mph_file_path) && std::remove(mph_file_path.c_str()) != 0) ||
+    if( !mphf_t::remove(mph_file_path) ||
         (file_exists(buckets_file_path) && std::remove(buckets_file_path.c_str()) != 0))
     {
         std::cerr << "Error removing the hash table files from disk. Aborting.\n";
@@ -195,8 +195,8 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::remove(const Build_Params& params) const
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::construct(const uint16_t thread_count, const std::string& working_dir_path, const std::string& mph_file_path, const bool save_mph)
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::construct(const uint16_t thread_count, const std::string& working_dir_path, const std::string& temp_file_prefix, const std::string& mph_file_path, const bool save_mph, const bool populate, const uint64_t partition_count)
 {
     // std::chrono::high_resolution_clock::time_point t_start = std::chrono::high_resolution_clock::now();
 
@@ -205,7 +205,7 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::construct(const uint16_t thread_count, co
 
 
     // Build the minimal perfect hash function.
-    build_mph_function(thread_count, working_dir_path, mph_file_path);
+    build_mph_function(thread_count, working_dir_path, temp_file_prefix, mph_file_path, populate, partition_count);
 
     if(save_mph)
     {
@@ -213,7 +213,7 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::construct(const uint16_t thread_count, co
         std::cout << "Saved the hash function at " << mph_file_path << "\n";
     }
 
-    const uint64_t total_bits = mph->totalBitSize();
+    const uint64_t total_bits = mph->bit_size();
     std::cout <<    "\nTotal MPHF size: " << total_bits / (8 * 1024 * 1024) << " MB."
                     " Bits per k-mer: " << static_cast<double>(total_bits) / kmer_count << ".\n";
 
@@ -233,22 +233,35 @@ void Kmer_Hash_Table<k, BITS_PER_KEY>::construct(const uint16_t thread_count, co
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-void Kmer_Hash_Table<k, BITS_PER_KEY>::clear()
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+Page_Backing Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::bucket_backing() const
+{
+    return hash_table.backing();
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+Page_Backing Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::mphf_backing() const
+{
+    return mph != NULL ? mph->backing() : Page_Backing::regular;
+}
+
+
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+void Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::clear()
 {
     if(mph != NULL)
         delete mph;
 
     mph = NULL;
 
-    
-    // hash_table.clear();
-    hash_table.resize(0);
+
+    hash_table.clear();
 }
 
 
-template <uint16_t k, uint8_t BITS_PER_KEY>
-Kmer_Hash_Table<k, BITS_PER_KEY>::~Kmer_Hash_Table()
+template <uint16_t k, uint8_t BITS_PER_KEY, typename T_MPHF_>
+Kmer_Hash_Table<k, BITS_PER_KEY, T_MPHF_>::~Kmer_Hash_Table()
 {
     clear();
 }
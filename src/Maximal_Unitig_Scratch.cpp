@@ -3,7 +3,9 @@
 
 
 template <uint16_t k>
-Maximal_Unitig_Scratch<k>::Maximal_Unitig_Scratch()
+Maximal_Unitig_Scratch<k>::Maximal_Unitig_Scratch(Slab_Arena<char>& label_arena, Slab_Arena<uint64_t>& hash_arena):
+    unitig_back(label_arena, hash_arena),
+    unitig_front(label_arena, hash_arena)
 {}
 
 
@@ -0,0 +1,66 @@
+
+#include "Memory_Mapped_File.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+constexpr std::size_t Memory_Mapped_File::page_size;
+
+
+Memory_Mapped_File::Memory_Mapped_File(const std::string& file_path, const bool populate, const bool random_access):
+    addr(nullptr),
+    size_(0)
+{
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if(fd < 0 || fstat(fd, &file_stat) != 0)
+    {
+        std::cerr << "Error opening file " << file_path << ": " << std::strerror(errno) << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    size_ = file_stat.st_size;
+    if(size_ > 0)
+    {
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if(populate)
+            flags |= MAP_POPULATE;
+#endif
+
+        addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, flags, fd, 0);
+        if(addr == MAP_FAILED)
+        {
+            std::cerr << "Error memory-mapping file " << file_path << ": " << std::strerror(errno) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        if(!populate)
+            madvise(addr, size_, random_access ? MADV_RANDOM : MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+}
+
+
+Memory_Mapped_File::~Memory_Mapped_File()
+{
+    if(addr != nullptr)
+        munmap(addr, size_);
+}
+
+
+std::size_t Memory_Mapped_File::pad(std::ostream& output, const std::size_t offset)
+{
+    static const char zeros[page_size] = {};
+    const std::size_t padded_offset = page_align(offset);
+
+    output.write(zeros, padded_offset - offset);
+    return padded_offset;
+}
@@ -103,11 +103,11 @@ template <uint16_t k, uint8_t l>
 void Minimizer_Policy<k, l>::count_lmers(Kmer_SPMC_Iterator<k>& parser, const uint16_t thread_id, std::vector<uint64_t>& count, Spin_Lock& lock)
 {
     std::vector<uint64_t> local_count(NUM_LMERS);
-    Kmer<k> kmer;
+    Kmer<k> chunk[PARSE_CHUNK_SZ];
 
     while(parser.tasks_expected(thread_id))
-        if(parser.value_at(thread_id, kmer))
-            kmer.template count_lmers<l>(local_count);
+        for(std::size_t i = 0, chunk_size = parser.next_chunk(thread_id, chunk, PARSE_CHUNK_SZ); i < chunk_size; ++i)
+            chunk[i].template count_lmers<l>(local_count);
 
     lock.lock();
     std::transform(count.begin(), count.end(), local_count.begin(), count.begin(), std::plus<uint64_t>());
@@ -152,11 +152,11 @@ template <uint16_t k, uint8_t l>
 void Minimizer_Policy<k, l>::count_minimizers(Kmer_SPMC_Iterator<k>& parser, const uint16_t thread_id, std::vector<uint64_t>& count, Spin_Lock& lock)
 {
     std::vector<uint64_t> local_count(NUM_LMERS);
-    Kmer<k> kmer;
+    Kmer<k> chunk[PARSE_CHUNK_SZ];
 
     while(parser.tasks_expected(thread_id))
-        if(parser.value_at(thread_id, kmer))
-            local_count[kmer.template minimizer<l>(order)]++;
+        for(std::size_t i = 0, chunk_size = parser.next_chunk(thread_id, chunk, PARSE_CHUNK_SZ); i < chunk_size; ++i)
+            local_count[chunk[i].template minimizer<l>(order)]++;
 
     lock.lock();
     std::transform(count.begin(), count.end(), local_count.begin(), count.begin(), std::plus<uint64_t>());
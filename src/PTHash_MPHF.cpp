@@ -0,0 +1,425 @@
+
+#include "PTHash_MPHF.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "globals.hpp"
+
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+
+
+template <uint16_t k> constexpr uint64_t PTHash_MPHF<k>::partition_size;
+template <uint16_t k> constexpr double PTHash_MPHF<k>::alpha;
+template <uint16_t k> constexpr double PTHash_MPHF<k>::dense_key_fraction;
+template <uint16_t k> constexpr double PTHash_MPHF<k>::dense_bucket_fraction;
+template <uint16_t k> constexpr double PTHash_MPHF<k>::bits_per_gamma[];
+template <uint16_t k> constexpr uint64_t PTHash_MPHF<k>::max_seed_attempts;
+template <uint16_t k> constexpr double PTHash_MPHF<k>::gamma_min;
+template <uint16_t k> constexpr double PTHash_MPHF<k>::gamma_max;
+template <uint16_t k> constexpr double PTHash_MPHF<k>::gamma_resolution;
+
+
+template <uint16_t k>
+PTHash_MPHF<k>::PTHash_MPHF():
+    seed(0),
+    key_count(0),
+    partition_count(0),
+    pilot_words(0),
+    remap_size(0),
+    partition(nullptr),
+    pilot(nullptr),
+    remap(nullptr)
+{}
+
+
+template <uint16_t k>
+double PTHash_MPHF<k>::bits_per_key(const double gamma)
+{
+    const std::size_t gamma_idx = static_cast<std::size_t>(std::min(std::max(gamma, gamma_min), gamma_max));
+    return bits_per_gamma[gamma_idx];
+}
+
+
+template <uint16_t k>
+double PTHash_MPHF<k>::gamma(const double max_bits_per_key)
+{
+    const std::size_t gamma_idx = (std::upper_bound(bits_per_gamma, bits_per_gamma + (sizeof(bits_per_gamma) / sizeof(*bits_per_gamma)), max_bits_per_key) - 1) - bits_per_gamma;
+    return std::max(gamma_idx * gamma_resolution, gamma_min);
+}
+
+
+template <uint16_t k>
+void PTHash_MPHF<k>::build(const Kmer_Container<k>& kmer_container, const uint16_t thread_count, const std::string& working_dir_path, const double gamma)
+{
+    (void)working_dir_path;
+
+    key_count = kmer_container.size();
+    partition_count = std::max(static_cast<uint64_t>(1), (key_count + partition_size - 1) / partition_size);
+    partition_buf.resize(partition_count);
+
+    const uint64_t initial_seed = seed;
+    while(true)
+    {
+        // Collect the key-hashes, per partition, from each thread.
+        std::vector<std::vector<std::vector<uint64_t>>> hashes(thread_count, std::vector<std::vector<uint64_t>>(partition_count));
+        Kmer_SPMC_Iterator<k> parser(&kmer_container, thread_count);
+        std::vector<std::unique_ptr<std::thread>> T(thread_count);
+
+        parser.launch_production();
+
+        for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+            T[thread_id].reset(
+                new std::thread(&PTHash_MPHF::collect_hashes, this, std::ref(parser), thread_id, std::ref(hashes[thread_id]))
+            );
+
+        parser.seize_production();
+
+        for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+            T[thread_id]->join();
+
+
+        if(build_partitions(hashes, thread_count, gamma))
+            break;
+
+        reseed(initial_seed);
+    }
+}
+
+
+template <uint16_t k>
+void PTHash_MPHF<k>::build(const Kmer<k>* const kmers, const std::size_t n, const uint16_t thread_count, const std::string& working_dir_path, const double gamma)
+{
+    (void)working_dir_path;
+
+    key_count = n;
+    partition_count = std::max(static_cast<uint64_t>(1), (key_count + partition_size - 1) / partition_size);
+    partition_buf.resize(partition_count);
+
+    const uint64_t initial_seed = seed;
+    while(true)
+    {
+        std::vector<std::vector<std::vector<uint64_t>>> hashes(1, std::vector<std::vector<uint64_t>>(partition_count));
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            const uint64_t h = hash(kmers[i]);
+            hashes[0][partition_id(h)].push_back(h);
+        }
+
+        if(build_partitions(hashes, thread_count, gamma))
+            break;
+
+        reseed(initial_seed);
+    }
+}
+
+
+template <uint16_t k>
+void PTHash_MPHF<k>::reseed(const uint64_t initial_seed)
+{
+    if(++seed - initial_seed >= max_seed_attempts)
+    {
+        std::cerr << "Keys with identical hashes persisted over " << max_seed_attempts << " seeds of the MPHF. Likely some distinct"
+                     " k-mers have identical fingerprints, i.e. forward and reverse rolling hashes, which no seed can tell apart."
+                     " Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Found keys with identical hashes. Rebuilding the MPHF with a different seed.\n";
+}
+
+
+template <uint16_t k>
+void PTHash_MPHF<k>::collect_hashes(Kmer_SPMC_Iterator<k>& parser, const uint16_t thread_id, std::vector<std::vector<uint64_t>>& hashes) const
+{
+    Kmer<k> kmer;
+
+    while(parser.tasks_expected(thread_id))
+        if(parser.value_at(thread_id, kmer))
+        {
+            const uint64_t h = hash(kmer);
+            hashes[partition_id(h)].push_back(h);
+        }
+}
+
+
+template <uint16_t k>
+bool PTHash_MPHF<k>::build_partitions(std::vector<std::vector<std::vector<uint64_t>>>& hashes, const uint16_t thread_count, const double c)
+{
+    std::vector<std::vector<uint32_t>> pilots(partition_count); // Pilots of the buckets, per partition.
+    std::vector<std::vector<uint32_t>> remapped(partition_count);   // Remapped positions, per partition.
+    std::atomic<std::size_t> next_partition(0);
+    std::atomic<bool> success(true);
+
+    const auto build = [&]()
+    {
+        std::vector<uint64_t> partition_hashes;
+        std::size_t p_id;
+
+        while(success && (p_id = next_partition++) < partition_count)
+        {
+            partition_hashes.clear();
+            for(auto& thread_hashes : hashes)
+            {
+                partition_hashes.insert(partition_hashes.end(), thread_hashes[p_id].begin(), thread_hashes[p_id].end());
+                std::vector<uint64_t>().swap(thread_hashes[p_id]);
+            }
+
+            if(!build_partition(partition_hashes, c, partition_buf[p_id], pilots[p_id], remapped[p_id]))
+                success = false;
+        }
+    };
+
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id].reset(new std::thread(build));
+
+    for(uint16_t thread_id = 0; thread_id < thread_count; ++thread_id)
+        T[thread_id]->join();
+
+    if(!success)
+        return false;
+
+
+    // Lay out the partitions contiguously.
+    uint64_t offset = 0, pilot_bits = 0;
+    remap_size = 0;
+    for(std::size_t p_id = 0; p_id < partition_count; ++p_id)
+    {
+        Partition& p = partition_buf[p_id];
+        p.offset = offset;
+        p.pilot_offset = pilot_bits;
+        p.remap_offset = remap_size;
+
+        offset += p.key_count;
+        pilot_bits += static_cast<uint64_t>(p.bucket_count) * p.pilot_width;
+        remap_size += remapped[p_id].size();
+    }
+
+    pilot_words = (pilot_bits + 63) / 64 + 1;
+    pilot_buf.assign(pilot_words, 0);
+    remap_buf.clear();
+    remap_buf.reserve(remap_size);
+
+    for(std::size_t p_id = 0; p_id < partition_count; ++p_id)
+    {
+        const Partition& p = partition_buf[p_id];
+        for(uint64_t b = 0; b < p.bucket_count; ++b)
+        {
+            const uint64_t bit_idx = p.pilot_offset + b * p.pilot_width;
+            const uint64_t val = pilots[p_id][b];
+            const uint8_t shift = (bit_idx & 63);
+
+            pilot_buf[bit_idx >> 6] |= (val << shift);
+            if(shift + p.pilot_width > 64)
+                pilot_buf[(bit_idx >> 6) + 1] |= (val >> (64 - shift));
+        }
+
+        remap_buf.insert(remap_buf.end(), remapped[p_id].begin(), remapped[p_id].end());
+    }
+
+    partition = partition_buf.data();
+    pilot = pilot_buf.data();
+    remap = remap_buf.data();
+
+    return true;
+}
+
+
+template <uint16_t k>
+bool PTHash_MPHF<k>::build_partition(std::vector<uint64_t>& hashes, const double c, Partition& p, std::vector<uint32_t>& pilots, std::vector<uint32_t>& remapped)
+{
+    const uint64_t n = hashes.size();
+    p.key_count = n;
+    p.table_size = std::max(n, static_cast<uint64_t>(std::ceil(n / alpha)));
+    p.bucket_count = std::max(static_cast<uint64_t>(1), static_cast<uint64_t>(std::ceil(c * n / std::max(1.0, std::log2(n)))));
+    p.dense_bucket_count = std::min(p.bucket_count, std::max(static_cast<uint32_t>(1), static_cast<uint32_t>(std::ceil(dense_bucket_fraction * p.bucket_count))));
+
+
+    // Group the keys by their buckets.
+    std::vector<std::pair<uint32_t, uint64_t>> bucketed_key;
+    bucketed_key.reserve(n);
+    for(const uint64_t h : hashes)
+        bucketed_key.emplace_back(bucket_id(h, p), h);
+
+    std::vector<uint64_t>().swap(hashes);
+    std::sort(bucketed_key.begin(), bucketed_key.end());
+    if(std::adjacent_find(bucketed_key.begin(), bucketed_key.end()) != bucketed_key.end())
+        return false;
+
+    std::vector<uint64_t> bucket_start(p.bucket_count + 1, 0);  // Start-index of each bucket in `bucketed_key`.
+    for(const auto& key : bucketed_key)
+        bucket_start[key.first + 1]++;
+
+    uint32_t max_bucket_size = 0;
+    for(uint64_t b = 0; b < p.bucket_count; ++b)
+    {
+        max_bucket_size = std::max(max_bucket_size, static_cast<uint32_t>(bucket_start[b + 1]));
+        bucket_start[b + 1] += bucket_start[b];
+    }
+
+
+    // Order the buckets in non-increasing order of their sizes, with a counting sort.
+    std::vector<uint64_t> size_start(max_bucket_size + 2, 0);
+    for(uint64_t b = 0; b < p.bucket_count; ++b)
+        size_start[max_bucket_size - (bucket_start[b + 1] - bucket_start[b]) + 1]++;
+
+    for(uint32_t s = 0; s <= max_bucket_size; ++s)
+        size_start[s + 1] += size_start[s];
+
+    std::vector<uint32_t> bucket_order(p.bucket_count);
+    for(uint64_t b = 0; b < p.bucket_count; ++b)
+        bucket_order[size_start[max_bucket_size - (bucket_start[b + 1] - bucket_start[b])]++] = b;
+
+
+    // Search the pilots of the buckets, from the largest to the smallest.
+    pilots.assign(p.bucket_count, 0);
+    std::vector<uint64_t> taken((p.table_size + 63) / 64, 0);  // Bitvector of the occupied positions of the table.
+    std::vector<uint64_t> pos(max_bucket_size); // Positions of the keys of a bucket.
+    uint64_t max_pilot = 0;
+
+    for(const uint32_t b : bucket_order)
+    {
+        const uint64_t size = bucket_start[b + 1] - bucket_start[b];
+        if(size == 0)
+            break;
+
+        const auto* const key = bucket_start[b] + bucketed_key.data();
+        for(uint64_t pl = 0; ; ++pl)
+        {
+            if(pl > UINT32_MAX)
+                return false;
+
+            uint64_t i;
+            for(i = 0; i < size; ++i)
+            {
+                pos[i] = position(key[i].second, pl, p.table_size);
+                if(taken[pos[i] >> 6] & (1ULL << (pos[i] & 63)))
+                    break;
+
+                uint64_t j;
+                for(j = 0; j < i && pos[j] != pos[i]; ++j);
+                if(j < i)
+                    break;
+            }
+
+            if(i == size)
+            {
+                for(i = 0; i < size; ++i)
+                    taken[pos[i] >> 6] |= (1ULL << (pos[i] & 63));
+
+                pilots[b] = pl;
+                max_pilot = std::max(max_pilot, pl);
+                break;
+            }
+        }
+    }
+
+    p.pilot_width = 1;
+    while(p.pilot_width < 32 && (max_pilot >> p.pilot_width))
+        p.pilot_width++;
+
+
+    // Remap the keys at positions beyond `n` to the free positions in `[0, n)`.
+    remapped.assign(p.table_size - n, 0);
+    uint64_t free_pos = 0;
+    for(uint64_t q = n; q < p.table_size; ++q)
+        if(taken[q >> 6] & (1ULL << (q & 63)))
+        {
+            while(taken[free_pos >> 6] & (1ULL << (free_pos & 63)))
+                free_pos++;
+
+            remapped[q - n] = free_pos++;
+        }
+
+    return true;
+}
+
+
+template <uint16_t k>
+uint64_t PTHash_MPHF<k>::bit_size() const
+{
+    return 8 * (sizeof(*this) + partition_count * sizeof(Partition) + pilot_words * sizeof(uint64_t) + remap_size * sizeof(uint32_t));
+}
+
+
+template <uint16_t k>
+Page_Backing PTHash_MPHF<k>::backing() const
+{
+    return pilot_words > 0 ? Huge_Pages::backing(pilot) : Page_Backing::regular;
+}
+
+
+template <uint16_t k>
+void PTHash_MPHF<k>::save(std::ostream& output) const
+{
+    std::size_t offset = 0;
+    const auto write = [&](const void* const data, const std::size_t bytes)
+    {
+        output.write(static_cast<const char*>(data), bytes);
+        offset += bytes;
+    };
+
+    write(&seed, sizeof(seed));
+    write(&key_count, sizeof(key_count));
+    write(&partition_count, sizeof(partition_count));
+    write(&pilot_words, sizeof(pilot_words));
+    write(&remap_size, sizeof(remap_size));
+
+    offset = Memory_Mapped_File::pad(output, offset);
+    write(partition, partition_count * sizeof(Partition));
+    offset = Memory_Mapped_File::pad(output, offset);
+    write(pilot, pilot_words * sizeof(uint64_t));
+    offset = Memory_Mapped_File::pad(output, offset);
+    write(remap, remap_size * sizeof(uint32_t));
+
+    if(output.fail())
+    {
+        std::cerr << "Error writing the MPHF. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+template <uint16_t k>
+void PTHash_MPHF<k>::load(const std::string& file_path, const bool populate)
+{
+    mapping.reset(new Memory_Mapped_File(file_path, populate));
+    const char* const data = mapping->data();
+    std::size_t offset = 0;
+    const auto read = [&](void* const field, const std::size_t bytes)
+    {
+        if(offset + bytes <= mapping->size())
+            std::memcpy(field, data + offset, bytes);
+
+        offset += bytes;
+    };
+
+    read(&seed, sizeof(seed));
+    read(&key_count, sizeof(key_count));
+    read(&partition_count, sizeof(partition_count));
+    read(&pilot_words, sizeof(pilot_words));
+    read(&remap_size, sizeof(remap_size));
+
+    const std::size_t partition_offset = Memory_Mapped_File::page_align(offset);
+    const std::size_t pilot_offset = Memory_Mapped_File::page_align(partition_offset + partition_count * sizeof(Partition));
+    const std::size_t remap_offset = Memory_Mapped_File::page_align(pilot_offset + pilot_words * sizeof(uint64_t));
+    if(offset > mapping->size() || remap_offset + remap_size * sizeof(uint32_t) != mapping->size())
+    {
+        std::cerr << "Error reading the MPHF from file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    partition = reinterpret_cast<const Partition*>(data + partition_offset);
+    pilot = reinterpret_cast<const uint64_t*>(data + pilot_offset);
+    remap = reinterpret_cast<const uint32_t*>(data + remap_offset);
+}
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, PTHash_MPHF)
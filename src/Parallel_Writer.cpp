@@ -0,0 +1,235 @@
+
+#include "Parallel_Writer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+
+Parallel_Writer::Parallel_Writer():
+    end(0),
+    pending(nullptr),
+    writer_idle(false)
+{}
+
+
+Parallel_Writer::~Parallel_Writer()
+{
+    close();
+}
+
+
+void Parallel_Writer::open(const std::string& output_file_path, const bool direct)
+{
+    file_path = output_file_path;
+    direct_io = false;
+
+    fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT, 0644);
+    const off_t size = (fd < 0 ? -1 : lseek(fd, 0, SEEK_END));
+    if(size < 0)
+    {
+        std::cerr << "Error opening output file " << file_path << ": " << std::strerror(errno) << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    base = size;
+
+#ifdef O_DIRECT
+    // Direct I/O needs the file offsets of the blocks to be aligned, and is not supported by some file systems.
+    if(direct && base % BLOCK_ALIGN == 0)
+    {
+        const int flags = fcntl(fd, F_GETFL);
+        if(flags >= 0 && fcntl(fd, F_SETFL, flags | O_DIRECT) == 0)
+            direct_io = true;
+        else
+            std::cerr << "Direct I/O is not supported for output file " << file_path << "; writing it through the page cache.\n";
+    }
+#endif
+
+
+    mem = static_cast<char*>(std::aligned_alloc(BLOCK_ALIGN, RING_SZ * BLOCK_SZ));
+    if(mem == nullptr)
+    {
+        std::cerr << "Error allocating the output blocks. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    ring.reset(new Block[RING_SZ]);
+    for(std::size_t i = 0; i < RING_SZ; ++i)
+    {
+        ring[i].data = mem + i * BLOCK_SZ;
+        ring[i].id = i;
+        ring[i].filled = 0;
+    }
+
+    end = 0;
+    pending = nullptr;
+    writer_idle = false;
+    closing = false;
+
+    writer.reset(new std::thread([this](){ write_blocks(); }));
+}
+
+
+void Parallel_Writer::hand_off(Block* const block)
+{
+    Block* head = pending.load(std::memory_order_relaxed);
+    do
+        block->next = head;
+    while(!pending.compare_exchange_weak(head, block));
+
+    // The writer thread checks the queue after marking itself idle, so either it finds the block, or it gets notified.
+    if(writer_idle)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        block_ready.notify_one();
+    }
+}
+
+
+void Parallel_Writer::write_blocks()
+{
+    std::vector<Block*> batch;
+
+    while(true)
+    {
+        Block* block = pending.exchange(nullptr);
+        if(block == nullptr)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            writer_idle = true;
+            block_ready.wait(lock, [this](){ return pending != nullptr || closing; });
+            writer_idle = false;
+
+            if(pending == nullptr)  // The writer is closing, and all the completed blocks have been written.
+                break;
+
+            continue;
+        }
+
+
+        // The completed blocks taken off are in no particular order; they are written in runs of consecutive ones.
+        batch.clear();
+        for(; block != nullptr; block = block->next)
+            batch.push_back(block);
+
+        std::sort(batch.begin(), batch.end(), [](const Block* const x, const Block* const y){ return x->id < y->id; });
+
+        std::size_t i = 0;
+        while(i < batch.size())
+        {
+            std::size_t j = i + 1;
+            while(j < batch.size() && j - i < MAX_COALESCE && batch[j]->id == batch[j - 1]->id + 1)
+                j++;
+
+            write_out(batch.data() + i, j - i);
+            i = j;
+        }
+    }
+}
+
+
+void Parallel_Writer::write_out(Block* const* const block, const std::size_t count)
+{
+    const uint64_t offset = base + block[0]->id * BLOCK_SZ;
+    iovec iov[MAX_COALESCE];
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        iov[i].iov_base = block[i]->data;
+        iov[i].iov_len = BLOCK_SZ;
+    }
+
+    const ssize_t written = pwritev(fd, iov, static_cast<int>(count), offset);
+    if(written < 0 && errno != EINTR)
+    {
+        std::cerr << "Error writing to output file " << file_path << ": " << std::strerror(errno) << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Complete a partial write, if any.
+    std::size_t done = (written < 0 ? 0 : written);
+    for(std::size_t i = 0; i < count; ++i)
+        if(done >= BLOCK_SZ)
+            done -= BLOCK_SZ;
+        else
+        {
+            write_at(block[i]->data + done, BLOCK_SZ - done, offset + i * BLOCK_SZ + done);
+            done = 0;
+        }
+
+
+    // Recycle the slots for the blocks `RING_SZ` places ahead.
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        block[i]->filled.store(0, std::memory_order_relaxed);
+        block[i]->id.store(block[i]->id + RING_SZ, std::memory_order_release);
+    }
+}
+
+
+void Parallel_Writer::write_at(const char* buf, std::size_t len, uint64_t offset) const
+{
+    while(len > 0)
+    {
+        const ssize_t written = pwrite(fd, buf, len, offset);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            std::cerr << "Error writing to output file " << file_path << ": " << std::strerror(errno) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        buf += written;
+        len -= written;
+        offset += written;
+    }
+}
+
+
+void Parallel_Writer::close()
+{
+    if(fd < 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing = true;
+    }
+
+    block_ready.notify_one();
+    writer->join();
+    writer.reset();
+
+
+    // Write the last, partially filled, block. Its size may not be aligned for direct I/O.
+    const uint64_t size = end;
+    const std::size_t tail = size % BLOCK_SZ;
+    if(tail > 0)
+    {
+#ifdef O_DIRECT
+        if(direct_io)
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+#endif
+
+        write_at(ring[(size / BLOCK_SZ) % RING_SZ].data, tail, base + size - tail);
+    }
+
+
+    if(::close(fd) != 0)
+    {
+        std::cerr << "Error closing output file " << file_path << ": " << std::strerror(errno) << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    fd = -1;
+    ring.reset();
+    std::free(mem);
+    mem = nullptr;
+}
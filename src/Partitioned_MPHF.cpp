@@ -0,0 +1,372 @@
+
+#include "Partitioned_MPHF.hpp"
+#include "BBHash_MPHF.hpp"
+#include "PTHash_MPHF.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "Spin_Lock.hpp"
+#include "utility.hpp"
+#include "globals.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+
+template <uint16_t k, typename T_MPHF_> constexpr double Partitioned_MPHF<k, T_MPHF_>::gamma_min;
+template <uint16_t k, typename T_MPHF_> constexpr double Partitioned_MPHF<k, T_MPHF_>::gamma_max;
+template <uint16_t k, typename T_MPHF_> constexpr double Partitioned_MPHF<k, T_MPHF_>::gamma_resolution;
+
+
+template <uint16_t k, typename T_MPHF_>
+Partitioned_MPHF<k, T_MPHF_>::Partitioned_MPHF(const uint64_t partition_count, const std::size_t max_memory, const std::string& temp_file_prefix):
+    partition_count_(std::max(partition_count, static_cast<uint64_t>(1))),
+    max_memory(max_memory),
+    temp_file_prefix(temp_file_prefix)
+{}
+
+
+template <uint16_t k, typename T_MPHF_>
+double Partitioned_MPHF<k, T_MPHF_>::bits_per_key(const double gamma)
+{
+    return base_t::bits_per_key(gamma);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+double Partitioned_MPHF<k, T_MPHF_>::gamma(const double max_bits_per_key)
+{
+    return base_t::gamma(max_bits_per_key);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+std::string Partitioned_MPHF<k, T_MPHF_>::partition_file_path(const std::string& file_path, const uint64_t p)
+{
+    return file_path + "." + std::to_string(p);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+std::string Partitioned_MPHF<k, T_MPHF_>::key_file_path(const uint64_t p) const
+{
+    return temp_file_prefix + "mphf_partition_" + std::to_string(p) + ".keys";
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+void Partitioned_MPHF<k, T_MPHF_>::build(const Kmer_Container<k>& kmer_container, const uint16_t thread_count, const std::string& working_dir_path, const double gamma)
+{
+    mphf.clear();
+    mphf.resize(partition_count_);
+    offset.assign(partition_count_ + 1, 0);
+
+    if(partition_count_ == 1)
+    {
+        mphf[0].reset(new base_t());
+        mphf[0]->build(kmer_container, thread_count, working_dir_path, gamma);
+        offset[1] = kmer_container.size();
+
+        return;
+    }
+
+
+    // Distribute the keys to their partitions' files.
+    std::vector<std::ofstream> key_file(partition_count_);
+    for(uint64_t p = 0; p < partition_count_; ++p)
+    {
+        key_file[p].open(key_file_path(p), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if(key_file[p].fail())
+        {
+            std::cerr << "Error opening temporary file " << key_file_path(p) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    std::vector<uint64_t> key_count(partition_count_, 0);
+    std::unique_ptr<Spin_Lock[]> lock(new Spin_Lock[partition_count_]);
+
+    Kmer_SPMC_Iterator<k> parser(&kmer_container, thread_count);
+    parser.launch_production();
+
+    std::vector<std::thread> worker;
+    worker.reserve(thread_count);
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        worker.emplace_back(&Partitioned_MPHF::partition_keys, this, std::ref(parser), t_id, std::ref(key_file), std::ref(key_count), lock.get());
+
+    parser.seize_production();
+
+    for(auto& w : worker)
+        w.join();
+
+    for(uint64_t p = 0; p < partition_count_; ++p)
+    {
+        key_file[p].close();
+        if(key_file[p].fail())
+        {
+            std::cerr << "Error writing to temporary file " << key_file_path(p) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        offset[p + 1] = offset[p] + key_count[p];
+    }
+
+    std::cout << "Distributed the k-mers to " << partition_count_ << " partitions.\n";
+
+
+    // Build the partitions in parallel, dividing the threads among the concurrent builds. A build
+    // holds its partition's keys and its working memory; the builds are admitted while these fit
+    // in the memory budget together—though one is always admitted if none is in progress.
+    const uint16_t builder_count = static_cast<uint16_t>(std::min(static_cast<uint64_t>(thread_count), partition_count_));
+    const uint16_t threads_per_build = std::max(thread_count / builder_count, 1);
+    std::atomic<uint64_t> next_partition(0);
+
+    std::size_t memory_in_use = 0;  // Memory of the builds in progress.
+    uint16_t build_count = 0;   // Number of builds in progress.
+    std::mutex memory_lock;
+    std::condition_variable memory_released;
+
+    const auto build_memory =
+        [&](const uint64_t p)
+        {
+            return key_count[p] * (sizeof(Kmer<k>) + base_t::build_bytes_per_key);
+        };
+
+    const auto build_partitions =
+        [&]()
+        {
+            std::vector<Kmer<k>> keys;
+            uint64_t p;
+            while((p = next_partition++) < partition_count_)
+            {
+                const std::size_t memory = build_memory(p);
+                {
+                    std::unique_lock<std::mutex> lock(memory_lock);
+                    memory_released.wait(lock, [&](){ return build_count == 0 || memory_in_use + memory <= max_memory; });
+                    memory_in_use += memory;
+                    build_count++;
+                }
+
+                const std::string file_path = key_file_path(p);
+                keys.resize(key_count[p]);
+
+                std::ifstream input(file_path.c_str(), std::ifstream::in | std::ifstream::binary);
+                input.read(reinterpret_cast<char*>(keys.data()), keys.size() * sizeof(Kmer<k>));
+                if(input.fail())
+                {
+                    std::cerr << "Error reading temporary file " << file_path << ". Aborting.\n";
+                    std::exit(EXIT_FAILURE);
+                }
+
+                input.close();
+                std::remove(file_path.c_str());
+
+                if(!keys.empty())
+                {
+                    mphf[p].reset(new base_t());
+                    mphf[p]->build(keys.data(), keys.size(), threads_per_build, working_dir_path, gamma);
+                }
+
+                // Release the keys' memory before admitting other builds.
+                keys.clear();
+                keys.shrink_to_fit();
+
+                {
+                    std::lock_guard<std::mutex> lock(memory_lock);
+                    memory_in_use -= memory;
+                    build_count--;
+                }
+
+                memory_released.notify_all();
+            }
+        };
+
+    worker.clear();
+    for(uint16_t t_id = 0; t_id < builder_count; ++t_id)
+        worker.emplace_back(build_partitions);
+
+    for(auto& w : worker)
+        w.join();
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+void Partitioned_MPHF<k, T_MPHF_>::partition_keys(Kmer_SPMC_Iterator<k>& parser, const uint16_t thread_id, std::vector<std::ofstream>& key_file, std::vector<uint64_t>& key_count, Spin_Lock* const lock) const
+{
+    std::vector<std::vector<Kmer<k>>> buf(partition_count_);   // Keys buffered per partition.
+
+    const auto flush =
+        [&](const uint64_t p)
+        {
+            lock[p].lock();
+            key_file[p].write(reinterpret_cast<const char*>(buf[p].data()), buf[p].size() * sizeof(Kmer<k>));
+            key_count[p] += buf[p].size();
+            lock[p].unlock();
+
+            buf[p].clear();
+        };
+
+
+    Kmer<k> kmer;
+    while(parser.tasks_expected(thread_id))
+        if(parser.value_at(thread_id, kmer))
+        {
+            const uint64_t p = partition(kmer);
+            buf[p].push_back(kmer);
+            if(buf[p].size() == key_buf_size)
+                flush(p);
+        }
+
+    for(uint64_t p = 0; p < partition_count_; ++p)
+        if(!buf[p].empty())
+            flush(p);
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+uint64_t Partitioned_MPHF<k, T_MPHF_>::bit_size() const
+{
+    uint64_t bits = (partition_count_ > 1 ? offset.size() * 64 : 0);
+    for(const auto& f : mphf)
+        if(f)
+            bits += f->bit_size();
+
+    return bits;
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+Page_Backing Partitioned_MPHF<k, T_MPHF_>::backing() const
+{
+    uint64_t max_p = 0;
+    for(uint64_t p = 1; p < partition_count_; ++p)
+        if(offset[p + 1] - offset[p] > offset[max_p + 1] - offset[max_p])
+            max_p = p;
+
+    return mphf[max_p] ? mphf[max_p]->backing() : Page_Backing::regular;
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+void Partitioned_MPHF<k, T_MPHF_>::save(const std::string& file_path) const
+{
+    const auto save_base =
+        [](const base_t& f, const std::string& file_path)
+        {
+            std::ofstream output(file_path.c_str(), std::ofstream::out | std::ofstream::binary);
+            if(output.fail())
+            {
+                std::cerr << "Error writing to file " << file_path << ". Aborting.\n";
+                std::exit(EXIT_FAILURE);
+            }
+
+            f.save(output);
+
+            output.close();
+        };
+
+
+    // The partitions are saved separately, even if single, so that their files can be mapped as the base MPHF's.
+    const uint32_t version = cuttlefish::HASH_TABLE_FORMAT_VERSION;
+    std::ofstream output(file_path.c_str(), std::ofstream::out | std::ofstream::binary);
+    output.write(reinterpret_cast<const char*>(&file_magic), sizeof(file_magic));
+    output.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    output.write(reinterpret_cast<const char*>(&partition_count_), sizeof(partition_count_));
+    output.write(reinterpret_cast<const char*>(offset.data()), offset.size() * sizeof(uint64_t));
+    output.close();
+    if(output.fail())
+    {
+        std::cerr << "Error writing to file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    for(uint64_t p = 0; p < partition_count_; ++p)
+        if(mphf[p])
+            save_base(*mphf[p], partition_file_path(file_path, p));
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+bool Partitioned_MPHF<k, T_MPHF_>::read_header(const std::string& file_path, uint32_t& version, uint64_t& partition_count, std::vector<uint64_t>& offset)
+{
+    std::ifstream input(file_path.c_str(), std::ifstream::in | std::ifstream::binary);
+    uint64_t magic = 0;
+    input.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    if(input.fail() || magic != file_magic)
+        return false;
+
+    input.read(reinterpret_cast<char*>(&version), sizeof(version));
+    input.read(reinterpret_cast<char*>(&partition_count), sizeof(partition_count));
+    offset.resize(partition_count + 1);
+    input.read(reinterpret_cast<char*>(offset.data()), offset.size() * sizeof(uint64_t));
+    if(input.fail())
+    {
+        std::cerr << "Error reading the MPHF from file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    return true;
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+void Partitioned_MPHF<k, T_MPHF_>::load(const std::string& file_path, const bool populate)
+{
+    mphf.clear();
+
+    uint32_t version;
+    if(!read_header(file_path, version, partition_count_, offset))
+    {
+        std::cerr << "No MPHF of a known format found at file " << file_path << ". Remove the file to have it rebuilt. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(version != cuttlefish::HASH_TABLE_FORMAT_VERSION)
+    {
+        std::cerr << "The MPHF at file " << file_path << " is of format version " << version
+                    << ", whereas version " << cuttlefish::HASH_TABLE_FORMAT_VERSION << " is expected. Remove the file to have it rebuilt. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    mphf.resize(partition_count_);
+    for(uint64_t p = 0; p < partition_count_; ++p)
+        if(offset[p + 1] > offset[p])
+        {
+            mphf[p].reset(new base_t());
+            mphf[p]->load(partition_file_path(file_path, p), populate);
+        }
+}
+
+
+template <uint16_t k, typename T_MPHF_>
+bool Partitioned_MPHF<k, T_MPHF_>::remove(const std::string& file_path)
+{
+    if(!file_exists(file_path))
+        return true;
+
+    uint32_t version;
+    uint64_t partition_count;
+    std::vector<uint64_t> offset;
+    bool success = true;
+    if(read_header(file_path, version, partition_count, offset))
+        for(uint64_t p = 0; p < partition_count; ++p)
+        {
+            const std::string partition_path = partition_file_path(file_path, p);
+            if(file_exists(partition_path) && std::remove(partition_path.c_str()) != 0)
+                success = false;
+        }
+
+    return std::remove(file_path.c_str()) == 0 && success;
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE_PER_MPHF, Partitioned_MPHF)
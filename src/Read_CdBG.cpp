@@ -3,6 +3,7 @@
 #include "kmer_Enumerator.hpp"
 #include "Kmer_SPMC_Iterator.hpp"
 #include "kmer_Enumeration_Stats.hpp"
+#include "Vertex_Enumerator.hpp"
 #include "Read_CdBG_Constructor.hpp"
 #include "Read_CdBG_Extractor.hpp"
 #include "kmc_runner.h"
@@ -144,16 +145,21 @@ kmer_Enumeration_Stats<k + 1> Read_CdBG<k>::enumerate_edges() const
 template <uint16_t k>
 kmer_Enumeration_Stats<k> Read_CdBG<k>::enumerate_vertices(const std::size_t max_memory) const
 {
-    return kmer_Enumerator<k>().enumerate(
-        KMC::InputFileType::KMC, std::vector<std::string>(1, logistics.edge_db_path()), 1, params.thread_count(),
-        max_memory, params.strict_memory(), false, bits_per_vertex,
-        logistics.working_dir_path(), logistics.vertex_db_path());
+    // An in-memory edge database occupies a part of the memory budget.
+    constexpr std::size_t GB = 1024U * 1024U * 1024U;
+    const std::size_t db_memory = in_memory_db_size();
+    const std::size_t memory = (max_memory * GB > db_memory ? (max_memory * GB - db_memory) / GB : 0);
+
+    return Vertex_Enumerator<k>(params.thread_count(), logistics.temp_file_prefix()).enumerate(
+        logistics.edge_db_path(), memory, logistics.vertex_db_path());
 }
 
 
 template <uint16_t k>
 void Read_CdBG<k>::construct_hash_table(const uint64_t vertex_count, const bool load)
 {
+    Huge_Pages::enable_explicit(params.explicit_huge_pages());
+
     if(load)
     {
         hash_table = std::make_unique<Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>>(logistics.vertex_db_path(), vertex_count);
@@ -163,7 +169,11 @@ void Read_CdBG<k>::construct_hash_table(const uint64_t vertex_count, const bool
     {
         std::size_t max_memory = std::max(process_peak_memory(), params.max_memory() * 1024U * 1024U * 1024U);
         const std::size_t parser_memory = Kmer_SPMC_Iterator<k>::memory(params.thread_count());
-        max_memory = (max_memory > parser_memory ? max_memory - parser_memory : 0);
+        const std::size_t db_memory = in_memory_db_size();
+        if(db_memory > 0 && db_memory + parser_memory >= max_memory)
+            std::cout << "WARNING: the in-memory databases exceed the memory limit. Consider increasing it, or not using the in-memory databases.\n";
+
+        max_memory = (max_memory > parser_memory + db_memory ? max_memory - (parser_memory + db_memory) : 0);
         
         hash_table =
 #ifdef CF_DEVELOP_MODE
@@ -173,7 +183,7 @@ void Read_CdBG<k>::construct_hash_table(const uint64_t vertex_count, const bool
                             std::make_unique<Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>>(logistics.vertex_db_path(), vertex_count, max_memory) :
                             std::make_unique<Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>>(logistics.vertex_db_path(), vertex_count, max_memory, std::numeric_limits<double>::max()));
 #endif
-        hash_table->construct(params.thread_count(), logistics.working_dir_path(), params.mph_file_path(), params.save_mph());
+        hash_table->construct(params.thread_count(), logistics.working_dir_path(), logistics.temp_file_prefix(), params.mph_file_path(), params.save_mph(), params.populate_loads(), params.partition_count());
     }
 }
 
@@ -181,10 +191,20 @@ void Read_CdBG<k>::construct_hash_table(const uint64_t vertex_count, const bool
 template <uint16_t k>
 void Read_CdBG<k>::compute_DFA_states()
 {
-    Read_CdBG_Constructor<k> cdBg_constructor(params, *hash_table);
+    if(!params.path_cover())
+    {
+        const std::size_t seed_memory = this->seed_memory();
+        if(seed_memory > Unitig_Seeds<k>::tracking_memory(hash_table->size()))
+            seeds = std::make_unique<Unitig_Seeds<k>>(hash_table->size(), params.thread_count(), seed_memory);
+        else
+            std::cout << "No memory is left for seed vertices; the maximal unitigs are to be extracted by scanning all the vertices.\n";
+    }
+
+    Read_CdBG_Constructor<k> cdBg_constructor(params, *hash_table, seeds.get());
     cdBg_constructor.compute_DFA_states(logistics.edge_db_path());
 
     dbg_info.add_basic_info(cdBg_constructor);
+    dbg_info.add_memory_info(hash_table->bucket_backing(), hash_table->mphf_backing());
 }
 
 
@@ -193,8 +213,10 @@ void Read_CdBG<k>::extract_maximal_unitigs()
 {
     Read_CdBG_Extractor<k> cdBg_extractor(params, *hash_table);
 
-    cdBg_extractor.extract_maximal_unitigs(logistics.vertex_db_path(), logistics.output_file_path());
+    cdBg_extractor.extract_maximal_unitigs(logistics.vertex_db_path(), logistics.output_file_path(), seeds.get());
     dbg_info.add_unipaths_info(cdBg_extractor);
+
+    seeds.reset();
 }
 
 
@@ -206,10 +228,38 @@ bool Read_CdBG<k>::is_constructed() const
 
 
 template <uint16_t k>
-std::size_t Read_CdBG<k>::max_disk_usage(const kmer_Enumeration_Stats<k + 1>& edge_stats, const kmer_Enumeration_Stats<k>& vertex_stats)
+std::size_t Read_CdBG<k>::seed_memory() const
+{
+    const std::size_t max_memory = std::max(process_peak_memory(), params.max_memory() * 1024U * 1024U * 1024U);
+    const std::size_t used_memory = hash_table->memory() + Kmer_SPMC_Iterator<k + 1>::memory(params.thread_count()) + Parallel_Writer::memory() + in_memory_db_size();
+
+    return max_memory > used_memory ? max_memory - used_memory : 0;
+}
+
+
+template <uint16_t k>
+std::size_t Read_CdBG<k>::in_memory_db_size() const
 {
-    const std::size_t at_edge_enum = std::max(edge_stats.temp_disk_usage(), edge_stats.db_size());
-    const std::size_t at_vertex_enum = edge_stats.db_size() + std::max(vertex_stats.temp_disk_usage(), vertex_stats.db_size());
+    std::size_t db_size = 0;
+
+    if(logistics.in_memory_edge_db() && Kmer_Container<k + 1>::exists(logistics.edge_db_path()))
+        db_size += Kmer_Container<k + 1>::database_size(logistics.edge_db_path());
+
+    if(logistics.in_memory_vertex_db() && Kmer_Container<k>::exists(logistics.vertex_db_path()))
+        db_size += Kmer_Container<k>::database_size(logistics.vertex_db_path());
+
+    return db_size;
+}
+
+
+template <uint16_t k>
+std::size_t Read_CdBG<k>::max_disk_usage(const kmer_Enumeration_Stats<k + 1>& edge_stats, const kmer_Enumeration_Stats<k>& vertex_stats) const
+{
+    const std::size_t edge_db_size = (logistics.in_memory_edge_db() ? 0 : edge_stats.db_size());
+    const std::size_t vertex_db_size = (logistics.in_memory_vertex_db() ? 0 : vertex_stats.db_size());
+
+    const std::size_t at_edge_enum = std::max(edge_stats.temp_disk_usage(), edge_db_size);
+    const std::size_t at_vertex_enum = edge_db_size + std::max(vertex_stats.temp_disk_usage(), vertex_db_size);
 
     const std::size_t max_disk = std::max(at_edge_enum, at_vertex_enum);
     return max_disk;
@@ -4,13 +4,16 @@
 #include "Kmer_SPMC_Iterator.hpp"
 #include "Thread_Pool.hpp"
 
+#include <vector>
+#include <algorithm>
 #include <chrono>
 
 
 template <uint16_t k>
-Read_CdBG_Constructor<k>::Read_CdBG_Constructor(const Build_Params& params, Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table):
+Read_CdBG_Constructor<k>::Read_CdBG_Constructor(const Build_Params& params, Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table, Unitig_Seeds<k>* const seeds):
     params(params),
-    hash_table(hash_table)
+    hash_table(hash_table),
+    seeds(seeds)
 {}
 
 
@@ -31,14 +34,21 @@ void Read_CdBG_Constructor<k>::compute_DFA_states(const std::string& edge_db_pat
     {
         std::cout <<    "Found the hash table buckets at file " << buckets_file_path << ".\n"
                         "Loading the buckets.\n";
-        hash_table.load_hash_buckets(buckets_file_path);
+        hash_table.load_hash_buckets(buckets_file_path, params.populate_loads());
         std::cout << "Loaded the buckets into memory.\n";
     }
     else
     {
         // Construct a thread pool.
         const uint16_t thread_count = params.thread_count();
-        Thread_Pool<k> thread_pool(thread_count, this, Thread_Pool<k>::Task_Type::compute_states_read_space);
+        Thread_Pool thread_pool(thread_count);
+
+        // Route the edges to the owner threads of their partitions, if the hash table is partitioned.
+        if(hash_table.partition_count() > 1 && thread_count > 1)
+        {
+            inbox.reset(new Edge_Inbox[thread_count]);
+            routers_done = 0;
+        }
 
         // Launch the reading (and parsing per demand) of the edges from disk.
         edge_parser.launch_production();
@@ -54,6 +64,7 @@ void Read_CdBG_Constructor<k>::compute_DFA_states(const std::string& edge_db_pat
         // Wait for the consumer threads to finish parsing and processing the edges.
         thread_pool.close();
 
+        inbox.reset();
         std::cout << "\nNumber of processed edges: " << edges_processed << "\n";
 
 
@@ -63,6 +74,20 @@ void Read_CdBG_Constructor<k>::compute_DFA_states(const std::string& edge_db_pat
             hash_table.save_hash_buckets(buckets_file_path); 
             std::cout << "Saved the hash buckets at " << buckets_file_path << "\n";
         }
+
+        if(seeds != nullptr)
+        {
+            seeds->seal();
+            if(seeds->complete())
+                std::cout << "Number of seed vertices for the unitigs extraction: " << seeds->size() << ".\n";
+            else if(seeds->usable())
+                std::cout << "Number of seed vertices for the unitigs extraction: " << seeds->size() << ";"
+                            " the cover seeds exceeded the memory limit of " << seeds->max_seeds() << " per thread, and the"
+                            " unitigs without flanking seeds are to be extracted by scanning the vertices.\n";
+            else
+                std::cout << "The seed vertices exceeded their memory limit of " << seeds->max_seeds() << " per thread;"
+                            " the maximal unitigs are to be extracted by scanning all the vertices.\n";
+        }
     }
 
 
@@ -73,88 +98,115 @@ void Read_CdBG_Constructor<k>::compute_DFA_states(const std::string& edge_db_pat
 
 
 template <uint16_t k>
-void Read_CdBG_Constructor<k>::distribute_states_computation(Kmer_SPMC_Iterator<k + 1>* const edge_parser, Thread_Pool<k>& thread_pool)
+void Read_CdBG_Constructor<k>::distribute_states_computation(Kmer_SPMC_Iterator<k + 1>* const edge_parser, Thread_Pool& thread_pool)
 {
     const uint16_t thread_count = params.thread_count();
 
     for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
-    {
-        const uint16_t idle_thread_id = thread_pool.get_idle_thread();
-        thread_pool.assign_read_dBG_compaction_task(edge_parser, idle_thread_id);
-    }
+        thread_pool.submit(
+            [this, edge_parser, t_id](uint16_t)
+            {
+                process_edges(edge_parser, t_id);
+            });
 }
 
 
 template <uint16_t k>
 void Read_CdBG_Constructor<k>::process_edges(Kmer_SPMC_Iterator<k + 1>* const edge_parser, const uint16_t thread_id)
 {
-    if(params.path_cover())
+    if(inbox)
+        process_routed_edges(edge_parser, thread_id);
+    else if(params.path_cover())
         process_path_cover_edges(edge_parser, thread_id);
     else
         process_cdbg_edges(edge_parser, thread_id);
 }
 
 
+template <uint16_t k>
+std::size_t Read_CdBG_Constructor<k>::fetch_edge_batch(Kmer_SPMC_Iterator<k + 1>* const edge_parser, const uint16_t thread_id, Edge<k>* const edge, Kmer<k>* const vertex, uint64_t* const h)
+{
+    Kmer<k + 1> e[edge_batch_size]; // Edge (k + 1)-mers parsed in chunks.
+    std::size_t edge_count = 0;
+    std::size_t chunk_size;
+    while(edge_count < edge_batch_size && (chunk_size = edge_parser->next_chunk(thread_id, e + edge_count, edge_batch_size - edge_count)) > 0)
+        edge_count += chunk_size;
+
+    for(std::size_t i = 0; i < edge_count; ++i)
+    {
+        edge[i].e() = e[i];
+        edge[i].configure();    // A new edge (k + 1)-mer has been parsed; set information for its two endpoints, except their hashes.
+    }
+
+    hash_edge_batch(edge, edge_count, vertex, h);
+
+    return edge_count;
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Constructor<k>::hash_edge_batch(Edge<k>* const edge, const std::size_t n, Kmer<k>* const vertex, uint64_t* const h)
+{
+    if(n == 0)
+        return;
+
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        vertex[2 * i] = edge[i].u().canonical();
+        vertex[2 * i + 1] = edge[i].v().canonical();
+    }
+
+    if(hash_table.partition_count() > 1)
+    {
+        // The endpoints of an edge are adjacent k-mers, so the minimizer of `v` is rolled from that of `u`.
+        uint64_t minimizer[2 * edge_batch_size];    // Canonical minimizers of the endpoints.
+        Kmer<k> u, v;
+        typename Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>::rolling_minimizer_t endpoint_minimizer;
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            u.from_prefix(edge[i].e()), v.from_suffix(edge[i].e());
+            endpoint_minimizer.reset(u);
+            minimizer[2 * i] = endpoint_minimizer();
+            endpoint_minimizer.roll(v);
+            minimizer[2 * i + 1] = endpoint_minimizer();
+        }
+
+        hash_table.bucket_ids(vertex, minimizer, 2 * n, h);
+    }
+    else
+        hash_table.bucket_ids(vertex, 2 * n, h);
+
+    hash_table.fetch(h, 2 * n);
+
+    for(std::size_t i = 0; i < n; ++i)
+        edge[i].set_hashes(h[2 * i], h[2 * i + 1]);
+}
+
+
 template <uint16_t k>
 void Read_CdBG_Constructor<k>::process_cdbg_edges(Kmer_SPMC_Iterator<k + 1>* const edge_parser, const uint16_t thread_id)
 {
-    // Data locations to be reused per each edge processed.
-    Edge<k> e;  // For the edges to be processed one-by-one.
-/*
-    cuttlefish::edge_encoding_t e_front, e_back;    // Edges incident to the front and to the back of a vertex with a crossing loop.
-    cuttlefish::edge_encoding_t e_u_old, e_u_new;   // Edges incident to some particular side of a vertex `u`, before and after the addition of a new edge.
-    cuttlefish::edge_encoding_t e_v_old, e_v_new;   // Edges incident to some particular side of a vertex `v`, before and after the addition of a new edge.
-*/
+    // Data locations to be reused per each edge-batch processed.
+    std::vector<Edge<k>> edge(edge_batch_size); // For the edges to be processed in batches.
+    std::vector<Kmer<k>> vertex(2 * edge_batch_size);   // Endpoint vertices of the edges in a batch.
+    std::vector<uint64_t> h(2 * edge_batch_size);   // Hash values of the endpoint vertices in a batch.
 
     uint64_t edge_count = 0;    // Number of edges processed by this thread.
     uint64_t progress = 0;  // Number of edges processed by the thread; is reset at reaching 1% of its approximate workload.
 
 
     while(edge_parser->tasks_expected(thread_id))
-        if(edge_parser->value_at(thread_id, e.e()))
+    {
+        const std::size_t batch_size = fetch_edge_batch(edge_parser, thread_id, edge.data(), vertex.data(), h.data());
+        for(std::size_t i = 0; i < batch_size; ++i)
         {
-            e.configure(hash_table);    // A new edge (k + 1)-mer has been parsed; set information for its two endpoints.
-
-            if(e.is_loop())
-                if(e.u().side() != e.v().side())    // It is a crossing loop.
-                {
-                    while(!add_crossing_loop(e.u()));
-/*
-                    while(!add_crossing_loop(e.u(), e_front, e_back));
-                    
-                    propagate_discard(e.u(), e.u().side() == cuttlefish::side_t::front ? e_front : e_back);
-                    propagate_discard(e.v(), e.v().side() == cuttlefish::side_t::front ? e_front : e_back);
-*/
-                }
-                else    // A one-sided loop.
-                {
-                    while(!add_one_sided_loop(e.u()));
-/*
-                    while(!add_one_sided_loop(e.u(), e_u_old));
-
-                    propagate_discard(e.u(), e_u_old);
-*/
-                }
-            else    // It connects two endpoints `u` and `v` of two distinct vertex.
-            {
-                while(!add_incident_edge(e.u()));
-                while(!add_incident_edge(e.v()));
-/*
-                while(!add_incident_edge(e.u(), e_u_old, e_u_new));
-                while(!add_incident_edge(e.v(), e_v_old, e_v_new));
-
-                if(e_u_new == cuttlefish::edge_encoding_t::N)
-                    propagate_discard(e.u(), e.v(), e_u_old);
-
-                if(e_v_new == cuttlefish::edge_encoding_t::N)
-                    propagate_discard(e.v(), e.u(), e_v_old);
-*/
-            }
+            process_cdbg_edge(edge[i], thread_id);
 
             edge_count++;
             if(progress_tracker.track_work(++progress))
                 progress = 0;
         }
+    }
 
     
     lock.lock();
@@ -166,16 +218,20 @@ void Read_CdBG_Constructor<k>::process_cdbg_edges(Kmer_SPMC_Iterator<k + 1>* con
 template <uint16_t k>
 void Read_CdBG_Constructor<k>::process_path_cover_edges(Kmer_SPMC_Iterator<k + 1>* const edge_parser, const uint16_t thread_id)
 {
-    Edge<k> e;  // For the edges to be processed one-by-one; say this is between the vertices `u` and `v`.
+    std::vector<Edge<k>> edge(edge_batch_size); // For the edges to be processed in batches; say each is between the vertices `u` and `v`.
+    std::vector<Kmer<k>> vertex(2 * edge_batch_size);   // Endpoint vertices of the edges in a batch.
+    std::vector<uint64_t> h(2 * edge_batch_size);   // Hash values of the endpoint vertices in a batch.
 
     uint64_t edge_count = 0;    // Number of edges processed by this thread.
     uint64_t progress = 0;  // Number of edges processed by the thread; is reset at reaching 1% of its approximate workload.
 
 
     while(edge_parser->tasks_expected(thread_id))
-        if(edge_parser->value_at(thread_id, e.e()))
+    {
+        const std::size_t batch_size = fetch_edge_batch(edge_parser, thread_id, edge.data(), vertex.data(), h.data());
+        for(std::size_t i = 0; i < batch_size; ++i)
         {
-            e.configure(hash_table);    // A new edge (k + 1)-mer has been parsed; set information for its two endpoints.
+            const Edge<k>& e = edge[i];
 
             if(e.is_loop())
                 continue;
@@ -186,6 +242,7 @@ void Read_CdBG_Constructor<k>::process_path_cover_edges(Kmer_SPMC_Iterator<k + 1
             if(progress_tracker.track_work(++progress))
                 progress = 0;
         }
+    }
 
     
     lock.lock();
@@ -194,6 +251,125 @@ void Read_CdBG_Constructor<k>::process_path_cover_edges(Kmer_SPMC_Iterator<k + 1
 }
 
 
+template <uint16_t k>
+void Read_CdBG_Constructor<k>::process_routed_edges(Kmer_SPMC_Iterator<k + 1>* const edge_parser, const uint16_t thread_id)
+{
+    const uint16_t thread_count = params.thread_count();
+    std::vector<std::vector<Edge<k>>> outbox(thread_count); // Edges to be routed to each other thread.
+    std::vector<Edge<k>> own;   // Edges of the partitions owned by this thread, to be processed in a batch.
+    std::vector<Edge<k>> received;  // Edges routed to this thread by the others.
+    std::vector<Kmer<k>> vertex(2 * edge_batch_size);   // Endpoint vertices of the edges in a batch.
+    std::vector<uint64_t> h(2 * edge_batch_size);   // Hash values of the endpoint vertices in a batch.
+    own.reserve(edge_batch_size);
+
+    uint64_t edge_count = 0;    // Number of edges processed by this thread.
+    uint64_t progress = 0;  // Number of edges processed by the thread; is reset at reaching 1% of its approximate workload.
+
+    // Routes the outbox edges for the thread with id `t_id` to it.
+    const auto send =
+        [&](const uint16_t t_id)
+        {
+            inbox[t_id].lock.lock();
+            inbox[t_id].edges.insert(inbox[t_id].edges.end(), outbox[t_id].begin(), outbox[t_id].end());
+            inbox[t_id].lock.unlock();
+
+            outbox[t_id].clear();
+        };
+
+    // Processes the edges routed to this thread so far.
+    const auto drain =
+        [&]()
+        {
+            inbox[thread_id].lock.lock();
+            received.swap(inbox[thread_id].edges);
+            inbox[thread_id].lock.unlock();
+
+            process_edge_batch(received.data(), received.size(), vertex.data(), h.data(), edge_count, progress, thread_id);
+            received.clear();
+        };
+
+
+    Kmer<k + 1> chunk[edge_batch_size];    // Edge (k + 1)-mers parsed in chunks.
+    Edge<k> e;
+    while(edge_parser->tasks_expected(thread_id))
+        for(std::size_t i = 0, chunk_size = edge_parser->next_chunk(thread_id, chunk, edge_batch_size); i < chunk_size; ++i)
+        {
+            e.e() = chunk[i];
+            e.configure();  // A new edge (k + 1)-mer has been parsed; set information for its two endpoints, except their hashes.
+
+            const uint16_t owner = static_cast<uint16_t>(hash_table.partition(e.u().canonical()) % thread_count);
+            if(owner != thread_id)
+            {
+                outbox[owner].push_back(e);
+                if(outbox[owner].size() == route_batch_size)
+                    send(owner);
+            }
+            else
+            {
+                own.push_back(e);
+                if(own.size() == edge_batch_size)
+                {
+                    process_edge_batch(own.data(), own.size(), vertex.data(), h.data(), edge_count, progress, thread_id);
+                    own.clear();
+
+                    drain();
+                }
+            }
+        }
+
+    process_edge_batch(own.data(), own.size(), vertex.data(), h.data(), edge_count, progress, thread_id);
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        if(!outbox[t_id].empty())
+            send(t_id);
+
+    routers_done++;
+
+    // Keep processing the routed edges till every thread is done routing; the edges routed before a thread
+    // marks itself done are visible to the drain following the observation of it.
+    while(true)
+    {
+        const bool all_routed = (routers_done == thread_count);
+        drain();
+        if(all_routed)
+            break;
+    }
+
+
+    lock.lock();
+    edges_processed += edge_count;
+    lock.unlock();
+}
+
+
+template <uint16_t k>
+void Read_CdBG_Constructor<k>::process_edge_batch(Edge<k>* const edge, const std::size_t n, Kmer<k>* const vertex, uint64_t* const h, uint64_t& edge_count, uint64_t& progress, const uint16_t thread_id)
+{
+    const bool path_cover = params.path_cover();
+
+    for(std::size_t batch_start = 0; batch_start < n; batch_start += edge_batch_size)
+    {
+        const std::size_t batch_size = std::min(edge_batch_size, n - batch_start);
+        hash_edge_batch(edge + batch_start, batch_size, vertex, h);
+
+        for(std::size_t i = batch_start; i < batch_start + batch_size; ++i)
+        {
+            const Edge<k>& e = edge[i];
+
+            if(!path_cover)
+                process_cdbg_edge(e, thread_id);
+            else if(e.is_loop())
+                continue;
+            else    // It connects two endpoints `u` and `v` of two distinct vertex.
+                add_path_cover_edge(e);
+
+            edge_count++;
+            if(progress_tracker.track_work(++progress))
+                progress = 0;
+        }
+    }
+}
+
+
 template <uint16_t k>
 uint64_t Read_CdBG_Constructor<k>::vertex_count() const
 {
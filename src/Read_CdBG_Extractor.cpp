@@ -5,45 +5,67 @@
 #include "Character_Buffer.hpp"
 #include "Thread_Pool.hpp"
 
+#include <vector>
+
 
 template <uint16_t k>
 Read_CdBG_Extractor<k>::Read_CdBG_Extractor(const Build_Params& params, Kmer_Hash_Table<k, cuttlefish::BITS_PER_READ_KMER>& hash_table):
     params(params),
-    hash_table(hash_table)
+    hash_table(hash_table),
+    vertices_unextracted(0)
 {}
 
 
 template <uint16_t k>
-void Read_CdBG_Extractor<k>::extract_maximal_unitigs(const std::string& vertex_db_path, const std::string& output_file_path)
+void Read_CdBG_Extractor<k>::extract_maximal_unitigs(const std::string& vertex_db_path, const std::string& output_file_path, Unitig_Seeds<k>* const seeds)
 {
     std::chrono::high_resolution_clock::time_point t_start = std::chrono::high_resolution_clock::now();
 
 
     // Construct a thread pool.
     const uint16_t thread_count = params.thread_count();
-    Thread_Pool<k> thread_pool(thread_count, this, Thread_Pool<k>::Task_Type::extract_unipaths_read_space);
-
-    // Launch the reading (and parsing per demand) of the vertices from disk.
-    const Kmer_Container<k> vertex_container(vertex_db_path);  // Wrapper container for the vertex-database.
-    Kmer_SPMC_Iterator<k> vertex_parser(&vertex_container, params.thread_count());  // Parser for the vertices from the vertex-database.
-    std::cout << "Number of distinct vertices: " << vertex_container.size() << ".\n";
-
-    vertex_parser.launch_production();
+    Thread_Pool thread_pool(thread_count);
 
     // Clear the output file and initialize the output sink.
     clear_file(output_file_path);
     init_output_sink(output_file_path);
 
-    // Launch (multi-threaded) extraction of the maximal unitigs.
     const uint64_t thread_load_percentile = static_cast<uint64_t>(std::round((vertex_count() / 100.0) / params.thread_count()));
-    progress_tracker.setup(vertex_count() * 2, thread_load_percentile,
-                            params.path_cover() ? "Extracting maximal path cover" :  "Extracting maximal unitigs");
-    distribute_unipaths_extraction(&vertex_parser, thread_pool);
+    vertices_unextracted = vertex_count();
+
+    // Launch (multi-threaded) extraction of the maximal unitigs from the seed vertices, if available.
+    if(seeds != nullptr && seeds->usable())
+    {
+        progress_tracker.setup(seeds->size() + vertex_count(), thread_load_percentile, "Extracting maximal unitigs from seeds");
+        distribute_unipaths_extraction(seeds, thread_pool);
+
+        // Wait for the consumer threads to finish processing the seeds.
+        thread_pool.wait_completion();
+        std::cout << "\nNumber of vertices in the unitigs extracted from seeds: " << unipaths_meta_info_.kmer_count() << ".\n";
+    }
 
-    // Wait for the vertices to be depleted from the database.
-    vertex_parser.seize_production();
+    // Scan the vertex-database for the rest of the maximal unitigs, if any: the ones without any seed.
+    if(unipaths_meta_info_.kmer_count() < vertex_count())
+    {
+        // Launch the reading (and parsing per demand) of the vertices from disk.
+        const Kmer_Container<k> vertex_container(vertex_db_path);  // Wrapper container for the vertex-database.
+        Kmer_SPMC_Iterator<k> vertex_parser(&vertex_container, params.thread_count());  // Parser for the vertices from the vertex-database.
+        std::cout << "Number of distinct vertices: " << vertex_container.size() << ".\n";
+
+        vertex_parser.launch_production();
+
+        // Launch (multi-threaded) extraction of the maximal unitigs.
+        progress_tracker.setup(vertex_count() * 2 - unipaths_meta_info_.kmer_count(), thread_load_percentile,
+                                params.path_cover() ? "Extracting maximal path cover" :  "Extracting maximal unitigs");
+        distribute_unipaths_extraction(&vertex_parser, thread_pool);
+
+        // Wait for the vertices to be depleted from the database.
+        vertex_parser.seize_production();
+
+        // Wait for the consumer threads to finish parsing and processing the vertices.
+        thread_pool.wait_completion();
+    }
 
-    // Wait for the consumer threads to finish parsing and processing edges.
     thread_pool.close();
 
     // Close the output sink.
@@ -60,24 +82,35 @@ void Read_CdBG_Extractor<k>::extract_maximal_unitigs(const std::string& vertex_d
 
 
 template <uint16_t k>
-void Read_CdBG_Extractor<k>::distribute_unipaths_extraction(Kmer_SPMC_Iterator<k>* const vertex_parser, Thread_Pool<k>& thread_pool)
+template <typename T_vertex_source_>
+void Read_CdBG_Extractor<k>::distribute_unipaths_extraction(T_vertex_source_* const vertex_source, Thread_Pool& thread_pool)
 {
     const uint16_t thread_count = params.thread_count();
 
     for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
-    {
-        const uint16_t idle_thread_id = thread_pool.get_idle_thread();
-        thread_pool.assign_read_dBG_compaction_task(vertex_parser, idle_thread_id);
-    }
+        thread_pool.submit(
+            [this, vertex_source, t_id](uint16_t)
+            {
+                process_vertices(vertex_source, t_id);
+            });
 }
 
 
 template <uint16_t k>
-void Read_CdBG_Extractor<k>::process_vertices(Kmer_SPMC_Iterator<k>* const vertex_parser, const uint16_t thread_id)
+template <typename T_vertex_source_>
+void Read_CdBG_Extractor<k>::process_vertices(T_vertex_source_* const vertex_source, const uint16_t thread_id)
 {
     // Data structures to be reused per each vertex scanned.
-    Kmer<k> v_hat;  // The vertex copy to be scanned one-by-one.
-    Maximal_Unitig_Scratch<k> maximal_unitig;  // The scratch space to be used to construct the containing maximal unitig of `v_hat`.
+    Kmer<k> chunk[PARSE_CHUNK_SZ];  // The vertices parsed in chunks, to be scanned one-by-one.
+    std::size_t chunk_size = 0; // Number of vertices in the current chunk.
+    std::size_t next_vertex = 0;    // Index of the next vertex to be scanned in the current chunk.
+    Slab_Arena<char> label_arena;   // Arena for the labels of the unitigs being walked.
+    Slab_Arena<uint64_t> hash_arena;    // Arena for the vertex hashes of the unitigs being walked.
+    std::vector<Unitig_Walk> walk;  // The walks constructing the containing maximal unitigs of the vertices being scanned.
+    walk.reserve(WALK_COUNT);
+    for(std::size_t i = 0; i < WALK_COUNT; ++i)
+        walk.emplace_back(label_arena, hash_arena);
+    std::size_t walks_in_progress = 0;  // Number of the walks in progress.
 
     uint64_t vertex_count = 0;  // Number of vertices scanned by this thread.
     Unipaths_Meta_info<k> extracted_unipaths_info;  // Meta-information over the maximal unitigs extracted by this thread.
@@ -86,26 +119,60 @@ void Read_CdBG_Extractor<k>::process_vertices(Kmer_SPMC_Iterator<k>* const verte
     Character_Buffer<BUFF_SZ, sink_t> output_buffer(output_sink.sink());  // The output buffer for maximal unitigs.
 
 
-    while(vertex_parser->tasks_expected(thread_id))
-        if(vertex_parser->value_at(thread_id, v_hat))
+    while(true)
+    {
+        for(Unitig_Walk& w : walk)
         {
-            if(extract_maximal_unitig(v_hat, maximal_unitig))
+            if(w.stage == Unitig_Walk::Stage::idle)
+            {
+                if(next_vertex == chunk_size && vertex_source->tasks_expected(thread_id))
+                {
+                    chunk_size = vertex_source->next_chunk(thread_id, chunk, PARSE_CHUNK_SZ);
+                    next_vertex = 0;
+                }
+
+                if(next_vertex == chunk_size)
+                    continue;
+
+                // All the maximal unitigs have been extracted; deplete the source without hashing its vertices.
+                if(vertices_unextracted == 0)
+                {
+                    next_vertex = chunk_size;
+                    continue;
+                }
+
+                start_walk(chunk[next_vertex++], w);
+                walks_in_progress++;
+
+                vertex_count++;
+                if(progress_tracker.track_work(++progress))
+                    progress = 0;
+
+                continue;
+            }
+
+
+            if(advance_walk(w))
             {
+                const Maximal_Unitig_Scratch<k>& maximal_unitig = w.maximal_unitig;
                 mark_maximal_unitig(maximal_unitig);
 
                 extracted_unipaths_info.add_maximal_unitig(maximal_unitig);
-                // output_buffer += maximal_unitig.fasta_rec();
+                vertices_unextracted -= maximal_unitig.size();
                 maximal_unitig.add_fasta_rec_to_buffer(output_buffer);
 
                 if(progress_tracker.track_work(progress += maximal_unitig.size()))
                     progress = 0;
             }
 
-            vertex_count++;
-            if(progress_tracker.track_work(++progress))
-                progress = 0;
+            if(w.stage == Unitig_Walk::Stage::idle)
+                walks_in_progress--;
         }
 
+        if(walks_in_progress == 0 && next_vertex == chunk_size && !vertex_source->tasks_expected(thread_id))
+            break;
+    }
+
 
     // Aggregate the meta-information over the extracted maximal unitigs and the thread-executions.
     lock.lock();
@@ -120,7 +187,7 @@ void Read_CdBG_Extractor<k>::process_vertices(Kmer_SPMC_Iterator<k>* const verte
 template <uint16_t k>
 void Read_CdBG_Extractor<k>::init_output_sink(const std::string& output_file_path)
 {
-    output_sink.init_sink(output_file_path);
+    output_sink.init_sink(output_file_path, params.direct_io());
 }
 
 
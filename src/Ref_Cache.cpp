@@ -0,0 +1,239 @@
+
+#include "Ref_Cache.hpp"
+#include "DNA_Utility.hpp"
+#include "utility.hpp"
+
+#include <cstring>
+#include <array>
+#include <algorithm>
+#include <iostream>
+
+
+// `DECODED_BYTE[b]` is the 4 characters of the bases packed in the byte `b`.
+static const std::array<std::array<char, 4>, 256> DECODED_BYTE =
+    []()
+    {
+        std::array<std::array<char, 4>, 256> decoded;
+        for(std::size_t b = 0; b < 256; ++b)
+            for(std::size_t i = 0; i < 4; ++i)
+                decoded[b][i] = DNA_Utility::map_char(static_cast<DNA::Base>((b >> (2 * i)) & 0b11));
+
+        return decoded;
+    }();
+
+
+Ref_Cache::Ref_Cache(const std::string& spill_file_path, const std::size_t memory_limit):
+    spill_file_path(spill_file_path),
+    memory_limit(memory_limit)
+{}
+
+
+Ref_Cache::~Ref_Cache()
+{
+    if(spilled_)
+    {
+        spill_output.close();
+        spill_input.close();
+
+        if(!remove_file(spill_file_path))
+            std::cerr << "Error removing the reference cache file " << spill_file_path << ".\n";
+    }
+}
+
+
+void Ref_Cache::append(const void* const data, const std::size_t len)
+{
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    buf.insert(buf.end(), bytes, bytes + len);
+    size_ += len;
+
+    if(!spilled_ && buf.size() > memory_limit)
+    {
+        spill_output.open(spill_file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!spill_output)
+        {
+            std::cerr << "Error opening the reference cache file " << spill_file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        spilled_ = true;
+        std::cout << "The reference cache exceeds its memory limit; spilling it to " << spill_file_path << ".\n";
+    }
+
+    if(spilled_ && buf.size() >= SPILL_BUF_SZ)
+        flush();
+}
+
+
+void Ref_Cache::flush()
+{
+    spill_output.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    if(!spill_output)
+    {
+        std::cerr << "Error writing to the reference cache file " << spill_file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    buf.clear();
+    if(buf.capacity() > 2 * SPILL_BUF_SZ)   // Release the memory of the records buffered before the spill.
+        buf.shrink_to_fit();
+}
+
+
+void Ref_Cache::encode(const char* const name, const char* const seq, const std::size_t seq_len, const uint64_t ref_id, const uint64_t seq_id, std::vector<uint8_t>& record)
+{
+    // Collect the runs of placeholders.
+    std::vector<std::pair<uint64_t, uint64_t>> n_run;
+    for(std::size_t i = 0; i < seq_len; ++i)
+        if(DNA_Utility::map_base(seq[i]) == DNA::N)
+        {
+            if(!n_run.empty() && n_run.back().first + n_run.back().second == i)
+                n_run.back().second++;
+            else
+                n_run.emplace_back(i, 1);
+        }
+
+
+    const std::size_t name_len = std::strlen(name);
+    const Record_Header header{ref_id, seq_id, seq_len, name_len, n_run.size()};
+    const std::size_t n_run_bytes = n_run.size() * sizeof(n_run[0]);
+    const std::size_t packed_offset = sizeof(header) + name_len + n_run_bytes;
+
+    record.resize(packed_offset + (seq_len + 3) / 4);
+    std::memcpy(record.data(), &header, sizeof(header));
+    std::memcpy(record.data() + sizeof(header), name, name_len);
+    std::memcpy(record.data() + sizeof(header) + name_len, n_run.data(), n_run_bytes);
+
+    // Pack the bases, 4 per byte; placeholders are packed as `A`s.
+    uint8_t* const packed = record.data() + packed_offset;
+    std::fill_n(packed, (seq_len + 3) / 4, 0);
+    for(std::size_t i = 0; i < seq_len; ++i)
+    {
+        const DNA::Base base = DNA_Utility::map_base(seq[i]);
+        if(base != DNA::N)
+            packed[i >> 2] |= (base << ((i & 3) << 1));
+    }
+}
+
+
+void Ref_Cache::add(const std::vector<uint8_t>& record, const std::string& ref_path, const uint64_t ref_id)
+{
+    if(ref_id > ref_path_.size())
+        ref_path_.resize(ref_id);
+    ref_path_[ref_id - 1] = ref_path;
+
+    append(record.data(), record.size());
+}
+
+
+void Ref_Cache::add(const char* const name, const char* const seq, const std::size_t seq_len, const std::string& ref_path, const uint64_t ref_id, const uint64_t seq_id)
+{
+    encode(name, seq, seq_len, ref_id, seq_id, record);
+    add(record, ref_path, ref_id);
+}
+
+
+void Ref_Cache::seal()
+{
+    if(spilled_)
+    {
+        flush();
+        spill_output.close();
+    }
+
+    sealed_ = true;
+}
+
+
+bool Ref_Cache::sealed() const
+{
+    return sealed_;
+}
+
+
+bool Ref_Cache::spilled() const
+{
+    return spilled_;
+}
+
+
+std::size_t Ref_Cache::size() const
+{
+    return size_;
+}
+
+
+void Ref_Cache::rewind()
+{
+    read_pos = 0;
+
+    if(spilled_)
+    {
+        spill_input.close();
+        spill_input.open(spill_file_path, std::ios::in | std::ios::binary);
+        if(!spill_input)
+        {
+            std::cerr << "Error opening the reference cache file " << spill_file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+bool Ref_Cache::fetch(void* const data, const std::size_t len)
+{
+    if(spilled_)
+    {
+        spill_input.read(static_cast<char*>(data), len);
+        return static_cast<std::size_t>(spill_input.gcount()) == len;
+    }
+
+    if(read_pos + len > buf.size())
+        return false;
+
+    std::memcpy(data, buf.data() + read_pos, len);
+    read_pos += len;
+
+    return true;
+}
+
+
+bool Ref_Cache::read_next_seq(std::string& seq, std::string& name, uint64_t& ref_id, uint64_t& seq_id)
+{
+    Record_Header header;
+    if(!fetch(&header, sizeof(header)))
+        return false;
+
+    ref_id = header.ref_id;
+    seq_id = header.seq_id;
+
+    name.resize(header.name_len);
+    n_run.resize(header.n_run_count);
+    packed.resize((header.seq_len + 3) / 4);
+    if(!fetch(&name[0], header.name_len) ||
+        !fetch(n_run.data(), n_run.size() * sizeof(n_run[0])) ||
+        !fetch(packed.data(), packed.size()))
+    {
+        std::cerr << "Truncated record encountered in the reference cache. Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+
+    // Unpack the bases, 4 at a time, and restore the placeholders.
+    seq.resize(packed.size() * 4);
+    for(std::size_t i = 0; i < packed.size(); ++i)
+        std::memcpy(&seq[i * 4], DECODED_BYTE[packed[i]].data(), 4);
+
+    seq.resize(header.seq_len);
+    for(const auto& run : n_run)
+        std::fill_n(seq.begin() + run.first, run.second, 'N');
+
+
+    return true;
+}
+
+
+const std::string& Ref_Cache::ref_path(const uint64_t ref_id) const
+{
+    return ref_path_[ref_id - 1];
+}
@@ -1,47 +1,129 @@
 
 #include "Ref_Parser.hpp"
 #include "Seq_Input.hpp"
+#include "BGZF_Reader.hpp"
+#include "Ref_Cache.hpp"
 #include "kseq/kseq.h"
 
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+
+
+// Reads up-to `len` bytes of the decompressed content of the reference currently being
+// parsed by `ref_parser` into `buf`; BGZF-compressed references are inflated in parallel,
+// and the rest through zlib's single stream.
+int read_reference(Ref_Parser* const ref_parser, void* const buf, const unsigned len)
+{
+    return ref_parser->bgzf_reader ? ref_parser->bgzf_reader->read(buf, len) : gzread(ref_parser->file_ptr, buf, len);
+}
 
 
 // Declare the type of file handler and the read() function.
 // Required for FASTA/FASTQ file reading using the kseq library.
-KSEQ_INIT(gzFile, gzread)
+KSEQ_INIT(Ref_Parser*, read_reference)
 
 
-Ref_Parser::Ref_Parser(const std::string& file_path)
+Ref_Parser::Ref_Parser(const std::string& file_path, const bool read_ahead):
+    read_ahead(read_ahead),
+    reader_count(1),
+    inflate_thread_count(0),
+    cache(nullptr),
+    replay(false)
 {
     ref_paths.push(file_path);
 
     // Open the first reference for subsequent parsing.
     open_next_reference();
+
+    if(read_ahead)
+        launch_read_ahead();
 }
 
 
-Ref_Parser::Ref_Parser(const Seq_Input& ref_input): Ref_Parser(ref_input.seqs())
+Ref_Parser::Ref_Parser(const Seq_Input& ref_input, const bool read_ahead, const uint16_t thread_count, Ref_Cache* const cache):
+    Ref_Parser(ref_input.seqs(), read_ahead, thread_count, cache)
 {
+    // The sequences are replayed from the cache by the background thread, without opening the references.
+    if(replay)
+    {
+        cache->rewind();
+        launch_read_ahead();
+        return;
+    }
+
+    // Multiple references are parsed concurrently by the reader threads themselves.
+    if(read_ahead && reader_count > 1 && ref_paths.size() > 1)
+    {
+        launch_multi_read_ahead();
+        return;
+    }
+
     // Open the first reference for subsequent parsing.
     open_next_reference();
+
+    if(read_ahead)
+        launch_read_ahead();
 }
 
 
-Ref_Parser::Ref_Parser(const std::vector<std::string>& refs):
-    ref_paths(std::deque<std::string>(refs.begin(), refs.end()))
+Ref_Parser::Ref_Parser(const std::vector<std::string>& refs, const bool read_ahead, const uint16_t thread_count, Ref_Cache* const cache):
+    ref_paths(std::deque<std::string>(refs.begin(), refs.end())),
+    read_ahead(read_ahead || (cache != nullptr && cache->sealed())),
+    reader_count(read_ahead ? reader_thread_count(refs, thread_count) : 1),
+    inflate_thread_count(thread_count / reader_count > BGZF_AUX_THREADS ? thread_count / reader_count - BGZF_AUX_THREADS : 0),
+    cache(cache),
+    replay(cache != nullptr && cache->sealed())
 {}
 
 
+uint16_t Ref_Parser::reader_thread_count(const std::vector<std::string>& refs, const uint16_t thread_count)
+{
+    // Half the threads parse the references concurrently, and the rest are left to inflate the BGZF ones;
+    // without any BGZF reference, all the threads parse.
+    const std::size_t max_readers = (has_BGZF(refs) ? thread_count / 2 : thread_count);
+    return static_cast<uint16_t>(std::max(std::min(refs.size(), max_readers), static_cast<std::size_t>(1)));
+}
+
+
+bool Ref_Parser::has_BGZF(const std::vector<std::string>& refs)
+{
+    return std::any_of(refs.cbegin(), refs.cend(), BGZF_Reader::is_BGZF);
+}
+
+
+uint16_t Ref_Parser::thread_demand(const Seq_Input& ref_input, const uint16_t thread_count)
+{
+    const std::vector<std::string> refs = ref_input.seqs();
+    const uint16_t readers = reader_thread_count(refs, thread_count);
+
+    // Threads beyond the readers are of use only in inflating the BGZF-compressed references.
+    return (thread_count / readers > BGZF_AUX_THREADS && has_BGZF(refs)) ? thread_count : readers;
+}
+
+
+Ref_Parser::~Ref_Parser()
+{
+    stop_read_ahead();
+}
+
+
 void Ref_Parser::open_reference(const std::string& reference_path)
 {
-    file_ptr = gzopen(reference_path.c_str(), "r");  // Open the file handler.
-    if(file_ptr == nullptr)
+    // A BGZF file is a valid gzip file too, so it's inflated through zlib without a thread to spare.
+    if(inflate_thread_count > 0 && BGZF_Reader::is_BGZF(reference_path))
+        bgzf_reader.reset(new BGZF_Reader(reference_path, inflate_thread_count));
+    else
     {
-        std::cerr << "Error opening reference file " << reference_path << ". Aborting.\n";
-        std::exit(EXIT_FAILURE);
+        file_ptr = gzopen(reference_path.c_str(), "r");  // Open the file handler.
+        if(file_ptr == nullptr)
+        {
+            std::cerr << "Error opening reference file " << reference_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
     }
 
-    parser = kseq_init(file_ptr);   // Initialize the kseq parser.
+    parser = kseq_init(this);   // Initialize the kseq parser.
 
     curr_ref_path = reference_path;
     ref_count++;
@@ -66,11 +148,11 @@ bool Ref_Parser::open_next_reference()
 
 const std::string& Ref_Parser::curr_ref() const
 {
-    return curr_ref_path;
+    return read_ahead ? record[head].ref_path : curr_ref_path;
 }
 
 
-bool Ref_Parser::read_next_seq()
+bool Ref_Parser::parse_next_seq()
 {
     // Sequences still remain at the current reference being parsed.
     if(parser != nullptr && kseq_read(parser) >= 0)
@@ -80,62 +162,370 @@ bool Ref_Parser::read_next_seq()
     }
 
     // The current reference has been parsed completely. Close its handles.
-    close();
+    close_reference();
 
     // Start parsing the next reference, if exists.
     if(open_next_reference())
-        return read_next_seq();
+        return parse_next_seq();
 
     return false;
 }
 
 
+bool Ref_Parser::read_next_seq()
+{
+    const bool read = (read_ahead ? fetch_next_seq() : parse_next_seq_timed());
+
+    // Record the sequence into the cache, if one is being filled.
+    if(cache != nullptr && !replay)
+    {
+        if(read)
+        {
+            if(read_ahead)  // The sequence has been encoded by its parser thread.
+                cache->add(record[head].cache_record, curr_ref(), ref_id());
+            else
+                cache->add(seq_name(), seq(), seq_len(), curr_ref(), ref_id(), seq_id());
+        }
+        else if(!cache->sealed())
+            cache->seal();
+    }
+
+
+    return read;
+}
+
+
+bool Ref_Parser::parse_next_seq_timed()
+{
+    const auto t_start = std::chrono::high_resolution_clock::now();
+    const bool parsed = parse_next_seq();
+    const auto t_end = std::chrono::high_resolution_clock::now();
+    parse_time_ += std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count();
+
+    return parsed;
+}
+
+
+bool Ref_Parser::fetch_next_seq()
+{
+    const auto t_start = std::chrono::high_resolution_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if(!ref_queue.empty())
+        curr_seq = pop_next_seq(lock);
+    else
+    {
+        // Free the buffer of the current sequence. An outsized buffer is released rather than kept for reuse.
+        if(curr_seq)
+        {
+            buffered_bytes -= record[head].bytes();
+            if(record[head].bytes() > READ_AHEAD_IDLE_BUF_MEMORY)
+            {
+                std::string().swap(record[head].seq);
+                std::vector<uint8_t>().swap(record[head].cache_record);
+            }
+
+            head = (head + 1) % READ_AHEAD_BUF_COUNT;
+            filled--;
+            curr_seq = false;
+
+            seq_freed.notify_one();
+        }
+
+        seq_filled.wait(lock, [this](){ return filled > 0 || parse_done; });
+        curr_seq = (filled > 0);
+    }
+
+    lock.unlock();
+    const auto t_end = std::chrono::high_resolution_clock::now();
+    wait_time_ += std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count();
+
+    return curr_seq;
+}
+
+
+void Ref_Parser::launch_read_ahead()
+{
+    record.resize(READ_AHEAD_BUF_COUNT);
+
+    reader.emplace_back(&Ref_Parser::read_ahead_seqs, this);
+}
+
+
+void Ref_Parser::read_ahead_seqs()
+{
+    Seq_Record replayed;    // Sequence replayed from the cache, if it's being replayed.
+
+    while(true)
+    {
+        const auto t_start = std::chrono::high_resolution_clock::now();
+        const bool parsed = (replay ?   cache->read_next_seq(replayed.seq, replayed.name, replayed.ref_id, replayed.seq_id) :
+                                        parse_next_seq());
+        const auto t_end = std::chrono::high_resolution_clock::now();
+        parse_time_ += std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(!parsed)
+        {
+            parse_done = true;
+            seq_filled.notify_one();
+
+            return;
+        }
+
+        // Wait for a free buffer, keeping the sequences parsed ahead within the memory limit.
+        const std::size_t len = (replay ? replayed.seq.size() : parser->seq.l);
+        seq_freed.wait(lock,
+            [this, len]()
+            {
+                return stop || (filled < READ_AHEAD_BUF_COUNT && (filled == 0 || buffered_bytes + len <= READ_AHEAD_MEMORY));
+            });
+
+        if(stop)
+            return;
+
+        // The ring is only ever appended to by this thread, so the buffer can be filled outside the lock.
+        Seq_Record& rec = record[(head + filled) % READ_AHEAD_BUF_COUNT];
+        lock.unlock();
+
+        if(replay)
+        {
+            std::swap(rec, replayed);   // The replaced buffers are reused for the next replay.
+            rec.ref_path = cache->ref_path(rec.ref_id);
+        }
+        else
+        {
+            rec.seq.assign(parser->seq.s, len);
+            rec.name.assign(parser->name.s, parser->name.l);
+            rec.ref_path = curr_ref_path;
+            rec.ref_id = ref_count;
+            rec.seq_id = seq_id_;
+
+            if(cache != nullptr)
+                Ref_Cache::encode(rec.name.c_str(), rec.seq.data(), len, rec.ref_id, rec.seq_id, rec.cache_record);
+        }
+
+        lock.lock();
+        buffered_bytes += rec.bytes();
+        filled++;
+        seq_filled.notify_one();
+    }
+}
+
+
+void Ref_Parser::launch_multi_read_ahead()
+{
+    record.resize(READ_AHEAD_BUF_COUNT);    // Only the head of the ring is used, to hold the current sequence.
+
+    for(; !ref_paths.empty(); ref_paths.pop())
+        ref_path_list.emplace_back(ref_paths.front());
+
+    ref_queue.resize(std::min(static_cast<std::size_t>(reader_count) * REF_WINDOW_PER_READER, ref_path_list.size()));
+
+    for(uint16_t t_id = 0; t_id < reader_count; ++t_id)
+        reader.emplace_back(&Ref_Parser::read_ahead_refs, this);
+}
+
+
+void Ref_Parser::read_ahead_refs()
+{
+    const uint64_t ref_total = ref_path_list.size();
+    const uint64_t window = ref_queue.size();
+
+    while(true)
+    {
+        // Claim the next reference, keeping the references parsed ahead within the window.
+        std::unique_lock<std::mutex> lock(mutex_);
+        seq_freed.wait(lock, [this, ref_total, window](){ return stop || next_ref >= ref_total || next_ref < curr_ref_idx + window; });
+        if(stop || next_ref >= ref_total)
+            return;
+
+        const uint64_t ref_idx = next_ref++;
+        Ref_Queue& queue = ref_queue[ref_idx % window];
+        lock.unlock();
+
+
+        // A synchronous parser for just this reference, numbered as per its position in the collection.
+        Ref_Parser ref_parser(std::vector<std::string>(1, ref_path_list[ref_idx]), false, 1, nullptr);
+        ref_parser.inflate_thread_count = inflate_thread_count;
+        ref_parser.ref_count = ref_idx;
+        ref_parser.open_next_reference();
+
+        while(ref_parser.read_next_seq())
+        {
+            Seq_Record rec;
+            rec.seq.assign(ref_parser.seq(), ref_parser.seq_len());
+            rec.name.assign(ref_parser.seq_name());
+            rec.ref_path = ref_parser.curr_ref();
+            rec.ref_id = ref_parser.ref_id();
+            rec.seq_id = ref_parser.seq_id();
+
+            if(cache != nullptr)
+                Ref_Cache::encode(rec.name.c_str(), rec.seq.data(), rec.seq.size(), rec.ref_id, rec.seq_id, rec.cache_record);
+
+            // Wait for memory to buffer the sequence, unless it's from the reference being read from.
+            const std::size_t len = rec.bytes();
+            lock.lock();
+            seq_freed.wait(lock,
+                [this, ref_idx, len]()
+                {
+                    return stop || ref_idx == curr_ref_idx || buffered_bytes + len <= READ_AHEAD_MEMORY;
+                });
+
+            if(stop)
+            {
+                lock.unlock();
+                ref_parser.close();
+                return;
+            }
+
+            queue.seq.emplace_back(std::move(rec));
+            buffered_bytes += len;
+            seq_filled.notify_one();
+            lock.unlock();
+        }
+
+        ref_parser.close();
+
+        lock.lock();
+        parse_time_ += ref_parser.parse_time();
+        queue.parsed = true;
+        seq_filled.notify_one();
+    }
+}
+
+
+bool Ref_Parser::pop_next_seq(std::unique_lock<std::mutex>& lock)
+{
+    const uint64_t ref_total = ref_path_list.size();
+    const uint64_t window = ref_queue.size();
+
+    // Free the buffer of the current sequence.
+    if(curr_seq)
+    {
+        buffered_bytes -= record[head].bytes();
+        curr_seq = false;
+
+        seq_freed.notify_all();
+    }
+
+    while(curr_ref_idx < ref_total)
+    {
+        Ref_Queue& queue = ref_queue[curr_ref_idx % window];
+        seq_filled.wait(lock, [&queue](){ return !queue.seq.empty() || queue.parsed; });
+
+        if(!queue.seq.empty())
+        {
+            record[head] = std::move(queue.seq.front());
+            queue.seq.pop_front();
+
+            return true;
+        }
+
+        // The reference has been read completely; its queue is freed for a later reference.
+        queue.parsed = false;
+        curr_ref_idx++;
+        seq_freed.notify_all();
+    }
+
+
+    return false;
+}
+
+
+void Ref_Parser::stop_read_ahead()
+{
+    if(reader.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop = true;
+    seq_freed.notify_all();
+    lock.unlock();
+
+    for(auto& t : reader)
+    {
+        if(!t.joinable())
+        {
+            std::cerr << "Early termination encountered for the reference parser thread. Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        t.join();
+    }
+
+    reader.clear();
+}
+
+
 const char* Ref_Parser::seq() const
 {
-    return parser->seq.s;
+    return read_ahead ? record[head].seq.data() : parser->seq.s;
 }
 
 
 size_t Ref_Parser::seq_len() const
 {
-    return parser->seq.l;
+    return read_ahead ? record[head].seq.size() : parser->seq.l;
 }
 
 
 size_t Ref_Parser::buff_sz() const
 {
-    return parser->seq.m;
+    return read_ahead ? record[head].seq.capacity() : parser->seq.m;
 }
 
 
 uint64_t Ref_Parser::ref_id() const
 {
-    return ref_count;
+    return read_ahead ? record[head].ref_id : ref_count;
 }
 
 
 uint64_t Ref_Parser::seq_id() const
 {
-    return seq_id_;
+    return read_ahead ? record[head].seq_id : seq_id_;
 }
 
 
 const char* Ref_Parser::seq_name() const
 {
-    return parser->name.s;
+    return read_ahead ? record[head].name.c_str() : parser->name.s;
+}
+
+
+double Ref_Parser::parse_time() const
+{
+    return parse_time_;
+}
+
+
+double Ref_Parser::wait_time() const
+{
+    return wait_time_;
 }
 
 
 void Ref_Parser::close()
 {
-    if(file_ptr != nullptr)
+    stop_read_ahead();
+    close_reference();
+}
+
+
+void Ref_Parser::close_reference()
+{
+    if(parser != nullptr)
     {
         kseq_destroy(parser);   // Close the kseq parser.
-        gzclose(file_ptr);  // Close the file handler.
+        if(bgzf_reader)
+            bgzf_reader.reset();    // Close the BGZF reader.
+        else
+            gzclose(file_ptr);  // Close the file handler.
 
         parser = nullptr;
         file_ptr = nullptr;
 
-        std::cerr << "\rClosed reference " << curr_ref() << ".\n";
+        std::cerr << "\rClosed reference " << curr_ref_path << ".\n";
     }
 }
@@ -1,218 +1,140 @@
 
 #include "Thread_Pool.hpp"
-#include "Kmer_SPMC_Iterator.hpp"
-#include "CdBG.hpp"
-#include "Read_CdBG_Constructor.hpp"
-#include "Read_CdBG_Extractor.hpp"
 
 #include <iostream>
 
 
-template <uint16_t k>
-Thread_Pool<k>::Thread_Pool(const uint16_t thread_count, void* const dBG, const Task_Type task_type):
+Thread_Pool::Thread_Pool(const uint16_t thread_count):
     thread_count(thread_count),
-    dBG(dBG),
-    task_type(task_type),
-    task_status(new volatile Task_Status[thread_count])
+    task_deque(new Task_Deque[thread_count]),
+    queued_count(0),
+    pending_count(0),
+    closed(false),
+    next_deque(0)
 {
-    // Mark the status of the task for each thread as `pending`.
-    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
-        task_status[t_id] = Task_Status::pending;
-
-    
-    // Resize the parameters collections.
-    switch(task_type)
-    {
-    case Task_Type::classification:
-        classify_params.resize(thread_count);
-        break;
-    
-    case Task_Type::output_plain:
-    case Task_Type::output_gfa:
-    case Task_Type::output_gfa_reduced:
-        output_params.resize(thread_count);
-        break;
-
-    case Task_Type::compute_states_read_space:
-    case Task_Type::extract_unipaths_read_space:
-        read_dBG_compaction_params.resize(thread_count);
-        break;
-
-    default:
-        std::cerr << "Unrecognized task type encountered in thread pool. Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
-
-
     // Launch the threads.
     for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
-        thread_pool.emplace_back(&Thread_Pool::task, this, t_id);
+        thread_pool.emplace_back(&Thread_Pool::run, this, t_id);
 }
 
 
-template <uint16_t k>
-void Thread_Pool<k>::task(const uint16_t thread_id)
+void Thread_Pool::push(const uint16_t thread_id, Task task)
 {
-    while(true)
-    {
-        // Busy-wait for some task.
-        while(task_status[thread_id] == Task_Status::pending);
-
-        // No more tasks to come in on the future.
-        if(task_status[thread_id] == Task_Status::no_more)
-            return;
+    pending_count++;
 
+    Task_Deque& deque = task_deque[thread_id];
+    deque.lock.lock();
+    deque.task.emplace_back(std::move(task));
+    deque.lock.unlock();
 
-        // Some task is available for the thread number `thread_id`.
-        if(task_status[thread_id] == Task_Status::available)
-        {
-            switch(task_type)
-            {
-            case Task_Type::classification:
-                {
-                    const Classification_Task_Params& params = classify_params[thread_id];
-                    static_cast<CdBG<k>*>(dBG)->process_substring(params.seq, params.seq_len, params.left_end, params.right_end);
-                }
-                break;
-
-            case Task_Type::output_plain:
-                {
-                    const Output_Task_Params& params = output_params[thread_id];
-                    static_cast<CdBG<k>*>(dBG)->output_plain_off_substring(params.thread_id, params.seq, params.seq_len, params.left_end, params.right_end);
-                }
-                break;
-
-            case Task_Type::output_gfa:
-            case Task_Type::output_gfa_reduced:
-                {
-                    const Output_Task_Params& params = output_params[thread_id];
-                    static_cast<CdBG<k>*>(dBG)->output_gfa_off_substring(params.thread_id, params.seq, params.seq_len, params.left_end, params.right_end);
-                }
-                break;
-            
-            case Task_Type::compute_states_read_space:
-                {
-                    const Read_dBG_Compaction_Params& params = read_dBG_compaction_params[thread_id];
-                    static_cast<Read_CdBG_Constructor<k>*>(dBG)->
-                        process_edges(static_cast<Kmer_SPMC_Iterator<k + 1>*>(params.parser), params.thread_id);
-                }
-                break;
-
-            case Task_Type::extract_unipaths_read_space:
-                {
-                    const Read_dBG_Compaction_Params& params = read_dBG_compaction_params[thread_id];
-                    static_cast<Read_CdBG_Extractor<k>*>(dBG)->
-                        process_vertices(static_cast<Kmer_SPMC_Iterator<k>*>(params.parser), params.thread_id);
-                }
-                break;
-            }
-
-
-            free_thread(thread_id);
-        }
-    }
+    queued_count++;
+    work_event.notify_all();
 }
 
 
-template <uint16_t k>
-uint16_t Thread_Pool<k>::get_idle_thread() const
+bool Thread_Pool::pop(const uint16_t thread_id, Task& task)
 {
-    int32_t idle_thread_id = -1;
-    uint16_t t_id = 0;
+    Task_Deque& deque = task_deque[thread_id];
+    deque.lock.lock();
+
+    const bool found = !deque.task.empty();
+    if(found)
+    {
+        task = std::move(deque.task.back());
+        deque.task.pop_back();
+        queued_count--;
+    }
 
-    while(idle_thread_id == -1)
-        if(task_status[t_id] == Task_Status::pending)
-            idle_thread_id = t_id;
-        else
-            t_id = (t_id + 1) % thread_count;
+    deque.lock.unlock();
 
-    
-    return idle_thread_id;
+    return found;
 }
 
 
-template <uint16_t k>
-void Thread_Pool<k>::get_thread(const uint16_t thread_id) const
+bool Thread_Pool::steal(const uint16_t thread_id, Task& task)
 {
-    while(task_status[thread_id] != Task_Status::pending);
-}
+    for(uint16_t i = 1; i < thread_count; ++i)
+    {
+        Task_Deque& deque = task_deque[(thread_id + i) % thread_count];
+        deque.lock.lock();
+
+        const bool found = !deque.task.empty();
+        if(found)
+        {
+            task = std::move(deque.task.front());
+            deque.task.pop_front();
+            queued_count--;
+        }
 
+        deque.lock.unlock();
 
-template <uint16_t k>
-void Thread_Pool<k>::assign_classification_task(const uint16_t thread_id, const char* const seq, const size_t seq_len, const size_t left_end, const size_t right_end)
-{
-    classify_params[thread_id] = Classification_Task_Params(seq, seq_len, left_end, right_end);
+        if(found)
+            return true;
+    }
 
-    assign_task(thread_id);
+
+    return false;
 }
 
 
-template <uint16_t k>
-void Thread_Pool<k>::assign_output_task(const uint16_t thread_id, const char* const seq, const size_t seq_len, const size_t left_end, const size_t right_end)
+void Thread_Pool::run(const uint16_t thread_id)
 {
-    output_params[thread_id] = Output_Task_Params(thread_id, seq, seq_len, left_end, right_end);
+    Task task;
 
-    assign_task(thread_id);
-}
+    while(true)
+    {
+        if(pop(thread_id, task) || steal(thread_id, task))
+        {
+            task(thread_id);
+            task = nullptr; // Release the resources captured by the task.
 
+            pending_count--;
+            done_event.notify_all();
 
-template <uint16_t k>
-void Thread_Pool<k>::assign_read_dBG_compaction_task(void* const parser, const uint16_t thread_id)
-{
-    read_dBG_compaction_params[thread_id] = Read_dBG_Compaction_Params(parser, thread_id);
+            continue;
+        }
 
-    assign_task(thread_id);
-}
 
+        // Wait for some task.
+        work_event.await([this](){ return queued_count > 0 || closed; });
 
-template <uint16_t k>
-void Thread_Pool<k>::assign_task(const uint16_t thread_id)
-{
-    if(task_status[thread_id] != Task_Status::pending)
-    {
-        std::cerr << "Expected thread " << thread_id << " to be idle while assigning a job, but found it unexpecedly busy. Aborting.\n";
-        std::exit(EXIT_FAILURE);
+        // No more tasks to come in on the future.
+        if(closed && queued_count == 0)
+            return;
     }
-
-    
-    task_status[thread_id] = Task_Status::available;
 }
 
 
-template <uint16_t k>
-void Thread_Pool<k>::free_thread(const uint16_t thread_id)
+void Thread_Pool::submit(Task task)
 {
-    if(task_status[thread_id] != Task_Status::available)
-    {
-        std::cerr << "Expected thread " << thread_id << " to be busy while assigning a job, but found it unexpecedly free. Aborting.\n";
-        std::exit(EXIT_FAILURE);
-    }
+    push(next_deque.fetch_add(1, std::memory_order_relaxed) % thread_count, std::move(task));
+}
 
 
-    task_status[thread_id] = Task_Status::pending;
+void Thread_Pool::wait_pending(const uint64_t max_pending)
+{
+    done_event.await([this, max_pending](){ return pending_count <= max_pending; });
 }
 
 
-template <uint16_t k>
-void Thread_Pool<k>::wait_completion() const
+void Thread_Pool::wait_completion()
 {
-    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
-        while(task_status[t_id] == Task_Status::available);
+    wait_pending(0);
 }
 
 
-template <uint16_t k>
-void Thread_Pool<k>::close()
+void Thread_Pool::close()
 {
     // Wait for all the threads to finish.
     wait_completion();
 
+    // Signal the threads to stop running.
+    closed = true;
+    work_event.notify_all();
+
     // Close all the threads.
     for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
     {
-        // Signal each thread to stop running.
-        task_status[t_id] = Task_Status::no_more;
-        
         if(!thread_pool[t_id].joinable())
         {
             std::cerr << "Early termination of a worker thread encountered. Aborting.\n";
@@ -221,12 +143,4 @@ void Thread_Pool<k>::close()
 
         thread_pool[t_id].join();
     }
-
-
-    delete[] task_status;
 }
-
-
-
-// Template instantiations for the required instances.
-ENUMERATE(INSTANCE_COUNT, INSTANTIATE, Thread_Pool)
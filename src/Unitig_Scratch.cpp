@@ -3,11 +3,11 @@
 
 
 template <uint16_t k>
-Unitig_Scratch<k>::Unitig_Scratch()
-{
-    label_.reserve(BUFF_SZ + k - 1),
-    hash_.reserve(BUFF_SZ);
-}
+Unitig_Scratch<k>::Unitig_Scratch(Slab_Arena<char>& label_arena, Slab_Arena<uint64_t>& hash_arena):
+    label_(label_arena),
+    hash_(hash_arena),
+    kmer_label(k)
+{}
 
 
 
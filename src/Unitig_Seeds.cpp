@@ -0,0 +1,127 @@
+
+#include "Unitig_Seeds.hpp"
+#include "globals.hpp"
+
+#include <algorithm>
+
+
+template <uint16_t k>
+Unitig_Seeds<k>::Unitig_Seeds(const uint64_t vertex_count, const uint16_t thread_count, const std::size_t max_memory):
+    thread_count(thread_count),
+    max_seeds_per_thread(std::min<uint64_t>((max_memory > tracking_memory(vertex_count) ? max_memory - tracking_memory(vertex_count) : 0) / (sizeof(Kmer<k>) * thread_count), vertex_count)),
+    recorded(vertex_count),
+    list(new Seed_List[thread_count]),
+    overflown(false),
+    cover_dropped(false)
+{
+    recorded.clear_mem();
+
+    // The lists are reserved at their limits, so that their growths do not transiently exceed the
+    // budget; the reserved memory is only backed as the seeds get recorded.
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+    {
+        list[t_id].seed.reserve(max_seeds_per_thread);
+        list[t_id].cover.reserve(max_seeds_per_thread);
+        list[t_id].consumed = 0;
+    }
+}
+
+
+template <uint16_t k>
+std::size_t Unitig_Seeds<k>::tracking_memory(const uint64_t vertex_count)
+{
+    return Atomic_Bit_Vector<1>::bytes_for(vertex_count);
+}
+
+
+template <uint16_t k>
+void Unitig_Seeds<k>::seal()
+{
+    recorded.clear();
+
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+    {
+        if(overflown)
+            std::vector<Kmer<k>>().swap(list[t_id].seed);
+
+        if(overflown || cover_dropped)
+            std::vector<Kmer<k>>().swap(list[t_id].cover);
+    }
+
+    sealed = true;
+}
+
+
+template <uint16_t k>
+bool Unitig_Seeds<k>::usable() const
+{
+    return sealed && !overflown;
+}
+
+
+template <uint16_t k>
+bool Unitig_Seeds<k>::complete() const
+{
+    return usable() && !cover_dropped;
+}
+
+
+template <uint16_t k>
+uint64_t Unitig_Seeds<k>::size() const
+{
+    uint64_t seed_count = 0;
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        seed_count += list[t_id].seed.size() + list[t_id].cover.size();
+
+    return seed_count;
+}
+
+
+template <uint16_t k>
+bool Unitig_Seeds<k>::tasks_expected(uint16_t) const
+{
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        if(list[t_id].consumed < list[t_id].seed.size() + list[t_id].cover.size())
+            return true;
+
+    return false;
+}
+
+
+template <uint16_t k>
+std::size_t Unitig_Seeds<k>::next_chunk(const uint16_t thread_id, Kmer<k>* const out, const std::size_t max)
+{
+    // Claim from the thread's own list first, and then from the others'.
+    for(uint16_t j = 0; j < thread_count; ++j)
+    {
+        Seed_List& l = list[(thread_id + j) % thread_count];
+        const uint64_t seed_count = l.seed.size() + l.cover.size();
+        if(l.consumed >= seed_count)
+            continue;
+
+        const uint64_t idx = l.consumed.fetch_add(max);
+        if(idx >= seed_count)
+            continue;
+
+        // The chunk spans the flanking seeds and then the cover seeds.
+        const std::size_t n = std::min(static_cast<std::size_t>(seed_count - idx), max);
+        if(idx >= l.seed.size())
+            std::copy_n(l.cover.begin() + (idx - l.seed.size()), n, out);
+        else
+        {
+            const std::size_t n_seed = std::min(static_cast<std::size_t>(l.seed.size() - idx), n);
+            std::copy_n(l.seed.begin() + idx, n_seed, out);
+            std::copy_n(l.cover.begin(), n - n_seed, out + n_seed);
+        }
+
+        return n;
+    }
+
+
+    return 0;
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, Unitig_Seeds)
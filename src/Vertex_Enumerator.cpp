@@ -0,0 +1,313 @@
+
+#include "Vertex_Enumerator.hpp"
+#include "Kmer_DB_Writer.hpp"
+#include "Kmer_Container.hpp"
+#include "Kmer_SPMC_Iterator.hpp"
+#include "globals.hpp"
+
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+
+template <uint16_t k>
+Vertex_Enumerator<k>::Vertex_Enumerator(const uint16_t thread_count, const std::string& temp_file_prefix):
+    thread_count(thread_count),
+    temp_file_prefix(temp_file_prefix),
+    bucket_file(bucket_count),
+    bucket_size(bucket_count, 0),
+    lock(new Spin_Lock[bucket_count])
+{}
+
+
+template <uint16_t k>
+std::string Vertex_Enumerator<k>::bucket_file_path(const std::size_t b) const
+{
+    return temp_file_prefix + "vertex_bucket_" + std::to_string(b);
+}
+
+
+template <uint16_t k>
+kmer_Enumeration_Stats<k> Vertex_Enumerator<k>::enumerate(const std::string& edge_db_path, const std::size_t max_memory, const std::string& vertex_db_path)
+{
+    const Kmer_Container<k + 1> edge_container(edge_db_path);
+    const uint64_t edge_count = edge_container.size();
+
+    for(std::size_t b = 0; b < bucket_count; ++b)
+    {
+        bucket_file[b].open(bucket_file_path(b), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if(bucket_file[b].fail())
+        {
+            std::cerr << "Error opening temporary file " << bucket_file_path(b) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+
+    // Split the edges into vertices, distributing those to the buckets.
+    Kmer_SPMC_Iterator<k + 1> parser(&edge_container, thread_count);
+    parser.launch_production();
+
+    std::vector<std::thread> worker;
+    worker.reserve(thread_count);
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        worker.emplace_back(&Vertex_Enumerator::split_edges, this, std::ref(parser), t_id);
+
+    parser.seize_production();
+
+    for(auto& w : worker)
+        w.join();
+
+    uint64_t bucketed_count = 0;
+    for(std::size_t b = 0; b < bucket_count; ++b)
+    {
+        bucket_file[b].close();
+        if(bucket_file[b].fail())
+        {
+            std::cerr << "Error writing to temporary file " << bucket_file_path(b) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        bucketed_count += bucket_size[b];
+    }
+
+
+    // Sort the buckets and write out the distinct vertices.
+    Kmer_DB_Writer<k> writer(vertex_db_path, edge_count);
+    sort_buckets(writer, max_memory * 1024U * 1024U * 1024U);
+    writer.close();
+
+
+    KMC::Stage1Results stage1_results{};
+    KMC::Stage2Results stage2_results{};
+    stage2_results.nTotalKmers = 2 * edge_count;
+    stage2_results.nUniqueKmers = writer.kmer_count();
+    stage2_results.nBelowCutoffMin = 0;
+    stage2_results.nAboveCutoffMax = 0;
+    stage2_results.maxDiskUsage = bucketed_count * sizeof(Kmer<k>);
+
+    return kmer_Enumeration_Stats<k>(stage1_results, stage2_results, max_memory, Kmer_Container<k>::database_size(vertex_db_path));
+}
+
+
+template <uint16_t k>
+void Vertex_Enumerator<k>::split_edges(Kmer_SPMC_Iterator<k + 1>& parser, const uint16_t thread_id)
+{
+    std::vector<std::vector<Kmer<k>>> buf(bucket_count);    // Vertices buffered per bucket.
+
+    // Deduplicates the buffer of the bucket `b` and writes it to disk; so
+    // that the repeated vertices of a neighborhood do not reach the disk.
+    const auto flush =
+        [&](const std::size_t b)
+        {
+            std::sort(buf[b].begin(), buf[b].end());
+            buf[b].erase(std::unique(buf[b].begin(), buf[b].end()), buf[b].end());
+
+            lock[b].lock();
+            bucket_file[b].write(reinterpret_cast<const char*>(buf[b].data()), buf[b].size() * sizeof(Kmer<k>));
+            bucket_size[b] += buf[b].size();
+            lock[b].unlock();
+
+            buf[b].clear();
+        };
+
+    const auto add_vertex =
+        [&](const Kmer<k>& v)
+        {
+            const std::size_t b = v.template leading_bases<bucket_prefix_len>();
+            buf[b].push_back(v);
+            if(buf[b].size() == vertex_buf_size)
+                flush(b);
+        };
+
+
+    Kmer<k + 1> e;
+    Kmer<k> u, v;
+    while(parser.tasks_expected(thread_id))
+        if(parser.value_at(thread_id, e))
+        {
+            u.from_prefix(e);
+            v.from_suffix(e);
+
+            add_vertex(u.canonical());
+            add_vertex(v.canonical());
+        }
+
+    for(std::size_t b = 0; b < bucket_count; ++b)
+        if(!buf[b].empty())
+            flush(b);
+}
+
+
+template <uint16_t k>
+void Vertex_Enumerator<k>::sort_buckets(Kmer_DB_Writer<k>& writer, const std::size_t max_memory)
+{
+    // Each sorter holds one bucket at a time, within an equal share of the memory bound; the buckets
+    // exceeding the share are split further. The share is kept to at least that of a split's buffer.
+    const uint16_t sorter_count = static_cast<uint16_t>(std::min(static_cast<std::size_t>(thread_count), bucket_count));
+    const std::size_t vertex_memory = sizeof(Kmer<k>) + writer.record_size();
+    const std::size_t sorter_memory = std::max(max_memory / sorter_count, split_buf_size * vertex_memory);
+
+    std::atomic<std::size_t> next_bucket(0);
+    std::size_t written = 0;    // Number of buckets written to the database.
+    std::mutex write_lock;
+    std::condition_variable write_turn;
+
+    const auto sort_and_write =
+        [&]()
+        {
+            std::vector<Kmer<k>> vertices;
+            std::vector<uint8_t> suff_buf;
+            std::vector<std::pair<uint64_t, uint64_t>> pref_runs;
+            std::size_t b;
+            while((b = next_bucket++) < bucket_count)
+            {
+                const std::string file_path = bucket_file_path(b);
+                const bool fits = (bucket_size[b] * vertex_memory <= sorter_memory);
+                if(fits)
+                {
+                    load_bucket(file_path, bucket_size[b], vertices);
+                    writer.encode(vertices.data(), vertices.size(), suff_buf, pref_runs);
+                }
+
+                // The buckets are written in order, as the database is sorted. An oversized bucket
+                // is written in parts, over its turn.
+                std::unique_lock<std::mutex> turn(write_lock);
+                write_turn.wait(turn, [&](){ return written == b; });
+                if(fits)
+                    writer.append(suff_buf, pref_runs);
+                else
+                {
+                    turn.unlock();
+                    write_split_bucket(file_path, bucket_size[b], bucket_prefix_len, sorter_memory, writer, vertices, suff_buf, pref_runs);
+                    turn.lock();
+                }
+
+                written++;
+                turn.unlock();
+
+                write_turn.notify_all();
+            }
+        };
+
+
+    std::vector<std::thread> sorter;
+    sorter.reserve(sorter_count);
+    for(uint16_t t_id = 0; t_id < sorter_count; ++t_id)
+        sorter.emplace_back(sort_and_write);
+
+    for(auto& s : sorter)
+        s.join();
+}
+
+
+template <uint16_t k>
+void Vertex_Enumerator<k>::load_bucket(const std::string& file_path, const uint64_t size, std::vector<Kmer<k>>& vertices)
+{
+    vertices.resize(size);
+    if(!vertices.empty())
+    {
+        std::ifstream input(file_path.c_str(), std::ifstream::in | std::ifstream::binary);
+        input.read(reinterpret_cast<char*>(vertices.data()), vertices.size() * sizeof(Kmer<k>));
+        if(input.fail())
+        {
+            std::cerr << "Error reading temporary file " << file_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    std::remove(file_path.c_str());
+
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+}
+
+
+template <uint16_t k>
+void Vertex_Enumerator<k>::split_bucket(const std::string& file_path, const uint16_t prefix_len, std::vector<uint64_t>& sub_size)
+{
+    const uint16_t split_len = std::min(split_prefix_len, static_cast<uint16_t>(k - prefix_len));
+    const std::size_t sub_count = static_cast<std::size_t>(1) << (2 * split_len);
+
+    std::vector<std::ofstream> sub_file(sub_count);
+    for(std::size_t s = 0; s < sub_count; ++s)
+    {
+        const std::string sub_path = file_path + "_" + std::to_string(s);
+        sub_file[s].open(sub_path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if(sub_file[s].fail())
+        {
+            std::cerr << "Error opening temporary file " << sub_path << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    sub_size.assign(sub_count, 0);
+
+    std::ifstream input(file_path.c_str(), std::ifstream::in | std::ifstream::binary);
+    std::vector<Kmer<k>> buf(split_buf_size);
+    while(input)
+    {
+        input.read(reinterpret_cast<char*>(buf.data()), buf.size() * sizeof(Kmer<k>));
+        const std::size_t n = input.gcount() / sizeof(Kmer<k>);
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            const std::size_t s = buf[i].bases_at(prefix_len, split_len);
+            sub_file[s].write(reinterpret_cast<const char*>(&buf[i]), sizeof(Kmer<k>));
+            sub_size[s]++;
+        }
+    }
+
+    if(input.bad())
+    {
+        std::cerr << "Error reading temporary file " << file_path << ". Aborting.\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    input.close();
+    std::remove(file_path.c_str());
+
+    for(std::size_t s = 0; s < sub_count; ++s)
+    {
+        sub_file[s].close();
+        if(sub_file[s].fail())
+        {
+            std::cerr << "Error writing to temporary file " << file_path + "_" + std::to_string(s) << ". Aborting.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+template <uint16_t k>
+void Vertex_Enumerator<k>::write_split_bucket(const std::string& file_path, const uint64_t size, const uint16_t prefix_len, const std::size_t max_memory, Kmer_DB_Writer<k>& writer, std::vector<Kmer<k>>& vertices, std::vector<uint8_t>& suff_buf, std::vector<std::pair<uint64_t, uint64_t>>& pref_runs)
+{
+    const std::size_t vertex_memory = sizeof(Kmer<k>) + writer.record_size();
+
+    // A bucket of whole vertices can not be split further; it is all duplicates, though.
+    if(size * vertex_memory <= max_memory || prefix_len == k)
+    {
+        load_bucket(file_path, size, vertices);
+        writer.encode(vertices.data(), vertices.size(), suff_buf, pref_runs);
+        writer.append(suff_buf, pref_runs);
+
+        return;
+    }
+
+
+    std::vector<uint64_t> sub_size;
+    split_bucket(file_path, prefix_len, sub_size);
+
+    const uint16_t split_len = std::min(split_prefix_len, static_cast<uint16_t>(k - prefix_len));
+    for(std::size_t s = 0; s < sub_size.size(); ++s)
+        write_split_bucket(file_path + "_" + std::to_string(s), sub_size[s], prefix_len + split_len, max_memory, writer, vertices, suff_buf, pref_runs);
+}
+
+
+
+// Template instantiations for the required instances.
+ENUMERATE(INSTANCE_COUNT, INSTANTIATE, Vertex_Enumerator)
@@ -74,6 +74,13 @@ int cf_build(int argc, char** argv)
         ("save-mph", "save the minimal perfect hash (BBHash) over the vertex set")
         ("save-buckets", "save the DFA-states collection of the vertices")
         ("save-vertices", "save the vertex set of the graph")
+        ("populate-loads", "read saved MPHF and buckets fully into memory at load, instead of on-demand")
+        ("hugetlb", "back the hash table with explicitly reserved (hugetlbfs) huge pages, if available")
+        ("partitions", "number of minimizer-partitions of the hash table",
+            cxxopts::value<uint64_t>()->default_value(std::to_string(cuttlefish::_default::PARTITION_COUNT)))
+        ("in-mem", "keep the edge and the vertex databases in memory, instead of in the working directory")
+        ("cache-refs", "cache the 2-bit encoded references from the first pass over them, instead of re-parsing them for the output")
+        ("direct-io", "write the output with direct I/O, bypassing the page cache")
         ;
 
     options.add_options("debug")
@@ -113,6 +120,12 @@ int cf_build(int argc, char** argv)
         const auto save_mph = result["save-mph"].as<bool>();
         const auto save_buckets = result["save-buckets"].as<bool>();
         const auto save_vertices = result["save-vertices"].as<bool>();
+        const auto populate_loads = result["populate-loads"].as<bool>();
+        const auto explicit_huge_pages = result["hugetlb"].as<bool>();
+        const auto partition_count = result["partitions"].as<uint64_t>();
+        const auto in_memory_dbs = result["in-mem"].as<bool>();
+        const auto cache_refs = result["cache-refs"].as<bool>();
+        const auto direct_io = result["direct-io"].as<bool>();
 #ifdef CF_DEVELOP_MODE
         const double gamma = result["gamma"].as<double>();
 #endif
@@ -122,7 +135,7 @@ int cf_build(int argc, char** argv)
                                     k, cutoff, vertex_db, edge_db, thread_count, max_memory, strict_memory,
                                     output_file, format, track_short_seqs, poly_n_stretch, working_dir,
                                     path_cover,
-                                    save_mph, save_buckets, save_vertices
+                                    save_mph, save_buckets, save_vertices, populate_loads, explicit_huge_pages, partition_count, in_memory_dbs, cache_refs, direct_io
 #ifdef CF_DEVELOP_MODE
                                     , gamma
 #endif
@@ -102,6 +102,14 @@ void dBG_Info<k>::add_unipaths_info(const CdBG<k>& cdbg)
 }
 
 
+template <uint16_t k>
+void dBG_Info<k>::add_memory_info(const Page_Backing bucket_backing, const Page_Backing mphf_backing)
+{
+    dBg_info[memory_field]["hash table buckets backing"] = Huge_Pages::to_string(bucket_backing);
+    dBg_info[memory_field]["MPHF backing"] = Huge_Pages::to_string(mphf_backing);
+}
+
+
 template <uint16_t k>
 void dBG_Info<k>::add_build_params(const Build_Params& params)
 {
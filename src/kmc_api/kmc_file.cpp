@@ -140,6 +140,7 @@ bool CKMC_DB::open_for_cuttlefish_listing(const std::string& file_name)
 	is_opened = opened_for_listing;
 	prefix_index = 0;
 	sufix_number = 0;
+	sufix_end = total_kmers;
 	index_in_partial_buf = 0;
 	return true;
 }
@@ -1,5 +1,6 @@
 
 #include "Directed_Kmer.hpp"
+#include "Kmer_Rolling_Minimizer.hpp"
 #include "Kmer_Container.hpp"
 #include "Kmer_SPMC_Iterator.hpp"
 #include "BBHash/BooPHF.h"
@@ -8,6 +9,13 @@
 #include "Character_Buffer.hpp"
 #include "Kmer_SPMC_Iterator.hpp"
 #include "FASTA_Record.hpp"
+#include "Atomic_Bit_Vector.hpp"
+#include "Unitig_Seeds.hpp"
+#include "Vertex_Enumerator.hpp"
+#include "Parallel_Writer.hpp"
+#include "Maximal_Unitig_Scratch.hpp"
+#include "dBG_Utilities.hpp"
+#include "utility.hpp"
 #include "kseq/kseq.h"
 #include "spdlog/spdlog.h"
 #include "spdlog/async.h"
@@ -15,6 +23,7 @@
 #include "spdlog/sinks/stdout_color_sinks.h"
 
 #include <chrono> 
+#include <ctime>
 #include <iostream>
 #include <fstream>
 #include <cstdio>
@@ -24,6 +33,8 @@
 #include <cstring>
 #include <set>
 #include <map>
+#include <thread>
+#include <iterator>
 
 
 /*
@@ -396,6 +407,10 @@ void test_SPMC_iterator_performance(const char* const db_path, const size_t cons
 {
     Kmer_Container<k> kmer_container(db_path);
 
+    // Wall-clock and CPU times are reported, as waiting threads should not burn CPU cycles.
+    const auto t_start = std::chrono::high_resolution_clock::now();
+    const std::clock_t cpu_start = std::clock();
+
     // Kmer_SPMC_Iterator<k> it(kmer_container.spmc_begin(consumer_count));
     Kmer_SPMC_Iterator<k> it(&kmer_container, consumer_count);
     it.launch_production();
@@ -442,12 +457,151 @@ void test_SPMC_iterator_performance(const char* const db_path, const size_t cons
     for(size_t i = 0; i < consumer_count; ++i)
         T[i]->join();
 
+    const auto t_end = std::chrono::high_resolution_clock::now();
+    const std::clock_t cpu_end = std::clock();
+
     //Kmer<k> global_max;
     //for (size_t i = 0; i < consumer_count; ++i) {
     //    global_max = std::max(global_max, max_kmer[i]);
     //}
     std::cout << "\nParsed " << ctr << " k-mers\n";
     std::cout << "Max k-mer: " << std::max_element(max_kmer.begin(), max_kmer.end())->string_label() << "\n";
+    std::cout << "Wall-clock time: " << std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count() << " seconds.\n";
+    std::cout << "CPU time: " << static_cast<double>(cpu_end - cpu_start) / CLOCKS_PER_SEC << " seconds.\n";
+}
+
+
+template <uint16_t k>
+void test_kmer_ops_performance(const size_t seq_len)
+{
+    const std::string seq = get_random_string(seq_len + k, "ACGT");
+
+    // Roll over the k-mers of the sequence along with their reverse complements, and canonicalize them.
+    Kmer<k> kmer(seq, 0), rev_compl(kmer.reverse_complement());
+    uint64_t fwd_count = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for(size_t idx = k; idx < seq.length(); ++idx)
+    {
+        kmer.roll_to_next_kmer(seq[idx], rev_compl);
+        fwd_count += (kmer.canonical(rev_compl) == kmer);
+    }
+
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::cout << "k = " << k << ": rolling and canonicalization: " << std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count() << " seconds"
+                " (" << fwd_count << " k-mers in forward).\n";
+
+    // Reverse complement the k-mers from scratch, and compare them.
+    uint64_t less_count = 0;
+    t_start = std::chrono::high_resolution_clock::now();
+    for(size_t idx = 0; idx + k <= seq.length(); idx += 4)
+    {
+        const Kmer<k> kmer(seq, idx);
+        less_count += (kmer < kmer.reverse_complement());
+    }
+
+    t_end = std::chrono::high_resolution_clock::now();
+    std::cout << "k = " << k << ": reverse complement and comparison: " << std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count() << " seconds"
+                " (" << less_count << " k-mers lesser).\n";
+}
+
+
+template <uint16_t k>
+void test_rolling_hash(const size_t seq_len)
+{
+    const std::string seq = get_random_string(seq_len + k, "ACGT");
+
+    // Roll the hash over the k-mers of the sequence, and check it against the hashes of the
+    // k-mers and of their reverse complements from scratch.
+    Kmer<k> kmer(seq, 0), rev_compl(kmer.reverse_complement());
+    Kmer_Rolling_Hash<k> h(kmer.rolling_hash(rev_compl));
+    uint64_t mismatch_count = 0;
+    for(size_t idx = k; idx < seq.length(); ++idx)
+    {
+        const DNA::Base out = kmer.front();
+        kmer.roll_to_next_kmer(seq[idx], rev_compl);
+        h.roll(out, DNA_Utility::map_base(seq[idx]));
+
+        mismatch_count += (h(idx) != kmer.to_u64(idx) || h(idx) != rev_compl.to_u64(idx));
+    }
+
+    std::cout << "k = " << k << ": " << mismatch_count << " mismatching rolling hashes.\n";
+
+
+    // Hash the k-mers from scratch, and by rolling.
+    uint64_t sum = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for(size_t idx = 0; idx + k <= seq.length(); ++idx)
+        sum += Kmer<k>(seq, idx).to_u64();
+
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::cout << "k = " << k << ": hashing from scratch: " << std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count() << " seconds.\n";
+
+    kmer = Kmer<k>(seq, 0);
+    rev_compl = kmer.reverse_complement();
+    h = kmer.rolling_hash(rev_compl);
+    t_start = std::chrono::high_resolution_clock::now();
+    for(size_t idx = k; idx < seq.length(); ++idx)
+    {
+        const DNA::Base out = kmer.front();
+        kmer.roll_to_next_kmer(seq[idx], rev_compl);
+        h.roll(out, DNA_Utility::map_base(seq[idx]));
+        sum += h(0);
+    }
+
+    t_end = std::chrono::high_resolution_clock::now();
+    std::cout << "k = " << k << ": hashing by rolling: " << std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count() << " seconds"
+                " (checksum " << sum << ").\n";
+}
+
+
+template <uint16_t k, uint8_t l>
+void test_rolling_minimizer(const size_t seq_len)
+{
+    // A binary alphabet repeats l-mers often, testing the ties of the minimizers too.
+    for(const char* const alphabet : {"ACGT", "AC"})
+    {
+        const std::string seq = get_random_string(seq_len + k, alphabet);
+
+        // Roll the minimizer over the k-mers of the sequence, and check it against the minimizers
+        // of the k-mers and of their reverse complements from scratch.
+        Kmer<k> kmer(seq, 0), rev_compl(kmer.reverse_complement());
+        Kmer_Rolling_Minimizer<k, l> m(kmer);
+        uint64_t mismatch_count = 0;
+        for(size_t idx = k; idx < seq.length(); ++idx)
+        {
+            kmer.roll_to_next_kmer(seq[idx], rev_compl);
+            m.roll(kmer);
+
+            mismatch_count += (m() != kmer.template canonical_minimizer<l>() || m() != rev_compl.template canonical_minimizer<l>());
+        }
+
+        std::cout << "k = " << k << ", l = " << +l << ", alphabet " << alphabet << ": " << mismatch_count << " mismatching rolling minimizers.\n";
+    }
+
+
+    // Compute the minimizers of the k-mers from scratch, and by rolling.
+    const std::string seq = get_random_string(seq_len + k, "ACGT");
+    uint64_t sum = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for(size_t idx = 0; idx + k <= seq.length(); ++idx)
+        sum += Kmer<k>(seq, idx).template canonical_minimizer<l>();
+
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::cout << "k = " << k << ": minimizers from scratch: " << std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count() << " seconds.\n";
+
+    Kmer<k> kmer(seq, 0), rev_compl(kmer.reverse_complement());
+    Kmer_Rolling_Minimizer<k, l> m(kmer);
+    t_start = std::chrono::high_resolution_clock::now();
+    for(size_t idx = k; idx < seq.length(); ++idx)
+    {
+        kmer.roll_to_next_kmer(seq[idx], rev_compl);
+        m.roll(kmer);
+        sum += m();
+    }
+
+    t_end = std::chrono::high_resolution_clock::now();
+    std::cout << "k = " << k << ": minimizers by rolling: " << std::chrono::duration_cast<std::chrono::duration<double>>(t_end - t_start).count() << " seconds"
+                " (checksum " << sum << ").\n";
 }
 
 
@@ -601,6 +755,369 @@ void write_kmers(const std::string& kmc_db_path, const uint16_t thread_count, co
 */
 
 
+// Checks the lock-free updates of `Atomic_Bit_Vector`: `thread_count` threads
+// increment (modulo 64) random pairs and singletons of entries through CAS,
+// and the final entries are then matched against the per-thread tallies.
+void test_atomic_bit_vector(const std::size_t entry_count, const uint16_t thread_count)
+{
+    constexpr uint64_t update_count = 10000000;
+    constexpr uint8_t mask = 0b111111;
+
+    Atomic_Bit_Vector<6> bv(entry_count);
+    bv.clear_mem();
+
+    std::vector<std::vector<uint64_t>> tally(thread_count, std::vector<uint64_t>(entry_count, 0));
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        T[t_id].reset(
+            new std::thread([&bv, &tally, entry_count, thread_count, t_id]()
+                {
+                    auto& count = tally[t_id];
+                    uint64_t seed = t_id + 1;
+                    const auto rand_idx = [&seed, entry_count]() { seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17; return seed % entry_count; };
+
+                    for(uint64_t i = 0; i < update_count / thread_count; ++i)
+                    {
+                        const std::size_t x = rand_idx(), y = rand_idx(), z = rand_idx();
+                        if(x != y)
+                        {
+                            uint8_t v_x, v_y;
+                            do
+                                v_x = bv.load(x), v_y = bv.load(y);
+                            while(!bv.cas_pair(x, v_x, (v_x + 1) & mask, y, v_y, (v_y + 1) & mask));
+
+                            count[x]++, count[y]++;
+                        }
+
+                        uint8_t v_z;
+                        do
+                            v_z = bv.load(z);
+                        while(!bv.cas(z, v_z, (v_z + 1) & mask));
+
+                        count[z]++;
+                    }
+                }
+            )
+        );
+
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        T[t_id]->join();
+
+    std::size_t mis = 0;
+    for(std::size_t idx = 0; idx < entry_count; ++idx)
+    {
+        uint64_t total = 0;
+        for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+            total += tally[t_id][idx];
+
+        if((total & mask) != bv.load(idx))
+            mis++;
+    }
+
+    std::cout << "#mismatching_entries = " << mis << "\n";
+    std::cout << (mis > 0 ? "Incorrect" : "Correct") << " lock-free updates.\n";
+}
+
+
+// Records the vertices `0, ..., vertex_count - 1`, each twice, as flanking or cover seeds at random
+// from `thread_count` threads, into seeds bounded by `max_memory` bytes; and checks that the seeds
+// consumed back are distinct, and are all the vertices if the seeds are complete.
+template <uint16_t k>
+void test_unitig_seeds(const uint64_t vertex_count, const uint16_t thread_count, const std::size_t max_memory)
+{
+    // The label of the vertex `h` spells `h` in base 4.
+    const auto label = [](uint64_t h) { std::string l(k, 'A'); for(uint16_t i = 0; i < k && h > 0; ++i, h >>= 2) l[k - 1 - i] = "ACGT"[h & 0b11]; return l; };
+    const auto id = [](const std::string& l) { uint64_t h = 0; for(const char c : l) h = (h << 2) | static_cast<uint64_t>(DNA_Utility::map_base(c)); return h; };
+
+    Unitig_Seeds<k> seeds(vertex_count, thread_count, max_memory);
+    std::vector<std::unique_ptr<std::thread>> T(thread_count);
+
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        T[t_id].reset(
+            new std::thread([&seeds, &label, vertex_count, thread_count, t_id]()
+                {
+                    uint64_t seed = t_id + 1;
+                    const auto rand = [&seed]() { seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17; return seed; };
+
+                    for(uint64_t h = t_id; h < 2 * vertex_count; h += thread_count)
+                    {
+                        const Kmer<k> v(label(h % vertex_count));
+                        rand() & 1 ? seeds.add(v, h % vertex_count, t_id) : seeds.add_cover(v, h % vertex_count, t_id);
+                    }
+                }
+            )
+        );
+
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        T[t_id]->join();
+
+    seeds.seal();
+
+
+    std::vector<uint64_t> count(vertex_count, 0);
+    Kmer<k> chunk[64];
+    std::size_t chunk_size;
+    for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+        while((chunk_size = seeds.next_chunk(t_id, chunk, 64)) > 0)
+            for(std::size_t i = 0; i < chunk_size; ++i)
+                count[id(chunk[i].string_label())]++;
+
+    uint64_t repeated = 0, missing = 0;
+    for(const uint64_t c : count)
+        repeated += (c > 1), missing += (c == 0);
+
+    std::cout << "Seeds: " << seeds.size() << (seeds.complete() ? " (complete)" : seeds.usable() ? " (cover seeds dropped)" : " (overflown)") << ".\n";
+    std::cout << "#repeated_seeds = " << repeated << ", #missing_seeds = " << missing << "\n";
+    std::cout << (repeated > 0 || (seeds.complete() && missing > 0) ? "Incorrect" : "Correct") << " seeds.\n";
+}
+
+
+// Checks the vertex set enumerated by `Vertex_Enumerator` from the edge database
+// at `edge_db_path` against the one enumerated by KMC at `kmc_vertex_db_path`,
+// reading both back through `Kmer_Container`. With `max_memory` as 0 GB, the
+// vertex buckets are split recursively.
+template <uint16_t k>
+void test_vertex_enumeration(const char* const edge_db_path, const char* const kmc_vertex_db_path, const uint16_t thread_count, const std::size_t max_memory)
+{
+    const std::string vertex_db_path = std::string(kmc_vertex_db_path) + ".enumerated";
+    Vertex_Enumerator<k>(thread_count, vertex_db_path + ".").enumerate(edge_db_path, max_memory, vertex_db_path);
+
+    const auto collect =
+        [](const std::string& db_path)
+        {
+            const Kmer_Container<k> kmer_container(db_path);
+            std::vector<Kmer<k>> kmers;
+            kmers.reserve(kmer_container.size());
+
+            Kmer_SPMC_Iterator<k> parser(&kmer_container, 1);
+            parser.launch_production();
+
+            Kmer<k> kmer;
+            while(parser.tasks_expected(0))
+                if(parser.value_at(0, kmer))
+                    kmers.emplace_back(kmer);
+
+            parser.seize_production();
+
+            std::sort(kmers.begin(), kmers.end());
+            return kmers;
+        };
+
+    const std::vector<Kmer<k>> enumerated = collect(vertex_db_path);
+    const std::vector<Kmer<k>> kmc_vertices = collect(kmc_vertex_db_path);
+
+    std::cout << "#enumerated_vertices = " << enumerated.size() << ", #KMC_vertices = " << kmc_vertices.size() << "\n";
+
+    std::size_t mis = 0;
+    for(std::size_t i = 0; i < std::min(enumerated.size(), kmc_vertices.size()); ++i)
+        if(!(enumerated[i] == kmc_vertices[i]))
+            mis++;
+
+    std::cout << "#mismatching_vertices = " << mis << "\n";
+    std::cout << (mis > 0 || enumerated.size() != kmc_vertices.size() ? "Incorrect" : "Correct") << " vertex set enumerated.\n";
+
+    Kmer_Container<k>::remove(vertex_db_path);
+}
+
+
+// Checks the FASTA records of maximal unitigs written directly from their slab-backed
+// scratches against the ones written through `FASTA_Record`s over their literal labels,
+// as done prior to the slabs. Random linear unitigs and cycles of `vertex_count` vertices
+// are checked, in both orientations each; `vertex_count` is to be small enough against
+// `4^k` for the random sequences to not repeat k-mers. The records of both the ways are
+// written to files with the path prefix `output_prefix`, through buffers smaller than
+// the records.
+template <uint16_t k>
+void test_maximal_unitig_output(const std::size_t vertex_count, const char* const output_prefix)
+{
+    constexpr std::size_t CAPACITY = 1024;
+    Slab_Arena<char> label_arena;
+    Slab_Arena<uint64_t> hash_arena;
+
+    const std::string slab_file_path = std::string(output_prefix) + ".slab";
+    const std::string record_file_path = std::string(output_prefix) + ".record";
+    std::ofstream slab_output(slab_file_path), record_output(record_file_path);
+
+    // Walks the sequence `seq` into the unitig scratch `u`, from its k-mer at index `start`
+    // onwards, until the walk ends or gets back to the k-mer at `start`. The vertices are
+    // hashed by their canonical k-mers, in place of an MPHF.
+    const auto walk =
+        [](Unitig_Scratch<k>& u, const std::string& seq, const std::size_t start)
+        {
+            Directed_Vertex<k> v;
+            v.from_kmer(Kmer<k>(seq.substr(start, k)));
+            v.set_hash(v.canonical().to_u64());
+            u.init(v);
+
+            for(std::size_t i = start + 1; i + k <= seq.length(); ++i)
+            {
+                v.from_kmer(Kmer<k>(seq.substr(i, k)));
+                v.set_hash(v.canonical().to_u64());
+                if(!u.extend(v, seq[i + k - 1]))
+                    break;
+            }
+        };
+
+    const auto rc =
+        [](std::string seq)
+        {
+            cuttlefish::reverse_complement(seq);
+            return seq;
+        };
+
+
+    // The buffers are flushed at their destruction.
+    {
+        Character_Buffer<CAPACITY, std::ofstream> slab_buf(slab_output), record_buf(record_output);
+
+        const std::string linear_seq = get_random_string(vertex_count + k - 1, "ACGT");
+        for(const std::string& seq : {linear_seq, rc(linear_seq)})
+        {
+            // The maximal unitig is split at its middle vertex, with the front piece walked over its reverse complement.
+            const std::size_t m = vertex_count / 2;
+            const std::string seq_bar = rc(seq);
+            Maximal_Unitig_Scratch<k> maximal_unitig(label_arena, hash_arena);
+            walk(maximal_unitig.unitig(cuttlefish::side_t::back), seq, m);
+            walk(maximal_unitig.unitig(cuttlefish::side_t::front), seq_bar, vertex_count - 1 - m);
+            maximal_unitig.mark_linear();
+            maximal_unitig.finalize();
+            maximal_unitig.add_fasta_rec_to_buffer(slab_buf);
+
+            std::vector<char> back_label(seq.begin() + m, seq.end());
+            std::vector<char> front_label(seq_bar.begin() + (vertex_count - 1 - m), seq_bar.end());
+            if(Kmer<k>(seq.substr(0, k)) < Kmer<k>(seq_bar.substr(0, k)))
+            {
+                cuttlefish::reverse_complement(front_label);
+                record_buf += FASTA_Record<std::vector<char>>(maximal_unitig.id(), front_label, back_label, 0, k);
+            }
+            else
+            {
+                cuttlefish::reverse_complement(back_label);
+                record_buf += FASTA_Record<std::vector<char>>(maximal_unitig.id(), back_label, front_label, 0, k);
+            }
+        }
+
+
+        const std::string cycle_seq = get_random_string(vertex_count, "ACGT");
+        for(const std::string& seq : {cycle_seq, rc(cycle_seq)})
+        {
+            const std::string circular_seq = seq + seq.substr(0, k);
+            Maximal_Unitig_Scratch<k> maximal_unitig(label_arena, hash_arena);
+            Unitig_Scratch<k>& cycle = maximal_unitig.unitig(cuttlefish::side_t::back);
+            walk(cycle, circular_seq, 0);
+            maximal_unitig.mark_cycle(cuttlefish::side_t::back);
+
+            std::vector<char> label(circular_seq.begin(), circular_seq.end() - 1);
+            if(!cycle.min_vertex().in_canonical_form())
+                cuttlefish::reverse_complement(label);
+
+            maximal_unitig.finalize();
+            maximal_unitig.add_fasta_rec_to_buffer(slab_buf);
+            record_buf.rotate_append_cycle<k>(FASTA_Record<std::vector<char>>(maximal_unitig.id(), label), cycle.min_vertex_idx());
+        }
+    }
+
+    slab_output.close();
+    record_output.close();
+
+    const auto content =
+        [](const std::string& file_path)
+        {
+            std::ifstream input(file_path);
+            return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        };
+
+    const std::string slab_content = content(slab_file_path);
+    const std::string record_content = content(record_file_path);
+    std::cout << "#slab_output_bytes = " << slab_content.size() << ", #record_output_bytes = " << record_content.size() << "\n";
+    std::cout << (slab_content != record_content ? "Incorrect" : "Correct") << " maximal unitig output from slabs.\n";
+
+    std::remove(slab_file_path.c_str());
+    std::remove(record_file_path.c_str());
+}
+
+
+// Checks `Parallel_Writer` with `thread_count` threads appending `record_count` records
+// each, of lengths from a few bytes up to past its block size, to the file at `file_path`
+// over two opening sessions, after some existing content. Each record is to appear intact
+// exactly once after the existing content, and the file is to have no other content.
+void test_parallel_writer(const char* const file_path, const uint16_t thread_count, const std::size_t record_count)
+{
+    const std::string existing_content = "Existing content.\n";
+    std::ofstream(file_path) << existing_content;
+
+    // Returns the record `i` of the thread `t_id` in the session `s`: a header line, and a line of a payload.
+    const auto record =
+        [](const uint16_t s, const uint16_t t_id, const std::size_t i)
+        {
+            const std::size_t len = (i % 64 == 63 ? 5 * 1024 * 1024 : (i * 7919 + t_id) % 4096);
+            return ">" + std::to_string(s) + "_" + std::to_string(t_id) + "_" + std::to_string(i) + "\n" +
+                    std::string(len, "ACGT"[(s + t_id + i) % 4]) + "\n";
+        };
+
+    Parallel_Writer writer;
+    for(uint16_t s = 0; s < 2; ++s)
+    {
+        writer.open(file_path);
+
+        std::vector<std::thread> appender;
+        for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+            appender.emplace_back(
+                [&writer, &record, s, t_id, record_count]()
+                {
+                    for(std::size_t i = 0; i < record_count; ++i)
+                    {
+                        const std::string rec = record(s, t_id, i);
+                        writer.write(rec.data(), rec.size());
+                    }
+                });
+
+        for(auto& t : appender)
+            t.join();
+
+        writer.close();
+    }
+
+
+    std::ifstream input(file_path);
+    const std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+
+    std::size_t expected_size = existing_content.size();
+    std::set<std::string> expected;
+    for(uint16_t s = 0; s < 2; ++s)
+        for(uint16_t t_id = 0; t_id < thread_count; ++t_id)
+            for(std::size_t i = 0; i < record_count; ++i)
+            {
+                const std::string rec = record(s, t_id, i);
+                expected_size += rec.size();
+                expected.insert(rec);
+            }
+
+    std::size_t found = 0, mis = 0;
+    bool correct = (content.size() == expected_size && content.compare(0, existing_content.size(), existing_content) == 0);
+    for(std::size_t pos = existing_content.size(); correct && pos < content.size(); )
+    {
+        const std::size_t payload_end = content.find('\n', content.find('\n', pos) + 1);
+        if(payload_end == std::string::npos)
+            break;
+
+        if(expected.erase(content.substr(pos, payload_end + 1 - pos)) > 0)
+            found++;
+        else
+            mis++;
+
+        pos = payload_end + 1;
+    }
+
+    std::cout << "#records_expected = " << 2 * thread_count * record_count << ", #records_found = " << found << ", #mismatching_records = " << mis << "\n";
+    std::cout << (correct && mis == 0 && expected.empty() ? "Correct" : "Incorrect") << " parallel writes.\n";
+
+    std::remove(file_path);
+}
+
+
 int main(int argc, char** argv)
 {
     (void)argc;
@@ -631,6 +1148,17 @@ int main(int argc, char** argv)
 
     // count_kmers_in_unitigs(argv[1], atoi(argv[2]));
 
+    // test_kmer_ops_performance<31>(std::atoi(argv[1]));
+    // test_kmer_ops_performance<63>(std::atoi(argv[1]));
+    // test_kmer_ops_performance<127>(std::atoi(argv[1]));
+    // test_kmer_ops_performance<255>(std::atoi(argv[1]));
+
+    // test_rolling_hash<31>(std::atoi(argv[1]));
+    // test_rolling_hash<63>(std::atoi(argv[1]));
+    // test_rolling_hash<127>(std::atoi(argv[1]));
+    // test_rolling_hash<255>(std::atoi(argv[1]));
+    // test_rolling_minimizer<31, 11>(std::atoi(argv[1]));
+
     static constexpr uint16_t k = 31;
     static const size_t consumer_count = std::atoi(argv[2]);
 
@@ -638,5 +1166,10 @@ int main(int argc, char** argv)
     test_SPMC_iterator_performance<k>(argv[1], consumer_count);
     // test_iterator_correctness<k>(argv[1], consumer_count);
     // write_kmers<32>(argv[1], std::atoi(argv[2]), argv[3]);
+    // test_atomic_bit_vector(std::atoi(argv[1]), std::atoi(argv[2]));
+    // test_unitig_seeds<k>(std::atoi(argv[1]), std::atoi(argv[2]), std::atoi(argv[3]));
+    // test_vertex_enumeration<k>(argv[1], argv[2], std::atoi(argv[3]), 0);
+    // test_maximal_unitig_output<k>(std::atoi(argv[1]), argv[2]);
+    // test_parallel_writer(argv[1], std::atoi(argv[2]), std::atoi(argv[3]));
     return 0;
 }
@@ -18,9 +18,10 @@ std::string get_random_string(const size_t len, const char* const alphabet)
     str.reserve(len);
 
     const unsigned int seed = static_cast<unsigned int>(std::time(NULL));
+    const size_t alphabet_size = std::strlen(alphabet);
     std::srand(seed);
     for (size_t i = 0; i < len; ++i)
-        str += alphabet[(std::rand() % (sizeof(alphabet) - 1))];
+        str += alphabet[std::rand() % alphabet_size];
 
     return str;
 }